@@ -32,6 +32,12 @@ typedef struct disp_conf
 	overflow_action_t overflow_action;
 	unsigned int max_restarts;
 	char *plugin_dir;
+	char *q_spill_dir;
+	unsigned int q_spill_max_size;
+	char *q_priority_types;
+	char *q_priority_keys;
+	char *q_bulk_types;
+	char *q_bulk_keys;
 } daemon_conf_t;
 
 #endif
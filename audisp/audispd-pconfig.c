@@ -72,6 +72,10 @@ static int args_parser(struct nv_pair *nv, int line,
 		plugin_conf_t *config);
 static int format_parser(struct nv_pair *nv, int line,
 		plugin_conf_t *config);
+static int event_types_parser(struct nv_pair *nv, int line,
+		plugin_conf_t *config);
+static int event_keys_parser(struct nv_pair *nv, int line,
+		plugin_conf_t *config);
 static int sanity_check(plugin_conf_t *config, const char *file);
 
 static const struct kw_pair keywords[] =
@@ -82,6 +86,8 @@ static const struct kw_pair keywords[] =
   {"type",                     service_type_parser,		0 },
   {"args",                     args_parser,			-1 },
   {"format",                   format_parser,			0 },
+  {"event_types",              event_types_parser,		-1 },
+  {"event_keys",               event_keys_parser,		-1 },
   { NULL,                      NULL,				0 }
 };
 
@@ -110,6 +116,7 @@ static const struct nv_list formats[] =
 {
   {"binary",  F_BINARY },
   {"string",  F_STRING },
+  {"framed",  F_FRAMED },
   { NULL,  0 }
 };
 
@@ -132,6 +139,10 @@ void clear_pconfig(plugin_conf_t *config)
 	config->checked = 0;
 	config->name = NULL;
 	config->restart_cnt = 0;
+	config->types = NULL;
+	config->keys = NULL;
+	config->nkeys = 0;
+	evcache_init(&config->key_events);
 }
 
 int load_pconfig(plugin_conf_t *config, char *file)
@@ -469,6 +480,87 @@ static int format_parser(struct nv_pair *nv, int line,
 	return 1;
 }
 
+/*
+ * The filters take a comma separated list. Since the values are also
+ * split on spaces, "A,B", "A, B", and "A B" all work.
+ */
+static int event_types_parser(struct nv_pair *nv, int line,
+		plugin_conf_t *config)
+{
+	int i;
+
+	if (config->types == NULL) {
+		config->types = calloc(MAX_PLUGIN_TYPE / 8, 1);
+		if (config->types == NULL)
+			return 1;
+	}
+	for (i = 0; i < nv->nvalues; i++) {
+		char *buf, *ptr, *saved;
+
+		buf = strdup(nv->values[i]);
+		if (buf == NULL)
+			return 1;
+		ptr = strtok_r(buf, ",", &saved);
+		while (ptr) {
+			int type = audit_name_to_msg_type(ptr);
+
+			if (type < 0 || type >= MAX_PLUGIN_TYPE) {
+				audit_msg(LOG_ERR,
+				    "Unknown event type %s - line %d",
+					ptr, line);
+				free(buf);
+				return 1;
+			}
+			config->types[type / 8] |= 1 << (type % 8);
+			ptr = strtok_r(NULL, ",", &saved);
+		}
+		free(buf);
+	}
+	return 0;
+}
+
+static int event_keys_parser(struct nv_pair *nv, int line,
+		plugin_conf_t *config)
+{
+	int i;
+
+	for (i = 0; i < nv->nvalues; i++) {
+		char *buf, *ptr, *saved;
+
+		buf = strdup(nv->values[i]);
+		if (buf == NULL)
+			return 1;
+		ptr = strtok_r(buf, ",", &saved);
+		while (ptr) {
+			char **tmp;
+
+			if (strlen(ptr) > AUDIT_MAX_KEY_LEN) {
+				audit_msg(LOG_ERR,
+				    "Event key %s is too long - line %d",
+					ptr, line);
+				free(buf);
+				return 1;
+			}
+			tmp = realloc(config->keys,
+				(config->nkeys + 1) * sizeof(char *));
+			if (tmp == NULL) {
+				free(buf);
+				return 1;
+			}
+			config->keys = tmp;
+			config->keys[config->nkeys] = strdup(ptr);
+			if (config->keys[config->nkeys] == NULL) {
+				free(buf);
+				return 1;
+			}
+			config->nkeys++;
+			ptr = strtok_r(NULL, ",", &saved);
+		}
+		free(buf);
+	}
+	return 0;
+}
+
 /*
  * This function is where we do the integrated check of the audispd config
  * options. At this point, all fields have been read. Returns 0 if no
@@ -530,6 +622,11 @@ void free_pconfig(plugin_conf_t *config)
 		free(config->args[i]);
 	}
 	free(config->args);
+	for (i = 0; i < config->nkeys; i++)
+		free(config->keys[i]);
+	free(config->keys);
+	free(config->types);
+	evcache_clear(&config->key_events);
 	if (config->plug_pipe[0] >= 0)
 		close(config->plug_pipe[0]);
 	if (config->plug_pipe[1] >= 0)
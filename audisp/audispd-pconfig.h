@@ -26,11 +26,15 @@
 
 #include <sys/types.h>
 #include "libaudit.h"
+#include "evcache.h"
 
 typedef enum { A_NO, A_YES } active_t;
 typedef enum { D_UNSET, D_IN, D_OUT } direction_t;
 typedef enum { S_ALWAYS, S_BUILTIN } service_t;
-typedef enum { F_BINARY, F_STRING } format_t;
+typedef enum { F_BINARY, F_STRING, F_FRAMED } format_t;
+
+/* Record types at or above this cannot be named in event_types */
+#define MAX_PLUGIN_TYPE 4096
 
 typedef struct plugin_conf
 {
@@ -47,6 +51,10 @@ typedef struct plugin_conf
 	int checked;		/* Used for internal housekeeping on HUP */
 	char *name;		/* Used to distinguish plugins for HUP */
 	unsigned restart_cnt;	/* Number of times its crashed */
+	unsigned char *types;	/* Bitmap of wanted record types, NULL for all */
+	char **keys;		/* Wanted event keys, NULL for all */
+	int nkeys;
+	evcache_t key_events;	/* Whether open events matched the keys */
 } plugin_conf_t;
 
 void clear_pconfig(plugin_conf_t *config);
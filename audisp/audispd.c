@@ -28,6 +28,7 @@
 #include <signal.h>
 #include <errno.h>
 #include <string.h>
+#include <ctype.h>
 #include <sys/wait.h>
 #include <pthread.h>
 #include <dirent.h>
@@ -45,8 +46,11 @@
 #include "audispd-config.h"
 #include "audispd-llist.h"
 #include "queue.h"
+#include "event-fields.h"
 #include "libaudit.h"
 #include "private.h"
+#include "common.h"
+#include "audit-frame.h"
 
 /* Global Data */
 static volatile ATOMIC_INT stop = 0;
@@ -56,6 +60,16 @@ volatile ATOMIC_INT disp_hup = 0;
 static daemon_conf_t daemon_config;
 static conf_llist plugin_conf;
 static pthread_t outbound_thread;
+/*
+ * The plugin list belongs to the outbound thread. auditd reaps the plugins
+ * and passes their pids over in a ring that needs no lock, since the child
+ * handler may run as a signal handler. If the ring overflows, every
+ * plugin's pid is checked instead.
+ */
+#define REAP_RING 64
+static pid_t reaped[REAP_RING];
+static ATOMIC_UNSIGNED reap_head = 0, reap_tail = 0;
+static volatile sig_atomic_t reap_rescan = 0;
 static int need_queue_depth_change = 0;
 
 /* Local function prototypes */
@@ -64,16 +78,36 @@ static int event_loop(void);
 static int safe_exec(plugin_conf_t *conf);
 static void *outbound_thread_main(void *arg);
 static int write_to_plugin(event_t *e, const char *string, size_t string_len,
-			   lnode *conf) __attr_access ((__read_only__, 2, 3));
+			   const struct audit_frame_header *fhdr, lnode *conf)
+			   __attr_access ((__read_only__, 2, 3));
 
 /*
  * Handle child plugins when they exit
  */
 void plugin_child_handler(pid_t pid)
 {
-	if (pid > 0) {
-		// Mark the child pid as 0 in the configs
+	unsigned int head = reap_head;
+
+	if (pid <= 0)
+		return;
+	// If full, have the outbound thread look at every plugin
+	if (head - reap_tail >= REAP_RING) {
+		reap_rescan = 1;
+		return;
+	}
+	reaped[head % REAP_RING] = pid;
+	reap_head = head + 1;
+}
+
+/* Mark the reaped plugins' pids as 0 in the configs */
+static void clear_reaped_pids(void)
+{
+	unsigned int tail = reap_tail;
+
+	while (tail != reap_head) {
+		pid_t pid = reaped[tail % REAP_RING];
 		lnode *tpconf;
+
 		plist_first(&plugin_conf);
 		tpconf = plist_get_cur(&plugin_conf);
 		while (tpconf) {
@@ -83,6 +117,24 @@ void plugin_child_handler(pid_t pid)
 			}
 			tpconf = plist_next(&plugin_conf);
 		}
+		reap_tail = ++tail;
+	}
+
+	// Some pids did not fit in the ring. The plugins are already
+	// reaped, so any that are gone no longer exist.
+	if (reap_rescan) {
+		lnode *tpconf;
+
+		reap_rescan = 0;
+		plist_first(&plugin_conf);
+		tpconf = plist_get_cur(&plugin_conf);
+		while (tpconf) {
+			if (tpconf->p && tpconf->p->pid > 0 &&
+					kill(tpconf->p->pid, 0) &&
+					errno == ESRCH)
+				tpconf->p->pid = 0;
+			tpconf = plist_next(&plugin_conf);
+		}
 	}
 }
 
@@ -180,6 +232,12 @@ static int start_plugins(conf_llist *plugin)
 	return active;
 }
 
+static void copy_string(char **dst, const char *src)
+{
+	free(*dst);
+	*dst = src ? strdup(src) : NULL;
+}
+
 static void copy_config(const struct daemon_conf *c)
 {
 	if (c->q_depth > daemon_config.q_depth)
@@ -197,6 +255,42 @@ static void copy_config(const struct daemon_conf *c)
 		daemon_config.plugin_dir = strdup(c->plugin_dir);
 	} // else c->plugin_dir is NULL or they are the same
 	  // Either way, let's leave them alone.
+
+	// The spill directory is only picked up when the queue starts
+	daemon_config.q_spill_max_size = c->q_spill_max_size;
+	if (daemon_config.q_spill_dir == NULL && c->q_spill_dir)
+		daemon_config.q_spill_dir = strdup(c->q_spill_dir);
+	copy_string(&daemon_config.q_priority_types, c->q_priority_types);
+	copy_string(&daemon_config.q_priority_keys, c->q_priority_keys);
+	copy_string(&daemon_config.q_bulk_types, c->q_bulk_types);
+	copy_string(&daemon_config.q_bulk_keys, c->q_bulk_keys);
+}
+
+static void free_config_strings(void)
+{
+	free(daemon_config.plugin_dir);
+	daemon_config.plugin_dir = NULL;
+	free(daemon_config.q_spill_dir);
+	daemon_config.q_spill_dir = NULL;
+	copy_string(&daemon_config.q_priority_types, NULL);
+	copy_string(&daemon_config.q_priority_keys, NULL);
+	copy_string(&daemon_config.q_bulk_types, NULL);
+	copy_string(&daemon_config.q_bulk_keys, NULL);
+}
+
+static void swap_filters(plugin_conf_t *o, plugin_conf_t *n)
+{
+	unsigned char *types = o->types;
+	char **keys = o->keys;
+	int nkeys = o->nkeys;
+
+	o->types = n->types;
+	o->keys = n->keys;
+	o->nkeys = n->nkeys;
+	evcache_clear(&o->key_events);
+	n->types = types;
+	n->keys = keys;
+	n->nkeys = nkeys;
 }
 
 static int reconfigure(void)
@@ -204,10 +298,14 @@ static int reconfigure(void)
 	conf_llist tmp_plugin;
 	lnode *tpconf;
 
+	clear_reaped_pids();
 	if (need_queue_depth_change) {
 		need_queue_depth_change = 0;
 		increase_queue_depth(daemon_config.q_depth);
 	}
+	set_queue_spill(daemon_config.q_spill_dir,
+			daemon_config.q_spill_max_size);
+	set_queue_lanes(&daemon_config);
 	reset_suspended();
 
 	/* The idea for handling SIGHUP to children goes like this:
@@ -263,6 +361,8 @@ static int reconfigure(void)
 							tpconf->p->inode;
 					}
 				}
+				/* Pick up any change to the filters */
+				swap_filters(opconf->p, tpconf->p);
 				opconf->p->checked = 1;
 			} else {
 				/* A change in state */
@@ -320,8 +420,6 @@ static int reconfigure(void)
  * */
 int libdisp_init(const struct daemon_conf *c)
 {
-	int i;
-
 	/* Init the dispatcher's config */
 	copy_config(c);
 
@@ -330,23 +428,20 @@ int libdisp_init(const struct daemon_conf *c)
 
 	/* If no plugins - exit */
 	if (plist_count(&plugin_conf) == 0) {
-		free(daemon_config.plugin_dir);
-		daemon_config.plugin_dir = NULL;
+		free_config_strings();
 		audit_msg(LOG_NOTICE,
 			"No plugins found, not dispatching events");
 		return 0;
 	}
 
-	/* Plugins are started with the auditd priority */
-	i = start_plugins(&plugin_conf);
-
 	/* Let the queue initialize */
 	init_queue(daemon_config.q_depth);
-	audit_msg(LOG_INFO,
-	  "audit dispatcher initialized with q_depth=%d and %d active plugins",
-		daemon_config.q_depth, i);
+	set_queue_spill(daemon_config.q_spill_dir,
+			daemon_config.q_spill_max_size);
+	set_queue_lanes(&daemon_config);
 
-	/* Create outbound thread */
+	/* Create outbound thread. It starts the plugins, so auditd can go
+	 * on with its own startup and queue events in the meantime. */
 	pthread_create(&outbound_thread, NULL, outbound_thread_main, NULL);
 	pthread_detach(outbound_thread);
 	return 0;
@@ -357,6 +452,7 @@ static void *outbound_thread_main(void *arg)
 {
 	lnode *conf;
 	sigset_t sigs;
+	int i;
 
 	/* This is a worker thread. Don't handle signals. */
 	sigemptyset(&sigs);
@@ -368,6 +464,12 @@ static void *outbound_thread_main(void *arg)
 	sigaddset(&sigs, SIGCONT);
 	pthread_sigmask(SIG_SETMASK, &sigs, NULL);
 
+	/* Plugins are started with the auditd priority */
+	i = start_plugins(&plugin_conf);
+	audit_msg(LOG_INFO,
+	  "audit dispatcher initialized with q_depth=%d and %d active plugins",
+		daemon_config.q_depth, i);
+
 	/* Start event loop */
 	while (event_loop()) {
 		if (reconfigure() == 0) {
@@ -379,6 +481,7 @@ static void *outbound_thread_main(void *arg)
 	}
 
 	/* Tell plugins we are going down */
+	clear_reaped_pids();
 	signal_plugins(SIGTERM);
 
 	/* Release configs */
@@ -392,8 +495,7 @@ static void *outbound_thread_main(void *arg)
 
 	/* Cleanup the queue */
 	destroy_queue();
-	free(daemon_config.plugin_dir);
-	daemon_config.plugin_dir = NULL;
+	free_config_strings();
 	audit_msg(LOG_DEBUG, "Finished cleaning up dispatcher");
 
 	return 0;
@@ -459,8 +561,15 @@ static void signal_plugins(int sig)
 	}
 }
 
+/*
+ * The field table of the framed format. Every field takes at least 2
+ * characters of the record and its formatting.
+ */
+#define MAX_FRAME_FIELDS ((MAX_AUDIT_MESSAGE_LENGTH + 512) / 2)
+static struct audit_frame_field frame_fields[MAX_FRAME_FIELDS];
+
 static int write_to_plugin(event_t *e, const char *string, size_t string_len,
-			   lnode *conf)
+			   const struct audit_frame_header *fhdr, lnode *conf)
 {
 	int rc;
 
@@ -468,6 +577,21 @@ static int write_to_plugin(event_t *e, const char *string, size_t string_len,
 		do {
 			rc = write(conf->p->plug_pipe[1], string, string_len);
 		} while (rc < 0 && errno == EINTR);
+	} else if (conf->p->format == F_FRAMED) {
+		struct iovec vec[3];
+
+		vec[0].iov_base = (void *)fhdr;
+		vec[0].iov_len = sizeof(struct audit_frame_header);
+
+		vec[1].iov_base = frame_fields;
+		vec[1].iov_len = fhdr->nfields *
+					sizeof(struct audit_frame_field);
+
+		vec[2].iov_base = (void *)string;
+		vec[2].iov_len = string_len;
+		do {
+			rc = writev(conf->p->plug_pipe[1], vec, 3);
+		} while (rc < 0 && errno == EINTR);
 	} else {
 		struct iovec vec[2];
 
@@ -483,56 +607,93 @@ static int write_to_plugin(event_t *e, const char *string, size_t string_len,
 	return rc;
 }
 
+/* Returns the length of the string version of the event, 0 on errors */
+static int format_event(const event_t *e, char **v)
+{
+	char *ptr, unknown[32];
+	int len;
+
+	// Protocol 1 is not formatted
+	if (e->hdr.ver == AUDISP_PROTOCOL_VER) {
+		const char *type;
+
+		/* Get the event formatted */
+		type = audit_msg_type_to_name(e->hdr.type);
+		if (type == NULL) {
+			snprintf(unknown, sizeof(unknown),
+				"UNKNOWN[%u]", e->hdr.type);
+			type = unknown;
+		}
+		len = asprintf(v, "type=%s msg=%.*s\n",
+				type, e->hdr.size, e->data);
+	// Protocol 2 events are already formatted
+	} else if (e->hdr.ver == AUDISP_PROTOCOL_VER2) {
+		len = asprintf(v, "%.*s\n", e->hdr.size, e->data);
+	} else
+		len = 0;
+	if (len <= 0) {
+		*v = NULL;
+		return 0;
+	}
+
+	/* Strip newlines from event record */
+	ptr = *v;
+	while ((ptr = strchr(ptr, 0x0A)) != NULL) {
+		if (ptr != &(*v)[len-1])
+			*ptr = ' ';
+		else
+			break; /* Done - exit loop */
+	}
+	return len;
+}
+
+/*
+ * Split up the string version of the event for the framed format. This is
+ * done once for all of the plugins that want it so that they can skip
+ * tokenizing the record themselves.
+ */
+static void frame_event(const event_t *e, const char *v, int len,
+			struct audit_frame_header *fhdr)
+{
+	memcpy(fhdr->magic, AUDISP_FRAME_MAGIC, sizeof(fhdr->magic));
+	fhdr->ver = AUDISP_FRAME_VER;
+	fhdr->hlen = sizeof(struct audit_frame_header);
+	fhdr->type = e->hdr.type;
+	fhdr->size = len;
+	if (event_stamp(e, &fhdr->sec, &fhdr->milli, &fhdr->serial)) {
+		fhdr->sec = 0;
+		fhdr->milli = 0;
+		fhdr->serial = 0;
+	}
+	// The trailing newline is not part of the record
+	fhdr->nfields = audit_strsplit_fields(v, len - 1, frame_fields,
+					      MAX_FRAME_FIELDS);
+}
+
 /* Returns 0 on stop, and 1 on HUP */
 static int event_loop(void)
 {
 	/* Figure out the format for the af_unix socket */
 	while (stop == 0) {
 		event_t *e;
-		char *v, *ptr, unknown[32];
-		int len;
+		char *v = NULL;
+		int len = 0;
 		lnode *conf;
+		struct filter_info fi;
+		struct audit_frame_header fhdr;
+		int framed = 0, bad;
 
 		/* This is where we block until we have an event */
 		e = dequeue();
+		clear_reaped_pids();
 		if (e == NULL) {
 			if (disp_hup)
 				return 1;
 			continue;
 		}
-
-		// Protocol 1 is not formatted
-		if (e->hdr.ver == AUDISP_PROTOCOL_VER) {
-			const char *type;
-
-			/* Get the event formatted */
-			type = audit_msg_type_to_name(e->hdr.type);
-			if (type == NULL) {
-				snprintf(unknown, sizeof(unknown),
-					"UNKNOWN[%u]", e->hdr.type);
-				type = unknown;
-			}
-			len = asprintf(&v, "type=%s msg=%.*s\n",
-					type, e->hdr.size, e->data);
-		// Protocol 2 events are already formatted
-		} else if (e->hdr.ver == AUDISP_PROTOCOL_VER2) {
-			len = asprintf(&v, "%.*s\n", e->hdr.size, e->data);
-		} else
-			len = 0;
-		if (len <= 0) {
-			v = NULL;
-			free(e); /* Either corrupted event or no memory */
-			continue;
-		}
-
-		/* Strip newlines from event record */
-		ptr = v;
-		while ((ptr = strchr(ptr, 0x0A)) != NULL) {
-			if (ptr != &v[len-1])
-				*ptr = ' ';
-			else
-				break; /* Done - exit loop */
-		}
+		fi.have_id = 0;
+		fi.have_keys = 0;
+		bad = 0;
 
 		/* Distribute event to the plugins */
 		plist_first(&plugin_conf);
@@ -542,11 +703,27 @@ static int event_loop(void)
 				continue;
 			if (conf->p->active == A_NO || stop)
 				continue;
+			if (!plugin_wants(conf->p, e, &fi))
+				continue;
+
+			/* Only format the event if a plugin wants a string */
+			if (conf->p->format != F_BINARY) {
+				if (v == NULL && !bad) {
+					len = format_event(e, &v);
+					bad = len == 0;
+				}
+				if (bad)
+					continue; /* Corrupted or no memory */
+			}
+			if (conf->p->format == F_FRAMED && !framed) {
+				frame_event(e, v, len, &fhdr);
+				framed = 1;
+			}
 
 			/* Now send the event to the child */
 			if (conf->p->type == S_ALWAYS && !stop) {
 				int rc;
-				rc = write_to_plugin(e, v, len, conf);
+				rc = write_to_plugin(e, v, len, &fhdr, conf);
 				if (rc < 0 && errno == EPIPE) {
 					/* Child disappeared ? */
 					if (!stop)
@@ -566,7 +743,7 @@ static int event_loop(void)
 					}
 					if (!stop && start_one_plugin(conf)) {
 						rc = write_to_plugin(e, v, len,
-								     conf);
+								&fhdr, conf);
 						audit_msg(LOG_NOTICE,
 						"plugin %s was restarted",
 							conf->p->path);
@@ -0,0 +1,168 @@
+/* event-fields.c -- fields of a dispatcher event
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+/*
+ * Quick looks at the raw text of a record for the fields the dispatcher
+ * sorts events by. The record is not NUL terminated.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include "libaudit.h"
+#include "event-fields.h"
+
+/* Returns 0 and the full id of the event, or 1 if there is none */
+int event_id(const event_t *e, struct audit_event_id *id)
+{
+	const char *ptr, *end = e->data + e->hdr.size;
+
+	ptr = memmem(e->data, e->hdr.size, "audit(", 6);
+	if (ptr == NULL)
+		return 1;
+	return audit_event_id_parse(ptr, end - ptr, id);
+}
+
+/* Returns 0 and the time stamp of the event, or 1 if there is none */
+int event_stamp(const event_t *e, uint64_t *sec, uint32_t *milli,
+		uint64_t *serial)
+{
+	const char *ptr, *end = e->data + e->hdr.size;
+	uint64_t s = 0, n = 0;
+	uint32_t m = 0;
+
+	ptr = memmem(e->data, e->hdr.size, "audit(", 6);
+	if (ptr == NULL)
+		return 1;
+	for (ptr += 6; ptr < end && *ptr >= '0' && *ptr <= '9'; ptr++)
+		s = s * 10 + (*ptr - '0');
+	if (ptr == end || *ptr != '.')
+		return 1;
+	for (ptr++; ptr < end && *ptr >= '0' && *ptr <= '9'; ptr++)
+		m = m * 10 + (*ptr - '0');
+	if (ptr == end || *ptr != ':')
+		return 1;
+	for (ptr++; ptr < end && *ptr >= '0' && *ptr <= '9'; ptr++)
+		n = n * 10 + (*ptr - '0');
+	if (s == 0 || m > 999)
+		return 1;
+	*sec = s;
+	*milli = m;
+	*serial = n;
+	return 0;
+}
+
+/* Multiple keys are hex encoded and separated by AUDIT_KEY_SEPARATOR */
+size_t event_keys(const event_t *e, char *buf, size_t blen)
+{
+	const char *ptr, *end = e->data + e->hdr.size;
+	size_t i = 0;
+
+	ptr = memmem(e->data, e->hdr.size, " key=", 5);
+	if (ptr == NULL)
+		return 0;
+	ptr += 5;
+	if (ptr < end && *ptr == '"') {
+		for (ptr++; ptr < end && *ptr != '"' && i < blen - 1; ptr++)
+			buf[i++] = *ptr;
+	} else {
+		while (ptr + 1 < end && isxdigit((unsigned char)ptr[0]) &&
+				isxdigit((unsigned char)ptr[1]) && i < blen - 1) {
+			char hex[3] = { ptr[0], ptr[1], 0 };
+
+			buf[i++] = (char)strtoul(hex, NULL, 16);
+			ptr += 2;
+		}
+	}
+	buf[i] = 0;
+	return i;
+}
+
+/* Returns 1 if any of the event's keys is in the list */
+int event_has_key(const char *keys, size_t klen, char * const *list, int n)
+{
+	const char *ptr = keys, *end = keys + klen;
+
+	while (ptr < end) {
+		const char *sep = memchr(ptr, AUDIT_KEY_SEPARATOR, end - ptr);
+		size_t len = sep ? (size_t)(sep - ptr) : (size_t)(end - ptr);
+		int i;
+
+		for (i = 0; i < n; i++) {
+			if (strlen(list[i]) == len &&
+				    memcmp(list[i], ptr, len) == 0)
+				return 1;
+		}
+		ptr += len + 1;
+	}
+	return 0;
+}
+
+/*
+ * Returns 1 if the event of this record carries one of the plugin's keys.
+ * Keys are only in the first record of an event, so the answer is
+ * remembered by event id for the rest of the event's records. This has to
+ * be done for every record, even ones the type filter drops, or the answer
+ * for the first record would be lost. If it can't be remembered, the
+ * plugin gets none of the event rather than only its first record.
+ */
+static int event_key_match(plugin_conf_t *p, const event_t *e,
+		struct filter_info *fi)
+{
+	uintptr_t match;
+
+	if (!fi->have_id) {
+		fi->id_valid = !event_id(e, &fi->id);
+		fi->have_id = 1;
+	}
+	if (fi->id_valid && evcache_find(&p->key_events, &fi->id, &match)) {
+		if (e->hdr.type == AUDIT_EOE)
+			evcache_remove(&p->key_events, &fi->id);
+		return match;
+	}
+
+	if (!fi->have_keys) {
+		fi->klen = event_keys(e, fi->keys, sizeof(fi->keys));
+		fi->have_keys = 1;
+	}
+	match = fi->klen &&
+		event_has_key(fi->keys, fi->klen, p->keys, p->nkeys);
+	if (fi->id_valid && e->hdr.type != AUDIT_EOE &&
+			!evcache_single_record(e->hdr.type) &&
+			evcache_add(&p->key_events, &fi->id, match))
+		return 0;
+	return match;
+}
+
+/* Returns 1 if the plugin wants this record. Types are checked per record. */
+int plugin_wants(plugin_conf_t *p, const event_t *e, struct filter_info *fi)
+{
+	if (p->nkeys && !event_key_match(p, e, fi))
+		return 0;
+	if (p->types) {
+		if (e->hdr.type >= MAX_PLUGIN_TYPE ||
+			    !(p->types[e->hdr.type / 8] & (1 << (e->hdr.type % 8))))
+			return 0;
+	}
+	return 1;
+}
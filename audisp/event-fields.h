@@ -0,0 +1,53 @@
+/* event-fields.h -- fields of a dispatcher event
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#ifndef EVENT_FIELDS_HEADER
+#define EVENT_FIELDS_HEADER
+
+#include <stddef.h>
+#include <stdint.h>
+#include "libaudit.h"
+#include "libdisp.h"
+#include "evcache.h"
+#include "audispd-pconfig.h"
+
+/*
+ * What the plugin interest filters look at. It is extracted from the
+ * record at most once no matter how many plugins ask for it.
+ */
+struct filter_info {
+	int have_id;
+	int id_valid;
+	struct audit_event_id id;
+	int have_keys;
+	size_t klen;
+	char keys[AUDIT_MAX_KEY_LEN+1];
+};
+
+int event_id(const event_t *e, struct audit_event_id *id);
+int event_stamp(const event_t *e, uint64_t *sec, uint32_t *milli,
+		uint64_t *serial);
+size_t event_keys(const event_t *e, char *buf, size_t blen);
+int event_has_key(const char *keys, size_t klen, char * const *list, int n);
+int plugin_wants(plugin_conf_t *p, const event_t *e, struct filter_info *fi);
+
+#endif
@@ -35,7 +35,6 @@
 #include <unistd.h>
 #include <sys/timerfd.h>
 #include "auparse.h"
-#include "common.h"
 #include "ids.h"
 #include "ids_config.h"
 #include "origin.h"
@@ -181,7 +180,7 @@ int main(void)
 	char tmp[MAX_AUDIT_MESSAGE_LENGTH+1];
 	struct sigaction sa;
 	struct itimerspec itval;
-	int tfd;
+	int tfd, eof = 0;
 	fd_set read_mask;
 
 	/* Register sighandlers */
@@ -208,8 +207,9 @@ int main(void)
 	init_accounts();
 	init_sessions();
 
-	/* Initialize the auparse library */
-	au = auparse_init(AUSOURCE_FEED, 0);
+	/* Initialize the auparse library. The framed feed takes both the
+	 * framed and string formats. */
+	au = auparse_init(AUSOURCE_FEED_FRAMED, 0);
 	if (au == NULL) {
 		my_printf("ids is exiting due to auparse init errors");
 		return -1;
@@ -272,18 +272,13 @@ int main(void)
 		/* Now the event loop */
 		 if (NO_ACTIONS && retval > 0) {
 			if (FD_ISSET(0, &read_mask)) {
-				do {
-					int len;
-					if ((len = audit_fgets(tmp,
-						MAX_AUDIT_MESSAGE_LENGTH,
-								0)) > 0) {
-					/*	char *buf = strndup(tmp, 40);
-					     my_printf("auparse_feed %s", buf);
-						free(buf); */
-						auparse_feed(au, tmp, len);
-					}
-				} while (audit_fgets_more(
-						MAX_AUDIT_MESSAGE_LENGTH));
+				// auparse reassembles whatever is read
+				int len = read(0, tmp, sizeof(tmp));
+
+				if (len > 0)
+					auparse_feed(au, tmp, len);
+				else if (len == 0 || errno != EINTR)
+					eof = 1;
 			}
 			if (FD_ISSET(tfd, &read_mask)) {
 				unsigned long long missed;
@@ -293,7 +288,7 @@ int main(void)
 			}
 
 		}
-		if (audit_fgets_eof())
+		if (eof)
 			break;
 	} while (stop == 0);
 
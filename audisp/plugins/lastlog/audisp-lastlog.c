@@ -0,0 +1,225 @@
+/* audisp-lastlog.c --
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ *
+ */
+
+/*
+ * This plugin keeps the last login database that aulastlog reads. It
+ * only looks at successful USER_LOGIN records and updates the record of
+ * the account in place, so a query never has to scan the logs.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <syslog.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <libgen.h>
+#ifdef HAVE_LIBCAP_NG
+#include <cap-ng.h>
+#endif
+#include "libaudit.h"
+#include "common.h"
+#include "lastlog-db.h"
+#include "auparse.h"
+
+/* Global Data */
+static volatile int stop = 0;
+static volatile int hup = 0;
+static const char *db_path = AULASTLOG_DB;
+static int db_fd = -1;
+
+/*
+ * SIGTERM handler
+ */
+static void term_handler( int sig )
+{
+        stop = 1;
+}
+
+/*
+ * SIGHUP handler: reopen the database
+ */
+static void hup_handler( int sig )
+{
+        hup = 1;
+}
+
+static int open_db(void)
+{
+	char *tmp, *dir;
+
+	tmp = strdup(db_path);
+	if (tmp == NULL)
+		return 1;
+	dir = dirname(tmp);
+	if (mkdir(dir, 0750) && errno != EEXIST) {
+		syslog(LOG_ERR, "audisp-lastlog cannot create %s (%s)",
+			dir, strerror(errno));
+		free(tmp);
+		return 1;
+	}
+	free(tmp);
+
+	db_fd = aulastlog_db_open(db_path, 1);
+	if (db_fd < 0) {
+		syslog(LOG_ERR, "audisp-lastlog cannot open %s (%s)",
+			db_path, strerror(errno));
+		return 1;
+	}
+	return 0;
+}
+
+static void reload_config(void)
+{
+	hup = 0;
+	if (db_fd >= 0) {
+		fsync(db_fd);
+		close(db_fd);
+	}
+	open_db();
+}
+
+static void copy_field(char *dest, size_t size, const char *src)
+{
+	if (src == NULL || strcmp(src, "?") == 0)
+		src = "";
+	strncpy(dest, src, size - 1);
+	dest[size - 1] = 0;
+}
+
+static void update_lastlog(char *s)
+{
+	struct aulastlog_rec rec, old;
+	auparse_state_t *au;
+	const char *str, *host;
+	uid_t auid;
+
+	au = auparse_init(AUSOURCE_BUFFER, s);
+	if (au == NULL)
+		return;
+	if (auparse_first_record(au) <= 0)
+		goto out;
+
+	if (auparse_find_field(au, "res") == NULL)
+		goto out;
+	str = auparse_interpret_field(au);
+	if (str == NULL || strcmp(str, "success"))
+		goto out;
+	auparse_first_record(au);
+	if (auparse_find_field(au, "auid") == NULL)
+		goto out;
+	auid = auparse_get_field_int(au);
+	if (auid == (uid_t)-1)
+		goto out;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.auid = auid;
+	rec.sec = auparse_get_time(au);
+
+	// Never go back in time if events are replayed
+	if (aulastlog_db_read(db_fd, auid, &old) == 1 && old.sec > rec.sec)
+		goto out;
+
+	host = auparse_find_field(au, "hostname");
+	if (host && strcmp(host, "?") == 0)
+		host = auparse_find_field(au, "addr");
+	copy_field(rec.host, sizeof(rec.host), host);
+	copy_field(rec.term, sizeof(rec.term),
+			auparse_find_field(au, "terminal"));
+
+	if (aulastlog_db_write(db_fd, &rec))
+		syslog(LOG_ERR, "audisp-lastlog cannot update %s (%s)",
+			db_path, strerror(errno));
+out:
+	auparse_destroy(au);
+}
+
+int main(int argc, const char *argv[])
+{
+	char tmp[MAX_AUDIT_MESSAGE_LENGTH+1];
+	struct sigaction sa;
+
+	if (argc > 1 && argv[1])
+		db_path = argv[1];
+
+	/* Register sighandlers */
+	sa.sa_flags = 0;
+	sigemptyset(&sa.sa_mask);
+	/* Set handler for the ones we care about */
+	sa.sa_handler = term_handler;
+	sigaction(SIGTERM, &sa, NULL);
+	sa.sa_handler = hup_handler;
+	sigaction(SIGHUP, &sa, NULL);
+
+	if (open_db())
+		return 1;
+
+#ifdef HAVE_LIBCAP_NG
+	// Drop capabilities
+	capng_clear(CAPNG_SELECT_BOTH);
+        if (capng_apply(CAPNG_SELECT_BOTH))
+		syslog(LOG_WARNING, "audisp-lastlog plugin was unable to drop capabilities, continuing with elevated priviles");
+#endif
+
+	do {
+		fd_set read_mask;
+		int retval = -1;
+
+		/* Reopen the database */
+		if (hup) {
+			reload_config();
+		}
+		do {
+			FD_ZERO(&read_mask);
+			FD_SET(0, &read_mask);
+			retval= select(1, &read_mask, NULL, NULL, NULL);
+		} while (retval == -1 && errno == EINTR && !hup && !stop);
+
+		/* Now the event loop */
+		 if (!stop && !hup && retval > 0) {
+			if (FD_ISSET(0, &read_mask)) {
+				do {
+					if (audit_fgets(tmp,
+					    MAX_AUDIT_MESSAGE_LENGTH, 0) > 0 &&
+					    db_fd >= 0 &&
+					    strncmp(tmp, "type=USER_LOGIN ",
+						    16) == 0)
+						update_lastlog(tmp);
+				} while (audit_fgets_more(
+						MAX_AUDIT_MESSAGE_LENGTH));
+			}
+		}
+		if (audit_fgets_eof())
+			break;
+	} while (stop == 0);
+
+	if (db_fd >= 0) {
+		fsync(db_fd);
+		close(db_fd);
+	}
+	return 0;
+}
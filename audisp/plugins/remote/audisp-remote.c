@@ -45,6 +45,12 @@
 #include <gssapi/gssapi_generic.h>
 #include <krb5.h>
 #endif
+#ifdef USE_TLS
+#include <arpa/inet.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+#endif
 #ifdef HAVE_LIBCAP_NG
 #include <cap-ng.h>
 #endif
@@ -112,6 +118,13 @@ gss_ctx_id_t my_context;
 #define USE_GSS (config.transport == T_KRB5)
 #endif
 
+#ifdef USE_TLS
+/* The context is kept across reconnects, the session is per socket */
+static SSL_CTX *tls_ctx;
+static SSL *ssl;
+#define USE_TLS_TRANSPORT (config.transport == T_TLS)
+#endif
+
 /* Compile-time expression verification */
 #define verify(E) do {				\
 		char verify__[(E) ? 1 : -1];	\
@@ -137,6 +150,11 @@ static void hup_handler( int sig )
 static void reload_config(void)
 {
 	stop_transport(); // FIXME: We should only stop transport if necessary
+#ifdef USE_TLS
+	// Pick up renewed certificates on the next connect
+	SSL_CTX_free(tls_ctx);
+	tls_ctx = NULL;
+#endif
 	hup = 0;
 }
 
@@ -632,9 +650,20 @@ int main(int argc, char *argv[])
 	}
 
 	if (sock >= 0) {
+#ifdef USE_TLS
+		if (ssl) {
+			// Tell the server this is an orderly close
+			SSL_shutdown(ssl);
+			SSL_free(ssl);
+			ssl = NULL;
+		}
+#endif
 		shutdown(sock, SHUT_RDWR);
 		close(sock);
 	}
+#ifdef USE_TLS
+	SSL_CTX_free(tls_ctx);
+#endif
 	free_config(&config);
 	q_len = q_queue_length(queue);
 	q_close(queue);
@@ -1037,6 +1066,90 @@ error1:
 }
 #endif // USE_GSSAPI
 
+#ifdef USE_TLS
+static void tls_failure(const char *msg)
+{
+	unsigned long err = ERR_get_error();
+	char buf[256];
+
+	if (err)
+		ERR_error_string_n(err, buf, sizeof(buf));
+	if (!quiet)
+		syslog(LOG_ERR, "TLS %s with %s failed (%s)", msg,
+			config.remote_server, err ? buf : strerror(errno));
+	ERR_clear_error();
+}
+
+static int init_tls_ctx(void)
+{
+	tls_ctx = SSL_CTX_new(TLS_client_method());
+	if (tls_ctx == NULL)
+		goto err;
+	SSL_CTX_set_min_proto_version(tls_ctx, TLS1_2_VERSION);
+	if (SSL_CTX_use_certificate_chain_file(tls_ctx,
+				config.tls_cert_file) != 1 ||
+	    SSL_CTX_use_PrivateKey_file(tls_ctx, config.tls_key_file,
+				SSL_FILETYPE_PEM) != 1 ||
+	    SSL_CTX_check_private_key(tls_ctx) != 1 ||
+	    SSL_CTX_load_verify_locations(tls_ctx, config.tls_ca_file,
+				NULL) != 1)
+		goto err;
+	SSL_CTX_set_verify(tls_ctx, SSL_VERIFY_PEER, NULL);
+	SSL_CTX_set_session_cache_mode(tls_ctx, SSL_SESS_CACHE_OFF);
+	// Let ar_read see records without data so it can poll again
+	SSL_CTX_clear_mode(tls_ctx, SSL_MODE_AUTO_RETRY);
+#ifdef SSL_OP_ENABLE_KTLS
+	SSL_CTX_set_options(tls_ctx, SSL_OP_ENABLE_KTLS);
+#endif
+	return 0;
+err:
+	tls_failure("setup");
+	SSL_CTX_free(tls_ctx);
+	tls_ctx = NULL;
+	return -1;
+}
+
+/*
+ * Both ends present certificates signed by the configured CA, and the
+ * server's certificate must match the name or address it was reached by.
+ * When the kernel supports it, OpenSSL moves the session keys into the
+ * socket after the handshake and records are then plain writes.
+ */
+static int start_tls(void)
+{
+	unsigned char addr[sizeof(struct in6_addr)];
+
+	if (tls_ctx == NULL && init_tls_ctx())
+		return -1;
+
+	ssl = SSL_new(tls_ctx);
+	if (ssl == NULL || SSL_set_fd(ssl, sock) != 1)
+		goto err;
+	if (inet_pton(AF_INET, config.remote_server, addr) == 1 ||
+		    inet_pton(AF_INET6, config.remote_server, addr) == 1) {
+		if (X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(ssl),
+					config.remote_server) != 1)
+			goto err;
+	} else if (SSL_set1_host(ssl, config.remote_server) != 1 ||
+		   SSL_set_tlsext_host_name(ssl, config.remote_server) != 1)
+		goto err;
+
+	if (SSL_connect(ssl) != 1)
+		goto err;
+
+	syslog(LOG_NOTICE, "TLS session with %s: %s, kernel TLS send %s recv %s",
+		config.remote_server, SSL_get_version(ssl),
+		BIO_get_ktls_send(SSL_get_wbio(ssl)) ? "yes" : "no",
+		BIO_get_ktls_recv(SSL_get_rbio(ssl)) ? "yes" : "no");
+	return 0;
+err:
+	tls_failure("handshake");
+	SSL_free(ssl);
+	ssl = NULL;
+	return -1;
+}
+#endif
+
 static int stop_sock(void)
 {
 	if (sock >= 0) {
@@ -1056,6 +1169,12 @@ static int stop_sock(void)
 			krb5_free_context(kcontext);
 			kcontext = NULL;
 		}
+#endif
+#ifdef USE_TLS
+		if (ssl) {
+			SSL_free(ssl);
+			ssl = NULL;
+		}
 #endif
 		shutdown(sock, SHUT_RDWR);
 		close(sock);
@@ -1073,6 +1192,7 @@ static int stop_transport(void)
 	switch (config.transport)
 	{
 		case T_TCP:
+		case T_TLS:
 		case T_KRB5:
 			rc = stop_sock();
 			break;
@@ -1202,6 +1322,13 @@ next_try:
 		}
 	}
 #endif
+#ifdef USE_TLS
+	if (USE_TLS_TRANSPORT && start_tls()) {
+		stop_sock();
+		rc = ET_TEMPORARY;
+		goto out;
+	}
+#endif
 
 	transport_ok = 1;
 	syslog(LOG_NOTICE, "Connected to %s", config.remote_server);
@@ -1217,6 +1344,7 @@ static int init_transport(void)
 	switch (config.transport)
 	{
 		case T_TCP:
+		case T_TLS:
 		case T_KRB5:
 			rc = init_sock();
 			// We set this so that it will retry the connection
@@ -1230,9 +1358,52 @@ static int init_transport(void)
 	return rc;
 }
 
+#ifdef USE_TLS
+/* SSL_write only returns once all of it is sent on a blocking socket */
+static int tls_write(const void *buf, int len)
+{
+	int r = SSL_write(ssl, buf, len);
+
+	if (r <= 0) {
+		tls_failure("write");
+		stop_sock();
+		return -1;
+	}
+	return r;
+}
+
+/* Like read(), except EINTR is also used when only a TLS protocol
+   record arrived, so the caller polls again. */
+static int tls_read(void *buf, int len)
+{
+	int r = SSL_read(ssl, buf, len);
+
+	if (r > 0)
+		return r;
+	switch (SSL_get_error(ssl, r))
+	{
+		case SSL_ERROR_WANT_READ:
+		case SSL_ERROR_WANT_WRITE:
+			errno = EINTR;
+			return -1;
+		case SSL_ERROR_ZERO_RETURN:
+			errno = 0;
+			return 0;
+		default:
+			tls_failure("read");
+			errno = EPIPE;
+			return -1;
+	}
+}
+#endif
+
 static int ar_write (int sk, const void *buf, int len)
 {
 	int rc = 0, r;
+#ifdef USE_TLS
+	if (ssl)
+		return tls_write(buf, len);
+#endif
 	while (len > 0) {
 		do {
 			r = write(sk, buf, len);
@@ -1262,10 +1433,22 @@ static int ar_read (int sk, void *buf, int len)
 	pfd.events = POLLIN | POLLPRI | POLLHUP | POLLERR | POLLNVAL;
 	while (len > 0) {
 		do {
+#ifdef USE_TLS
+			// Data may already be decrypted and waiting
+			if (ssl && SSL_pending(ssl)) {
+				r = tls_read(buf, len);
+				continue;
+			}
+#endif
 			// Reads can hang if cable is disconnected
 			int prc = poll(&pfd, (nfds_t) 1, timeout);
 			if (prc <= 0)
 				return -1;
+#ifdef USE_TLS
+			if (ssl)
+				r = tls_read(buf, len);
+			else
+#endif
 			r = read(sk, buf, len);
 		} while (r < 0 && errno == EINTR);
 		if (r < 0) {
@@ -1410,6 +1593,24 @@ static int send_msg_tcp (unsigned char *header, const char *msg, uint32_t mlen)
 {
 	int rc;
 
+#ifdef USE_TLS
+	// One TLS record per event rather than one for the header too
+	if (ssl && msg != NULL && mlen > 0 &&
+				mlen <= MAX_AUDIT_MESSAGE_LENGTH) {
+		static unsigned char buf[AUDIT_RMW_HEADER_SIZE +
+					 MAX_AUDIT_MESSAGE_LENGTH];
+
+		memcpy(buf, header, AUDIT_RMW_HEADER_SIZE);
+		memcpy(buf + AUDIT_RMW_HEADER_SIZE, msg, mlen);
+		if (ar_write(sock, buf, AUDIT_RMW_HEADER_SIZE + mlen) <= 0) {
+			syslog(LOG_ERR, "send to %s failed",
+				config.remote_server);
+			return 1;
+		}
+		return 0;
+	}
+#endif
+
 	rc = ar_write(sock, header, AUDIT_RMW_HEADER_SIZE);
 	if (rc <= 0) {
 		syslog(LOG_ERR, "send to %s failed", config.remote_server);
@@ -1681,6 +1882,7 @@ static int relay_event(const char *s, size_t len)
 	switch (config.transport)
 	{
 		case T_TCP:
+		case T_TLS:
 		case T_KRB5:
 			rc = relay_sock(s, len);
 			break;
@@ -84,6 +84,8 @@ static int krb5_client_name_parser(struct nv_pair *nv, int line,
 		remote_conf_t *config);
 static int krb5_key_file_parser(struct nv_pair *nv, int line, 
 		remote_conf_t *config);
+static int tls_file_parser(struct nv_pair *nv, int line,
+		remote_conf_t *config);
 static int network_retry_time_parser(struct nv_pair *nv, int line, 
 		remote_conf_t *config);
 static int max_tries_per_record_parser(struct nv_pair *nv, int line, 
@@ -125,6 +127,9 @@ static const struct kw_pair keywords[] =
   {"krb5_principal",         krb5_principal_parser,             0 },
   {"krb5_client_name",       krb5_client_name_parser,           0 },
   {"krb5_key_file",          krb5_key_file_parser,              0 },
+  {"tls_cert_file",          tls_file_parser,                   0 },
+  {"tls_key_file",           tls_file_parser,                   0 },
+  {"tls_ca_file",            tls_file_parser,                   0 },
   {"network_failure_action", network_failure_action_parser,	1 },
   {"disk_low_action",        disk_low_action_parser,		1 },
   {"disk_full_action",       disk_full_action_parser,		1 },
@@ -141,6 +146,9 @@ static const struct kw_pair keywords[] =
 static const struct nv_list transport_words[] =
 {
   {"tcp",  T_TCP  },
+#ifdef USE_TLS
+  {"tls",  T_TLS  },
+#endif
 #ifdef USE_GSSAPI
   {"krb5", T_KRB5 },
 #endif
@@ -229,6 +237,9 @@ void clear_config(remote_conf_t *config)
 	config->krb5_principal = NULL;
 	config->krb5_client_name = NULL;
 	config->krb5_key_file = NULL;
+	config->tls_cert_file = NULL;
+	config->tls_key_file = NULL;
+	config->tls_ca_file = NULL;
 }
 
 int load_config(remote_conf_t *config, const char *file)
@@ -749,6 +760,28 @@ static int krb5_key_file_parser(struct nv_pair *nv, int line,
 	return 0;
 }
 
+static int tls_file_parser(struct nv_pair *nv, int line,
+		remote_conf_t *config)
+{
+#ifndef USE_TLS
+	syslog(LOG_INFO,
+		"TLS support is not enabled, ignoring value at line %d",
+		line);
+#else
+	const char **file;
+
+	if (strcmp(nv->name, "tls_cert_file") == 0)
+		file = &config->tls_cert_file;
+	else if (strcmp(nv->name, "tls_key_file") == 0)
+		file = &config->tls_key_file;
+	else
+		file = &config->tls_ca_file;
+	free((void *)*file);
+	*file = strdup(nv->value);
+#endif
+	return 0;
+}
+
 /*
  * This function is where we do the integrated check of the config
  * options. At this point, all fields have been read. Returns 0 if no
@@ -767,6 +800,13 @@ static int sanity_check(remote_conf_t *config, const char *file)
 		       "\"format=managed\"");
 		return 1;
 	}
+	if (config->transport == T_TLS && (config->tls_cert_file == NULL ||
+			config->tls_key_file == NULL ||
+			config->tls_ca_file == NULL)) {
+		syslog(LOG_ERR, "\"transport=tls\" needs tls_cert_file, "
+		       "tls_key_file, and tls_ca_file");
+		return 1;
+	}
 	if (config->startup_failure_action > FA_EXEC) {
 		syslog(LOG_ERR, "startup_failure_action has invalid option");
 		return 1;
@@ -790,5 +830,8 @@ void free_config(remote_conf_t *config)
 	free((void *)config->krb5_principal);
 	free((void *)config->krb5_client_name);
 	free((void *)config->krb5_key_file);
+	free((void *)config->tls_cert_file);
+	free((void *)config->tls_key_file);
+	free((void *)config->tls_ca_file);
 }
 
@@ -50,6 +50,9 @@ typedef struct remote_conf
 	const char *krb5_principal;
 	const char *krb5_client_name;
 	const char *krb5_key_file;
+	const char *tls_cert_file;
+	const char *tls_key_file;
+	const char *tls_ca_file;
 
 	failure_action_t network_failure_action;
 	const char *network_failure_exe;
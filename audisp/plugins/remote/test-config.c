@@ -0,0 +1,110 @@
+/* test-config.c -- test suite for remote-config.c
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "remote-config.h"
+
+static char filename[] = "/tmp/tcXXXXXX";
+
+/* Writes text to the config file and loads it */
+static int load(remote_conf_t *config, const char *text)
+{
+	FILE *f = fopen(filename, "w");
+
+	if (f == NULL)
+		return -1;
+	fputs(text, f);
+	fclose(f);
+	return load_config(config, filename);
+}
+
+static void cleanup(void)
+{
+	unlink(filename);
+}
+
+int main(void)
+{
+	remote_conf_t config;
+	int fd;
+
+	if (geteuid() != 0) {
+		puts("config files must be owned by root, skipped");
+		return 77;
+	}
+	fd = mkstemp(filename);
+	if (fd < 0) {
+		puts("Test failed - cannot make the config file");
+		return 1;
+	}
+	close(fd);
+	atexit(cleanup);
+
+#ifdef USE_TLS
+	if (load(&config, "transport = tls\n"
+			"tls_cert_file = /etc/pki/audit/client.crt\n"
+			"tls_key_file = /etc/pki/audit/client.key\n"
+			"tls_ca_file = /etc/pki/audit/ca.crt\n") ||
+			config.transport != T_TLS ||
+			config.tls_cert_file == NULL ||
+			strcmp(config.tls_cert_file,
+				"/etc/pki/audit/client.crt") ||
+			config.tls_key_file == NULL ||
+			strcmp(config.tls_key_file,
+				"/etc/pki/audit/client.key") ||
+			config.tls_ca_file == NULL ||
+			strcmp(config.tls_ca_file, "/etc/pki/audit/ca.crt")) {
+		puts("Test failed - tls options");
+		return 1;
+	}
+	free_config(&config);
+
+	// Every file is needed to use TLS
+	if (load(&config, "transport = tls\n"
+			"tls_cert_file = /etc/pki/audit/client.crt\n"
+			"tls_ca_file = /etc/pki/audit/ca.crt\n") == 0) {
+		puts("Test failed - tls without a key accepted");
+		return 1;
+	}
+	free_config(&config);
+#else
+	// Without TLS support the files are ignored and it can't be chosen
+	if (load(&config, "tls_cert_file = /etc/pki/audit/client.crt\n") ||
+			config.tls_cert_file) {
+		puts("Test failed - tls file without tls support");
+		return 1;
+	}
+	free_config(&config);
+	if (load(&config, "transport = tls\n") == 0) {
+		puts("Test failed - tls transport without tls support");
+		return 1;
+	}
+	free_config(&config);
+#endif
+
+	puts("config test passed");
+	return 0;
+}
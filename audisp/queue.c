@@ -23,28 +23,65 @@
 #include "config.h"
 #include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <syslog.h>
 #ifdef HAVE_ATOMIC
 #include <stdatomic.h>
 #endif
 #include "queue.h"
+#include "spill.h"
+#include "event-fields.h"
+#include "libaudit.h"
+
+/*
+ * Events go into one of three lanes by record type or key. Each lane is
+ * a ring of q_depth pointers, but the lanes together never hold more
+ * than q_depth events. Normal events spill and bulk events are shed once
+ * the queue is 7/8 full, which keeps the rest free for priority events.
+ */
+enum { LANE_NORMAL, LANE_PRIORITY, LANE_BULK, LANE_MAX };
+struct lane
+{
+	volatile event_t **q;
+	unsigned int next, last, used, max_used;
+};
+static struct lane lanes[LANE_MAX];
+// Dequeue order, and the events taken from each lane per round
+static const int lane_order[LANE_MAX] = { LANE_PRIORITY, LANE_NORMAL,
+					  LANE_BULK };
+static const unsigned int lane_weight[LANE_MAX] = {
+	[LANE_NORMAL] = 4, [LANE_PRIORITY] = 8, [LANE_BULK] = 1 };
+static unsigned int lane_credit[LANE_MAX];
+static unsigned int bulk_shed, bulk_shed_warning;
+
+#define MAX_LANE_TYPE 4096
+static unsigned char *type_lane;	// NULL when no types are configured
+static char **lane_keys[LANE_MAX];
+static int lane_nkeys[LANE_MAX];
+
+// Records of an event follow the lane of its first record
+static evcache_t lane_events;
 
-static volatile event_t **q;
 static pthread_mutex_t queue_lock;
 static pthread_cond_t queue_nonempty;
-static unsigned int q_next, q_last, q_depth, processing_suspended, overflowed;
+static unsigned int q_depth, processing_suspended, overflowed;
+static unsigned int spill_on;	// Set once the spill directory is ready
+static unsigned int spilling;	// Events being written to disk
 static ATOMIC_UNSIGNED currently_used, max_used;
 static const char *SINGLE = "1";
 static const char *HALT = "0";
 static int queue_full_warning = 0;
 extern volatile ATOMIC_INT disp_hup;
 #define QUEUE_FULL_LIMIT 5
+// Start spilling to disk when the queue is this full
+#define SPILL_HIGH_WATER(d) ((d) - (d)/8)
 
 void reset_suspended(void)
 {
 	processing_suspended = 0;
 	queue_full_warning = 0;
+	bulk_shed_warning = 0;
 }
 
 int init_queue(unsigned int size)
@@ -59,15 +96,17 @@ int init_queue(unsigned int size)
 	if (q_depth == 0) {
 		unsigned int i;
 
-		q_depth = size;
-		q = malloc(q_depth * sizeof(event_t *));
-		if (q == NULL) {
-			processing_suspended = 1;
-			return -1;
+		for (i = 0; i < LANE_MAX; i++) {
+			lanes[i].q = calloc(size, sizeof(event_t *));
+			if (lanes[i].q == NULL) {
+				while (i)
+					free(lanes[--i].q);
+				processing_suspended = 1;
+				return -1;
+			}
 		}
-
-		for (i=0; i < q_depth; i++)
-			q[i] = NULL;
+		q_depth = size;
+		evcache_init(&lane_events);
 
 		/* Setup IPC mechanisms */
 		pthread_mutex_init(&queue_lock, NULL);
@@ -77,6 +116,170 @@ int init_queue(unsigned int size)
 	return 0;
 }
 
+/*
+ * Events are spilled to dir rather than dropped if the queue fills up.
+ * The directory is picked up once, the size may change on reconfigure.
+ * Segments left by an earlier run are scanned without the queue lock.
+ */
+void set_queue_spill(const char *dir, unsigned int max_mb)
+{
+	if (q_depth == 0)
+		return;
+
+	if (spill_enabled()) {
+		spill_set_max(max_mb);
+		return;
+	}
+	if (spill_init(dir, max_mb) == 0 && spill_enabled()) {
+		pthread_mutex_lock(&queue_lock);
+		spill_on = 1;
+		pthread_mutex_unlock(&queue_lock);
+	}
+}
+
+static void free_lanes_config(void)
+{
+	int i, j;
+
+	free(type_lane);
+	type_lane = NULL;
+	for (i = 0; i < LANE_MAX; i++) {
+		for (j = 0; j < lane_nkeys[i]; j++)
+			free(lane_keys[i][j]);
+		free(lane_keys[i]);
+		lane_keys[i] = NULL;
+		lane_nkeys[i] = 0;
+	}
+	evcache_clear(&lane_events);
+}
+
+static int add_lane_types(unsigned char **map, const char *list,
+			  unsigned int lane)
+{
+	char *buf, *ptr, *saved;
+
+	if (list == NULL)
+		return 0;
+	if (*map == NULL) {
+		*map = calloc(MAX_LANE_TYPE, 1);
+		if (*map == NULL)
+			return 1;
+	}
+	buf = strdup(list);
+	if (buf == NULL)
+		return 1;
+	for (ptr = strtok_r(buf, ",", &saved); ptr;
+				ptr = strtok_r(NULL, ",", &saved)) {
+		int type = audit_name_to_msg_type(ptr);
+
+		if (type >= 0 && type < MAX_LANE_TYPE)
+			(*map)[type] = lane;
+	}
+	free(buf);
+	return 0;
+}
+
+static int add_lane_keys(char ***keys, int *nkeys, const char *list)
+{
+	char *buf, *ptr, *saved;
+
+	if (list == NULL)
+		return 0;
+	buf = strdup(list);
+	if (buf == NULL)
+		return 1;
+	for (ptr = strtok_r(buf, ",", &saved); ptr;
+				ptr = strtok_r(NULL, ",", &saved)) {
+		char **tmp = realloc(*keys, (*nkeys + 1) * sizeof(char *));
+
+		if (tmp == NULL)
+			break;
+		*keys = tmp;
+		tmp[*nkeys] = strdup(ptr);
+		if (tmp[*nkeys] == NULL)
+			break;
+		(*nkeys)++;
+	}
+	free(buf);
+	return ptr ? 1 : 0;
+}
+
+/* Sets up which events go to the priority and bulk lanes */
+void set_queue_lanes(const struct disp_conf *config)
+{
+	unsigned char *map = NULL;
+	char **pkeys = NULL, **bkeys = NULL;
+	int npkeys = 0, nbkeys = 0, rc;
+
+	if (q_depth == 0)
+		return;
+
+	// Priority goes last so it wins if a type is in both lists
+	rc = add_lane_types(&map, config->q_bulk_types, LANE_BULK);
+	rc |= add_lane_types(&map, config->q_priority_types, LANE_PRIORITY);
+	rc |= add_lane_keys(&pkeys, &npkeys, config->q_priority_keys);
+	rc |= add_lane_keys(&bkeys, &nbkeys, config->q_bulk_keys);
+	if (rc)
+		syslog(LOG_ERR, "Out of memory setting up queue lanes");
+
+	pthread_mutex_lock(&queue_lock);
+	free_lanes_config();
+	type_lane = map;
+	lane_keys[LANE_PRIORITY] = pkeys;
+	lane_nkeys[LANE_PRIORITY] = npkeys;
+	lane_keys[LANE_BULK] = bkeys;
+	lane_nkeys[LANE_BULK] = nbkeys;
+	pthread_mutex_unlock(&queue_lock);
+}
+
+static int lanes_configured(void)
+{
+	return type_lane || lane_nkeys[LANE_PRIORITY] || lane_nkeys[LANE_BULK];
+}
+
+/* Called with the queue lock held */
+static unsigned int pick_lane(const event_t *e)
+{
+	unsigned int lane = LANE_NORMAL;
+	struct audit_event_id id;
+	uintptr_t cached;
+	int have_id;
+
+	if (!lanes_configured())
+		return LANE_NORMAL;
+
+	have_id = event_id(e, &id) == 0;
+	if (have_id && evcache_find(&lane_events, &id, &cached)) {
+		if (e->hdr.type == AUDIT_EOE)
+			evcache_remove(&lane_events, &id);
+		return cached;
+	}
+
+	if (type_lane && e->hdr.type < MAX_LANE_TYPE)
+		lane = type_lane[e->hdr.type];
+	if (lane == LANE_NORMAL &&
+			(lane_nkeys[LANE_PRIORITY] || lane_nkeys[LANE_BULK])) {
+		char keys[AUDIT_MAX_KEY_LEN+1];
+		size_t klen = event_keys(e, keys, sizeof(keys));
+
+		if (klen == 0)
+			;
+		else if (event_has_key(keys, klen, lane_keys[LANE_PRIORITY],
+					lane_nkeys[LANE_PRIORITY]))
+			lane = LANE_PRIORITY;
+		else if (event_has_key(keys, klen, lane_keys[LANE_BULK],
+					lane_nkeys[LANE_BULK]))
+			lane = LANE_BULK;
+	}
+
+	// If it cannot be remembered the rest of the event goes by its
+	// own records, which at worst puts it in the normal lane
+	if (have_id && e->hdr.type != AUDIT_EOE &&
+			!evcache_single_record(e->hdr.type))
+		evcache_add(&lane_events, &id, lane);
+	return lane;
+}
+
 static void change_runlevel(const char *level)
 {
 	char *argv[3];
@@ -146,6 +349,8 @@ static int do_overflow_action(struct disp_conf *config)
 int enqueue(event_t *e, struct disp_conf *config)
 {
 	unsigned int n, retry_cnt = 0;
+	struct lane *l;
+	int lane;
 
 	if (processing_suspended) {
 		free(e);
@@ -160,12 +365,50 @@ retry:
 		return do_overflow_action(config);
 	}
 	pthread_mutex_lock(&queue_lock);
+	lane = pick_lane(e);
+	l = &lanes[lane];
+
+	// Bulk events give way before the queue is full
+	if (lane == LANE_BULK &&
+			currently_used >= SPILL_HIGH_WATER(q_depth)) {
+		bulk_shed++;
+		pthread_mutex_unlock(&queue_lock);
+		free(e);
+		if (bulk_shed_warning == 0) {
+			syslog(LOG_WARNING,
+		"queue to plugins is filling up - shedding bulk events");
+			bulk_shed_warning = 1;
+		}
+		return 0;
+	}
+
+	// Once anything is on disk, keep spilling so the order holds.
+	// The write is done without the queue lock so a slow disk does
+	// not hold up dequeue.
+	if (lane == LANE_NORMAL && spill_on && (spill_pending() ||
+			spilling || currently_used >= SPILL_HIGH_WATER(q_depth))) {
+		int rc;
+
+		spilling++;
+		pthread_mutex_unlock(&queue_lock);
+		rc = spill_write(e);
+		free(e);
+		pthread_mutex_lock(&queue_lock);
+		spilling--;
+		if (rc == 0)
+			pthread_cond_signal(&queue_nonempty);
+		pthread_mutex_unlock(&queue_lock);
+		return rc ? do_overflow_action(config) : 0;
+	}
 
 	// OK, have lock add event
-	n = q_next%q_depth;
-	if (q[n] == NULL) {
-		q[n] = e;
-		q_next = (n+1) % q_depth;
+	n = l->next%q_depth;
+	if (currently_used < q_depth && l->q[n] == NULL) {
+		l->q[n] = e;
+		l->next = (n+1) % q_depth;
+		l->used++;
+		if (l->used > l->max_used)
+			l->max_used = l->used;
 		currently_used++;
 		if (currently_used > max_used)
 			max_used = currently_used;
@@ -183,10 +426,45 @@ retry:
 	return 0;
 }
 
+static int lane_ready(int lane)
+{
+	return lanes[lane].used || (lane == LANE_NORMAL && spill_pending());
+}
+
+/*
+ * Weighted round robin over the lanes. A lane with nothing waiting gives
+ * up its turn, so a lone lane gets the full dequeue rate.
+ */
+static int next_lane(void)
+{
+	int i, lane;
+
+	for (i = 0; i < LANE_MAX; i++) {
+		lane = lane_order[i];
+		if (lane_credit[lane] && lane_ready(lane)) {
+			lane_credit[lane]--;
+			return lane;
+		}
+	}
+
+	// Start a new round
+	for (i = 0; i < LANE_MAX; i++)
+		lane_credit[i] = lane_weight[i];
+	for (i = 0; i < LANE_MAX; i++) {
+		lane = lane_order[i];
+		if (lane_ready(lane)) {
+			lane_credit[lane]--;
+			return lane;
+		}
+	}
+	return -1;
+}
+
 event_t *dequeue(void)
 {
 	event_t *e;
 	unsigned int n;
+	int lane;
 
 	// Wait until its got something in it
 	pthread_mutex_lock(&queue_lock);
@@ -194,25 +472,36 @@ event_t *dequeue(void)
 		pthread_mutex_unlock(&queue_lock);
 		return NULL;
 	}
-	n = q_last%q_depth;
-	if (q[n] == NULL) {
+	lane = next_lane();
+	if (lane < 0) {
 		pthread_cond_wait(&queue_nonempty, &queue_lock);
 		if (disp_hup) {
 			pthread_mutex_unlock(&queue_lock);
 			return NULL;
 		}
-		n = q_last%q_depth;
+		lane = next_lane();
 	}
 
 	// OK, grab the next event
-	if (q[n] != NULL) {
-		e = (event_t *)q[n];
-		q[n] = NULL;
-		q_last = (n+1) % q_depth;
-	} else
+	if (lane < 0)
 		e = NULL;
+	else if (lanes[lane].used) {
+		struct lane *l = &lanes[lane];
+
+		n = l->last%q_depth;
+		e = (event_t *)l->q[n];
+		l->q[n] = NULL;
+		l->last = (n+1) % q_depth;
+		l->used--;
+		currently_used--;
+	} else {
+		// Spilled events are newer than any in memory. Enqueue
+		// writes new ones to disk as long as any are pending, so
+		// they can be read without the queue lock.
+		pthread_mutex_unlock(&queue_lock);
+		return spill_read();
+	}
 
-	currently_used--;
 	pthread_mutex_unlock(&queue_lock);
 
 	// Process the event
@@ -228,18 +517,20 @@ void increase_queue_depth(unsigned int size)
 {
 	pthread_mutex_lock(&queue_lock);
 	if (size > q_depth) {
-		unsigned int i;
+		unsigned int i, j;
 		void *tmp_q;
 
-		tmp_q = realloc(q, size * sizeof(event_t *));
-		if (tmp_q == NULL) {
-			fprintf(stderr, "Out of Memory. Check %s file, %d line", __FILE__, __LINE__);
-			pthread_mutex_unlock(&queue_lock);
-			return;
+		for (j = 0; j < LANE_MAX; j++) {
+			tmp_q = realloc(lanes[j].q, size * sizeof(event_t *));
+			if (tmp_q == NULL) {
+				fprintf(stderr, "Out of Memory. Check %s file, %d line", __FILE__, __LINE__);
+				pthread_mutex_unlock(&queue_lock);
+				return;
+			}
+			lanes[j].q = tmp_q;
+			for (i=q_depth; i<size; i++)
+				lanes[j].q[i] = NULL;
 		}
-		q = tmp_q;
-		for (i=q_depth; i<size; i++)
-			q[i] = NULL;
 		q_depth = size;
 		overflowed = 0;
 	}
@@ -255,6 +546,18 @@ void write_queue_state(FILE *f)
 				overflowed ? "yes" : "no");
 	fprintf(f, "plugin queueing suspended = %s\n",
 				processing_suspended ? "yes" : "no");
+	if (lanes_configured()) {
+		fprintf(f, "current priority lane depth = %u\n",
+				lanes[LANE_PRIORITY].used);
+		fprintf(f, "max priority lane depth used = %u\n",
+				lanes[LANE_PRIORITY].max_used);
+		fprintf(f, "current bulk lane depth = %u\n",
+				lanes[LANE_BULK].used);
+		fprintf(f, "max bulk lane depth used = %u\n",
+				lanes[LANE_BULK].max_used);
+		fprintf(f, "bulk events shed = %u\n", bulk_shed);
+	}
+	spill_write_state(f);
 }
 
 void resume_queue(void)
@@ -264,14 +567,21 @@ void resume_queue(void)
 
 void destroy_queue(void)
 {
-	unsigned int i;
-
-	for (i=0; i<q_depth; i++)
-		free((void *)q[i]);
+	unsigned int i, j;
 
-	free(q);
-	q_last = 0;
+	for (j = 0; j < LANE_MAX; j++) {
+		for (i=0; i<q_depth; i++)
+			free((void *)lanes[j].q[i]);
+		free(lanes[j].q);
+	}
+	memset(lanes, 0, sizeof(lanes));
+	memset(lane_credit, 0, sizeof(lane_credit));
+	free_lanes_config();
+	spill_destroy();
+	spill_on = 0;
+	spilling = 0;
 	q_depth = 0;
+	bulk_shed = 0;
 	processing_suspended = 1;
 	currently_used = 0;
 	max_used = 0;
@@ -30,6 +30,8 @@
 
 void reset_suspended(void);
 int init_queue(unsigned int size);
+void set_queue_spill(const char *dir, unsigned int max_mb);
+void set_queue_lanes(const struct disp_conf *config);
 int enqueue(event_t *e, struct disp_conf *config);
 event_t *dequeue(void);
 void nudge_queue(void);
@@ -0,0 +1,553 @@
+/* spill.c -- spill the dispatcher queue to disk
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+/*
+ * When a plugin falls behind, the dispatcher queue can spill events to a
+ * set of segment files instead of dropping them. Events are appended to
+ * the newest segment and replayed from the oldest one, and as long as
+ * anything is on disk new events go there too so the order is kept.
+ *
+ * Every segment starts with a header that records how far it has been
+ * replayed. It is rewritten every SPILL_SAVE_EVERY events and when the
+ * daemon stops, so after a crash up to that many events are replayed a
+ * second time. Records carry their length and a checksum. After a crash
+ * or restart the segments are scanned, a torn last record is cut off, and
+ * replay continues where it stopped. Nothing is fsync'ed, so this
+ * protects against the daemon dying, not against losing power.
+ *
+ * The disk is only touched under spill_lock, never under the queue lock,
+ * so a slow disk holds up the spilling and replay but not the rest of
+ * the queue.
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef HAVE_ATOMIC
+#include <stdatomic.h>
+#endif
+#include "spill.h"
+
+#define SPILL_MAGIC		"AUSPILL"
+#define SPILL_VERSION		1
+#define SPILL_SEGMENT_SIZE	(8 * 1024 * 1024)
+#define SPILL_PREFIX		"spill."
+#define SPILL_SAVE_EVERY	64	/* Replayed events per header update */
+
+struct seg_header
+{
+	char magic[8];		/* SPILL_MAGIC */
+	uint32_t version;	/* SPILL_VERSION */
+	uint32_t check;		/* Checksum of the header with this as 0 */
+	uint64_t seq;		/* Segment number, also in the file name */
+	uint64_t read_off;	/* Offset of the first record not replayed */
+};
+
+struct rec_header
+{
+	uint32_t len;		/* Bytes of dispatcher header and data */
+	uint32_t check;		/* Checksum of those bytes */
+};
+
+static pthread_mutex_t spill_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *spill_dir = NULL;
+static unsigned long max_bytes;		/* Disk space allowed for segments */
+static unsigned long disk_bytes;	/* Disk space used by segments */
+static ATOMIC_UNSIGNED pending;		/* Read without the lock */
+static unsigned int max_pending;
+static unsigned long long head_seq, tail_seq;
+static int rfd = -1, wfd = -1;
+static off_t woff;
+static struct seg_header rhdr;		/* Header of the segment being read */
+static unsigned int unsaved;		/* Replayed since rhdr was written */
+static unsigned char wbuf[sizeof(struct rec_header) +
+		sizeof(struct audit_dispatcher_header) +
+		MAX_AUDIT_MESSAGE_LENGTH];
+
+static uint32_t spill_check(const void *buf, size_t len)
+{
+	const unsigned char *ptr = buf;
+	uint32_t h = 2166136261U;
+
+	while (len--) {
+		h ^= *ptr++;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+/* Like pread(), except that it handles partial reads, and returns 0 on
+   success. */
+static int full_pread(int fd, void *buf, size_t size, off_t offset)
+{
+	while (size != 0) {
+		ssize_t res = pread(fd, buf, size, offset);
+
+		if (res < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (res == 0) {
+			errno = ENXIO;
+			return -1;
+		}
+		buf = (unsigned char *)buf + res;
+		size -= res;
+		offset += res;
+	}
+	return 0;
+}
+
+/* Like pwrite(), except that it handles partial writes, and returns 0 on
+   success. */
+static int full_pwrite(int fd, const void *buf, size_t size, off_t offset)
+{
+	while (size != 0) {
+		ssize_t res = pwrite(fd, buf, size, offset);
+
+		if (res < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (res == 0) {
+			errno = ENXIO;
+			return -1;
+		}
+		buf = (const unsigned char *)buf + res;
+		size -= res;
+		offset += res;
+	}
+	return 0;
+}
+
+static void seg_name(char *buf, size_t len, unsigned long long seq)
+{
+	snprintf(buf, len, "%s/%s%016llx", spill_dir, SPILL_PREFIX, seq);
+}
+
+static int write_seg_header(int fd, struct seg_header *h)
+{
+	h->check = 0;
+	h->check = spill_check(h, sizeof(*h));
+	return full_pwrite(fd, h, sizeof(*h), 0);
+}
+
+static int read_seg_header(int fd, struct seg_header *h)
+{
+	uint32_t check;
+
+	if (full_pread(fd, h, sizeof(*h), 0))
+		return 1;
+	check = h->check;
+	h->check = 0;
+	if (memcmp(h->magic, SPILL_MAGIC, sizeof(h->magic)) ||
+			h->version != SPILL_VERSION ||
+			spill_check(h, sizeof(*h)) != check ||
+			h->read_off < sizeof(*h))
+		return 1;
+	h->check = check;
+	return 0;
+}
+
+/*
+ * Read the record at off into e, which may be NULL to only validate it.
+ * Returns the offset of the next record or 0 if there is no valid record.
+ */
+static off_t read_record(int fd, off_t off, off_t end, event_t *e)
+{
+	struct rec_header rh;
+	unsigned char *buf = wbuf + sizeof(rh);
+	const struct audit_dispatcher_header *hdr;
+
+	if (off + (off_t)sizeof(rh) > end ||
+			full_pread(fd, &rh, sizeof(rh), off))
+		return 0;
+	if (rh.len < sizeof(*hdr) ||
+			rh.len > sizeof(*hdr) + MAX_AUDIT_MESSAGE_LENGTH ||
+			off + (off_t)(sizeof(rh) + rh.len) > end ||
+			full_pread(fd, buf, rh.len, off + sizeof(rh)) ||
+			spill_check(buf, rh.len) != rh.check)
+		return 0;
+	hdr = (const struct audit_dispatcher_header *)buf;
+	if (sizeof(*hdr) + hdr->size != rh.len)
+		return 0;
+	if (e) {
+		memcpy(&e->hdr, hdr, sizeof(*hdr));
+		memcpy(e->data, buf + sizeof(*hdr), hdr->size);
+	}
+	return off + sizeof(rh) + rh.len;
+}
+
+static int filter_segment(const struct dirent *d)
+{
+	return strncmp(d->d_name, SPILL_PREFIX, sizeof(SPILL_PREFIX)-1) == 0;
+}
+
+/*
+ * Pick up the segments left by an earlier run. Broken segments are
+ * removed and a torn record at the end of one is cut off.
+ */
+static void recover_segments(void)
+{
+	struct dirent **names;
+	int i, n, found = 0;
+
+	n = scandir(spill_dir, &names, filter_segment, alphasort);
+	if (n < 0)
+		return;
+
+	for (i = 0; i < n; i++) {
+		char path[PATH_MAX];
+		struct seg_header h;
+		struct stat sb;
+		unsigned int cnt = 0;
+		off_t off, next;
+		int fd;
+
+		snprintf(path, sizeof(path), "%s/%s", spill_dir,
+			names[i]->d_name);
+		free(names[i]);
+		fd = open(path, O_RDWR|O_CLOEXEC);
+		if (fd < 0)
+			continue;
+		if (fstat(fd, &sb) || read_seg_header(fd, &h)) {
+			syslog(LOG_WARNING,
+			    "Removing damaged queue spill segment %s", path);
+			close(fd);
+			unlink(path);
+			continue;
+		}
+		off = h.read_off;
+		while ((next = read_record(fd, off, sb.st_size, NULL))) {
+			off = next;
+			cnt++;
+		}
+		if (off < sb.st_size)
+			ftruncate(fd, off);
+		close(fd);
+		if (cnt == 0) {
+			unlink(path);
+			continue;
+		}
+		if (!found || h.seq < head_seq)
+			head_seq = h.seq;
+		if (!found || h.seq > tail_seq)
+			tail_seq = h.seq;
+		found = 1;
+		pending += cnt;
+		disk_bytes += off;
+	}
+	free(names);
+
+	if (pending) {
+		max_pending = pending;
+		syslog(LOG_NOTICE,
+			"Replaying %u queued events spilled to %s",
+			(unsigned int)pending, spill_dir);
+	}
+}
+
+int spill_init(const char *dir, unsigned int max_mb)
+{
+	if (spill_dir || dir == NULL)
+		return 0;
+
+	if (mkdir(dir, 0700) && errno != EEXIST) {
+		syslog(LOG_ERR, "Cannot create queue spill directory %s (%s)",
+			dir, strerror(errno));
+		return -1;
+	}
+	pthread_mutex_lock(&spill_lock);
+	spill_dir = strdup(dir);
+	if (spill_dir == NULL) {
+		pthread_mutex_unlock(&spill_lock);
+		return -1;
+	}
+	max_bytes = (unsigned long)max_mb * 1024 * 1024;
+	head_seq = tail_seq = 0;
+	recover_segments();
+	pthread_mutex_unlock(&spill_lock);
+	return 0;
+}
+
+void spill_set_max(unsigned int max_mb)
+{
+	pthread_mutex_lock(&spill_lock);
+	max_bytes = (unsigned long)max_mb * 1024 * 1024;
+	pthread_mutex_unlock(&spill_lock);
+}
+
+int spill_enabled(void)
+{
+	return spill_dir != NULL;
+}
+
+unsigned int spill_pending(void)
+{
+	return pending;
+}
+
+static int open_new_segment(void)
+{
+	struct seg_header h;
+	char path[PATH_MAX];
+
+	if (disk_bytes + sizeof(h) > max_bytes)
+		return 1;
+
+	tail_seq++;
+	if (pending == 0)
+		head_seq = tail_seq;
+	seg_name(path, sizeof(path), tail_seq);
+	wfd = open(path, O_RDWR|O_CREAT|O_TRUNC|O_CLOEXEC, 0600);
+	if (wfd < 0)
+		goto err;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, SPILL_MAGIC, sizeof(h.magic));
+	h.version = SPILL_VERSION;
+	h.seq = tail_seq;
+	h.read_off = sizeof(h);
+	if (write_seg_header(wfd, &h)) {
+		close(wfd);
+		wfd = -1;
+		unlink(path);
+		goto err;
+	}
+	woff = sizeof(h);
+	disk_bytes += sizeof(h);
+	return 0;
+err:
+	syslog(LOG_ERR, "Cannot create queue spill segment %s (%s)",
+		path, strerror(errno));
+	return 1;
+}
+
+static int write_record(const event_t *e)
+{
+	struct rec_header *rh = (struct rec_header *)wbuf;
+	unsigned char *buf = wbuf + sizeof(*rh);
+	size_t len;
+
+	if (spill_dir == NULL || e->hdr.size > MAX_AUDIT_MESSAGE_LENGTH)
+		return 1;
+
+	rh->len = sizeof(e->hdr) + e->hdr.size;
+	len = sizeof(*rh) + rh->len;
+	if (wfd >= 0 && woff + (off_t)len > SPILL_SEGMENT_SIZE) {
+		close(wfd);
+		wfd = -1;
+	}
+	if (wfd < 0 && open_new_segment())
+		return 1;
+	if (disk_bytes + len > max_bytes)
+		return 1;
+
+	memcpy(buf, &e->hdr, sizeof(e->hdr));
+	memcpy(buf + sizeof(e->hdr), e->data, e->hdr.size);
+	rh->check = spill_check(buf, rh->len);
+	if (full_pwrite(wfd, wbuf, len, woff)) {
+		syslog(LOG_ERR, "Cannot write to queue spill segment (%s)",
+			strerror(errno));
+		return 1;
+	}
+	woff += len;
+	disk_bytes += len;
+	pending++;
+	if (pending > max_pending)
+		max_pending = pending;
+	return 0;
+}
+
+/* Returns 0 if the event is on disk and 1 if it could not be spilled */
+int spill_write(const event_t *e)
+{
+	int rc;
+
+	pthread_mutex_lock(&spill_lock);
+	rc = write_record(e);
+	pthread_mutex_unlock(&spill_lock);
+	return rc;
+}
+
+static void remove_segment(unsigned long long seq)
+{
+	char path[PATH_MAX];
+	struct stat sb;
+
+	seg_name(path, sizeof(path), seq);
+	if (stat(path, &sb) == 0) {
+		if ((unsigned long)sb.st_size > disk_bytes)
+			disk_bytes = 0;
+		else
+			disk_bytes -= sb.st_size;
+	}
+	unlink(path);
+}
+
+/* Everything was replayed, start over with an empty directory */
+static void spill_reset(void)
+{
+	unsigned long long seq;
+
+	if (rfd >= 0)
+		close(rfd);
+	if (wfd >= 0)
+		close(wfd);
+	rfd = wfd = -1;
+	for (seq = head_seq; seq <= tail_seq; seq++)
+		remove_segment(seq);
+	head_seq = tail_seq + 1;
+	pending = 0;
+	disk_bytes = 0;
+	unsaved = 0;
+}
+
+static event_t *read_oldest(void)
+{
+	event_t *e;
+
+	if (pending == 0)
+		return NULL;
+
+	e = malloc(sizeof(event_t));
+	if (e == NULL)
+		return NULL;
+
+	while (head_seq <= tail_seq) {
+		off_t end, next;
+
+		if (rfd < 0) {
+			char path[PATH_MAX];
+
+			seg_name(path, sizeof(path), head_seq);
+			rfd = open(path, O_RDWR|O_CLOEXEC);
+			unsaved = 0;
+			if (rfd < 0 || read_seg_header(rfd, &rhdr)) {
+				if (rfd >= 0)
+					close(rfd);
+				rfd = -1;
+				remove_segment(head_seq++);
+				continue;
+			}
+		}
+
+		// The segment being written ends where the writer is
+		if (head_seq == tail_seq && wfd >= 0)
+			end = woff;
+		else {
+			struct stat sb;
+
+			end = fstat(rfd, &sb) ? 0 : sb.st_size;
+		}
+
+		next = read_record(rfd, rhdr.read_off, end, e);
+		if (next == 0) {
+			if (rhdr.read_off < (uint64_t)end)
+				syslog(LOG_ERR,
+	    "Queue spill segment %llu is damaged, skipping the rest of it",
+					head_seq);
+			close(rfd);
+			rfd = -1;
+			if (head_seq == tail_seq)
+				break;
+			remove_segment(head_seq++);
+			continue;
+		}
+
+		// Remember how far we got in case of a restart
+		rhdr.read_off = next;
+		if (++unsaved >= SPILL_SAVE_EVERY) {
+			write_seg_header(rfd, &rhdr);
+			unsaved = 0;
+		}
+		if (--pending == 0)
+			spill_reset();
+		return e;
+	}
+
+	// The count and the segments disagree, trust the segments
+	syslog(LOG_ERR, "Queue spill lost track of %u events",
+		(unsigned int)pending);
+	spill_reset();
+	free(e);
+	return NULL;
+}
+
+/* Returns the oldest spilled event or NULL if there is none */
+event_t *spill_read(void)
+{
+	event_t *e;
+
+	pthread_mutex_lock(&spill_lock);
+	e = read_oldest();
+	pthread_mutex_unlock(&spill_lock);
+	return e;
+}
+
+void spill_write_state(FILE *f)
+{
+	pthread_mutex_lock(&spill_lock);
+	if (spill_dir) {
+		fprintf(f, "plugin queue spill directory = %s\n", spill_dir);
+		fprintf(f, "current plugin queue spilled events = %u\n",
+			(unsigned int)pending);
+		fprintf(f, "max plugin queue spilled events = %u\n",
+			max_pending);
+		fprintf(f, "plugin queue spill bytes used = %lu\n",
+			disk_bytes);
+		fprintf(f, "plugin queue spill bytes allowed = %lu\n",
+			max_bytes);
+	}
+	pthread_mutex_unlock(&spill_lock);
+}
+
+/* Spilled events stay on disk so that they are replayed on restart */
+void spill_destroy(void)
+{
+	pthread_mutex_lock(&spill_lock);
+	if (rfd >= 0 && unsaved)
+		write_seg_header(rfd, &rhdr);
+	unsaved = 0;
+	if (rfd >= 0)
+		close(rfd);
+	if (wfd >= 0)
+		close(wfd);
+	rfd = wfd = -1;
+	free(spill_dir);
+	spill_dir = NULL;
+	pending = 0;
+	max_pending = 0;
+	disk_bytes = 0;
+	pthread_mutex_unlock(&spill_lock);
+}
@@ -0,0 +1,40 @@
+/* spill.h -- spill the dispatcher queue to disk
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#ifndef SPILL_HEADER
+#define SPILL_HEADER
+
+#include <stdio.h>
+#include "libdisp.h"
+
+/* These take their own lock. Don't call them with the queue lock held,
+ * spill_write and spill_read wait on the disk. */
+int spill_init(const char *dir, unsigned int max_mb);
+void spill_set_max(unsigned int max_mb);
+int spill_enabled(void);
+unsigned int spill_pending(void);
+int spill_write(const event_t *e);
+event_t *spill_read(void);
+void spill_write_state(FILE *f);
+void spill_destroy(void);
+
+#endif
@@ -0,0 +1,136 @@
+/* test-filter.c -- test suite for the plugin interest filters
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "event-fields.h"
+
+#define EVENTS 40
+
+static event_t e;
+
+static int wants(plugin_conf_t *p, int type, const char *fmt,
+		 unsigned int sec, unsigned int serial, const char *rest)
+{
+	struct filter_info fi;
+
+	memset(&fi, 0, sizeof(fi));
+	e.hdr.ver = AUDISP_PROTOCOL_VER;
+	e.hdr.type = type;
+	e.hdr.size = snprintf(e.data, sizeof(e.data), fmt, sec, serial, rest);
+	return plugin_wants(p, &e, &fi);
+}
+
+#define STAMP "audit(%u.000:%u): %s"
+
+int main(void)
+{
+	char *keys[] = { "wanted" };
+	plugin_conf_t p;
+	int i;
+
+	memset(&p, 0, sizeof(p));
+	p.keys = keys;
+	p.nkeys = 1;
+	evcache_init(&p.key_events);
+
+	// Open many events at once, every third one has the key
+	for (i = 0; i < EVENTS; i++) {
+		int w = wants(&p, AUDIT_SYSCALL, STAMP, 1700000000, 100 + i,
+			i % 3 ? "syscall=2 key=\"other\"" :
+				"syscall=2 key=\"wanted\"");
+		if (w != !(i % 3)) {
+			printf("Test failed - SYSCALL of event %d\n", i);
+			return 1;
+		}
+	}
+	// The other records carry no key and follow the first record
+	for (i = EVENTS - 1; i >= 0; i--) {
+		if (wants(&p, AUDIT_PATH, STAMP, 1700000000, 100 + i,
+				"item=0") != !(i % 3)) {
+			printf("Test failed - PATH of event %d\n", i);
+			return 1;
+		}
+	}
+	// The same serial at another time is another event
+	if (wants(&p, AUDIT_PATH, STAMP, 1700000001, 100, "item=0") ||
+			wants(&p, AUDIT_EOE, STAMP, 1700000001, 100, "")) {
+		puts("Test failed - unrelated event took a cached answer");
+		return 1;
+	}
+	for (i = 0; i < EVENTS; i++) {
+		if (wants(&p, AUDIT_EOE, STAMP, 1700000000, 100 + i, "") !=
+				!(i % 3)) {
+			printf("Test failed - EOE of event %d\n", i);
+			return 1;
+		}
+	}
+	if (p.key_events.used != 0) {
+		printf("Test failed - %u events left open\n",
+			p.key_events.used);
+		return 1;
+	}
+
+	// Record types are checked per record
+	p.nkeys = 0;
+	p.types = calloc(MAX_PLUGIN_TYPE / 8, 1);
+	if (p.types == NULL)
+		return 1;
+	p.types[AUDIT_EXECVE / 8] |= 1 << (AUDIT_EXECVE % 8);
+	if (!wants(&p, AUDIT_EXECVE, STAMP, 1700000002, 1, "argc=1") ||
+		    wants(&p, AUDIT_SYSCALL, STAMP, 1700000002, 1, "syscall=59")) {
+		puts("Test failed - type filter");
+		return 1;
+	}
+
+	// Both filters together: the key decision from a SYSCALL record the
+	// type filter drops still applies to the event's other records
+	memset(p.types, 0, MAX_PLUGIN_TYPE / 8);
+	p.types[AUDIT_PATH / 8] |= 1 << (AUDIT_PATH % 8);
+	p.nkeys = 1;
+	if (wants(&p, AUDIT_SYSCALL, STAMP, 1700000003, 1,
+			"syscall=2 key=\"wanted\"") ||
+		    !wants(&p, AUDIT_PATH, STAMP, 1700000003, 1, "item=0") ||
+		    wants(&p, AUDIT_CWD, STAMP, 1700000003, 1, "cwd=\"/\"") ||
+		    wants(&p, AUDIT_EOE, STAMP, 1700000003, 1, "")) {
+		puts("Test failed - type and key filters together");
+		return 1;
+	}
+	if (wants(&p, AUDIT_SYSCALL, STAMP, 1700000003, 2,
+			"syscall=2 key=\"other\"") ||
+		    wants(&p, AUDIT_PATH, STAMP, 1700000003, 2, "item=0") ||
+		    wants(&p, AUDIT_EOE, STAMP, 1700000003, 2, "")) {
+		puts("Test failed - type filter let in an unwanted key");
+		return 1;
+	}
+	if (p.key_events.used != 0) {
+		printf("Test failed - %u events left open\n",
+			p.key_events.used);
+		return 1;
+	}
+	free(p.types);
+	evcache_clear(&p.key_events);
+	puts("filter test passed");
+	return 0;
+}
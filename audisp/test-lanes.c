@@ -0,0 +1,138 @@
+/* test-lanes.c -- test suite for the dispatcher queue lanes
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_ATOMIC
+#include <stdatomic.h>
+#endif
+#include "queue.h"
+
+#define DEPTH 8
+
+volatile ATOMIC_INT disp_hup = 0;
+static struct disp_conf config;
+
+static int put(int type, unsigned int sec, unsigned int serial,
+	       const char *rest)
+{
+	event_t *e = calloc(1, sizeof(event_t));
+
+	if (e == NULL)
+		exit(1);
+	e->hdr.ver = AUDISP_PROTOCOL_VER;
+	e->hdr.hlen = sizeof(e->hdr);
+	e->hdr.type = type;
+	e->hdr.size = snprintf(e->data, sizeof(e->data),
+			"type=%s msg=audit(%u.000:%u): %s",
+			audit_msg_type_to_name(type), sec, serial, rest);
+	return enqueue(e, &config);
+}
+
+/* Checks the type and serial of the next event out of the queue */
+static int get(int type, unsigned int serial)
+{
+	event_t *e = dequeue();
+	char want[32];
+	int rc;
+
+	if (e == NULL) {
+		printf("Test failed - no event, wanted serial %u\n", serial);
+		return 1;
+	}
+	snprintf(want, sizeof(want), ":%u)", serial);
+	rc = e->hdr.type != type || strstr(e->data, want) == NULL;
+	if (rc)
+		printf("Test failed - wanted type %d serial %u, got %.*s\n",
+			type, serial, (int)e->hdr.size, e->data);
+	free(e);
+	return rc;
+}
+
+int main(void)
+{
+	unsigned int i;
+
+	memset(&config, 0, sizeof(config));
+	config.q_depth = DEPTH;
+	config.overflow_action = O_IGNORE;
+	config.q_priority_keys = "hot";
+	config.q_bulk_types = "USER_LOGIN";
+	if (init_queue(DEPTH)) {
+		puts("Test failed - queue not set up");
+		return 1;
+	}
+	set_queue_lanes(&config);
+
+	// Interleaved events each keep to the lane of their first record
+	put(AUDIT_SYSCALL, 100, 1, "syscall=2 key=\"cold\"");
+	put(AUDIT_SYSCALL, 100, 2, "syscall=2 key=\"hot\"");
+	put(AUDIT_PATH, 100, 1, "item=0 name=\"/a\"");
+	put(AUDIT_PATH, 100, 2, "item=0 name=\"/b\"");
+	put(AUDIT_EOE, 100, 2, "");
+	put(AUDIT_EOE, 100, 1, "");
+	if (get(AUDIT_SYSCALL, 2) || get(AUDIT_PATH, 2) || get(AUDIT_EOE, 2) ||
+	    get(AUDIT_SYSCALL, 1) || get(AUDIT_PATH, 1) || get(AUDIT_EOE, 1))
+		return 1;
+
+	// The same serial in another second is another event
+	put(AUDIT_SYSCALL, 100, 3, "syscall=2 key=\"hot\"");
+	put(AUDIT_PATH, 101, 3, "item=0 name=\"/c\"");
+	put(AUDIT_PATH, 100, 3, "item=0 name=\"/c\"");
+	if (get(AUDIT_SYSCALL, 3) || get(AUDIT_PATH, 3))
+		return 1;
+	{
+		event_t *e = dequeue();
+
+		if (e == NULL || strstr(e->data, "(101.000:3)") == NULL) {
+			puts("Test failed - unrelated event took a lane");
+			return 1;
+		}
+		free(e);
+	}
+	put(AUDIT_EOE, 100, 3, "");
+	if (get(AUDIT_EOE, 3))
+		return 1;
+
+	// The lanes share the depth, with the top eighth kept for priority
+	for (i = 0; i < DEPTH - 1; i++)
+		put(AUDIT_USER, 200, 10 + i, "msg='x'");
+	put(AUDIT_USER_LOGIN, 200, 20, "msg='op=login'");
+	put(AUDIT_USER, 200, 21, "msg='op=x key=\"hot\"'");
+	put(AUDIT_USER, 200, 22, "msg='x'");
+	if (get(AUDIT_USER, 21))
+		return 1;
+	for (i = 0; i < DEPTH - 1; i++)
+		if (get(AUDIT_USER, 10 + i))
+			return 1;
+
+	// Nothing else should be left
+	put(AUDIT_USER, 200, 30, "msg='x'");
+	if (get(AUDIT_USER, 30))
+		return 1;
+
+	destroy_queue();
+	puts("lanes test passed");
+	return 0;
+}
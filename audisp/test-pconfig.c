@@ -0,0 +1,115 @@
+/* test-pconfig.c -- test suite for the plugin config parser
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This software may be freely redistributed and/or modified under the
+ * terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING. If not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+ * Boston, MA 02110-1335, USA.
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "audispd-pconfig.h"
+
+static char filename[] = "/tmp/pcXXXXXX";
+
+/* Writes text to the plugin config file and loads it */
+static int load(plugin_conf_t *config, const char *text)
+{
+	FILE *f = fopen(filename, "w");
+
+	if (f == NULL)
+		return -1;
+	fputs(text, f);
+	fclose(f);
+	return load_pconfig(config, filename);
+}
+
+static int wants_type(const plugin_conf_t *config, int type)
+{
+	return (config->types[type / 8] >> (type % 8)) & 1;
+}
+
+static void cleanup(void)
+{
+	unlink(filename);
+}
+
+int main(void)
+{
+	plugin_conf_t config;
+	int fd;
+
+	if (geteuid() != 0) {
+		puts("config files must be owned by root, skipped");
+		return 77;
+	}
+	fd = mkstemp(filename);
+	if (fd < 0) {
+		puts("Test failed - cannot make the config file");
+		return 1;
+	}
+	close(fd);
+	atexit(cleanup);
+
+	// Without filters a plugin gets everything as text
+	if (load(&config, "active = no\n") || config.types || config.keys ||
+			config.nkeys || config.format != F_STRING) {
+		puts("Test failed - plugin defaults");
+		return 1;
+	}
+	free_pconfig(&config);
+
+	// Lists may be split by commas, spaces, or repeated lines
+	if (load(&config, "event_types = SYSCALL,EXECVE USER_LOGIN\n"
+			"event_types = path\n"
+			"event_keys = passwd, shadow\n"
+			"event_keys = sudo\n"
+			"format = framed\n") ||
+			config.types == NULL ||
+			!wants_type(&config, AUDIT_SYSCALL) ||
+			!wants_type(&config, AUDIT_EXECVE) ||
+			!wants_type(&config, AUDIT_USER_LOGIN) ||
+			!wants_type(&config, AUDIT_PATH) ||
+			wants_type(&config, AUDIT_CWD) ||
+			wants_type(&config, AUDIT_EOE) ||
+			config.nkeys != 3 || strcmp(config.keys[0], "passwd") ||
+			strcmp(config.keys[1], "shadow") ||
+			strcmp(config.keys[2], "sudo") ||
+			config.format != F_FRAMED) {
+		puts("Test failed - filter and format options");
+		return 1;
+	}
+	free_pconfig(&config);
+
+	if (load(&config, "event_types = SYSCALL,NOT_A_TYPE\n") == 0) {
+		puts("Test failed - unknown event type accepted");
+		return 1;
+	}
+	free_pconfig(&config);
+	if (load(&config, "format = frames\n") == 0) {
+		puts("Test failed - unknown format accepted");
+		return 1;
+	}
+	free_pconfig(&config);
+
+	puts("pconfig test passed");
+	return 0;
+}
@@ -0,0 +1,196 @@
+/* test-spill.c -- test suite for the dispatcher queue spill
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "spill.h"
+
+#define EVENTS	100
+#define FIRST	40
+
+static char dir[] = "/tmp/test-spill.XXXXXX";
+
+static int put(unsigned int n, size_t size)
+{
+	event_t e;
+
+	memset(&e, 0, sizeof(e));
+	e.hdr.ver = AUDISP_PROTOCOL_VER;
+	e.hdr.hlen = sizeof(e.hdr);
+	e.hdr.type = AUDIT_SYSCALL;
+	snprintf(e.data, sizeof(e.data), "event %u", n);
+	e.hdr.size = size ? size : strlen(e.data);
+	return spill_write(&e);
+}
+
+static int get(unsigned int n)
+{
+	event_t *e = spill_read();
+	char want[32];
+	int rc;
+
+	if (e == NULL) {
+		printf("Test failed - event %u missing\n", n);
+		return 1;
+	}
+	snprintf(want, sizeof(want), "event %u", n);
+	rc = e->hdr.type != AUDIT_SYSCALL || e->hdr.size < strlen(want) ||
+		strncmp(e->data, want, strlen(want)) ||
+		(e->hdr.size > strlen(want) && e->data[strlen(want)]);
+	if (rc)
+		printf("Test failed - wanted %s, got %.*s\n", want,
+			(int)e->hdr.size, e->data);
+	free(e);
+	return rc;
+}
+
+/* Appends a partial record to every segment, like a crash would */
+static void tear_segments(void)
+{
+	struct dirent *d;
+	DIR *dp = opendir(dir);
+
+	while ((d = readdir(dp))) {
+		char path[PATH_MAX];
+		int fd;
+
+		if (strncmp(d->d_name, "spill.", 6))
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", dir, d->d_name);
+		fd = open(path, O_WRONLY|O_APPEND);
+		write(fd, "\x40\0\0\0torn", 8);
+		close(fd);
+	}
+	closedir(dp);
+}
+
+static void cleanup(void)
+{
+	struct dirent *d;
+	DIR *dp = opendir(dir);
+
+	while ((d = readdir(dp))) {
+		char path[PATH_MAX];
+
+		if (d->d_name[0] == '.')
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", dir, d->d_name);
+		unlink(path);
+	}
+	closedir(dp);
+	rmdir(dir);
+}
+
+static int run(void)
+{
+	unsigned int i, n;
+
+	if (spill_init(dir, 1) || !spill_enabled()) {
+		puts("Test failed - spill not started");
+		return 1;
+	}
+
+	// Events come back in the order they went out
+	for (i = 0; i < EVENTS; i++) {
+		if (put(i, 0)) {
+			printf("Test failed - event %u not spilled\n", i);
+			return 1;
+		}
+	}
+	for (i = 0; i < FIRST; i++)
+		if (get(i))
+			return 1;
+	if (spill_pending() != EVENTS - FIRST) {
+		printf("Test failed - %u pending\n", spill_pending());
+		return 1;
+	}
+
+	// A restart picks up where replay stopped
+	spill_destroy();
+	if (spill_init(dir, 1) || spill_pending() != EVENTS - FIRST) {
+		printf("Test failed - %u recovered\n", spill_pending());
+		return 1;
+	}
+	for (i = FIRST; i < EVENTS; i++)
+		if (get(i))
+			return 1;
+	if (spill_read() != NULL || spill_pending()) {
+		puts("Test failed - spill not empty");
+		return 1;
+	}
+
+	// A torn record at the end is cut off and the rest is kept
+	for (i = 0; i < 3; i++)
+		put(i, 0);
+	spill_destroy();
+	tear_segments();
+	if (spill_init(dir, 1) || spill_pending() != 3) {
+		printf("Test failed - %u recovered after tear\n",
+			spill_pending());
+		return 1;
+	}
+	put(3, 0);
+	for (i = 0; i < 4; i++)
+		if (get(i))
+			return 1;
+
+	// Nothing is written past the limit, and what fit is kept
+	for (n = 0; n < 1024; n++)
+		if (put(n, MAX_AUDIT_MESSAGE_LENGTH))
+			break;
+	if (n == 0 || n >= 1024 ||
+			(unsigned long)n * MAX_AUDIT_MESSAGE_LENGTH > 1024*1024) {
+		printf("Test failed - %u large events fit\n", n);
+		return 1;
+	}
+	for (i = 0; i < n; i++)
+		if (get(i))
+			return 1;
+	if (put(n, 0) || get(n)) {
+		puts("Test failed - spill not usable after draining");
+		return 1;
+	}
+	spill_destroy();
+	return 0;
+}
+
+int main(void)
+{
+	int rc;
+
+	if (mkdtemp(dir) == NULL) {
+		puts("Test failed - no temp dir");
+		return 1;
+	}
+	rc = run();
+	spill_destroy();
+	cleanup();
+	if (rc == 0)
+		puts("spill test passed");
+	return rc;
+}
@@ -35,7 +35,8 @@ extern "C" {
 /* This tells the library where the data source is located */
 typedef enum { AUSOURCE_LOGS, AUSOURCE_FILE, AUSOURCE_FILE_ARRAY, 
 	AUSOURCE_BUFFER, AUSOURCE_BUFFER_ARRAY,
-	AUSOURCE_DESCRIPTOR, AUSOURCE_FILE_POINTER, AUSOURCE_FEED } ausource_t;
+	AUSOURCE_DESCRIPTOR, AUSOURCE_FILE_POINTER, AUSOURCE_FEED,
+	AUSOURCE_FEED_FRAMED } ausource_t;
 
 /* This used to define the types of searches that can be done.  It is not used
    any more. */
@@ -103,6 +104,17 @@ typedef enum { AUPARSE_DESTROY_ALL,
 /* auparse_normalize options */
 typedef enum { NORM_OPT_ALL, NORM_OPT_NO_ATTRS} normalize_option_t;
 
+/* auparse_snapshot_event options */
+typedef enum { AUPARSE_SNAPSHOT_RAW,
+	AUPARSE_SNAPSHOT_INTERPRET } auparse_snapshot_mode_t;
+
+/* One argument from auparse_get_execve_argv. It is not NUL terminated. */
+typedef struct
+{
+	const char *ptr;	// Start of the argument
+	size_t len;		// Its length in bytes
+} auparse_arg_t;
+
 
 #ifdef __cplusplus
 }
@@ -33,9 +33,11 @@
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <stdio_ext.h>
 #include <limits.h>
 #include "common.h"
+#include "audit-frame.h"
 
 //#define LOL_EVENTS_DEBUG01	1	// add debug for list of list event
 					// processing
@@ -555,6 +557,7 @@ auparse_state_t *auparse_init(ausource_t source, const void *b)
 			au->in = (FILE *)b;
 			break;
 		case AUSOURCE_FEED:
+		case AUSOURCE_FEED_FRAMED:
                     if (databuf_init(&au->databuf, 0, 0) < 0) goto bad_exit;
 			break;
 		default:
@@ -574,6 +577,12 @@ auparse_state_t *auparse_init(ausource_t source, const void *b)
 	au->find_field = NULL;
 	au->search_where = AUSEARCH_STOP_EVENT;
 	au->tmp_translation = NULL;
+	au->seek_active = 0;
+	au->seek_lines = 0;
+	au->frame_fields = NULL;
+	au->frame_nfields = 0;
+	au->frame_size = 0;
+	au->frame_e.sec = 0;
 	init_normalizer(&au->norm_data);
 
 	return au;
@@ -756,6 +765,8 @@ int auparse_reset(auparse_state_t *au)
 	au->parse_state = EVENT_EMPTY;
 	au->au_ready = 0;
 	au->le = NULL;
+	au->seek_active = 0;
+	au->seek_lines = 0;
 
 	switch (au->source)
 	{
@@ -1037,6 +1048,7 @@ static void auparse_destroy_common(auparse_state_t *au)
 	clear_normalizer(&au->norm_data);
 	au_lol_clear(au->au_lo, 0);
 	free((void *)au->tmp_translation);
+	free(au->frame_fields);
 	free(au->au_lo);
 	free(au);
 }
@@ -1173,6 +1185,87 @@ static int readline_buf(auparse_state_t *au)
 	}
 }
 
+/*
+ * Framed feeds carry records from the dispatcher with the field table
+ * and time stamp already worked out. Anything not starting with the frame
+ * magic is taken to be a text line so that the string format still works.
+ * Same return values as readline_buf.
+ */
+static int readline_frame(auparse_state_t *au)
+{
+	struct audit_frame_header hdr;
+	size_t flen, total;
+	const char *beg;
+	unsigned int i;
+
+	au->frame_nfields = 0;
+	au->frame_e.sec = 0;
+	while (au->databuf.len && *databuf_beg(&au->databuf) == 0x1E) {
+		if (au->databuf.len < sizeof(hdr)) {
+			errno = 0;
+			return 0;
+		}
+		beg = databuf_beg(&au->databuf);
+		memcpy(&hdr, beg, sizeof(hdr));
+		if (memcmp(hdr.magic, AUDISP_FRAME_MAGIC, sizeof(hdr.magic)) ||
+		    hdr.ver != AUDISP_FRAME_VER || hdr.hlen < sizeof(hdr) ||
+		    hdr.size == 0 || hdr.size > MAX_AUDIT_MESSAGE_LENGTH * 2 ||
+		    hdr.nfields > hdr.size) {
+			// Garbage, skip to where it might make sense again
+			if (databuf_advance(&au->databuf, 1) < 0)
+				return -1;
+			continue;
+		}
+		flen = hdr.nfields * sizeof(struct audit_frame_field);
+		total = hdr.hlen + flen + hdr.size;
+		if (au->databuf.len < total) {
+			errno = 0;
+			return 0;
+		}
+
+		free(au->cur_buf);
+		au->cur_buf = malloc(hdr.size + 1);
+		if (au->cur_buf == NULL)
+			return -1;
+		memcpy(au->cur_buf, beg + hdr.hlen + flen, hdr.size);
+		if (au->cur_buf[hdr.size - 1] == '\n')
+			hdr.size--;
+		au->cur_buf[hdr.size] = 0;
+
+		if (hdr.nfields > au->frame_size) {
+			struct audit_frame_field *tmp;
+
+			tmp = realloc(au->frame_fields, flen);
+			if (tmp == NULL)
+				return -1;
+			au->frame_fields = tmp;
+			au->frame_size = hdr.nfields;
+		}
+		memcpy(au->frame_fields, beg + hdr.hlen, flen);
+		// Don't trust a table that points outside the record
+		for (i = 0; i < hdr.nfields; i++) {
+			const struct audit_frame_field *f =
+						&au->frame_fields[i];
+
+			if (f->name_off + f->name_len > hdr.size ||
+			    (f->val_off && (f->val_off !=
+					f->name_off + f->name_len + 1 ||
+				f->val_off + f->val_len > hdr.size)))
+				break;
+		}
+		au->frame_nfields = i == hdr.nfields ? hdr.nfields : 0;
+		au->frame_e.sec = hdr.sec;
+		au->frame_e.milli = hdr.milli;
+		au->frame_e.serial = hdr.serial;
+
+		if (databuf_advance(&au->databuf, total) < 0)
+			return -1;
+		errno = 0;
+		return 1;
+	}
+	return readline_buf(au);
+}
+
 static int str2event(char *s, au_event_t *e)
 {
 	char *ptr;
@@ -1260,6 +1353,28 @@ static int extract_timestamp(const char *b, au_event_t *e)
 	return rc;
 }
 
+/*
+ * Use the time stamp of a framed record if it has one. The node is the
+ * first field when there is one.
+ */
+static int get_timestamp(const auparse_state_t *au, au_event_t *e)
+{
+	const struct audit_frame_field *f = au->frame_fields;
+
+	if (au->frame_e.sec == 0)
+		return extract_timestamp(au->cur_buf, e);
+
+	*e = au->frame_e;
+	e->host = NULL;
+	if (au->frame_nfields && f->val_off && f->name_len == 4 &&
+			memcmp(au->cur_buf + f->name_off, "node", 4) == 0) {
+		e->host = strndup(au->cur_buf + f->val_off, f->val_len);
+		if (e->host == NULL)
+			return 1;
+	}
+	return 0;
+}
+
 static int events_are_equal(const au_event_t *e1, const au_event_t *e2)
 {
 	// Check time & serial first since its most likely way
@@ -1279,6 +1394,15 @@ static int events_are_equal(const au_event_t *e1, const au_event_t *e2)
 	return 1;
 }
 
+/*
+ * The line number of the record just read. After a seek the lines before
+ * the seek point were never counted, so 0 is returned for that file.
+ */
+static unsigned int current_line(const auparse_state_t *au)
+{
+	return au->seek_lines ? 0 : au->line_number;
+}
+
 /* This function will figure out how to get the next line of input.
  * storing it cur_buf. cur_buf will be NULL terminated but will not
  * contain a trailing newline. This implies a successful read
@@ -1345,6 +1469,7 @@ static int retrieve_next_line(auparse_state_t *au)
 					au->in = NULL;
 					au->list_idx++;
 					au->line_number = 0;
+					au->seek_lines = 0;
 					if (au->source_list[au->list_idx]) {
 						au->in = fopen(
 						  au->source_list[au->list_idx],
@@ -1368,7 +1493,11 @@ static int retrieve_next_line(auparse_state_t *au)
 				au->line_number++;
 			return rc;
 		case AUSOURCE_FEED:
-			rc = readline_buf(au);
+		case AUSOURCE_FEED_FRAMED:
+			if (au->source == AUSOURCE_FEED_FRAMED)
+				rc = readline_frame(au);
+			else
+				rc = readline_buf(au);
 			// No such thing as EOF for feed, translate EOF
 			// to data not available
 			if (rc == -2)
@@ -1383,6 +1512,140 @@ static int retrieve_next_line(auparse_state_t *au)
 	return -1;		/* should never reach here */
 }
 
+/*
+ * Seeking in file sources. A log is written in time order except that
+ * records of events that are in flight at the same time interleave. The
+ * position is found by bisecting on the byte offset. Each probe skips to
+ * the next line and reads the stamp of the first record there. Reading
+ * then starts an end of event timeout earlier than asked for so that events
+ * straddling that point are complete. Events stamped before the target
+ * are skipped by auparse_next_event().
+ */
+#define SEEK_LINEAR	8192	// Read lines once the range is this small
+
+static int seek_is_before(const au_event_t *e, time_t sec, unsigned int milli)
+{
+	return e->sec < sec || (e->sec == sec && e->milli < milli);
+}
+
+/*
+ * Find the first record that starts at or after off and has a timestamp.
+ * Unless off is 0 it is taken to be inside a line which is skipped.
+ * Returns 0 with its offset in pos, 1 if there is none, and -1 on error.
+ */
+static int seek_probe(FILE *f, off_t off, off_t *pos, au_event_t *e)
+{
+	char *buf = NULL;
+	size_t n = 0;
+	ssize_t len;
+	int rc = 1;
+
+	if (fseeko(f, off, SEEK_SET))
+		return -1;
+	if (off) {
+		len = getline(&buf, &n, f);
+		if (len <= 0) {
+			free(buf);
+			return 1;
+		}
+		off += len;
+	}
+	while ((len = getline(&buf, &n, f)) > 0) {
+		if (extract_timestamp(buf, e) == 0) {
+			free((void *)e->host);
+			e->host = NULL;
+			*pos = off;
+			rc = 0;
+			break;
+		}
+		off += len;
+	}
+	free(buf);
+	return rc;
+}
+
+/*
+ * Returns the offset of the last record boundary known to be stamped
+ * before sec.milli, or 0. hi always has the first record at or after it
+ * stamped at or after the target, so the answer is between lo and hi.
+ */
+static off_t seek_bisect(FILE *f, time_t sec, unsigned int milli)
+{
+	struct stat st;
+	off_t lo = 0, hi, pos;
+	au_event_t e;
+
+	if (fstat(fileno(f), &st))
+		return 0;
+	hi = st.st_size;
+	while (hi - lo > SEEK_LINEAR) {
+		off_t mid = lo + (hi - lo) / 2;
+
+		if (seek_probe(f, mid, &pos, &e) == 0 && pos < hi &&
+				seek_is_before(&e, sec, milli))
+			lo = pos;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+int auparse_seek_time(auparse_state_t *au, time_t sec, unsigned int milli)
+{
+	time_t start_sec;
+	au_event_t e;
+	off_t off;
+	FILE *f = NULL;
+	int idx;
+
+	if (au == NULL || milli > 999 || au->source_list == NULL ||
+	    (au->source != AUSOURCE_FILE && au->source != AUSOURCE_LOGS &&
+	     au->source != AUSOURCE_FILE_ARRAY)) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (auparse_reset(au))
+		return -1;
+
+	start_sec = sec > eoe_timeout ? sec - eoe_timeout : 0;
+
+	// Files are oldest first, use the last one starting before the target
+	for (idx = 0; au->source_list[idx]; idx++)
+		;
+	while (idx > 0) {
+		idx--;
+		f = fopen(au->source_list[idx], "rm");
+		if (f == NULL)
+			return -1;
+		if (seek_probe(f, 0, &off, &e) == 0 &&
+				seek_is_before(&e, start_sec, milli))
+			break;
+		if (idx)
+			fclose(f);
+	}
+	if (f == NULL) {
+		errno = 0;
+		return 0;
+	}
+	__fsetlocking(f, FSETLOCKING_BYCALLER);
+
+	off = seek_bisect(f, start_sec, milli);
+	if (fseeko(f, off, SEEK_SET)) {
+		int saved_errno = errno;
+
+		fclose(f);
+		errno = saved_errno;
+		return -1;
+	}
+	au->in = f;
+	au->list_idx = idx;
+	au->seek_sec = sec;
+	au->seek_milli = milli;
+	au->seek_active = 1;
+	au->seek_lines = off != 0;
+	return 0;
+}
+
 /*******
 * Functions that traverse events.
 ********/
@@ -1617,7 +1880,7 @@ static int au_auparse_next_event(auparse_state_t *au)
 			return -1;
 		}
 		/* So we got a successful read ie rc > 0 */
-		if (extract_timestamp(au->cur_buf, &e)) {
+		if (get_timestamp(au, &e)) {
 #ifdef	LOL_EVENTS_DEBUG01
 			if (debug)
 				printf("Malformed line:%s\n", au->cur_buf);
@@ -1638,7 +1901,9 @@ static int au_auparse_next_event(auparse_state_t *au)
 						printf("Adding event to building event\n");
 #endif	/* LOL_EVENTS_DEBUG01 */
 					if (aup_list_append(cur->l, au->cur_buf,
-					    au->list_idx, au->line_number) < 0) {
+					    au->list_idx, current_line(au),
+					    au->frame_fields,
+					    au->frame_nfields) < 0) {
 						au->cur_buf = NULL;
 						continue;
 					}
@@ -1670,7 +1935,8 @@ static int au_auparse_next_event(auparse_state_t *au)
 		aup_list_create(l);
 		aup_list_set_event(l, &e);
 		if (aup_list_append(l, au->cur_buf, au->list_idx,
-				    au->line_number) < 0) {
+				    current_line(au), au->frame_fields,
+				    au->frame_nfields) < 0) {
 			au->cur_buf = NULL;
 			aup_list_clear(l);
 			free(l);
@@ -1716,8 +1982,18 @@ static int au_auparse_next_event(auparse_state_t *au)
 // Brute force go to next event. Returns < 0 on error, 0 no data, > 0 success
 int auparse_next_event(auparse_state_t *au)
 {
-	clear_normalizer(&au->norm_data);
-	return au_auparse_next_event(au);
+	int rc;
+
+	do {
+		clear_normalizer(&au->norm_data);
+		rc = au_auparse_next_event(au);
+		// Skip what was read before the time seeked to
+	} while (rc > 0 && au->seek_active &&
+		 seek_is_before(&au->le->e, au->seek_sec, au->seek_milli));
+	// Events after the first one at the target are all returned
+	if (rc > 0)
+		au->seek_active = 0;
+	return rc;
 }
 
 /* Accessors to event data */
@@ -47,6 +47,9 @@ extern "C" {
 /* opaque data type used for maintaining library state */
 typedef struct opaque auparse_state_t;
 
+/* opaque data type holding a copy of one event */
+typedef struct auparse_snapshot auparse_snapshot_t;
+
 typedef void (*user_destroy)(void *user_data);
 typedef void (*auparse_callback_ptr)(auparse_state_t *au,
 			auparse_cb_event_t cb_event_type, void *user_data);
@@ -68,6 +71,7 @@ void auparse_add_callback(auparse_state_t *au, auparse_callback_ptr callback,
 			void *user_data, user_destroy user_destroy_func);
 void auparse_set_escape_mode(auparse_state_t *au, auparse_esc_t mode);
 int auparse_reset(auparse_state_t *au);
+int auparse_seek_time(auparse_state_t *au, time_t sec, unsigned int milli);
 char *auparse_metrics(const auparse_state_t *au) __attr_dealloc_free;
 
 /* Functions that are part of the search interface */
@@ -172,6 +176,35 @@ const char *auparse_interpret_realpath(const auparse_state_t *au);
 const char *auparse_interpret_sock_family(auparse_state_t *au);
 const char *auparse_interpret_sock_port(auparse_state_t *au);
 const char *auparse_interpret_sock_address(auparse_state_t *au);
+
+/* The command line of an event put back together from its EXECVE records */
+const auparse_arg_t *auparse_get_execve_argv(auparse_state_t *au,
+	unsigned int *argc);
+
+/* Read only copies of an event that may be shared between threads */
+void auparse_snapshot_unref(auparse_snapshot_t *s);
+auparse_snapshot_t *auparse_snapshot_event(auparse_state_t *au,
+	auparse_snapshot_mode_t mode)
+	__attribute_malloc__ __attr_dealloc (auparse_snapshot_unref, 1);
+auparse_snapshot_t *auparse_snapshot_ref(auparse_snapshot_t *s);
+const au_event_t *auparse_snapshot_get_timestamp(const auparse_snapshot_t *s);
+unsigned int auparse_snapshot_get_num_records(const auparse_snapshot_t *s);
+int auparse_snapshot_get_type(const auparse_snapshot_t *s, unsigned int rec);
+const char *auparse_snapshot_get_record_text(const auparse_snapshot_t *s,
+	unsigned int rec);
+unsigned int auparse_snapshot_get_num_fields(const auparse_snapshot_t *s,
+	unsigned int rec);
+const char *auparse_snapshot_find_field(const auparse_snapshot_t *s,
+	const char *name, unsigned int *rec, unsigned int *field);
+const char *auparse_snapshot_get_field_name(const auparse_snapshot_t *s,
+	unsigned int rec, unsigned int field);
+const char *auparse_snapshot_get_field_str(const auparse_snapshot_t *s,
+	unsigned int rec, unsigned int field);
+int auparse_snapshot_get_field_type(const auparse_snapshot_t *s,
+	unsigned int rec, unsigned int field);
+const char *auparse_snapshot_interpret_field(const auparse_snapshot_t *s,
+	unsigned int rec, unsigned int field);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,106 @@
+/*
+ * decode.c - table driven decoders shared with the search tools
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include "decode.h"
+#include "gen_tables.h"
+#include "famtabs.h"
+#include "ipctabs.h"
+#include "socktabs.h"
+
+const char *_auparse_socketcall_to_name(long long sc)
+{
+	if ((int)sc != sc)
+		return NULL;
+	return sock_i2s(sc);
+}
+
+const char *_auparse_ipccall_to_name(long long ic)
+{
+	if ((int)ic != ic)
+		return NULL;
+	return ipc_i2s(ic);
+}
+
+const char *_auparse_family_to_name(int family)
+{
+	return fam_i2s(family);
+}
+
+/*
+ * Write the numeric address of an AF_INET or AF_INET6 sockaddr to host and,
+ * if serv is not NULL, its port to serv. The output matches getnameinfo()
+ * with NI_NUMERICHOST and NI_NUMERICSERV without its locking and lookups.
+ * Returns 0 on success and 1 if the sockaddr is too short or another
+ * family.
+ */
+int _auparse_sockaddr_addr(const struct sockaddr *saddr, size_t len,
+	char *host, size_t hlen, char *serv, size_t slen)
+{
+	unsigned int port;
+
+	if (saddr->sa_family == AF_INET) {
+		const struct sockaddr_in *in =
+				(const struct sockaddr_in *)saddr;
+
+		if (len < sizeof(struct sockaddr_in) ||
+		    inet_ntop(AF_INET, &in->sin_addr, host, hlen) == NULL)
+			return 1;
+		port = ntohs(in->sin_port);
+	} else if (saddr->sa_family == AF_INET6) {
+		const struct sockaddr_in6 *in6 =
+				(const struct sockaddr_in6 *)saddr;
+
+		if (len < sizeof(struct sockaddr_in6) ||
+		    inet_ntop(AF_INET6, &in6->sin6_addr, host, hlen) == NULL)
+			return 1;
+		if (in6->sin6_scope_id) {
+			size_t used = strlen(host);
+			char ifname[IF_NAMESIZE];
+			int rc;
+
+			// Link local scopes are shown by name, like getnameinfo
+			if ((IN6_IS_ADDR_LINKLOCAL(&in6->sin6_addr) ||
+			    IN6_IS_ADDR_MC_LINKLOCAL(&in6->sin6_addr)) &&
+			    if_indextoname(in6->sin6_scope_id, ifname))
+				rc = snprintf(host + used, hlen - used, "%%%s",
+					      ifname);
+			else
+				rc = snprintf(host + used, hlen - used, "%%%u",
+					      in6->sin6_scope_id);
+			if (rc < 0 || (size_t)rc >= hlen - used)
+				return 1;
+		}
+		port = ntohs(in6->sin6_port);
+	} else
+		return 1;
+
+	if (serv && snprintf(serv, slen, "%u", port) >= (int)slen)
+		return 1;
+	return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * decode.h - Header file for decode.c
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#ifndef DECODE_HEADER
+#define DECODE_HEADER
+
+#include "config.h"
+#include "dso.h"
+#include <stddef.h>
+#include <sys/socket.h>
+
+/*
+ * Decoders shared by auparse's interpretations and ausearch/aureport.
+ * They use the generated tables and do not allocate memory. They are not
+ * part of the library's ABI, the search tools build decode.c themselves.
+ */
+AUDIT_HIDDEN_START
+
+const char *_auparse_socketcall_to_name(long long sc);
+const char *_auparse_ipccall_to_name(long long ic);
+const char *_auparse_family_to_name(int family);
+int _auparse_sockaddr_addr(const struct sockaddr *saddr, size_t len,
+	char *host, size_t hlen, char *serv, size_t slen);
+
+AUDIT_HIDDEN_END
+
+#endif
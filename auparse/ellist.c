@@ -29,6 +29,7 @@
 #include "ellist.h"
 #include "interpret.h"
 #include "common.h"
+#include "audit-frame.h"
 
 static const char key_sep[2] = { AUDIT_KEY_SEPARATOR, 0 };
 
@@ -42,6 +43,8 @@ void aup_list_create(event_list_t *l)
 	l->e.serial = 0L;
 	l->e.host = NULL;
 	l->cwd = NULL;
+	l->argv = NULL;
+	l->argc = 0;
 }
 
 static void aup_list_last(event_list_t *l)
@@ -98,12 +101,67 @@ static char *escape(const char *tmp)
 	return name;
 }
 
+/* The tokens of a record come from splitting it on spaces or from the
+ * field table of a framed record. Both give the same tokens. */
+typedef struct {
+	char *buf;		// Record being split up
+	char *saved;		// audit_strsplit_r state
+	const struct audit_frame_field *fields;
+	unsigned int nfields;
+	unsigned int cnt;	// Tokens handed out so far
+} tokens_t;
+
+/* Returns the next NUL terminated token and where its '=' is */
+static char *next_token(tokens_t *t, char **eq)
+{
+	char *ptr;
+
+	if (t->fields) {
+		const struct audit_frame_field *f;
+
+		if (t->cnt == t->nfields)
+			return NULL;
+		f = &t->fields[t->cnt++];
+		ptr = t->buf + f->name_off;
+		if (f->val_off) {
+			t->buf[f->val_off + f->val_len] = 0;
+			*eq = t->buf + f->val_off - 1;
+		} else {
+			t->buf[f->name_off + f->name_len] = 0;
+			*eq = NULL;
+		}
+		return ptr;
+	}
+
+	ptr = audit_strsplit_r(t->cnt++ ? NULL : t->buf, &t->saved);
+	*eq = ptr ? strchr(ptr, '=') : NULL;
+	return ptr;
+}
+
+/* Returns 1 if the field table fits the record of length len */
+static int fields_fit(const struct audit_frame_field *f, unsigned int cnt,
+	unsigned int len)
+{
+	unsigned int i;
+
+	for (i = 0; i < cnt; i++) {
+		unsigned int end = f[i].val_off ? f[i].val_off + f[i].val_len :
+				f[i].name_off + f[i].name_len;
+
+		if (end >= len)
+			return 0;
+	}
+	return 1;
+}
+
 /* This function does the heavy duty work of splitting a record into
  * its little tiny pieces */
-static int parse_up_record(rnode* r)
+static int parse_up_record(rnode* r, const struct audit_frame_field *fields,
+	unsigned int nfields)
 {
-	char *ptr, *buf, *saved=NULL;
+	char *ptr, *buf, *eq;
 	unsigned int offset = 0, len;
+	tokens_t t;
 
 	// Potentially cut the record in two
 	ptr = strchr(r->record, AUDIT_INTERP_SEPARATOR);
@@ -121,7 +179,18 @@ static int parse_up_record(rnode* r)
 		return -1;
 	memcpy(r->nv.record, r->record, len);
 	r->nv.end = r->nv.record + len;
-	ptr = audit_strsplit_r(buf, &saved);
+
+	t.buf = buf;
+	t.saved = NULL;
+	t.cnt = 0;
+	if (nfields && fields_fit(fields, nfields, len)) {
+		t.fields = fields;
+		t.nfields = nfields;
+	} else {
+		t.fields = NULL;
+		t.nfields = 0;
+	}
+	ptr = next_token(&t, &eq);
 	// If no fields we have fuzzer induced problems, leave
 	if (ptr == NULL) {
 		free(buf);
@@ -132,7 +201,7 @@ static int parse_up_record(rnode* r)
 	do {	// If there's an '=' sign, its a keeper
 		nvnode n;
 
-		char *val = strchr(ptr, '=');
+		char *val = eq;
 		if (val) {
 			int vlen;
 
@@ -306,7 +375,7 @@ static int parse_up_record(rnode* r)
 					char tmpctx[256], *to;
 					tmpctx[0] = 0;
 					to = tmpctx;
-					ptr = audit_strsplit_r(NULL, &saved);
+					ptr = next_token(&t, &eq);
 					while (ptr && *ptr != '}') {
 						clen = strlen(ptr);
 						if ((clen+1) >= (256-total)) {
@@ -321,8 +390,7 @@ static int parse_up_record(rnode* r)
 						}
 						to = stpcpy(to, ptr);
 						total += clen;
-						ptr = audit_strsplit_r(NULL,
-								 &saved);
+						ptr = next_token(&t, &eq);
 					}
 					n.name = strdup("seperms");
 					n.val = strdup(tmpctx);
@@ -338,7 +406,7 @@ static int parse_up_record(rnode* r)
 			n.val = ptr;
 			nvlist_append(&r->nv, &n);
 		}
-	} while((ptr = audit_strsplit_r(NULL, &saved)));
+	} while((ptr = next_token(&t, &eq)));
 
 	// If for some reason it was useless, delete buf
 	if (r->nv.cnt == 0) {
@@ -353,8 +421,13 @@ static int parse_up_record(rnode* r)
 	return 0;
 }
 
+/*
+ * fields is an optional table of where the tokens of a framed record are.
+ * It is only used while parsing the record.
+ */
 int aup_list_append(event_list_t *l, char *record, int list_idx,
-	unsigned int line_number)
+	unsigned int line_number, const struct audit_frame_field *fields,
+	unsigned int nfields)
 {
 	int rc;
 	rnode* r;
@@ -394,7 +467,7 @@ int aup_list_append(event_list_t *l, char *record, int list_idx,
 	l->cnt++;
 
 	// Then parse the record up into nvlist
-	rc = parse_up_record(r);
+	rc = parse_up_record(r, fields, nfields);
 	if (r->nv.cnt == 0) // This is fuzzer induced, return an error.
 		rc = -1;
 
@@ -431,6 +504,9 @@ void aup_list_clear(event_list_t* l)
 	free((char *)l->e.host);
 	l->e.host = NULL;
 	free((void *)l->cwd);
+	free(l->argv);
+	l->argv = NULL;
+	l->argc = 0;
 }
 
 /*int aup_list_get_event(event_list_t* l, au_event_t *e)
@@ -40,6 +40,8 @@ typedef struct {
 	// Data we add as 1 per event
 	au_event_t e;		// event - time & serial number
 	const char *cwd;	// cwd used for realpath conversion
+	auparse_arg_t *argv;	// EXECVE arguments, built when asked for
+	unsigned int argc;	// How many are in argv
 } event_list_t;
 
 static inline unsigned int aup_list_get_cnt(const event_list_t *l)
@@ -48,13 +50,16 @@ static inline void aup_list_first(event_list_t *l) { l->cur = l->head; }
 static inline rnode *aup_list_get_cur(const event_list_t *l)
 { return l ? l->cur : NULL; }
 
+struct audit_frame_field;
+
 AUDIT_HIDDEN_START
 
 void aup_list_create(event_list_t *l);
 void aup_list_clear(event_list_t* l);
 rnode *aup_list_next(event_list_t *l);
 int aup_list_append(event_list_t *l, char *record, int list_idx,
-	unsigned int line_number);
+	unsigned int line_number, const struct audit_frame_field *fields,
+	unsigned int nfields);
 //int aup_list_get_event(event_list_t* l, au_event_t *e);
 int aup_list_set_event(event_list_t* l, au_event_t *e);
 
@@ -0,0 +1,190 @@
+/* execve.c -- Command lines from EXECVE records
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+/*
+ * The kernel logs a command line as a0, a1, ... fields that may be spread
+ * over several EXECVE records. An argument that is too long for one record
+ * is logged as aN_len followed by aN[0], aN[1], ... chunks. Each argument,
+ * or each chunk, is either quoted or hex encoded.
+ *
+ * The argument vector is built the first time it is asked for and kept
+ * with the event. Quoted arguments point into the parsed record. Hex
+ * encoded ones and chunked ones are decoded into one buffer allocated
+ * together with the vector.
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include "libaudit.h"
+#include "auparse.h"
+#include "internal.h"
+#include "common.h"
+
+typedef enum { ARG_NONE, ARG_WHOLE, ARG_CHUNK, ARG_LEN } arg_kind_t;
+
+// Classifies an EXECVE field name and gets its argument number
+static arg_kind_t arg_name(const char *name, unsigned long *num)
+{
+	char *end;
+
+	if (name == NULL || name[0] != 'a' || !isdigit((unsigned char)name[1]))
+		return ARG_NONE;
+	*num = strtoul(name + 1, &end, 10);
+	if (*end == 0)
+		return ARG_WHOLE;
+	if (*end == '[')
+		return ARG_CHUNK;
+	if (strcmp(end, "_len") == 0)
+		return ARG_LEN;
+	return ARG_NONE;
+}
+
+/*
+ * Finds the text of a value. Quotes are removed. Returns its length and
+ * sets *hex if it needs decoding.
+ */
+static size_t arg_value(const char *val, const char **start, int *hex)
+{
+	const char *end;
+	size_t len;
+
+	*hex = 0;
+	if (*val == '"') {
+		*start = val + 1;
+		end = strchr(*start, '"');
+		return end ? (size_t)(end - *start) : strlen(*start);
+	}
+	*start = val;
+	len = strlen(val);
+	if (len && audit_hex_span(val, len) == len)
+		*hex = 1;
+	return len;
+}
+
+static int build_argv(event_list_t *l)
+{
+	unsigned long num, max = 0;
+	size_t bytes = 0, nargs = 0, building = (size_t)-1;
+	auparse_arg_t *argv;
+	unsigned int i;
+	char *pos;
+	rnode *r;
+
+	// Count the arguments and size the decode buffer
+	for (r = l->head; r; r = r->next) {
+		if (r->type != AUDIT_EXECVE)
+			continue;
+		for (i = 0; i < r->nv.cnt; i++) {
+			const nvnode *n = &r->nv.array[i];
+			arg_kind_t k = arg_name(n->name, &num);
+
+			if (k == ARG_NONE || n->val == NULL)
+				continue;
+			if (k != ARG_CHUNK)
+				nargs++;
+			if (k != ARG_LEN)
+				bytes += strlen(n->val);
+			if (num > max)
+				max = num;
+		}
+	}
+	if (nargs == 0) {
+		errno = ENODATA;
+		return -1;
+	}
+	// A record in the middle of the command line is missing
+	if (max >= nargs) {
+		errno = EBADMSG;
+		return -1;
+	}
+
+	argv = calloc(1, nargs * sizeof(auparse_arg_t) + bytes + 1);
+	if (argv == NULL)
+		return -1;
+	pos = (char *)(argv + nargs);
+
+	for (r = l->head; r; r = r->next) {
+		if (r->type != AUDIT_EXECVE)
+			continue;
+		for (i = 0; i < r->nv.cnt; i++) {
+			const nvnode *n = &r->nv.array[i];
+			arg_kind_t k = arg_name(n->name, &num);
+			const char *start;
+			size_t len;
+			int hex;
+
+			if (k == ARG_NONE || k == ARG_LEN || n->val == NULL)
+				continue;
+			len = arg_value(n->val, &start, &hex);
+			if (k == ARG_WHOLE && !hex) {
+				argv[num].ptr = start;
+				argv[num].len = len;
+				building = (size_t)-1;
+				continue;
+			}
+			// Chunks of one argument are logged one after another
+			if (k == ARG_WHOLE || num != building) {
+				argv[num].ptr = pos;
+				argv[num].len = 0;
+				building = k == ARG_CHUNK ? num : (size_t)-1;
+			}
+			if (hex)
+				len = audit_hex_decode((unsigned char *)pos,
+							start, len);
+			else
+				memcpy(pos, start, len);
+			argv[num].len += len;
+			pos += len;
+		}
+	}
+
+	l->argv = argv;
+	l->argc = nargs;
+	return 0;
+}
+
+/*
+ * Returns the command line of the current event as a vector of
+ * arguments, or NULL if there is none. The vector belongs to the event.
+ */
+const auparse_arg_t *auparse_get_execve_argv(auparse_state_t *au,
+	unsigned int *argc)
+{
+	if (argc)
+		*argc = 0;
+	if (au == NULL || argc == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (au->le == NULL || au->le->e.sec == 0) {
+		errno = ENODATA;
+		return NULL;
+	}
+	if (au->le->argv == NULL && build_argv(au->le))
+		return NULL;
+
+	*argc = au->le->argc;
+	return au->le->argv;
+}
@@ -178,6 +178,15 @@ struct opaque
 	debug_message_t debug_message;	// Whether or not messages are debug or not
 	const char *tmp_translation;	// Pointer to manage mem for field translation
 	normalize_data norm_data;
+	time_t seek_sec;		// After auparse_seek_time(), events
+	unsigned int seek_milli;	//	 before this are skipped
+	int seek_active;
+	int seek_lines;			// Line numbers in the file seeked
+					//	into are unknown
+	struct audit_frame_field *frame_fields;	// Field table of the
+	unsigned int frame_nfields;		//	current framed record
+	unsigned int frame_size;		// Entries allocated
+	au_event_t frame_e;		// Its time stamp, sec is 0 if none
 };
 
 AUDIT_HIDDEN_START
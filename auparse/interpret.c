@@ -68,6 +68,7 @@
 #include "auparse-defs.h"
 #include "gen_tables.h"
 #include "common.h"
+#include "decode.h"
 
 #if !HAVE_DECL_ADDR_NO_RANDOMIZE
 # define ADDR_NO_RANDOMIZE       0x0040000
@@ -92,11 +93,9 @@
 #include "captabs.h"
 #include "clone-flagtabs.h"
 #include "epoll_ctls.h"
-#include "famtabs.h"
 #include "fcntl-cmdtabs.h"
 #include "flagtabs.h"
 #include "fsconfigs.h"
-#include "ipctabs.h"
 #include "ipccmdtabs.h"
 #include "mmaptabs.h"
 #include "mounttabs.h"
@@ -107,7 +106,6 @@
 #include "recvtabs.h"
 #include "rlimittabs.h"
 #include "seektabs.h"
-#include "socktabs.h"
 #include "socktypetabs.h"
 #include "signaltabs.h"
 #include "clocktabs.h"
@@ -141,38 +139,6 @@ static const char *print_signals(const char *val, unsigned int base);
 // FIXME: move next declaration to auparse_state_t
 static nvlist il;  // Interpretations list
 
-/*
- * This function will take a pointer to a 2 byte Ascii character buffer and
- * return the actual hex value.
- */
-static unsigned char x2c(const unsigned char *buf)
-{
-        static const char AsciiArray[17] = "0123456789ABCDEF";
-        char *ptr;
-        unsigned char total=0;
-
-        ptr = strchr(AsciiArray, (char)toupper(buf[0]));
-        if (ptr)
-                total = (unsigned char)(((ptr-AsciiArray) & 0x0F)<<4);
-        ptr = strchr(AsciiArray, (char)toupper(buf[1]));
-        if (ptr)
-                total += (unsigned char)((ptr-AsciiArray) & 0x0F);
-
-        return total;
-}
-
-// Check if any characters need tty escaping. Returns how many found.
-static unsigned int need_tty_escape(const unsigned char *s, unsigned int len)
-{
-	unsigned int i = 0, cnt = 0;
-	while (i < len) {
-		if (s[i] < 32)
-			cnt++;
-		i++;
-	}
-	return cnt;
-}
-
 // TTY escaping s string into dest.
 static void tty_escape(const char *s, char *dest, unsigned int len)
 {
@@ -266,7 +232,7 @@ static unsigned int need_escaping(const char *s, unsigned int len,
 		case AUPARSE_ESC_RAW:
 			break;
 		case AUPARSE_ESC_TTY:
-			return need_tty_escape(s, len);
+			return audit_ctrl_count((const unsigned char *)s, len);
 		case AUPARSE_ESC_SHELL:
 			return need_shell_escape(s, len);
 		case AUPARSE_ESC_SHELL_QUOTE:
@@ -330,70 +296,42 @@ static void key_escape(const char *orig, char *dest, auparse_esc_t escape_mode)
 
 static int is_hex_string(const char *str)
 {
-	while (*str) {
-		if (!isxdigit(*str))
-			return 0;
-		str++;
-	}
-	return 1;
+	size_t len = strlen(str);
+
+	return audit_hex_span(str, len) == len;
 }
 
 /* returns a freshly malloc'ed and converted buffer */
 char *au_unescape(char *buf)
 {
-        int olen, len, i;
-        char saved, *str, *ptr = buf;
+	size_t olen, len;
+	char *str, *ptr;
+
+	/* See if its '(null)' from the kernel */
+	if (*buf == '(') {
+		ptr = strchr(buf, ')');
+		if (ptr == NULL)
+			return NULL;
+		return strndup(buf, ptr - buf + 1);
+	}
+
+	/* Find the end of the name */
+	olen = strlen(buf);
+	len = audit_hex_span(buf, olen);
+	if (len < 2)
+		return NULL;
 
-        /* Find the end of the name */
-        if (*ptr == '(') {
-                ptr = strchr(ptr, ')');
-                if (ptr == NULL)
-                        return NULL;
-                else
-                        ptr++;
-        } else {
-                while (isxdigit(*ptr))
-                        ptr++;
-        }
 	// Make the buffer based on size of original buffer.
 	// This is in case we have unexpected non-hex digit
 	// that causes truncation of the conversion and passes
 	// back a buffer that is not sized on the expectation of
-	// strlen(buf) / 2.
-	olen = strlen(buf);
+	// strlen(buf) / 2. Everything past the decoded bytes is 0.
 	str = malloc(olen+1);
 	if (!str)
 		return NULL;
-
-        saved = *ptr;
-        *ptr = 0;
-	strcpy(str, buf);
-        *ptr = saved;
-
-	/* See if its '(null)' from the kernel */
-        if (*buf == '(')
-                return str;
-
-        /* We can get away with this since the buffer is 2 times
-         * bigger than what we are putting there.
-         */
-        len = strlen(str);
-        if (len < 2) {
-                free(str);
-                return NULL;
-        }
-        ptr = str;
-        for (i=0; i<len; i+=2) {
-                *ptr = x2c((unsigned char *)&str[i]);
-                ptr++;
-        }
-        *ptr = 0;
-	len = ptr - str - 1;
-	olen /= 2;
-	// Because *ptr is 0, writing another 0 to it doesn't hurt anything
-	if (olen > len)
-		memset(ptr, 0, olen - len);
-        return str;
+	len = audit_hex_decode((unsigned char *)str, buf, len);
+	memset(str + len, 0, olen + 1 - len);
+	return str;
 }
 
 /////////// Interpretation list functions ///////////////
@@ -750,7 +688,7 @@ static const char *print_ipccall(const char *val, unsigned int base)
 			out2 = NULL;
 		return out2;
 	}
-	func = ipc_i2s(a0);
+	func = _auparse_ipccall_to_name(a0);
 	if (func)
 		return strdup(func);
 	else {
@@ -774,7 +712,7 @@ static const char *print_socketcall(const char *val, unsigned int base)
 			out2 = NULL;
 		return out2;
 	}
-	func = sock_i2s(a0);
+	func = _auparse_socketcall_to_name(a0);
 	if (func)
 		return strdup(func);
 	else {
@@ -800,12 +738,10 @@ static const char *print_syscall(const idata *id)
         sys = audit_syscall_to_name(syscall, machine);
         if (sys) {
                 const char *func = NULL;
-                if (strcmp(sys, "socketcall") == 0) {
-			if ((int)a0 == a0)
-				func = sock_i2s(a0);
-                } else if (strcmp(sys, "ipc") == 0)
-			if ((int)a0 == a0)
-				func = ipc_i2s(a0);
+                if (strcmp(sys, "socketcall") == 0)
+			func = _auparse_socketcall_to_name(a0);
+                else if (strcmp(sys, "ipc") == 0)
+			func = _auparse_ipccall_to_name(a0);
                 if (func) {
 			if (asprintf(&out, "%s(%s)", sys, func) < 0)
 				out = NULL;
@@ -1152,7 +1088,7 @@ static const char *print_socket_domain(const char *val)
 			out = NULL;
 		return out;
 	}
-        str = fam_i2s(i);
+        str = _auparse_family_to_name(i);
         if (str == NULL) {
 		if (asprintf(&out, "unknown-family(0x%s)", val) < 0)
 			out = NULL;
@@ -1225,7 +1161,7 @@ static const char *print_sockaddr(const char *val)
         saddr = (struct sockaddr *)host;
 
 
-        str = fam_i2s(saddr->sa_family);
+        str = _auparse_family_to_name(saddr->sa_family);
         if (str == NULL) {
 		if (asprintf(&out, "unknown-family(%d)", saddr->sa_family) < 0)
 			out = NULL;
@@ -1263,10 +1199,8 @@ static const char *print_sockaddr(const char *val)
 					     str);
 				break;
                         }
-                        slen = sizeof(struct sockaddr_in);
-                        if (getnameinfo(saddr, slen, name, NI_MAXHOST, serv,
-                                NI_MAXSERV, NI_NUMERICHOST |
-                                        NI_NUMERICSERV) == 0 ) {
+                        if (_auparse_sockaddr_addr(saddr, slen, name,
+				    sizeof(name), serv, sizeof(serv)) == 0) {
 				rc = asprintf(&out,
 				      "{ saddr_fam=%s laddr=%s lport=%s }",
 					      str, name, serv);
@@ -1327,10 +1261,8 @@ static const char *print_sockaddr(const char *val)
 					   str);
 				break;
                         }
-                        slen = sizeof(struct sockaddr_in6);
-                        if (getnameinfo(saddr, slen, name, NI_MAXHOST, serv,
-                                NI_MAXSERV, NI_NUMERICHOST |
-                                        NI_NUMERICSERV) == 0 ) {
+                        if (_auparse_sockaddr_addr(saddr, slen, name,
+				    sizeof(name), serv, sizeof(serv)) == 0) {
 				rc = asprintf(&out,
 					"{ saddr_fam=%s laddr=%s lport=%s }",
 						str, name, serv);
@@ -0,0 +1,319 @@
+/* snapshot.c -- Detached copies of audit events
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+/*
+ * An event normally lives in the parser's record list and is replaced by
+ * the next one. A snapshot copies the current event into a single
+ * allocation that nothing else points into. It is never modified after
+ * it is made, so any number of threads may read it at once. It is freed
+ * when the last reference is dropped.
+ *
+ * Interpretation uses caches and state that are not thread safe. If it
+ * is wanted, it is done by the thread taking the snapshot and the results
+ * are stored with the raw values.
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include "auparse.h"
+#include "auparse-idata.h"
+#include "internal.h"
+#include "interpret.h"
+
+typedef struct {
+	const char *name;
+	const char *val;
+	const char *interp_val;
+} snap_field;
+
+typedef struct {
+	int type;
+	unsigned int num_fields;
+	const char *text;
+	const snap_field *fields;
+} snap_record;
+
+struct auparse_snapshot {
+	atomic_uint refcnt;
+	au_event_t e;
+	unsigned int num_records;
+	const snap_record *records;
+};
+
+static size_t str_size(const char *s)
+{
+	return s ? strlen(s) + 1 : 0;
+}
+
+static const char *str_copy(char **pos, const char *s)
+{
+	char *ret = *pos;
+	size_t len;
+
+	if (s == NULL)
+		return NULL;
+	len = strlen(s) + 1;
+	memcpy(ret, s, len);
+	*pos += len;
+	return ret;
+}
+
+/*
+ * Interpret every field of the event so the results get copied. The
+ * cursors and the interpretation list are put back the way they were.
+ */
+static void interpret_all(auparse_state_t *au)
+{
+	rnode *cur = au->le->cur, *r;
+
+	for (r = au->le->head; r; r = r->next) {
+		unsigned int saved = r->nv.cur, i;
+
+		free_interpretation_list();
+		load_interpretation_list(r->interp);
+		for (i = 0; i < r->nv.cnt; i++) {
+			r->nv.cur = i;
+			r->cwd = NULL;
+			nvlist_interp_cur_val(r, au->escape_mode);
+		}
+		r->nv.cur = saved;
+	}
+	free_interpretation_list();
+	if (cur)
+		load_interpretation_list(cur->interp);
+}
+
+auparse_snapshot_t *auparse_snapshot_event(auparse_state_t *au,
+	auparse_snapshot_mode_t mode)
+{
+	auparse_snapshot_t *s;
+	snap_record *recs;
+	snap_field *fields;
+	size_t size, num_fields = 0, strs = 0;
+	unsigned int i, j;
+	char *pos;
+	rnode *r;
+
+	if (au == NULL || au->le == NULL || au->le->e.sec == 0) {
+		errno = ENODATA;
+		return NULL;
+	}
+	if (mode == AUPARSE_SNAPSHOT_INTERPRET)
+		interpret_all(au);
+
+	// Size everything up so it can go in one block
+	strs = str_size(au->le->e.host);
+	for (r = au->le->head; r; r = r->next) {
+		num_fields += r->nv.cnt;
+		strs += str_size(r->record);
+		for (j = 0; j < r->nv.cnt; j++) {
+			const nvnode *n = &r->nv.array[j];
+
+			strs += str_size(n->name) + str_size(n->val);
+			if (mode == AUPARSE_SNAPSHOT_INTERPRET ||
+					n->val == NULL)
+				strs += str_size(n->interp_val);
+		}
+	}
+	size = sizeof(auparse_snapshot_t) +
+		au->le->cnt * sizeof(snap_record) +
+		num_fields * sizeof(snap_field) + strs;
+	s = malloc(size);
+	if (s == NULL)
+		return NULL;
+
+	recs = (snap_record *)(s + 1);
+	fields = (snap_field *)(recs + au->le->cnt);
+	pos = (char *)(fields + num_fields);
+
+	atomic_init(&s->refcnt, 1);
+	s->e = au->le->e;
+	s->e.host = str_copy(&pos, au->le->e.host);
+	s->num_records = au->le->cnt;
+	s->records = recs;
+	for (r = au->le->head, i = 0; r; r = r->next, i++) {
+		recs[i].type = r->type;
+		recs[i].num_fields = r->nv.cnt;
+		recs[i].text = str_copy(&pos, r->record);
+		recs[i].fields = fields;
+		for (j = 0; j < r->nv.cnt; j++) {
+			const nvnode *n = &r->nv.array[j];
+
+			fields[j].name = str_copy(&pos, n->name);
+			fields[j].val = str_copy(&pos, n->val);
+			// Enriched fields only have an interpreted value
+			if (mode == AUPARSE_SNAPSHOT_INTERPRET ||
+					n->val == NULL)
+				fields[j].interp_val =
+					str_copy(&pos, n->interp_val);
+			else
+				fields[j].interp_val = NULL;
+		}
+		fields += r->nv.cnt;
+	}
+
+	return s;
+}
+
+auparse_snapshot_t *auparse_snapshot_ref(auparse_snapshot_t *s)
+{
+	if (s)
+		atomic_fetch_add_explicit(&s->refcnt, 1, memory_order_relaxed);
+	return s;
+}
+
+void auparse_snapshot_unref(auparse_snapshot_t *s)
+{
+	if (s && atomic_fetch_sub_explicit(&s->refcnt, 1,
+				memory_order_acq_rel) == 1)
+		free(s);
+}
+
+const au_event_t *auparse_snapshot_get_timestamp(const auparse_snapshot_t *s)
+{
+	return s ? &s->e : NULL;
+}
+
+unsigned int auparse_snapshot_get_num_records(const auparse_snapshot_t *s)
+{
+	return s ? s->num_records : 0;
+}
+
+static const snap_record *get_rec(const auparse_snapshot_t *s,
+	unsigned int rec)
+{
+	if (s == NULL || rec >= s->num_records) {
+		errno = ERANGE;
+		return NULL;
+	}
+	return &s->records[rec];
+}
+
+static const snap_field *get_field(const auparse_snapshot_t *s,
+	unsigned int rec, unsigned int field)
+{
+	const snap_record *r = get_rec(s, rec);
+
+	if (r == NULL)
+		return NULL;
+	if (field >= r->num_fields) {
+		errno = ERANGE;
+		return NULL;
+	}
+	return &r->fields[field];
+}
+
+int auparse_snapshot_get_type(const auparse_snapshot_t *s, unsigned int rec)
+{
+	const snap_record *r = get_rec(s, rec);
+
+	return r ? r->type : 0;
+}
+
+const char *auparse_snapshot_get_record_text(const auparse_snapshot_t *s,
+	unsigned int rec)
+{
+	const snap_record *r = get_rec(s, rec);
+
+	return r ? r->text : NULL;
+}
+
+unsigned int auparse_snapshot_get_num_fields(const auparse_snapshot_t *s,
+	unsigned int rec)
+{
+	const snap_record *r = get_rec(s, rec);
+
+	return r ? r->num_fields : 0;
+}
+
+/*
+ * Look for a field by name. The search starts at *rec and *field and
+ * moves through the remaining records. Returns the value and updates
+ * *rec and *field with where it was found, or NULL if there is none.
+ */
+const char *auparse_snapshot_find_field(const auparse_snapshot_t *s,
+	const char *name, unsigned int *rec, unsigned int *field)
+{
+	unsigned int i, j;
+
+	if (s == NULL || name == NULL || rec == NULL || field == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	for (i = *rec, j = *field; i < s->num_records; i++, j = 0) {
+		const snap_record *r = &s->records[i];
+
+		for (; j < r->num_fields; j++) {
+			const char *n = r->fields[j].name;
+
+			if (n && strcmp(n, name) == 0) {
+				*rec = i;
+				*field = j;
+				return r->fields[j].val ? r->fields[j].val :
+					r->fields[j].interp_val;
+			}
+		}
+	}
+	return NULL;
+}
+
+const char *auparse_snapshot_get_field_name(const auparse_snapshot_t *s,
+	unsigned int rec, unsigned int field)
+{
+	const snap_field *f = get_field(s, rec, field);
+
+	return f ? f->name : NULL;
+}
+
+const char *auparse_snapshot_get_field_str(const auparse_snapshot_t *s,
+	unsigned int rec, unsigned int field)
+{
+	const snap_field *f = get_field(s, rec, field);
+
+	return f ? f->val : NULL;
+}
+
+int auparse_snapshot_get_field_type(const auparse_snapshot_t *s,
+	unsigned int rec, unsigned int field)
+{
+	const snap_field *f = get_field(s, rec, field);
+
+	if (f == NULL || f->val == NULL)
+		return AUPARSE_TYPE_UNCLASSIFIED;
+	return auparse_interp_adjust_type(s->records[rec].type, f->name,
+					  f->val);
+}
+
+const char *auparse_snapshot_interpret_field(const auparse_snapshot_t *s,
+	unsigned int rec, unsigned int field)
+{
+	const snap_field *f = get_field(s, rec, field);
+
+	if (f == NULL)
+		return NULL;
+	if (f->interp_val == NULL)
+		errno = ENODATA;
+	return f->interp_val;
+}
@@ -0,0 +1,178 @@
+/* execve_test.c -- A test of auparse_get_execve_argv.
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; see the file COPYING. If not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+ * Boston, MA 02110-1335, USA.
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include "libaudit.h"
+#include "auparse.h"
+
+#define EXECVE(n) "type=EXECVE msg=audit(1700000000.000:" #n "): "
+#define EOE(n) "type=EOE msg=audit(1700000000.000:" #n "): \n"
+
+static const char *buf =
+	// Quoted arguments
+	EXECVE(1) "argc=3 a0=\"ls\" a1=\"-l\" a2=\"/tmp\"\n"
+	EOE(1)
+	// Hex encoded ones, which may hold spaces, quotes and NULs
+	EXECVE(2) "argc=3 a0=\"echo\" a1=68656C6C6F20776F726C64 "
+		"a2=612262006300\n"
+	EOE(2)
+	// A long argument in chunks spread over two records
+	EXECVE(3) "argc=3 a0=\"cat\" a1_len=14 a1[0]=\"01234\"\n"
+	EXECVE(3) "a1[1]=3536373839 a1[2]=\"abcd\" a2=\"x\"\n"
+	EOE(3)
+	// Whole arguments spread over several records
+	EXECVE(4) "argc=5 a0=\"a\" a1=\"b\"\n"
+	EXECVE(4) "a2=\"c\" a3=6420\n"
+	EXECVE(4) "a4=\"e\"\n"
+	EOE(4)
+	// The record holding a2 and a3 was lost
+	EXECVE(5) "argc=5 a0=\"a\" a1=\"b\"\n"
+	EXECVE(5) "a4=\"e\"\n"
+	EOE(5)
+	// The last record was lost, what came is still returned
+	EXECVE(6) "argc=5 a0=\"a\" a1=\"b\"\n"
+	EXECVE(6) "a2=\"c\" a3=6420\n"
+	EOE(6)
+	// An event that ran nothing
+	"type=CWD msg=audit(1700000000.000:7): cwd=\"/\"\n"
+	EOE(7);
+
+/* Checks the command line of the next event against want, NULL ended */
+static int check(auparse_state_t *au, unsigned long serial,
+	const char *const want[], const size_t lens[])
+{
+	const auparse_arg_t *argv, *again;
+	unsigned int argc, again_argc, i;
+
+	if (auparse_next_event(au) <= 0 ||
+			auparse_get_serial(au) != serial) {
+		printf("Test failed - event %lu not found\n", serial);
+		return 1;
+	}
+	argv = auparse_get_execve_argv(au, &argc);
+	if (argv == NULL) {
+		printf("Test failed - event %lu has no arguments, errno %d\n",
+			serial, errno);
+		return 1;
+	}
+	for (i = 0; want[i]; i++) {
+		size_t len = lens ? lens[i] : strlen(want[i]);
+
+		if (i >= argc || argv[i].ptr == NULL ||
+				argv[i].len != len ||
+				memcmp(argv[i].ptr, want[i], len)) {
+			printf("Test failed - event %lu argument %u\n", serial,
+				i);
+			return 1;
+		}
+	}
+	if (argc != i) {
+		printf("Test failed - event %lu has %u arguments not %u\n",
+			serial, argc, i);
+		return 1;
+	}
+
+	// Asking again gives the same vector
+	again = auparse_get_execve_argv(au, &again_argc);
+	if (again != argv || again_argc != argc) {
+		printf("Test failed - event %lu rebuilt its arguments\n",
+			serial);
+		return 1;
+	}
+	return 0;
+}
+
+/* Checks that the next event has no command line and why */
+static int check_none(auparse_state_t *au, unsigned long serial, int err)
+{
+	unsigned int argc = 1;
+
+	if (auparse_next_event(au) <= 0 ||
+			auparse_get_serial(au) != serial) {
+		printf("Test failed - event %lu not found\n", serial);
+		return 1;
+	}
+	errno = 0;
+	if (auparse_get_execve_argv(au, &argc) || argc || errno != err) {
+		printf("Test failed - event %lu gave argc %u errno %d\n",
+			serial, argc, errno);
+		return 1;
+	}
+	return 0;
+}
+
+int main(void)
+{
+	static const char *const quoted[] = { "ls", "-l", "/tmp", NULL };
+	static const char *const hex[] = { "echo", "hello world",
+					   "a\"b\0c\0", NULL };
+	static const size_t hex_lens[] = { 4, 11, 6 };
+	static const char *const chunked[] = { "cat", "0123456789abcd", "x",
+					       NULL };
+	static const char *const multi[] = { "a", "b", "c", "d ", "e", NULL };
+	static const char *const partial[] = { "a", "b", "c", "d ", NULL };
+	auparse_state_t *au;
+	const char *name;
+	unsigned int argc;
+
+	au = auparse_init(AUSOURCE_BUFFER, buf);
+	if (au == NULL) {
+		puts("Test failed - init");
+		return 1;
+	}
+
+	// Bad arguments and no event yet
+	errno = 0;
+	if (auparse_get_execve_argv(au, NULL) || errno != EINVAL) {
+		puts("Test failed - NULL argc accepted");
+		return 1;
+	}
+	errno = 0;
+	if (auparse_get_execve_argv(au, &argc) || errno != ENODATA) {
+		puts("Test failed - arguments before the first event");
+		return 1;
+	}
+
+	if (check(au, 1, quoted, NULL))
+		return 1;
+	// The cursors stay where they were
+	name = auparse_get_field_name(au);
+	if (auparse_get_type(au) != AUDIT_EXECVE || name == NULL ||
+			strcmp(name, "type")) {
+		puts("Test failed - cursors moved");
+		return 1;
+	}
+	if (check(au, 2, hex, hex_lens) || check(au, 3, chunked, NULL) ||
+			check(au, 4, multi, NULL) ||
+			check_none(au, 5, EBADMSG) ||
+			check(au, 6, partial, NULL) ||
+			check_none(au, 7, ENODATA))
+		return 1;
+
+	auparse_destroy(au);
+	puts("execve test passed");
+	return 0;
+}
@@ -0,0 +1,198 @@
+/* frame_test.c -- A test of the framed feed source.
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; see the file COPYING. If not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+ * Boston, MA 02110-1335, USA.
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include "libaudit.h"
+#include "auparse.h"
+#include "common.h"
+#include "audit-frame.h"
+
+#define MAX_FIELDS	64
+#define STAMP		1700000000	/* Time stamp of the headers */
+
+/* What the callback saw of the last event */
+static struct {
+	int events;
+	unsigned long serial;
+	time_t sec;
+	char syscall[16];
+	char key[16];
+} seen;
+
+static void ready(auparse_state_t *au, auparse_cb_event_t type, void *data)
+{
+	const au_event_t *e = auparse_get_timestamp(au);
+	const char *val;
+
+	seen.events++;
+	seen.serial = e ? e->serial : 0;
+	seen.sec = e ? e->sec : 0;
+	seen.syscall[0] = seen.key[0] = 0;
+	auparse_first_record(au);
+	val = auparse_find_field(au, "syscall");
+	if (val)
+		snprintf(seen.syscall, sizeof(seen.syscall), "%s", val);
+	auparse_first_record(au);
+	val = auparse_find_field(au, "key");
+	if (val)
+		snprintf(seen.key, sizeof(seen.key), "%s", val);
+}
+
+/*
+ * Frames text the way the dispatcher does, with the given time stamp.
+ * If nfields is not 0 the table is cut down to that many entries. If bad
+ * is set the first entry is moved past the end of the text. Returns the
+ * length of the frame.
+ */
+static size_t frame(char *out, const char *text, unsigned long long sec,
+	unsigned long serial, unsigned int nfields, int bad)
+{
+	struct audit_frame_header hdr;
+	struct audit_frame_field f[MAX_FIELDS];
+	size_t len = strlen(text);
+	unsigned int cnt;
+
+	cnt = audit_strsplit_fields(text, len, f, MAX_FIELDS);
+	if (nfields && nfields < cnt)
+		cnt = nfields;
+	if (bad)
+		f[0].name_off = len + 10;
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, AUDISP_FRAME_MAGIC, sizeof(hdr.magic));
+	hdr.ver = AUDISP_FRAME_VER;
+	hdr.hlen = sizeof(hdr);
+	hdr.type = AUDIT_SYSCALL;
+	hdr.size = len;
+	hdr.nfields = cnt;
+	hdr.sec = sec;
+	hdr.milli = 0;
+	hdr.serial = serial;
+	memcpy(out, &hdr, sizeof(hdr));
+	memcpy(out + sizeof(hdr), f, cnt * sizeof(f[0]));
+	memcpy(out + sizeof(hdr) + cnt * sizeof(f[0]), text, len);
+	return sizeof(hdr) + cnt * sizeof(f[0]) + len;
+}
+
+static const char *syscall_rec =
+	"type=SYSCALL msg=audit(1.000:1): arch=c000003e syscall=2 "
+	"success=yes exit=3 a0=0 a1=0 a2=0 a3=0 items=0 ppid=1 pid=2 "
+	"auid=0 uid=0 gid=0 euid=0 suid=0 fsuid=0 egid=0 sgid=0 fsgid=0 "
+	"tty=(none) ses=1 comm=\"t\" exe=\"/t\" key=\"k\"\n";
+static const char *eoe_rec = "type=EOE msg=audit(1.000:1): \n";
+
+/* Frames one event, a syscall record and its EOE */
+static size_t event(char *out, unsigned long serial, unsigned int nfields,
+	int bad)
+{
+	size_t len;
+
+	len = frame(out, syscall_rec, STAMP, serial, nfields, bad);
+	return len + frame(out + len, eoe_rec, STAMP, serial, 0, 0);
+}
+
+/* Feeds data and flushes out the events it completes */
+static int feed(auparse_state_t *au, const char *data, size_t len)
+{
+	if (auparse_feed(au, data, len))
+		return 1;
+	return auparse_flush_feed(au);
+}
+
+static int expect(time_t sec, unsigned long serial, const char *syscall,
+	const char *key)
+{
+	if (seen.events != 1 || seen.serial != serial || seen.sec != sec || strcmp(seen.syscall, syscall) ||
+			strcmp(seen.key, key)) {
+		printf("Test failed - event %lu gave %d events, serial %lu, "
+			"syscall '%s', key '%s'\n", serial, seen.events,
+			seen.serial, seen.syscall, seen.key);
+		return 1;
+	}
+	seen.events = 0;
+	return 0;
+}
+
+int main(void)
+{
+	static char buf[8192];
+	auparse_state_t *au;
+	size_t len, i;
+
+	au = auparse_init(AUSOURCE_FEED_FRAMED, NULL);
+	if (au == NULL) {
+		puts("Test failed - init");
+		return 1;
+	}
+	auparse_add_callback(au, ready, NULL, NULL);
+
+	// A whole frame is split by its table and stamped by its header
+	len = event(buf, 10, 0, 0);
+	if (feed(au, buf, len) || expect(STAMP, 10, "2", "\"k\""))
+		return 1;
+
+	// Only the fields in the table are used
+	len = event(buf, 11, 4, 0);
+	if (feed(au, buf, len) || expect(STAMP, 11, "2", ""))
+		return 1;
+
+	// A frame fed a byte at a time is not used until it is all there
+	len = frame(buf, syscall_rec, STAMP, 12, 0, 0);
+	for (i = 0; i < len; i++) {
+		if (feed(au, buf + i, 1))
+			return 1;
+		if (seen.events && i + 1 < len) {
+			printf("Test failed - event ready at byte %zu of %zu\n",
+				i + 1, len);
+			return 1;
+		}
+	}
+	if (expect(STAMP, 12, "2", "\"k\""))
+		return 1;
+
+	// A table pointing outside the record is ignored and the record
+	// split up the usual way
+	len = event(buf, 13, 0, 1);
+	if (feed(au, buf, len) || expect(STAMP, 13, "2", "\"k\""))
+		return 1;
+
+	// A header that makes no sense is skipped up to the next line
+	len = frame(buf, syscall_rec, STAMP, 14, 0, 0);
+	((struct audit_frame_header *)buf)->ver = AUDISP_FRAME_VER + 1;
+	len += event(buf + len, 15, 0, 0);
+	if (feed(au, buf, len) || expect(STAMP, 15, "2", "\"k\""))
+		return 1;
+
+	// Plain text lines still work
+	len = snprintf(buf, sizeof(buf), "%s%s", syscall_rec, eoe_rec);
+	if (feed(au, buf, len))
+		return 1;
+	if (expect(1, 1, "2", "\"k\""))
+		return 1;
+
+	auparse_destroy(au);
+	puts("frame test passed");
+	return 0;
+}
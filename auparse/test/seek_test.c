@@ -0,0 +1,208 @@
+/* seek_test.c -- A test of auparse_seek_time.
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; see the file COPYING. If not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+ * Boston, MA 02110-1335, USA.
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "auparse.h"
+
+#define BASE	1700000000
+#define EVENTS	20000		/* Per file, 4 a second */
+#define LATE	10		/* Events after the target of the late one */
+
+static char file1[] = "/tmp/seek_test1.XXXXXX";
+static char file2[] = "/tmp/seek_test2.XXXXXX";
+
+static void cleanup(void)
+{
+	unlink(file1);
+	unlink(file2);
+}
+
+/* Event i of the test is stamped BASE + i/4 seconds, i%4 quarter seconds */
+static void stamp(unsigned int i, time_t *sec, unsigned int *milli)
+{
+	*sec = BASE + i / 4;
+	*milli = (i % 4) * 250;
+}
+
+static void write_event(FILE *f, time_t sec, unsigned int milli,
+			unsigned int serial)
+{
+	fprintf(f, "type=SYSCALL msg=audit(%lld.%03u:%u): arch=c000003e "
+		"syscall=2 success=yes exit=3 a0=0 a1=0 a2=0 a3=0 items=0 "
+		"ppid=1 pid=2 auid=0 uid=0 gid=0 euid=0 suid=0 fsuid=0 egid=0 "
+		"sgid=0 fsgid=0 tty=(none) ses=1 comm=\"t\" exe=\"/t\" "
+		"key=(null)\n", (long long)sec, milli, serial);
+	fprintf(f, "type=EOE msg=audit(%lld.%03u:%u): \n", (long long)sec,
+		milli, serial);
+}
+
+/*
+ * Writes events first to first + EVENTS - 1. If late is set, an event
+ * stamped a second before event late is written LATE events after it.
+ */
+static int write_log(char *path, unsigned int first, unsigned int late)
+{
+	int fd = mkstemp(path);
+	FILE *f = fd < 0 ? NULL : fdopen(fd, "w");
+	unsigned int i;
+	time_t sec;
+	unsigned int milli;
+
+	if (f == NULL)
+		return 1;
+	for (i = first; i < first + EVENTS; i++) {
+		stamp(i, &sec, &milli);
+		write_event(f, sec, milli, i + 1);
+		if (late && i == late + LATE) {
+			stamp(late, &sec, &milli);
+			write_event(f, sec - 1, milli, 1000000);
+		}
+	}
+	return fclose(f);
+}
+
+/* Returns the serial of the next event, 0 at the end and -1 on errors */
+static long next_serial(auparse_state_t *au)
+{
+	const au_event_t *e;
+	int rc = auparse_next_event(au);
+
+	if (rc <= 0)
+		return rc;
+	e = auparse_get_timestamp(au);
+	return e ? (long)e->serial : -1;
+}
+
+static int seek_to(auparse_state_t *au, unsigned int i)
+{
+	time_t sec;
+	unsigned int milli;
+
+	stamp(i, &sec, &milli);
+	return auparse_seek_time(au, sec, milli);
+}
+
+int main(void)
+{
+	const char *files[3];
+	auparse_state_t *au;
+	unsigned int target = EVENTS / 2 + 1, i;
+	long serial;
+	int late;
+
+	atexit(cleanup);
+	if (write_log(file1, 0, target) || write_log(file2, EVENTS, 0)) {
+		puts("Test failed - cannot write the logs");
+		return 1;
+	}
+
+	// The first event returned is the first one at the target
+	au = auparse_init(AUSOURCE_FILE, file1);
+	if (au == NULL || seek_to(au, target)) {
+		puts("Test failed - seek");
+		return 1;
+	}
+	serial = next_serial(au);
+	if (serial != target + 1) {
+		printf("Test failed - seek gave event %ld not %u\n", serial,
+			target + 1);
+		return 1;
+	}
+	// The lines before the seek point were not counted
+	if (auparse_get_line_number(au) != 0) {
+		puts("Test failed - line number after seek");
+		return 1;
+	}
+	// Everything after it is returned, also the one written late
+	late = 0;
+	for (i = target + 1; (serial = next_serial(au)) > 0; i++) {
+		if (serial == 1000000) {
+			late = 1;
+			i--;
+		} else if (serial != i + 1) {
+			printf("Test failed - got event %ld not %u\n", serial,
+				i + 1);
+			return 1;
+		}
+	}
+	if (serial < 0 || i != EVENTS || !late) {
+		puts("Test failed - events after the target were dropped");
+		return 1;
+	}
+
+	// Seeking before the start gives every event with its line number
+	if (auparse_seek_time(au, BASE - 100, 0) || next_serial(au) != 1 ||
+			auparse_get_line_number(au) != 1) {
+		puts("Test failed - seek before the first event");
+		return 1;
+	}
+	// Seeking past the end gives nothing
+	if (seek_to(au, EVENTS + 10) || next_serial(au) != 0) {
+		puts("Test failed - seek past the last event");
+		return 1;
+	}
+	// A reset starts over at the beginning
+	if (seek_to(au, target) || auparse_reset(au) ||
+			next_serial(au) != 1) {
+		puts("Test failed - reset after seek");
+		return 1;
+	}
+	auparse_destroy(au);
+
+	// Across files the seek lands in the right one, and reading goes on
+	// into the next file where lines are numbered again
+	files[0] = file1;
+	files[1] = file2;
+	files[2] = NULL;
+	au = auparse_init(AUSOURCE_FILE_ARRAY, files);
+	if (au == NULL || seek_to(au, EVENTS + 7) ||
+			next_serial(au) != EVENTS + 8) {
+		puts("Test failed - seek into the second file");
+		return 1;
+	}
+	if (seek_to(au, EVENTS - 2) || next_serial(au) != EVENTS - 1 ||
+			next_serial(au) != EVENTS || next_serial(au) != EVENTS + 1 ||
+			auparse_get_line_number(au) != 1) {
+		puts("Test failed - reading on into the second file");
+		return 1;
+	}
+	auparse_destroy(au);
+
+	// Only file sources can seek
+	au = auparse_init(AUSOURCE_BUFFER, "type=EOE msg=audit(1.000:1): \n");
+	errno = 0;
+	if (au == NULL || auparse_seek_time(au, BASE, 0) != -1 ||
+			errno != EINVAL) {
+		puts("Test failed - seek on a buffer");
+		return 1;
+	}
+	auparse_destroy(au);
+
+	puts("seek test passed");
+	return 0;
+}
@@ -0,0 +1,212 @@
+/* snapshot_test.c -- A test of auparse event snapshots.
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; see the file COPYING. If not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+ * Boston, MA 02110-1335, USA.
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "libaudit.h"
+#include "auparse.h"
+
+#define THREADS	4
+#define READS	10000
+
+static const char *buf =
+	"type=SYSCALL msg=audit(1143146623.787:142): arch=c000003e "
+	"syscall=2 success=yes exit=3 a0=0 a1=0 a2=0 a3=0 items=2 ppid=1 "
+	"pid=7 auid=0 uid=0 gid=0 euid=0 suid=0 fsuid=0 egid=0 sgid=0 "
+	"fsgid=0 tty=(none) ses=1 comm=\"cat\" exe=\"/bin/cat\" key=(null)\n"
+	"type=CWD msg=audit(1143146623.787:142):  cwd=\"/root\"\n"
+	"type=PATH msg=audit(1143146623.787:142): item=0 name=\"/etc/a\" "
+	"inode=1 dev=fd:00 mode=0100644 ouid=0 ogid=0 rdev=00:00\n"
+	"type=PATH msg=audit(1143146623.787:142): item=1 name=\"/etc/b\" "
+	"inode=2 dev=fd:00 mode=0100644 ouid=0 ogid=0 rdev=00:00\n"
+	"type=EOE msg=audit(1143146623.787:142): \n"
+	"type=USER_LOGIN msg=audit(1143146624.000:143): pid=9 uid=0 "
+	"auid=0 ses=1 msg='op=login acct=\"root\" exe=\"/bin/login\" "
+	"hostname=? addr=? terminal=tty1 res=success'\n";
+
+/* Checks a snapshot of event 142, whatever the parser has done since */
+static int check(const auparse_snapshot_t *s)
+{
+	const au_event_t *e = auparse_snapshot_get_timestamp(s);
+	unsigned int rec = 0, field = 0;
+	const char *val;
+
+	if (e == NULL || e->sec != 1143146623 || e->milli != 787 ||
+			e->serial != 142)
+		return 1;
+	if (auparse_snapshot_get_num_records(s) != 5 ||
+			auparse_snapshot_get_type(s, 0) != AUDIT_SYSCALL ||
+			auparse_snapshot_get_type(s, 3) != AUDIT_PATH ||
+			auparse_snapshot_get_type(s, 4) != AUDIT_EOE)
+		return 1;
+	val = auparse_snapshot_get_record_text(s, 1);
+	if (val == NULL || strstr(val, "cwd=\"/root\"") == NULL)
+		return 1;
+	val = auparse_snapshot_get_field_name(s, 0, 2);
+	if (val == NULL || strcmp(val, "syscall"))
+		return 1;
+	val = auparse_snapshot_get_field_str(s, 0, 2);
+	if (val == NULL || strcmp(val, "2"))
+		return 1;
+
+	// Every name field is found, in order, across the records
+	val = auparse_snapshot_find_field(s, "name", &rec, &field);
+	if (val == NULL || strcmp(val, "\"/etc/a\"") || rec != 2)
+		return 1;
+	field++;
+	val = auparse_snapshot_find_field(s, "name", &rec, &field);
+	if (val == NULL || strcmp(val, "\"/etc/b\"") || rec != 3)
+		return 1;
+	field++;
+	if (auparse_snapshot_find_field(s, "name", &rec, &field))
+		return 1;
+	return 0;
+}
+
+static void *reader(void *arg)
+{
+	auparse_snapshot_t *s = arg;
+	long failed = 0;
+	int i;
+
+	for (i = 0; i < READS && !failed; i++)
+		failed = check(s);
+	auparse_snapshot_unref(s);
+	return (void *)failed;
+}
+
+int main(void)
+{
+	auparse_state_t *au;
+	auparse_snapshot_t *raw, *interp;
+	pthread_t t[THREADS];
+	const char *val;
+	int i;
+
+	au = auparse_init(AUSOURCE_BUFFER, buf);
+	if (au == NULL) {
+		puts("Test failed - init");
+		return 1;
+	}
+
+	// There is nothing to copy before the first event
+	errno = 0;
+	if (auparse_snapshot_event(au, AUPARSE_SNAPSHOT_RAW) ||
+			errno != ENODATA) {
+		puts("Test failed - snapshot without an event");
+		return 1;
+	}
+
+	if (auparse_next_event(au) <= 0 || auparse_goto_record_num(au, 2) != 1 ||
+			auparse_goto_field_num(au, 2) != 1) {
+		puts("Test failed - parsing");
+		return 1;
+	}
+	raw = auparse_snapshot_event(au, AUPARSE_SNAPSHOT_RAW);
+	interp = auparse_snapshot_event(au, AUPARSE_SNAPSHOT_INTERPRET);
+	if (raw == NULL || interp == NULL || check(raw) || check(interp)) {
+		puts("Test failed - snapshot contents");
+		return 1;
+	}
+
+	// The parser's cursors are left alone
+	val = auparse_get_field_name(au);
+	if (val == NULL || strcmp(val, "name") ||
+			auparse_get_type(au) != AUDIT_PATH) {
+		puts("Test failed - cursors moved");
+		return 1;
+	}
+
+	// Raw snapshots have no interpretations, interpreted ones all of them
+	errno = 0;
+	if (auparse_snapshot_interpret_field(raw, 0, 2) || errno != ENODATA) {
+		puts("Test failed - raw snapshot interpreted");
+		return 1;
+	}
+	val = auparse_snapshot_interpret_field(interp, 0, 2);
+	if (val == NULL || strcmp(val, "open")) {
+		puts("Test failed - syscall interpretation");
+		return 1;
+	}
+	val = auparse_snapshot_interpret_field(interp, 2, 2);
+	if (val == NULL || strcmp(val, "/etc/a")) {
+		puts("Test failed - name interpretation");
+		return 1;
+	}
+	if (auparse_snapshot_get_field_type(raw, 0, 2) !=
+			AUPARSE_TYPE_SYSCALL ||
+	    auparse_snapshot_get_field_type(raw, 0, 1) != AUPARSE_TYPE_ARCH) {
+		puts("Test failed - field types");
+		return 1;
+	}
+
+	// Out of range records and fields give nothing
+	errno = 0;
+	if (auparse_snapshot_get_field_str(raw, 0, 1000) || errno != ERANGE ||
+			auparse_snapshot_get_record_text(raw, 5) ||
+			auparse_snapshot_get_num_fields(raw, 5) ||
+			auparse_snapshot_get_type(raw, 5)) {
+		puts("Test failed - out of range");
+		return 1;
+	}
+
+	// The copies outlive the parser's event and the parser itself
+	if (auparse_next_event(au) <= 0 ||
+			auparse_get_type(au) != AUDIT_USER_LOGIN) {
+		puts("Test failed - second event");
+		return 1;
+	}
+	auparse_destroy(au);
+	if (check(raw) || check(interp)) {
+		puts("Test failed - snapshot changed with the parser");
+		return 1;
+	}
+
+	// Many threads can read at once, each dropping its own reference
+	for (i = 0; i < THREADS; i++) {
+		auparse_snapshot_t *s = i % 2 ? raw : interp;
+
+		if (pthread_create(&t[i], NULL, reader,
+				   auparse_snapshot_ref(s))) {
+			puts("Test failed - cannot start threads");
+			return 1;
+		}
+	}
+	auparse_snapshot_unref(raw);
+	auparse_snapshot_unref(interp);
+	for (i = 0; i < THREADS; i++) {
+		void *failed;
+
+		pthread_join(t[i], &failed);
+		if (failed) {
+			puts("Test failed - threaded read");
+			return 1;
+		}
+	}
+
+	puts("snapshot test passed");
+	return 0;
+}
@@ -474,7 +474,8 @@ AuParser_init(AuParser *self, PyObject *args, PyObject *kwds)
             return -1;
         }
     } break;
-    case AUSOURCE_FEED: {
+    case AUSOURCE_FEED:
+    case AUSOURCE_FEED_FRAMED: {
         if (source != Py_None) {
             PyErr_SetString(PyExc_ValueError, "source must be None when source_type is AUSOURCE_FEED");
             return -1;
@@ -746,6 +747,38 @@ AuParser_reset(AuParser *self)
     return NULL;
 }
 
+/********************************
+ * auparse_seek_time
+ ********************************/
+PyDoc_STRVAR(seek_time_doc,
+"seek_time(sec, milli) Position the parser at a point in time\n\
+\n\
+seek_time positions a parser reading log files so that the next event\n\
+returned is the first one stamped at or after sec and milli. It resets\n\
+the parser first.\n\
+\n\
+Returns None.\n\
+Raises exception (EnvironmentError) on error\n\
+");
+static PyObject *
+AuParser_seek_time(AuParser *self, PyObject *args)
+{
+    PY_LONG_LONG sec;
+    int milli;
+    int result;
+
+    /* milli is int for the same reason as in search_add_timestamp_item */
+    if (!PyArg_ParseTuple(args, "Li", &sec, &milli))
+	    return NULL;
+    PARSER_CHECK;
+
+    result = auparse_seek_time(self->au, sec, (unsigned)milli);
+    if (result == 0)
+	    Py_RETURN_NONE;
+    PyErr_SetFromErrno(PyExc_EnvironmentError);
+    return NULL;
+}
+
 /********************************
  * auparse_metrics
  ********************************/
@@ -1672,6 +1705,52 @@ AuParser_get_num_records(AuParser *self)
     return Py_BuildValue("i", num_records);
 }
 
+/********************************
+ * auparse_get_execve_argv
+ ********************************/
+PyDoc_STRVAR(get_execve_argv_doc,
+"get_execve_argv() Get the command line of the current event.\n\
+\n\
+Puts the arguments logged in the event's EXECVE records back together.\n\
+Hex encoded arguments are decoded and long ones that were split are\n\
+joined.\n\
+\n\
+Returns a list of strings, or None if the event has no command line.\n\
+Raises exception (EnvironmentError) on error.\n\
+");
+static PyObject *
+AuParser_get_execve_argv(AuParser *self)
+{
+    const auparse_arg_t *argv;
+    unsigned int argc, i;
+    PyObject *list;
+
+    PARSER_CHECK;
+    argv = auparse_get_execve_argv(self->au, &argc);
+    if (argv == NULL) {
+        if (errno == ENODATA) Py_RETURN_NONE;
+        PyErr_SetFromErrno(PyExc_EnvironmentError);
+        return NULL;
+    }
+    list = PyList_New(argc);
+    if (list == NULL) return NULL;
+    for (i = 0; i < argc; i++) {
+        PyObject *arg;
+
+        if (argv[i].ptr)
+            arg = PyUnicode_DecodeFSDefaultAndSize(argv[i].ptr,
+                                                   argv[i].len);
+        else
+            arg = PYSTR_FROMSTRING("");
+        if (arg == NULL) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, arg);
+    }
+    return list;
+}
+
 /********************************
  * auparse_first_record
  ********************************/
@@ -2300,6 +2379,7 @@ static PyMethodDef AuParser_methods[] = {
     {"set_escape_mode",   (PyCFunction)AuParser_set_escape_mode,   METH_VARARGS, set_escape_mode_doc},
     {"set_eoe_timeout",   (PyCFunction)AuParser_set_eoe_timeout,   METH_VARARGS, set_eoe_timeout_doc},
     {"reset",             (PyCFunction)AuParser_reset,             METH_NOARGS,  reset_doc},
+    {"seek_time",         (PyCFunction)AuParser_seek_time,         METH_VARARGS, seek_time_doc},
     {"metrics",           (PyCFunction)AuParser_metrics,           METH_NOARGS,  metrics_doc},
     {"search_add_expression", (PyCFunction)AuParser_search_add_expression, METH_VARARGS, search_add_expression_doc},
     {"search_add_item",   (PyCFunction)AuParser_search_add_item,   METH_VARARGS, search_add_item_doc},
@@ -2330,6 +2410,7 @@ static PyMethodDef AuParser_methods[] = {
     {"aup_normalize_key", (PyCFunction)AuParser_aup_normalize_key, METH_NOARGS, aup_normalize_key_doc},
     {"get_timestamp",     (PyCFunction)AuParser_get_timestamp,     METH_NOARGS,  get_timestamp_doc},
     {"get_num_records",   (PyCFunction)AuParser_get_num_records,   METH_NOARGS,  get_num_records_doc},
+    {"get_execve_argv",   (PyCFunction)AuParser_get_execve_argv,   METH_NOARGS,  get_execve_argv_doc},
     {"first_record",      (PyCFunction)AuParser_first_record,      METH_NOARGS,  first_record_doc},
     {"next_record",       (PyCFunction)AuParser_next_record,       METH_NOARGS,  next_record_doc},
     {"get_record_num",    (PyCFunction)AuParser_get_record_num,    METH_NOARGS,  get_record_num_doc},
@@ -2373,6 +2454,7 @@ AUSOURCE_BUFFER_ARRAY: list or tuple of strings each containing audit data to pa
 AUSOURCE_DESCRIPTOR:   integer file descriptor (e.g. fileno)\n\
 AUSOURCE_FILE_POINTER: file object (e.g. types.FileType)\n\
 AUSOURCE_FEED:         None (data supplied via feed()\n\
+AUSOURCE_FEED_FRAMED:  None (framed data supplied via feed()\n\
 ");
 
 static PyTypeObject AuParserType = {
@@ -2443,6 +2525,7 @@ PyInit_auparse(void)
     PyModule_AddIntConstant(m, "AUSOURCE_DESCRIPTOR",    AUSOURCE_DESCRIPTOR);
     PyModule_AddIntConstant(m, "AUSOURCE_FILE_POINTER",  AUSOURCE_FILE_POINTER);
     PyModule_AddIntConstant(m, "AUSOURCE_FEED",          AUSOURCE_FEED);
+    PyModule_AddIntConstant(m, "AUSOURCE_FEED_FRAMED",   AUSOURCE_FEED_FRAMED);
 
     /* ausearch_op_t */
     PyModule_AddIntConstant(m, "AUSEARCH_UNSET",         AUSEARCH_UNSET);
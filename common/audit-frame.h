@@ -0,0 +1,58 @@
+/* audit-frame.h -- the framed plugin format
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#ifndef AUDIT_FRAME_HEADER
+#define AUDIT_FRAME_HEADER
+
+#include <stdint.h>
+
+/* The framed plugin format sends each record as an audit_frame_header,
+ * a table of nfields audit_frame_field, and size bytes of the same text
+ * the string format sends. The tokens of the text, as split by auparse,
+ * are located by the field table. Everything is in host byte order.
+ * A reader skips hlen bytes to get to the field table so that members
+ * can be added to the end of the header. */
+#define AUDISP_FRAME_MAGIC	"\x1e" "AUF"
+#define AUDISP_FRAME_VER	1
+
+struct audit_frame_header {
+	char		magic[4];	/* AUDISP_FRAME_MAGIC */
+	uint16_t	ver;		/* AUDISP_FRAME_VER */
+	uint16_t	hlen;		/* Header length */
+	uint32_t	type;		/* Record type */
+	uint32_t	size;		/* Size of the text after the fields */
+	uint32_t	nfields;	/* 0 if the text was not split up */
+	uint32_t	milli;		/* Event time stamp, sec is 0 if */
+	uint64_t	sec;		/*	it could not be found */
+	uint64_t	serial;
+};
+
+/* Offsets are from the start of the text. A token without an '=' has
+ * a val_off of 0 and its name is the whole token. */
+struct audit_frame_field {
+	uint16_t	name_off;
+	uint16_t	name_len;
+	uint16_t	val_off;
+	uint16_t	val_len;
+};
+
+#endif
@@ -48,8 +48,17 @@ int audit_fgets(char *buf, size_t blen, int fd)
 
 char *audit_strsplit_r(char *s, char **savedpp);
 char *audit_strsplit(char *s);
+struct audit_frame_field;
+unsigned int audit_strsplit_fields(const char *s, size_t len,
+	struct audit_frame_field *f, unsigned int max);
 int audit_is_last_record(int type);
 
+size_t audit_hex_span(const char *s, size_t len);
+size_t audit_hex_decode(unsigned char *dst, const char *src, size_t len)
+	__attr_access ((__read_only__, 2, 3));
+size_t audit_ctrl_count(const unsigned char *s, size_t len)
+	__attr_access ((__read_only__, 1, 2));
+
 AUDIT_HIDDEN_END
 #endif
 
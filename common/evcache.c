@@ -0,0 +1,236 @@
+/* evcache.c -- remember a decision for every record of an event
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "libaudit.h"
+#include "common.h"
+#include "evcache.h"
+
+#define EVCACHE_MIN	64
+
+struct evc_slot {
+	struct audit_event_id id;
+	uintptr_t val;
+	int used;
+};
+
+/*
+ * Reads the event id from the audit(sec.milli:serial) stamp at the start
+ * of a record. Returns 0 on success and 1 if there is none.
+ */
+int audit_event_id_parse(const char *msg, size_t len,
+	struct audit_event_id *id)
+{
+	const char *ptr = msg, *end = msg + len;
+	unsigned long long sec = 0;
+	unsigned int milli = 0;
+	unsigned long serial = 0;
+
+	if (len < 8 || strncmp(msg, "audit(", 6))
+		return 1;
+	for (ptr += 6; ptr < end && isdigit((unsigned char)*ptr); ptr++)
+		sec = sec * 10 + (*ptr - '0');
+	if (ptr >= end || *ptr != '.')
+		return 1;
+	for (ptr++; ptr < end && isdigit((unsigned char)*ptr); ptr++)
+		milli = milli * 10 + (*ptr - '0');
+	if (ptr >= end || *ptr != ':')
+		return 1;
+	for (ptr++; ptr < end && isdigit((unsigned char)*ptr); ptr++)
+		serial = serial * 10 + (*ptr - '0');
+	if (ptr >= end || *ptr != ')')
+		return 1;
+	id->sec = (time_t)sec;
+	id->milli = milli;
+	id->serial = serial;
+	return 0;
+}
+
+/* Returns 1 if a record of this type is an event by itself */
+int evcache_single_record(int type)
+{
+	return audit_is_last_record(type) && type != AUDIT_PROCTITLE &&
+		type != AUDIT_EOE;
+}
+
+static unsigned int id_hash(const struct audit_event_id *id)
+{
+	uint64_t h = (uint64_t)id->serial * 0x9E3779B97F4A7C15ULL;
+
+	h ^= ((uint64_t)id->sec << 10 | id->milli) * 0xC2B2AE3D27D4EB4FULL;
+	return (unsigned int)(h >> 32);
+}
+
+static inline int id_equal(const struct audit_event_id *a,
+	const struct audit_event_id *b)
+{
+	return a->serial == b->serial && a->sec == b->sec &&
+		a->milli == b->milli;
+}
+
+static inline int expired(const evcache_t *c, time_t sec)
+{
+	time_t d = c->newest - sec;
+
+	// The clock may go backwards, so look both ways
+	return d > EVCACHE_TTL || d < -EVCACHE_TTL;
+}
+
+void evcache_init(evcache_t *c)
+{
+	c->slots = NULL;
+	c->size = 0;
+	c->used = 0;
+	c->newest = 0;
+	c->swept = -1;
+}
+
+void evcache_clear(evcache_t *c)
+{
+	free(c->slots);
+	evcache_init(c);
+}
+
+static struct evc_slot *find_slot(const evcache_t *c,
+	const struct audit_event_id *id)
+{
+	unsigned int mask = c->size - 1, i;
+
+	if (c->size == 0)
+		return NULL;
+	for (i = id_hash(id) & mask; c->slots[i].used; i = (i + 1) & mask) {
+		if (id_equal(&c->slots[i].id, id))
+			return &c->slots[i];
+	}
+	return NULL;
+}
+
+/* Returns 1 and sets *val if the event is known */
+int evcache_find(const evcache_t *c, const struct audit_event_id *id,
+	uintptr_t *val)
+{
+	const struct evc_slot *s = find_slot(c, id);
+
+	// Expired events are swept out when the table fills up
+	if (s == NULL || expired(c, s->id.sec))
+		return 0;
+	*val = s->val;
+	return 1;
+}
+
+static void put(struct evc_slot *slots, unsigned int size,
+	const struct audit_event_id *id, uintptr_t val)
+{
+	unsigned int mask = size - 1, i;
+
+	for (i = id_hash(id) & mask; slots[i].used; i = (i + 1) & mask)
+		;
+	slots[i].id = *id;
+	slots[i].val = val;
+	slots[i].used = 1;
+}
+
+/* Moves the live entries to a table of the given size */
+static int rebuild(evcache_t *c, unsigned int size)
+{
+	struct evc_slot *slots = calloc(size, sizeof(struct evc_slot));
+	unsigned int i, used = 0;
+
+	if (slots == NULL)
+		return 1;
+	for (i = 0; i < c->size; i++) {
+		const struct evc_slot *s = &c->slots[i];
+
+		if (s->used && !expired(c, s->id.sec)) {
+			put(slots, size, &s->id, s->val);
+			used++;
+		}
+	}
+	free(c->slots);
+	c->slots = slots;
+	c->size = size;
+	c->used = used;
+	return 0;
+}
+
+/*
+ * Remembers val for the event. Returns 0 on success and 1 if the event
+ * could not be added because memory ran out or the table is as large as
+ * it may get and full of open events.
+ */
+int evcache_add(evcache_t *c, const struct audit_event_id *id, uintptr_t val)
+{
+	struct evc_slot *s = find_slot(c, id);
+
+	if (s) {
+		s->val = val;
+		return 0;
+	}
+	c->newest = id->sec;
+
+	// Keep the load under 3/4. Old events go first, then it grows.
+	if ((c->used + 1) * 4 > c->size * 3) {
+		unsigned int size = c->size ? c->size : EVCACHE_MIN;
+
+		// A full table is only swept again once time moves on
+		if (c->size == EVCACHE_MAX && c->swept == c->newest)
+			return 1;
+		if (c->size && rebuild(c, size))
+			return 1;
+		if (c->size == EVCACHE_MAX)
+			c->swept = c->newest;
+		while ((c->used + 1) * 2 > size && size < EVCACHE_MAX)
+			size *= 2;
+		if ((c->used + 1) * 4 > size * 3)
+			return 1;
+		if (size != c->size && rebuild(c, size))
+			return 1;
+	}
+	put(c->slots, c->size, id, val);
+	c->used++;
+	return 0;
+}
+
+void evcache_remove(evcache_t *c, const struct audit_event_id *id)
+{
+	struct evc_slot *s = find_slot(c, id);
+	unsigned int mask = c->size - 1, i, j, k;
+
+	if (s == NULL)
+		return;
+
+	// Shift later entries of the probe run back over the hole
+	i = s - c->slots;
+	for (j = (i + 1) & mask; c->slots[j].used; j = (j + 1) & mask) {
+		k = id_hash(&c->slots[j].id) & mask;
+		if ((j > i && (k <= i || k > j)) ||
+				(j < i && (k <= i && k > j))) {
+			c->slots[i] = c->slots[j];
+			i = j;
+		}
+	}
+	c->slots[i].used = 0;
+	c->used--;
+}
@@ -0,0 +1,71 @@
+/* evcache.h -- remember a decision for every record of an event
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#ifndef AUDIT_EVCACHE_HEADER
+#define AUDIT_EVCACHE_HEADER
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "dso.h"
+
+/*
+ * Records of different events can be interleaved. Anything that decides
+ * what to do with the first record of an event and wants the rest of the
+ * event to follow keeps the decision here, keyed by the full event id.
+ * An entry is removed when the event's EOE record is seen, or after
+ * EVCACHE_TTL seconds of event time for events that never get one. The
+ * table grows rather than forgetting an event that is still open.
+ */
+#define EVCACHE_TTL	30
+#define EVCACHE_MAX	(1U << 20)	/* Largest table, in slots */
+
+struct audit_event_id {
+	time_t sec;
+	unsigned int milli;
+	unsigned long serial;
+};
+
+struct evc_slot;
+
+typedef struct {
+	struct evc_slot *slots;
+	unsigned int size;	/* Number of slots, a power of 2 */
+	unsigned int used;	/* Slots holding an event */
+	time_t newest;		/* Time of the last event added */
+	time_t swept;		/* newest when a full table was last swept */
+} evcache_t;
+
+AUDIT_HIDDEN_START
+
+int audit_event_id_parse(const char *msg, size_t len,
+	struct audit_event_id *id);
+int evcache_single_record(int type);
+void evcache_init(evcache_t *c);
+void evcache_clear(evcache_t *c);
+int evcache_find(const evcache_t *c, const struct audit_event_id *id,
+	uintptr_t *val);
+int evcache_add(evcache_t *c, const struct audit_event_id *id,
+	uintptr_t val);
+void evcache_remove(evcache_t *c, const struct audit_event_id *id);
+
+AUDIT_HIDDEN_END
+#endif
@@ -0,0 +1,224 @@
+/* hexdecode.c -- decoding of hex encoded fields
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+/*
+ * The kernel hex encodes any untrusted string that has a space, quote or
+ * control character in it. proctitle, execve arguments and tty data are
+ * nearly always encoded and can be long, so the scanning and decoding is
+ * done a vector at a time when the compiler targets SSE2 or AVX2. Every
+ * loop is bounded by the length passed in and never reads past it.
+ */
+
+#include "config.h"
+#include <stddef.h>
+#include "common.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Returns the value of a hex digit or -1 if it is not one
+static inline int hex_val(unsigned char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	c |= 0x20;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+#if defined(__SSE2__)
+/*
+ * Converts 16 characters to their nibble values. Anything that is not a
+ * hex digit becomes 0. Returns a bit mask of the lanes that were not.
+ */
+static inline unsigned int hex_nibbles16(__m128i c, __m128i *val)
+{
+	const __m128i lc = _mm_or_si128(c, _mm_set1_epi8(0x20));
+	__m128i dig, alp;
+
+	// Signed compares are fine, nothing >= 0x80 is in range
+	dig = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+			    _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+	alp = _mm_and_si128(_mm_cmpgt_epi8(lc, _mm_set1_epi8('a' - 1)),
+			    _mm_cmplt_epi8(lc, _mm_set1_epi8('f' + 1)));
+	*val = _mm_or_si128(
+		_mm_and_si128(dig, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+		_mm_and_si128(alp, _mm_sub_epi8(lc, _mm_set1_epi8('a' - 10))));
+	return ~_mm_movemask_epi8(_mm_or_si128(dig, alp)) & 0xFFFF;
+}
+
+// Joins the pairs of nibbles in each 16 bit lane into a byte
+static inline __m128i hex_pairs16(__m128i val)
+{
+	return _mm_or_si128(
+		_mm_slli_epi16(_mm_and_si128(val, _mm_set1_epi16(0x00FF)), 4),
+		_mm_srli_epi16(val, 8));
+}
+#endif
+
+#if defined(__AVX2__)
+static inline unsigned int hex_nibbles32(__m256i c, __m256i *val)
+{
+	const __m256i lc = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+	__m256i dig, alp;
+
+	dig = _mm256_and_si256(
+		_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+		_mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+	alp = _mm256_and_si256(
+		_mm256_cmpgt_epi8(lc, _mm256_set1_epi8('a' - 1)),
+		_mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lc));
+	*val = _mm256_or_si256(
+		_mm256_and_si256(dig,
+			_mm256_sub_epi8(c, _mm256_set1_epi8('0'))),
+		_mm256_and_si256(alp,
+			_mm256_sub_epi8(lc, _mm256_set1_epi8('a' - 10))));
+	return ~(unsigned int)_mm256_movemask_epi8(
+				_mm256_or_si256(dig, alp));
+}
+
+static inline __m256i hex_pairs32(__m256i val)
+{
+	return _mm256_or_si256(
+		_mm256_slli_epi16(_mm256_and_si256(val,
+				_mm256_set1_epi16(0x00FF)), 4),
+		_mm256_srli_epi16(val, 8));
+}
+#endif
+
+/*
+ * Returns the number of hex digits at the start of s, looking at no more
+ * than len characters.
+ */
+size_t audit_hex_span(const char *s, size_t len)
+{
+	const unsigned char *p = (const unsigned char *)s;
+	size_t i = 0;
+#if defined(__SSE2__)
+	__m128i val;
+	unsigned int bad;
+#endif
+#if defined(__AVX2__)
+	__m256i val32;
+
+	for (; i + 32 <= len; i += 32) {
+		bad = hex_nibbles32(_mm256_loadu_si256(
+					(const __m256i *)(p + i)), &val32);
+		if (bad)
+			return i + __builtin_ctz(bad);
+	}
+#endif
+#if defined(__SSE2__)
+	for (; i + 16 <= len; i += 16) {
+		bad = hex_nibbles16(_mm_loadu_si128(
+					(const __m128i *)(p + i)), &val);
+		if (bad)
+			return i + __builtin_ctz(bad);
+	}
+#endif
+	while (i < len && hex_val(p[i]) >= 0)
+		i++;
+	return i;
+}
+
+/*
+ * Decodes len hex digits from src into dst, which must have room for
+ * (len + 1) / 2 bytes. A character that is not a hex digit counts as 0
+ * and an odd digit at the end becomes the high nibble of the last byte.
+ * The result is not terminated. Returns the number of bytes written.
+ */
+size_t audit_hex_decode(unsigned char *dst, const char *src, size_t len)
+{
+	const unsigned char *p = (const unsigned char *)src;
+	size_t i = 0, o = 0;
+	int hi, lo;
+#if defined(__SSE2__)
+	__m128i v1, v2;
+#endif
+#if defined(__AVX2__)
+	__m256i w1, w2;
+
+	for (; i + 64 <= len; i += 64, o += 32) {
+		hex_nibbles32(_mm256_loadu_si256(
+				(const __m256i *)(p + i)), &w1);
+		hex_nibbles32(_mm256_loadu_si256(
+				(const __m256i *)(p + i + 32)), &w2);
+		// The pack works within each 128 bit lane, put them in order
+		w1 = _mm256_packus_epi16(hex_pairs32(w1), hex_pairs32(w2));
+		_mm256_storeu_si256((__m256i *)(dst + o),
+				_mm256_permute4x64_epi64(w1, 0xD8));
+	}
+#endif
+#if defined(__SSE2__)
+	for (; i + 32 <= len; i += 32, o += 16) {
+		hex_nibbles16(_mm_loadu_si128((const __m128i *)(p + i)), &v1);
+		hex_nibbles16(_mm_loadu_si128((const __m128i *)(p + i + 16)),
+				&v2);
+		_mm_storeu_si128((__m128i *)(dst + o),
+			_mm_packus_epi16(hex_pairs16(v1), hex_pairs16(v2)));
+	}
+#endif
+	for (; i + 1 < len; i += 2) {
+		hi = hex_val(p[i]);
+		lo = hex_val(p[i + 1]);
+		dst[o++] = (unsigned char)(((hi < 0 ? 0 : hi) << 4) |
+					   (lo < 0 ? 0 : lo));
+	}
+	if (i < len) {
+		hi = hex_val(p[i]);
+		dst[o++] = (unsigned char)((hi < 0 ? 0 : hi) << 4);
+	}
+	return o;
+}
+
+// Returns how many of the len bytes at s are control characters
+size_t audit_ctrl_count(const unsigned char *s, size_t len)
+{
+	size_t i = 0, cnt = 0;
+#if defined(__SSE2__)
+	const __m128i max16 = _mm_set1_epi8(31);
+#endif
+#if defined(__AVX2__)
+	const __m256i max32 = _mm256_set1_epi8(31);
+
+	for (; i + 32 <= len; i += 32) {
+		__m256i c = _mm256_loadu_si256((const __m256i *)(s + i));
+		cnt += __builtin_popcount((unsigned int)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(_mm256_min_epu8(c, max32), c)));
+	}
+#endif
+#if defined(__SSE2__)
+	for (; i + 16 <= len; i += 16) {
+		__m128i c = _mm_loadu_si128((const __m128i *)(s + i));
+		cnt += __builtin_popcount(_mm_movemask_epi8(
+			_mm_cmpeq_epi8(_mm_min_epu8(c, max16), c)));
+	}
+#endif
+	for (; i < len; i++) {
+		if (s[i] < 32)
+			cnt++;
+	}
+	return cnt;
+}
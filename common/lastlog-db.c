@@ -0,0 +1,161 @@
+/* lastlog-db.c -- on disk last login database
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *      agent <agent@local>
+ */
+
+#include "config.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "lastlog-db.h"
+
+struct aulastlog_hdr {
+	char magic[8];
+	uint32_t version;
+	uint32_t rec_size;
+	int64_t created;	// Logins before this are only in the logs
+};
+
+static uint32_t rec_check(const struct aulastlog_rec *rec)
+{
+	const unsigned char *ptr = (const unsigned char *)&rec->auid;
+	const unsigned char *end = (const unsigned char *)(rec + 1);
+	uint32_t h = 2166136261U;
+
+	while (ptr < end) {
+		h ^= *ptr++;
+		h *= 16777619U;
+	}
+	// 0 marks an unused slot
+	return h ? h : 1;
+}
+
+static off_t rec_offset(uid_t auid)
+{
+	// Slot 0 holds the header
+	return ((off_t)auid + 1) * (off_t)sizeof(struct aulastlog_rec);
+}
+
+/*
+ * Open the database and check its header. A writer creates it if needed.
+ * Returns the descriptor or -1 with errno set.
+ */
+int aulastlog_db_open(const char *path, int writable)
+{
+	struct aulastlog_hdr hdr;
+	struct stat sb;
+	int fd, saved;
+
+	if (writable)
+		fd = open(path, O_RDWR|O_CREAT|O_CLOEXEC, 0640);
+	else
+		fd = open(path, O_RDONLY|O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &sb))
+		goto err;
+
+	if (sb.st_size == 0 && writable) {
+		memset(&hdr, 0, sizeof(hdr));
+		memcpy(hdr.magic, AULASTLOG_MAGIC, sizeof(hdr.magic));
+		hdr.version = AULASTLOG_VERSION;
+		hdr.rec_size = sizeof(struct aulastlog_rec);
+		hdr.created = time(NULL);
+		if (pwrite(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr))
+			goto err;
+		return fd;
+	}
+
+	if (pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+			memcmp(hdr.magic, AULASTLOG_MAGIC, sizeof(hdr.magic)) ||
+			hdr.version != AULASTLOG_VERSION ||
+			hdr.rec_size != sizeof(struct aulastlog_rec)) {
+		errno = EPROTO;
+		goto err;
+	}
+	return fd;
+err:
+	saved = errno;
+	close(fd);
+	errno = saved;
+	return -1;
+}
+
+/* Returns the time the database was created, or 0 if it is unknown */
+time_t aulastlog_db_created(int fd)
+{
+	struct aulastlog_hdr hdr;
+
+	if (pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr))
+		return 0;
+	return (time_t)hdr.created;
+}
+
+/*
+ * Read the record of auid. Returns 1 if there is one, 0 if the account
+ * never logged in, and -1 on errors. A record that stays damaged sets
+ * errno to EBADMSG.
+ */
+int aulastlog_db_read(int fd, uid_t auid, struct aulastlog_rec *rec)
+{
+	int tries;
+
+	for (tries = 0; tries < 3; tries++) {
+		ssize_t rc = pread(fd, rec, sizeof(*rec), rec_offset(auid));
+
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		// Past the end of the file or a hole
+		if (rc == 0 || (rc == sizeof(*rec) && rec->check == 0))
+			return 0;
+		// A mismatch is a write in progress, try again
+		if (rc == sizeof(*rec) && rec->check == rec_check(rec) &&
+						rec->auid == auid) {
+			rec->term[AULASTLOG_TERM_SIZE-1] = 0;
+			rec->host[AULASTLOG_HOST_SIZE-1] = 0;
+			return 1;
+		}
+	}
+	errno = EBADMSG;
+	return -1;
+}
+
+/* Write the record to the slot of rec->auid. Returns 0 on success. */
+int aulastlog_db_write(int fd, struct aulastlog_rec *rec)
+{
+	ssize_t rc;
+
+	rec->check = rec_check(rec);
+	do {
+		rc = pwrite(fd, rec, sizeof(*rec), rec_offset(rec->auid));
+	} while (rc < 0 && errno == EINTR);
+	if (rc != sizeof(*rec)) {
+		if (rc >= 0)
+			errno = EIO;
+		return -1;
+	}
+	return 0;
+}
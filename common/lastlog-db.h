@@ -0,0 +1,60 @@
+/* lastlog-db.h -- on disk last login database
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *      agent <agent@local>
+ */
+
+#ifndef AULASTLOG_DB_HEADER
+#define AULASTLOG_DB_HEADER
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+#include "dso.h"
+
+/*
+ * The database is an array of fixed size records indexed by auid, the
+ * first slot holding the header. Unused slots are holes in a sparse file
+ * so it only takes space for the accounts that have logged in. Each
+ * record is written with one pwrite and carries a checksum so that a
+ * reader never uses a torn record.
+ */
+#define AULASTLOG_DB		"/var/lib/audit/lastlog"
+#define AULASTLOG_MAGIC		"AULASTLG"
+#define AULASTLOG_VERSION	1
+#define AULASTLOG_TERM_SIZE	32
+#define AULASTLOG_HOST_SIZE	256
+
+struct aulastlog_rec {
+	uint32_t check;		// Checksum of the rest, 0 if the slot is unused
+	uint32_t auid;		// Account the record belongs to
+	int64_t sec;		// Time of the last login
+	char term[AULASTLOG_TERM_SIZE];	// Terminal of the last login
+	char host[AULASTLOG_HOST_SIZE];	// Host logged in from
+};
+
+AUDIT_HIDDEN_START
+
+int aulastlog_db_open(const char *path, int writable);
+time_t aulastlog_db_created(int fd);
+int aulastlog_db_read(int fd, uid_t auid, struct aulastlog_rec *rec);
+int aulastlog_db_write(int fd, struct aulastlog_rec *rec);
+
+AUDIT_HIDDEN_END
+#endif
@@ -22,7 +22,10 @@
  */
 
 #include <string.h>
+#include <stdint.h>
+#include "libaudit.h"
 #include "common.h"
+#include "audit-frame.h"
 
 char *audit_strsplit_r(char *s, char **savedpp)
 {
@@ -86,3 +89,48 @@ retry:
 		return s;
 	}
 }
+
+/*
+ * Locate the tokens audit_strsplit_r would return for a record without
+ * changing it. The record ends at len, a NUL, or the start of the
+ * interpretations. Returns the number of tokens, or 0 if they do not fit
+ * in max entries or the record is too long for the offsets.
+ */
+unsigned int audit_strsplit_fields(const char *s, size_t len,
+	struct audit_frame_field *f, unsigned int max)
+{
+	unsigned int cnt = 0;
+	size_t i = 0;
+
+	while (i < len) {
+		size_t start, eq = len;
+
+		while (i < len && s[i] == ' ')
+			i++;
+		if (i == len || s[i] == 0 || s[i] == AUDIT_INTERP_SEPARATOR)
+			break;
+		start = i;
+		while (i < len && s[i] != ' ' && s[i] != 0 &&
+				s[i] != AUDIT_INTERP_SEPARATOR) {
+			if (s[i] == '=' && eq == len)
+				eq = i;
+			i++;
+		}
+		if (cnt == max || i > UINT16_MAX)
+			return 0;
+		f[cnt].name_off = start;
+		if (eq != len) {
+			f[cnt].name_len = eq - start;
+			f[cnt].val_off = eq + 1;
+			f[cnt].val_len = i - eq - 1;
+		} else {
+			f[cnt].name_len = i - start;
+			f[cnt].val_off = 0;
+			f[cnt].val_len = 0;
+		}
+		cnt++;
+		if (i < len && s[i] != ' ')
+			break;
+	}
+	return cnt;
+}
@@ -27,6 +27,7 @@
 #include <limits.h>
 #include <linux/net.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -170,12 +171,10 @@ output_strings(const char *prefix)
 	fputs("\";\n", stdout);
 }
 
-/* Output the string to integer mapping code.
-   Assume strings are all uppsercase or all lowercase if specified by
-   parameters; in that case, make the search case-insensitive.
-   values must be sorted by strings. */
+/* Check that the strings are unique and, if a case was specified, that
+   they are all in that case. values must be sorted by strings. */
 static void
-output_s2i(const char *prefix, bool uppercase, bool lowercase)
+check_s2i_strings(bool uppercase, bool lowercase)
 {
 	size_t i;
 
@@ -187,23 +186,6 @@ output_s2i(const char *prefix, bool uppercase, bool lowercase)
 			abort();
 		}
 	}
-	printf("static const unsigned %s_s2i_s[] = {", prefix);
-	for (i = 0; i < NUM_VALUES; i++) {
-		if (i % 10 == 0)
-			fputs("\n\t", stdout);
-		assert(values[i].s_offset <= UINT_MAX);
-		printf("%zu,", values[i].s_offset);
-	}
-	printf("\n"
-	       "};\n"
-	       "static const int %s_s2i_i[] = {", prefix);
-	for (i = 0; i < NUM_VALUES; i++) {
-		if (i % 10 == 0)
-			fputs("\n\t", stdout);
-		printf("%d,", values[i].val);
-	}
-	fputs("\n"
-	      "};\n", stdout);
 	assert(!(uppercase && lowercase));
 	if (uppercase) {
 		for (i = 0; i < NUM_VALUES; i++) {
@@ -222,6 +204,35 @@ output_s2i(const char *prefix, bool uppercase, bool lowercase)
 				       && !GT_ISUPPER(*c));
 		}
 	}
+}
+
+/* Output the string to integer mapping code.
+   Assume strings are all uppsercase or all lowercase if specified by
+   parameters; in that case, make the search case-insensitive.
+   values must be sorted by strings. */
+static void
+output_s2i(const char *prefix, bool uppercase, bool lowercase)
+{
+	size_t i;
+
+	check_s2i_strings(uppercase, lowercase);
+	printf("static const unsigned %s_s2i_s[] = {", prefix);
+	for (i = 0; i < NUM_VALUES; i++) {
+		if (i % 10 == 0)
+			fputs("\n\t", stdout);
+		assert(values[i].s_offset <= UINT_MAX);
+		printf("%zu,", values[i].s_offset);
+	}
+	printf("\n"
+	       "};\n"
+	       "static const int %s_s2i_i[] = {", prefix);
+	for (i = 0; i < NUM_VALUES; i++) {
+		if (i % 10 == 0)
+			fputs("\n\t", stdout);
+		printf("%d,", values[i].val);
+	}
+	fputs("\n"
+	      "};\n", stdout);
 	if (uppercase || lowercase) {
 		printf("static int %s_s2i(const char *s, int *value) {\n"
 		       "\tsize_t len, i;\n"
@@ -250,6 +261,204 @@ output_s2i(const char *prefix, bool uppercase, bool lowercase)
 		       "}\n", prefix, prefix, prefix, prefix, NUM_VALUES);
 }
 
+/* Hash a string for the perfect hash tables, folding the case like the
+   lookup does. This must match the code emitted by output_s2i_hash(). */
+static uint32_t
+hash_string(const char *s, bool uppercase, bool lowercase)
+{
+	uint32_t h = 2166136261u;
+
+	for (; *s != '\0'; s++) {
+		unsigned char c = *s;
+
+		if (uppercase && GT_ISLOWER(c))
+			c = c - 'a' + 'A';
+		else if (lowercase && GT_ISUPPER(c))
+			c = c - 'A' + 'a';
+		h = (h ^ c) * 16777619u;
+	}
+	return h;
+}
+
+/* Mix the bucket's seed into a string hash to get its slot. */
+static uint32_t
+hash_mix(uint32_t h, uint32_t seed)
+{
+	h ^= seed * 0x9e3779b9u;
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+static const size_t *bucket_sizes;
+
+/* Compare two buckets by size, largest first. */
+static int
+cmp_bucket_sizes(const void *xa, const void *xb)
+{
+	size_t a = *(const size_t *)xa, b = *(const size_t *)xb;
+
+	if (bucket_sizes[a] != bucket_sizes[b])
+		return bucket_sizes[a] < bucket_sizes[b] ? 1 : -1;
+	return a < b ? -1 : a > b;
+}
+
+/* Output the string to integer mapping as a perfect hash. The strings are
+   spread over buckets of about 4, then every bucket gets the first seed
+   that puts its strings into free slots. A lookup is one hash, one seed
+   load and one string compare. Returns false if no table could be built,
+   the caller then falls back to the bsearch tables. */
+static bool
+output_s2i_hash(const char *prefix, bool uppercase, bool lowercase)
+{
+	size_t i, j, b, nbuckets, nslots, *order, *members, *sizes;
+	uint32_t *hashes, *seeds;
+	long *slots;
+	bool ok = true;
+
+	check_s2i_strings(uppercase, lowercase);
+	nbuckets = (NUM_VALUES + 3) / 4;
+	for (nslots = 1; nslots < NUM_VALUES; nslots *= 2)
+		;
+	hashes = malloc(NUM_VALUES * sizeof(*hashes));
+	seeds = calloc(nbuckets, sizeof(*seeds));
+	order = malloc(nbuckets * sizeof(*order));
+	members = malloc(NUM_VALUES * sizeof(*members));
+	slots = malloc(nslots * sizeof(*slots));
+	sizes = calloc(nbuckets, sizeof(*sizes));
+	if (hashes == NULL || seeds == NULL || order == NULL ||
+	    members == NULL || slots == NULL || sizes == NULL) {
+		fprintf(stderr, "Out of memory. Check %s file, %d line", __FILE__, __LINE__);
+		abort();
+	}
+
+	for (i = 0; i < nslots; i++)
+		slots[i] = -1;
+	for (i = 0; i < NUM_VALUES; i++) {
+		hashes[i] = hash_string(values[i].s, uppercase, lowercase);
+		sizes[hashes[i] % nbuckets]++;
+	}
+	for (b = 0; b < nbuckets; b++)
+		order[b] = b;
+	bucket_sizes = sizes;
+	qsort(order, nbuckets, sizeof(*order), cmp_bucket_sizes);
+
+	for (b = 0; ok && b < nbuckets && sizes[order[b]]; b++) {
+		size_t n = 0;
+		uint32_t seed;
+
+		for (i = 0; i < NUM_VALUES; i++)
+			if (hashes[i] % nbuckets == order[b])
+				members[n++] = i;
+		for (seed = 0; seed < (1u << 20); seed++) {
+			for (i = 0; i < n; i++) {
+				size_t s = hash_mix(hashes[members[i]], seed) &
+					   (nslots - 1);
+
+				if (slots[s] != -1)
+					break;
+				slots[s] = members[i];
+			}
+			if (i == n)
+				break;
+			// Give back the slots taken by this attempt
+			for (j = 0; j < i; j++)
+				slots[hash_mix(hashes[members[j]], seed) &
+				      (nslots - 1)] = -1;
+		}
+		if (seed == (1u << 20))
+			ok = false;
+		seeds[order[b]] = seed;
+	}
+
+	if (ok) {
+		printf("static const unsigned %s_s2i_seed[] = {", prefix);
+		for (i = 0; i < nbuckets; i++) {
+			if (i % 10 == 0)
+				fputs("\n\t", stdout);
+			printf("%u,", seeds[i]);
+		}
+		printf("\n"
+		       "};\n"
+		       "static const unsigned %s_s2i_hs[] = {", prefix);
+		for (i = 0; i < nslots; i++) {
+			if (i % 10 == 0)
+				fputs("\n\t", stdout);
+			if (slots[i] == -1)
+				fputs("-1u,", stdout);
+			else {
+				assert(values[slots[i]].s_offset <= UINT_MAX);
+				printf("%zu,", values[slots[i]].s_offset);
+			}
+		}
+		printf("\n"
+		       "};\n"
+		       "static const int %s_s2i_hi[] = {", prefix);
+		for (i = 0; i < nslots; i++) {
+			if (i % 10 == 0)
+				fputs("\n\t", stdout);
+			printf("%d,", slots[i] == -1 ? 0 : values[slots[i]].val);
+		}
+		fputs("\n"
+		      "};\n", stdout);
+		printf("static int %s_s2i(const char *s, int *value) {\n"
+		       "\tuint32_t h = 2166136261u;\n"
+		       "\tconst char *p, *t;\n"
+		       "\tunsigned off;\n"
+		       "\tif (s == NULL || value == NULL)\n"
+		       "\t\treturn 0;\n"
+		       "\tfor (p = s; *p != '\\0'; p++) {\n"
+		       "\t\tunsigned char c = *p;\n", prefix);
+		if (uppercase)
+			fputs("\t\tif (GT_ISLOWER(c)) c = c - 'a' + 'A';\n",
+			      stdout);
+		else if (lowercase)
+			fputs("\t\tif (GT_ISUPPER(c)) c = c - 'A' + 'a';\n",
+			      stdout);
+		printf("\t\th = (h ^ c) * 16777619u;\n"
+		       "\t}\n"
+		       "\th ^= %s_s2i_seed[h %% %zuu] * 0x9e3779b9u;\n"
+		       "\th ^= h >> 16;\n"
+		       "\th *= 0x85ebca6bu;\n"
+		       "\th ^= h >> 13;\n"
+		       "\th *= 0xc2b2ae35u;\n"
+		       "\th ^= h >> 16;\n"
+		       "\th &= %zuu;\n"
+		       "\toff = %s_s2i_hs[h];\n"
+		       "\tif (off == -1u)\n"
+		       "\t\treturn 0;\n"
+		       "\tfor (p = s, t = %s_strings + off; *t != '\\0'; "
+			      "p++, t++) {\n"
+		       "\t\tunsigned char c = *p;\n", prefix, nbuckets,
+		       nslots - 1, prefix, prefix);
+		if (uppercase)
+			fputs("\t\tif (GT_ISLOWER(c)) c = c - 'a' + 'A';\n",
+			      stdout);
+		else if (lowercase)
+			fputs("\t\tif (GT_ISUPPER(c)) c = c - 'A' + 'a';\n",
+			      stdout);
+		printf("\t\tif (c != (unsigned char)*t)\n"
+		       "\t\t\treturn 0;\n"
+		       "\t}\n"
+		       "\tif (*p != '\\0')\n"
+		       "\t\treturn 0;\n"
+		       "\t*value = %s_s2i_hi[h];\n"
+		       "\treturn 1;\n"
+		       "}\n", prefix);
+	}
+
+	free(sizes);
+	free(slots);
+	free(members);
+	free(order);
+	free(seeds);
+	free(hashes);
+	return ok;
+}
+
 /* Output the string to integer mapping table.
    values must be sorted by strings. */
 static void
@@ -371,7 +580,7 @@ output_i2s_transtab(const char *prefix)
 int
 main(int argc, char **argv)
 {
-	bool gen_i2s, gen_i2s_transtab, gen_s2i, uppercase, lowercase;
+	bool gen_i2s, gen_i2s_transtab, gen_s2i, s2i_hash, uppercase, lowercase;
 	char *prefix;
 	size_t i;
 
@@ -383,6 +592,7 @@ main(int argc, char **argv)
 	gen_i2s = false;
 	gen_i2s_transtab = false;
 	gen_s2i = false;
+	s2i_hash = false;
 	uppercase = false;
 	lowercase = false;
 	prefix = NULL;
@@ -394,6 +604,10 @@ main(int argc, char **argv)
 			gen_i2s_transtab = true;
 		else if (strcmp(argv[i], "--s2i") == 0)
 			gen_s2i = true;
+		else if (strcmp(argv[i], "--s2i-hash") == 0) {
+			gen_s2i = true;
+			s2i_hash = true;
+		}
 		else if (strcmp(argv[i], "--uppercase") == 0)
 			uppercase = true;
 		else if (strcmp(argv[i], "--lowercase") == 0)
@@ -420,8 +634,11 @@ main(int argc, char **argv)
 	/* FIXME? If the only thing generated is a transtab, keep the strings
 	   in the original order to use the cache better. */
 	output_strings(prefix);
-	if (gen_s2i)
-		output_s2i(prefix, uppercase, lowercase);
+	if (gen_s2i) {
+		if (!s2i_hash ||
+		    !output_s2i_hash(prefix, uppercase, lowercase))
+			output_s2i(prefix, uppercase, lowercase);
+	}
 	if (gen_i2s) {
 		qsort(values, NUM_VALUES, sizeof(*values), cmp_value_vals);
 		output_i2s(prefix);
@@ -867,6 +867,177 @@ int audit_delete_rule_data(int fd, struct audit_rule_data *rule,
 	return rc;
 }
 
+/*
+ * Rule set fingerprints. Each rule is hashed from a canonical form of its
+ * audit_rule_data so that a rule built by auditctl and the same rule listed
+ * back by the kernel hash the same. The kernel lists rules grouped by
+ * filter list, so rules are chained per list and the lists are combined in
+ * list order. This is FNV-1a, it detects drift, not tampering.
+ */
+#define FP_OFFSET 0xcbf29ce484222325ULL
+#define FP_PRIME  0x100000001b3ULL
+
+static uint64_t fp_bytes(uint64_t h, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		h ^= p[i];
+		h *= FP_PRIME;
+	}
+	return h;
+}
+
+/* Hash the value little endian so all machines agree */
+static uint64_t fp_u32(uint64_t h, uint32_t v)
+{
+	unsigned char b[4];
+
+	b[0] = v & 0xFF;
+	b[1] = (v >> 8) & 0xFF;
+	b[2] = (v >> 16) & 0xFF;
+	b[3] = v >> 24;
+	return fp_bytes(h, b, sizeof(b));
+}
+
+static uint64_t fp_u64(uint64_t h, uint64_t v)
+{
+	h = fp_u32(h, (uint32_t)v);
+	return fp_u32(h, (uint32_t)(v >> 32));
+}
+
+static int fp_string_field(int field)
+{
+	return ((field >= AUDIT_SUBJ_USER && field <= AUDIT_OBJ_LEV_HIGH)
+		&& field != AUDIT_PPID) || field == AUDIT_WATCH ||
+		field == AUDIT_DIR || field == AUDIT_FILTERKEY ||
+		field == AUDIT_EXE;
+}
+
+uint64_t audit_rule_hash_data(const struct audit_rule_data *rule)
+{
+	uint64_t h = FP_OFFSET;
+	unsigned int i;
+	size_t boffset = 0;
+
+	// The prepend flag only says where the kernel put the rule
+	h = fp_u32(h, rule->flags & ~AUDIT_FILTER_PREPEND);
+	h = fp_u32(h, rule->action);
+
+	// The kernel expands syscall classes and clears their bits
+	for (i = 0; i < AUDIT_BITMASK_SIZE; i++) {
+		uint32_t mask = rule->mask[i];
+
+		if (i == AUDIT_BITMASK_SIZE - 1)
+			mask &= ~(((1U << AUDIT_SYSCALL_CLASSES) - 1) <<
+					(32 - AUDIT_SYSCALL_CLASSES));
+		h = fp_u32(h, mask);
+	}
+
+	h = fp_u32(h, rule->field_count);
+	for (i = 0; i < rule->field_count && i < AUDIT_MAX_FIELDS; i++) {
+		int field = rule->fields[i] & ~AUDIT_OPERATORS;
+
+		h = fp_u32(h, field);
+		h = fp_u32(h, rule->fieldflags[i] & AUDIT_OPERATORS);
+		h = fp_u32(h, rule->values[i]);
+		if (fp_string_field(field)) {
+			size_t len = rule->values[i];
+
+			if (boffset + len > rule->buflen)
+				len = boffset < rule->buflen ?
+					rule->buflen - boffset : 0;
+			h = fp_bytes(h, &rule->buf[boffset], len);
+			boffset += len;
+		}
+	}
+	return h;
+}
+
+void audit_fingerprint_init(struct audit_fingerprint *fp)
+{
+	unsigned int i;
+
+	for (i = 0; i <= AUDIT_FILTER_MASK; i++) {
+		fp->list[i] = FP_OFFSET;
+		fp->count[i] = 0;
+	}
+}
+
+void audit_fingerprint_add_rule(struct audit_fingerprint *fp,
+				const struct audit_rule_data *rule)
+{
+	unsigned int list = rule->flags & AUDIT_FILTER_MASK;
+
+	fp->list[list] = fp_u64(fp->list[list], audit_rule_hash_data(rule));
+	fp->count[list]++;
+}
+
+void audit_fingerprint_format(const struct audit_fingerprint *fp,
+				char *buf, size_t len)
+{
+	uint64_t h = FP_OFFSET;
+	unsigned int i;
+
+	for (i = 0; i <= AUDIT_FILTER_MASK; i++) {
+		if (fp->count[i] == 0)
+			continue;
+		h = fp_u32(h, i);
+		h = fp_u32(h, fp->count[i]);
+		h = fp_u64(h, fp->list[i]);
+	}
+	snprintf(buf, len, "%016llx", (unsigned long long)h);
+}
+
+/*
+ * Lists the kernel's rules and puts their fingerprint in buf. The fd should
+ * not be the one auditd receives events on. Returns 0 on success and -1
+ * on errors.
+ */
+int audit_get_rules_fingerprint(int fd, char *buf, size_t len)
+{
+	struct audit_fingerprint fp;
+	struct audit_reply rep;
+	int rc, timeout = 40;	// Each wait is .1 second
+
+	if (audit_request_rules_list_data(fd) <= 0)
+		return -1;
+
+	audit_fingerprint_init(&fp);
+	while (timeout) {
+		struct pollfd pfd[1];
+
+		pfd[0].fd = fd;
+		pfd[0].events = POLLIN;
+		do {
+			rc = poll(pfd, 1, 100);
+		} while (rc < 0 && errno == EINTR);
+		if (rc == 0) {
+			timeout--;
+			continue;
+		}
+
+		while ((rc = audit_get_reply(fd, &rep,
+					GET_REPLY_NONBLOCKING, 0)) > 0) {
+			if (rep.type == AUDIT_LIST_RULES)
+				audit_fingerprint_add_rule(&fp, rep.ruledata);
+			else if (rep.type == NLMSG_DONE) {
+				audit_fingerprint_format(&fp, buf, len);
+				return 0;
+			} else if (rep.type == NLMSG_ERROR &&
+					rep.error->error) {
+				errno = -rep.error->error;
+				return -1;
+			}
+		}
+		if (rc < 0 && rc != -EAGAIN)
+			return -1;
+	}
+	errno = ETIMEDOUT;
+	return -1;
+}
+
 /*
  * This function is part of the directory auditing code
  */
@@ -213,6 +213,7 @@ int        audit_name_to_field(const char *field);
 const char *audit_field_to_name(int field);
 int        audit_name_to_syscall(const char *sc, int machine);
 const char *audit_syscall_to_name(int sc, int machine);
+const char *audit_elf_syscall_to_name(unsigned int elf, int sc);
 const char *audit_uringop_to_name(int uringop);
 int        audit_name_to_uringop(const char *uringop);
 int        audit_name_to_flag(const char *flag);
@@ -278,6 +279,20 @@ int audit_add_rule_data(int fd, struct audit_rule_data *rule,
 int audit_delete_rule_data(int fd, struct audit_rule_data *rule,
                                   int flags, int action);
 
+/* Rule set fingerprints */
+struct audit_fingerprint {
+	uint64_t	list[AUDIT_FILTER_MASK + 1];	/* Hash per filter list */
+	uint32_t	count[AUDIT_FILTER_MASK + 1];	/* Rules per filter list */
+};
+#define AUDIT_FINGERPRINT_LEN 17	/* Hex digits and the NUL */
+uint64_t audit_rule_hash_data(const struct audit_rule_data *rule);
+void audit_fingerprint_init(struct audit_fingerprint *fp);
+void audit_fingerprint_add_rule(struct audit_fingerprint *fp,
+				const struct audit_rule_data *rule);
+void audit_fingerprint_format(const struct audit_fingerprint *fp,
+				char *buf, size_t len);
+int audit_get_rules_fingerprint(int fd, char *buf, size_t len);
+
 /* Rule-building helper functions */
 /* Heap-allocates and initializes an audit_rule_data */
 struct audit_rule_data *audit_rule_create_data(void);
@@ -211,6 +211,40 @@ const char *audit_syscall_to_name(int sc, int machine)
 	return NULL;
 }
 
+/*
+ * Syscall records carry the ELF arch. Going straight from it to the arch's
+ * direct indexed table saves mapping it to a machine first.
+ */
+const char *audit_elf_syscall_to_name(unsigned int elf, int sc)
+{
+#ifndef NO_TABLES
+	switch (elf)
+	{
+		case AUDIT_ARCH_I386:
+			return i386_syscall_i2s(sc);
+		case AUDIT_ARCH_X86_64:
+			return x86_64_syscall_i2s(sc);
+		case AUDIT_ARCH_PPC64:
+		case AUDIT_ARCH_PPC64LE:
+		case AUDIT_ARCH_PPC:
+			return ppc_syscall_i2s(sc);
+		case AUDIT_ARCH_S390X:
+			return s390x_syscall_i2s(sc);
+		case AUDIT_ARCH_S390:
+			return s390_syscall_i2s(sc);
+#ifdef WITH_ARM
+		case AUDIT_ARCH_ARM:
+			return arm_syscall_i2s(sc);
+#endif
+#ifdef WITH_AARCH64
+		case AUDIT_ARCH_AARCH64:
+			return aarch64_syscall_i2s(sc);
+#endif
+	}
+#endif
+	return NULL;
+}
+
 int audit_name_to_flag(const char *flag)
 {
 	int res;
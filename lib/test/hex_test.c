@@ -0,0 +1,192 @@
+/* hex_test.c -- A test of the hex decoding helpers.
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+/*
+ * The helpers work a vector at a time when the compiler allows it. Each
+ * one is checked against a byte at a time version for every length up
+ * to a few vectors past the widest one, at every alignment, with a bad
+ * byte at every position, and with the input ending at an unmapped page.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "common.h"
+
+#define MAX_LEN	200		/* Past 64 + 32 + 16 and their tails */
+#define ALIGNS	32
+#define CANARY	0xA5
+
+static const char digits[] = "0123456789abcdefABCDEF";
+
+static int ref_val(unsigned char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+static size_t ref_span(const char *s, size_t len)
+{
+	size_t i = 0;
+
+	while (i < len && ref_val(s[i]) >= 0)
+		i++;
+	return i;
+}
+
+static size_t ref_decode(unsigned char *dst, const char *src, size_t len)
+{
+	size_t i, o = 0;
+
+	for (i = 0; i < len; i += 2) {
+		int hi = ref_val(src[i]);
+		int lo = i + 1 < len ? ref_val(src[i + 1]) : 0;
+
+		dst[o++] = ((hi < 0 ? 0 : hi) << 4) | (lo < 0 ? 0 : lo);
+	}
+	return o;
+}
+
+static size_t ref_ctrl(const unsigned char *s, size_t len)
+{
+	size_t i, cnt = 0;
+
+	for (i = 0; i < len; i++)
+		if (s[i] < 32)
+			cnt++;
+	return cnt;
+}
+
+/* Runs all three helpers on len bytes at s and compares them */
+static int check(const char *s, size_t len, const char *what)
+{
+	static unsigned char got[MAX_LEN + 64], want[MAX_LEN + 64];
+	size_t n, m, i;
+
+	n = audit_hex_span(s, len);
+	m = ref_span(s, len);
+	if (n != m) {
+		printf("Test failed - %s span of %zu is %zu not %zu\n", what,
+			len, n, m);
+		return 1;
+	}
+
+	memset(got, CANARY, sizeof(got));
+	n = audit_hex_decode(got, s, len);
+	m = ref_decode(want, s, len);
+	if (n != m || memcmp(got, want, m)) {
+		printf("Test failed - %s decode of %zu\n", what, len);
+		return 1;
+	}
+	for (i = m; i < sizeof(got); i++) {
+		if (got[i] != CANARY) {
+			printf("Test failed - %s decode of %zu wrote byte %zu\n",
+				what, len, i);
+			return 1;
+		}
+	}
+
+	n = audit_ctrl_count((const unsigned char *)s, len);
+	m = ref_ctrl((const unsigned char *)s, len);
+	if (n != m) {
+		printf("Test failed - %s control count of %zu is %zu not %zu\n",
+			what, len, n, m);
+		return 1;
+	}
+	return 0;
+}
+
+static void fill_hex(char *s, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		s[i] = digits[random() % (sizeof(digits) - 1)];
+}
+
+int main(void)
+{
+	static char buf[MAX_LEN + ALIGNS];
+	size_t page = sysconf(_SC_PAGESIZE), len, a, pos;
+	unsigned int c;
+	char *map;
+
+	srandom(1);
+
+	// Hex digits of every length at every alignment
+	for (a = 0; a < ALIGNS; a++) {
+		for (len = 0; len <= MAX_LEN; len++) {
+			fill_hex(buf + a, len);
+			if (check(buf + a, len, "hex"))
+				return 1;
+		}
+	}
+
+	// A byte that is not a hex digit at every position. Every byte
+	// value gets a turn, including the ones next to the digits and
+	// the ones with the high bit set.
+	c = 0;
+	for (len = 1; len <= MAX_LEN; len++) {
+		for (pos = 0; pos < len; pos++) {
+			do
+				c = (c + 1) & 0xFF;
+			while (ref_val(c) >= 0);
+			fill_hex(buf + 1, len);
+			buf[1 + pos] = c;
+			if (check(buf + 1, len, "bad byte"))
+				return 1;
+		}
+	}
+
+	// Random bytes, for the control character count
+	for (len = 0; len <= MAX_LEN; len++) {
+		for (pos = 0; pos < len; pos++)
+			buf[pos] = random();
+		if (check(buf, len, "random"))
+			return 1;
+	}
+
+	// Nothing past the length is read
+	map = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED || mprotect(map + page, page, PROT_NONE)) {
+		puts("Test failed - cannot map a guard page");
+		return 1;
+	}
+	for (len = 0; len <= MAX_LEN; len++) {
+		fill_hex(map + page - len, len);
+		if (check(map + page - len, len, "page end"))
+			return 1;
+	}
+	munmap(map, 2 * page);
+
+	puts("hex test passed");
+	return 0;
+}
@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/stat.h>
 
 #include "libaudit.h"
@@ -118,6 +119,84 @@ gen_id(char *dest)
 		}							\
 	} while (0)
 
+static const unsigned int elfs[] = {
+	AUDIT_ARCH_I386, AUDIT_ARCH_X86_64, AUDIT_ARCH_PPC, AUDIT_ARCH_PPC64,
+	AUDIT_ARCH_PPC64LE, AUDIT_ARCH_S390, AUDIT_ARCH_S390X,
+#ifdef WITH_ARM
+	AUDIT_ARCH_ARM,
+#endif
+#ifdef WITH_AARCH64
+	AUDIT_ARCH_AARCH64,
+#endif
+};
+
+static int
+in_table(const struct entry *t, size_t n, const char *s)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		if (strcasecmp(t[i].s, s) == 0)
+			return 1;
+	return 0;
+}
+
+/* Checks what the syscall perfect hash and the ELF lookup add to the
+   plain round trip of TEST_I2S and TEST_S2I. */
+static void
+test_syscalls(const struct entry *t, size_t n, int machine)
+{
+	size_t i, e;
+	char buf[64];
+	int found = 0;
+
+	for (i = 0; i < n; i++) {
+		size_t j, len = strlen(t[i].s);
+
+		assert(len + 2 <= sizeof(buf));
+		/* The hash folds case like the bsearch table did */
+		for (j = 0; j <= len; j++)
+			buf[j] = t[i].s[j] >= 'a' && t[i].s[j] <= 'z' ?
+				t[i].s[j] - 'a' + 'A' : t[i].s[j];
+		if (audit_name_to_syscall(buf, machine) != t[i].val) {
+			fprintf(stderr, "`%s' not found\n", buf);
+			abort();
+		}
+		/* Names that share a slot or a prefix do not match */
+		strcpy(buf, t[i].s);
+		strcat(buf, "x");
+		if (!in_table(t, n, buf) &&
+		    audit_name_to_syscall(buf, machine) != -1) {
+			fprintf(stderr, "Unexpected match `%s'\n", buf);
+			abort();
+		}
+		buf[len - 1] = '\0';
+		if (len > 1 && !in_table(t, n, buf) &&
+		    audit_name_to_syscall(buf, machine) != -1) {
+			fprintf(stderr, "Unexpected match `%s'\n", buf);
+			abort();
+		}
+	}
+
+	/* Going by the ELF arch gives what going by the machine does */
+	for (e = 0; e < sizeof(elfs) / sizeof(*elfs); e++) {
+		if (audit_elf_to_machine(elfs[e]) != machine)
+			continue;
+		found = 1;
+		for (i = 0; i < n; i++)
+			assert(audit_elf_syscall_to_name(elfs[e], t[i].val) ==
+			       audit_syscall_to_name(t[i].val, machine));
+		for (i = 0; i < RAND_ITERATIONS; i++) {
+			int val = rand() % 8192 - 64;
+
+			assert(audit_elf_syscall_to_name(elfs[e], val) ==
+			       audit_syscall_to_name(val, machine));
+		}
+	}
+	assert(found);
+	assert(audit_elf_syscall_to_name(0, t[0].val) == NULL);
+}
+
 #ifdef WITH_ARM
 static void
 test_arm_table(void)
@@ -131,6 +210,7 @@ test_arm_table(void)
 #define S2I(S) audit_name_to_syscall((S), MACH_ARM)
 	TEST_I2S(0);
 	TEST_S2I(-1);
+	test_syscalls(t, sizeof(t) / sizeof(*t), MACH_ARM);
 #undef I2S
 #undef S2I
 }
@@ -149,6 +229,7 @@ test_aarch64_table(void)
 #define S2I(S) audit_name_to_syscall((S), MACH_AARCH64)
 	TEST_I2S(0);
 	TEST_S2I(-1);
+	test_syscalls(t, sizeof(t) / sizeof(*t), MACH_AARCH64);
 #undef I2S
 #undef S2I
 }
@@ -166,6 +247,7 @@ test_i386_table(void)
 #define S2I(S) audit_name_to_syscall((S), MACH_X86)
 	TEST_I2S(strcmp(t[i].s, "madvise1") == 0);
 	TEST_S2I(-1);
+	test_syscalls(t, sizeof(t) / sizeof(*t), MACH_X86);
 #undef I2S
 #undef S2I
 }
@@ -182,6 +264,7 @@ test_ppc_table(void)
 #define S2I(S) audit_name_to_syscall((S), MACH_PPC)
 	TEST_I2S(0);
 	TEST_S2I(-1);
+	test_syscalls(t, sizeof(t) / sizeof(*t), MACH_PPC);
 #undef I2S
 #undef S2I
 }
@@ -198,6 +281,7 @@ test_s390_table(void)
 #define S2I(S) audit_name_to_syscall((S), MACH_S390)
 	TEST_I2S(0);
 	TEST_S2I(-1);
+	test_syscalls(t, sizeof(t) / sizeof(*t), MACH_S390);
 #undef I2S
 #undef S2I
 }
@@ -214,6 +298,7 @@ test_s390x_table(void)
 #define S2I(S) audit_name_to_syscall((S), MACH_S390X)
 	TEST_I2S(0);
 	TEST_S2I(-1);
+	test_syscalls(t, sizeof(t) / sizeof(*t), MACH_S390X);
 #undef I2S
 #undef S2I
 }
@@ -230,6 +315,7 @@ test_x86_64_table(void)
 #define S2I(S) audit_name_to_syscall((S), MACH_86_64)
 	TEST_I2S(0);
 	TEST_S2I(-1);
+	test_syscalls(t, sizeof(t) / sizeof(*t), MACH_86_64);
 #undef I2S
 #undef S2I
 }
@@ -396,6 +482,105 @@ test_optab(void)
 #undef I2S
 }
 
+static struct audit_rule_data *
+fp_rule(int list, const char *syscall, const char *pair)
+{
+	struct audit_rule_data *rule = audit_rule_create_data();
+	char buf[64];
+
+	assert(rule != NULL);
+	rule->flags = list;
+	rule->action = AUDIT_ALWAYS;
+	if (syscall && audit_rule_syscallbyname_data(rule, syscall)) {
+		fprintf(stderr, "Cannot add syscall %s\n", syscall);
+		abort();
+	}
+	if (pair) {
+		// The pair is split in place
+		strcpy(buf, pair);
+		if (audit_rule_fieldpair_data(&rule, buf, list)) {
+			fprintf(stderr, "Cannot add field %s\n", pair);
+			abort();
+		}
+	}
+	return rule;
+}
+
+static void
+fp_string(const struct audit_rule_data **rules, int n, char *buf)
+{
+	struct audit_fingerprint fp;
+	int i;
+
+	audit_fingerprint_init(&fp);
+	for (i = 0; i < n; i++)
+		audit_fingerprint_add_rule(&fp, rules[i]);
+	audit_fingerprint_format(&fp, buf, AUDIT_FINGERPRINT_LEN);
+}
+
+static void
+test_fingerprint(void)
+{
+	struct audit_rule_data *a, *b, *c, *u;
+	const struct audit_rule_data *set[3];
+	char f1[AUDIT_FINGERPRINT_LEN], f2[AUDIT_FINGERPRINT_LEN];
+	uint64_t h;
+	int i;
+
+	printf("Testing fingerprints...\n");
+	a = fp_rule(AUDIT_FILTER_EXIT, "open", "key=k1");
+	b = fp_rule(AUDIT_FILTER_EXIT, "open", "key=k1");
+	h = audit_rule_hash_data(a);
+	assert(h == audit_rule_hash_data(b));
+
+	/* The kernel does not keep the prepend flag or the class bits */
+	b->flags |= AUDIT_FILTER_PREPEND;
+	b->mask[AUDIT_BITMASK_SIZE - 1] |= 0x80000000;
+	assert(h == audit_rule_hash_data(b));
+	audit_rule_free_data(b);
+
+	/* Any other difference shows */
+	b = fp_rule(AUDIT_FILTER_EXIT, "open", "key=k2");
+	assert(h != audit_rule_hash_data(b));
+	audit_rule_free_data(b);
+	b = fp_rule(AUDIT_FILTER_EXIT, "openat", "key=k1");
+	assert(h != audit_rule_hash_data(b));
+	audit_rule_free_data(b);
+	b = fp_rule(AUDIT_FILTER_EXIT, "open", "key=k1");
+	b->action = AUDIT_NEVER;
+	assert(h != audit_rule_hash_data(b));
+	audit_rule_free_data(b);
+
+	b = fp_rule(AUDIT_FILTER_EXIT, "open", "uid=0");
+	c = fp_rule(AUDIT_FILTER_EXIT, "open", "uid=1");
+	assert(audit_rule_hash_data(b) != audit_rule_hash_data(c));
+	audit_rule_free_data(c);
+	u = fp_rule(AUDIT_FILTER_USER, NULL, "uid=0");
+
+	/* An empty set is 16 hex digits */
+	fp_string(set, 0, f1);
+	assert(strlen(f1) == 16);
+	for (i = 0; i < 16; i++)
+		assert((f1[i] >= '0' && f1[i] <= '9') ||
+			(f1[i] >= 'a' && f1[i] <= 'f'));
+
+	/* Order within a list matters, order across lists does not */
+	set[0] = a; set[1] = b; set[2] = u;
+	fp_string(set, 3, f1);
+	set[0] = u; set[1] = a; set[2] = b;
+	fp_string(set, 3, f2);
+	assert(strcmp(f1, f2) == 0);
+	set[0] = b; set[1] = a; set[2] = u;
+	fp_string(set, 3, f2);
+	assert(strcmp(f1, f2) != 0);
+	fp_string(set, 2, f2);
+	assert(strcmp(f1, f2) != 0);
+
+	audit_rule_free_data(a);
+	audit_rule_free_data(b);
+	audit_rule_free_data(u);
+}
+
 int
 main(void)
 {
@@ -425,6 +610,7 @@ main(void)
 	test_machinetab();
 	test_msg_typetab();
 	test_optab();
+	test_fingerprint();
 	return EXIT_SUCCESS;
 }
 
@@ -40,10 +40,23 @@
 /* Global vars */
 static llist l;
 static int printed;
-extern int list_requested, interpret;
+static FILE *out;		// Where rules are rendered
+static int status_open;		// JSON status object still needs closing
+extern int list_requested, interpret, json_output;
 extern char key[AUDIT_MAX_KEY_LEN+1];
 extern const char key_sep[2];
 
+/*
+ * Returns 1 if the field's value is a length of a string in the rule buffer
+ */
+static int field_in_buf(int field)
+{
+	return ((field >= AUDIT_SUBJ_USER && field <= AUDIT_OBJ_LEV_HIGH)
+		&& field != AUDIT_PPID) || field == AUDIT_WATCH ||
+		field == AUDIT_DIR || field == AUDIT_FILTERKEY ||
+		field == AUDIT_EXE;
+}
+
 /*
  * Returns 1 if rule should be printed & 0 if not
  */
@@ -69,12 +82,8 @@ int key_match(const struct audit_rule_data *r)
 			}
 			free(keyptr);
 		}
-		if (((field >= AUDIT_SUBJ_USER && field <= AUDIT_OBJ_LEV_HIGH)
-                     && field != AUDIT_PPID) || field == AUDIT_WATCH ||
-			field == AUDIT_DIR || field == AUDIT_FILTERKEY
-		     || field == AUDIT_EXE) {
-				boffset += r->values[i];
-		}
+		if (field_in_buf(field))
+			boffset += r->values[i];
 	}
 	return 0;
 }
@@ -119,19 +128,19 @@ static int print_arch(unsigned int value, int op)
 	_audit_elf = value;
 	machine = audit_elf_to_machine(_audit_elf);
 	if (machine < 0)
-		printf(" -F arch%s0x%X", audit_operator_to_symbol(op),
+		fprintf(out, " -F arch%s0x%X", audit_operator_to_symbol(op),
 				(unsigned)value);
 	else {
 		if (interpret == 0) {
 			if (__AUDIT_ARCH_64BIT & _audit_elf)
-				printf(" -F arch%sb64",
+				fprintf(out, " -F arch%sb64",
 						audit_operator_to_symbol(op));
 			else
-				printf(" -F arch%sb32",
+				fprintf(out, " -F arch%sb32",
 						audit_operator_to_symbol(op));
 		} else {
 			const char *ptr = audit_machine_to_name(machine);
-			printf(" -F arch%s%s", audit_operator_to_symbol(op),
+			fprintf(out, " -F arch%s%s", audit_operator_to_symbol(op),
 						ptr);
 		}
 	}
@@ -167,7 +176,7 @@ static int print_syscall(const struct audit_rule_data *r, unsigned int *sc)
 	}
 
 	if (all) {
-		printf(" -S all");
+		fprintf(out, " -S all");
 		count = i;
 	} else if (io_uring) {
 		for (i = 0; i < IORING_OP_LAST; i++) {
@@ -176,11 +185,11 @@ static int print_syscall(const struct audit_rule_data *r, unsigned int *sc)
 			if (r->mask[word] & bit) {
 				const char *ptr = audit_uringop_to_name(i);
 				if (!count)
-					printf(" -S ");
+					fprintf(out, " -S ");
 				if (ptr)
-					printf("%s%s", !count ? "" : ",", ptr);
+					fprintf(out, "%s%s", !count ? "" : ",", ptr);
 				else
-					printf("%s%u", !count ? "" : ",", i);
+					fprintf(out, "%s%u", !count ? "" : ",", i);
 				count++;
 				*sc = i;
 			}
@@ -198,11 +207,11 @@ static int print_syscall(const struct audit_rule_data *r, unsigned int *sc)
 				else
 					ptr = audit_syscall_to_name(i, machine);
 				if (!count)
-					printf(" -S ");
+					fprintf(out, " -S ");
 				if (ptr)
-					printf("%s%s", !count ? "" : ",", ptr);
+					fprintf(out, "%s%s", !count ? "" : ",", ptr);
 				else
-					printf("%s%u", !count ? "" : ",", i);
+					fprintf(out, "%s%u", !count ? "" : ",", i);
 				count++;
 				*sc = i;
 			}
@@ -216,103 +225,103 @@ static void print_field_cmp(int value, int op)
 	switch (value)
 	{
 		case AUDIT_COMPARE_UID_TO_OBJ_UID:
-			printf(" -C uid%sobj_uid",
+			fprintf(out, " -C uid%sobj_uid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_GID_TO_OBJ_GID:
-			printf(" -C gid%sobj_gid",
+			fprintf(out, " -C gid%sobj_gid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_EUID_TO_OBJ_UID:
-			printf(" -C euid%sobj_uid",
+			fprintf(out, " -C euid%sobj_uid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_EGID_TO_OBJ_GID:
-			printf(" -C egid%sobj_gid",
+			fprintf(out, " -C egid%sobj_gid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_AUID_TO_OBJ_UID:
-			printf(" -C auid%sobj_uid",
+			fprintf(out, " -C auid%sobj_uid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_SUID_TO_OBJ_UID:
-			printf(" -C suid%sobj_uid",
+			fprintf(out, " -C suid%sobj_uid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_SGID_TO_OBJ_GID:
-			printf(" -C sgid%sobj_gid",
+			fprintf(out, " -C sgid%sobj_gid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_FSUID_TO_OBJ_UID:
-			printf(" -C fsuid%sobj_uid",
+			fprintf(out, " -C fsuid%sobj_uid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_FSGID_TO_OBJ_GID:
-			printf(" -C fsgid%sobj_gid",
+			fprintf(out, " -C fsgid%sobj_gid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_UID_TO_AUID:
-			printf(" -C uid%sauid",
+			fprintf(out, " -C uid%sauid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_UID_TO_EUID:
-			printf(" -C uid%seuid",
+			fprintf(out, " -C uid%seuid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_UID_TO_FSUID:
-			printf(" -C uid%sfsuid",
+			fprintf(out, " -C uid%sfsuid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_UID_TO_SUID:
-			printf(" -C uid%ssuid",
+			fprintf(out, " -C uid%ssuid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_AUID_TO_FSUID:
-			printf(" -C auid%sfsuid",
+			fprintf(out, " -C auid%sfsuid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_AUID_TO_SUID:
-			printf(" -C auid%ssuid",
+			fprintf(out, " -C auid%ssuid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_AUID_TO_EUID:
-			printf(" -C auid%seuid",
+			fprintf(out, " -C auid%seuid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_EUID_TO_SUID:
-			printf(" -C euid%ssuid",
+			fprintf(out, " -C euid%ssuid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_EUID_TO_FSUID:
-			printf(" -C euid%sfsuid",
+			fprintf(out, " -C euid%sfsuid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_SUID_TO_FSUID:
-			printf(" -C suid%sfsuid",
+			fprintf(out, " -C suid%sfsuid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_GID_TO_EGID:
-			printf(" -C gid%segid",
+			fprintf(out, " -C gid%segid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_GID_TO_FSGID:
-			printf(" -C gid%sfsgid",
+			fprintf(out, " -C gid%sfsgid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_GID_TO_SGID:
-			printf(" -C gid%ssgid",
+			fprintf(out, " -C gid%ssgid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_EGID_TO_FSGID:
-			printf(" -C egid%sfsgid",
+			fprintf(out, " -C egid%sfsgid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_EGID_TO_SGID:
-			printf(" -C egid%ssgid",
+			fprintf(out, " -C egid%ssgid",
 				audit_operator_to_symbol(op));
 			break;
 		case AUDIT_COMPARE_SGID_TO_FSGID:
-			printf(" -C sgid%sfsgid",
+			fprintf(out, " -C sgid%sfsgid",
 				audit_operator_to_symbol(op));
 			break;
 	}
@@ -329,7 +338,7 @@ static void print_rule(const struct audit_rule_data *r)
 	unsigned long long a0 = 0, a1 = 0;
 
 	if (!watch) { /* This is syscall auditing */
-		printf("-a %s,%s",
+		fprintf(out, "-a %s,%s",
 			audit_action_to_name((int)r->action),
 				audit_flag_to_name(r->flags));
 
@@ -360,44 +369,44 @@ static void print_rule(const struct audit_rule_data *r)
 			// in a meaningful way.
 			if (field == AUDIT_MSGTYPE) {
 				if (!audit_msg_type_to_name(r->values[i]))
-					printf(" -F %s%s%d", name,
+					fprintf(out, " -F %s%s%d", name,
 						audit_operator_to_symbol(op),
 						r->values[i]);
 				else
-					printf(" -F %s%s%s", name,
+					fprintf(out, " -F %s%s%s", name,
 						audit_operator_to_symbol(op),
 						audit_msg_type_to_name(
 						r->values[i]));
 			} else if ((field >= AUDIT_SUBJ_USER &&
 						field <= AUDIT_OBJ_LEV_HIGH)
 						&& field != AUDIT_PPID) {
-				printf(" -F %s%s%.*s", name,
+				fprintf(out, " -F %s%s%.*s", name,
 						audit_operator_to_symbol(op),
 						r->values[i], &r->buf[boffset]);
 				boffset += r->values[i];
 			} else if (field == AUDIT_WATCH) {
 				if (watch)
-					printf("-w %.*s", r->values[i],
+					fprintf(out, "-w %.*s", r->values[i],
 						&r->buf[boffset]);
 				else
-					printf(" -F path%s%.*s",
+					fprintf(out, " -F path%s%.*s",
 						audit_operator_to_symbol(op),
 						r->values[i],
 						&r->buf[boffset]);
 				boffset += r->values[i];
 			} else if (field == AUDIT_DIR) {
 				if (watch)
-					printf("-w %.*s", r->values[i],
+					fprintf(out, "-w %.*s", r->values[i],
 						&r->buf[boffset]);
 				else
-					printf(" -F dir%s%.*s",
+					fprintf(out, " -F dir%s%.*s",
 						audit_operator_to_symbol(op),
 						r->values[i],
 						&r->buf[boffset]);
 
 				boffset += r->values[i];
 			} else if (field == AUDIT_EXE) {
-				printf(" -F exe%s%.*s",
+				fprintf(out, " -F exe%s%.*s",
 					audit_operator_to_symbol(op),
 					r->values[i], &r->buf[boffset]);
 				boffset += r->values[i];
@@ -410,9 +419,9 @@ static void print_rule(const struct audit_rule_data *r)
 				ptr = strtok_r(rkey, key_sep, &saved);
 				while (ptr) {
 					if (watch)
-						printf(" -k %s", ptr);
+						fprintf(out, " -k %s", ptr);
 					else
-						printf(" -F key=%s", ptr);
+						fprintf(out, " -F key=%s", ptr);
 					ptr = strtok_r(NULL, key_sep, &saved);
 				}
 				free(rkey);
@@ -429,12 +438,12 @@ static void print_rule(const struct audit_rule_data *r)
 				if (val & AUDIT_PERM_ATTR)
 					strcat(perms, "a");
 				if (watch)
-					printf(" -p %s", perms);
+					fprintf(out, " -p %s", perms);
 				else
-					printf(" -F perm=%s", perms);
+					fprintf(out, " -F perm=%s", perms);
 			} else if (field == AUDIT_INODE) {
 				// This is unsigned
-				printf(" -F %s%s%u", name,
+				fprintf(out, " -F %s%s%u", name,
 						audit_operator_to_symbol(op),
 						r->values[i]);
 			} else if (field == AUDIT_FIELD_COMPARE) {
@@ -447,11 +456,11 @@ static void print_rule(const struct audit_rule_data *r)
 
 				// Show these as hex
 				if (count > 1 || interpret == 0)
-					printf(" -F %s%s0x%X", name,
+					fprintf(out, " -F %s%s0x%X", name,
 						audit_operator_to_symbol(op),
 						r->values[i]);
 				else {	// Use ignore to mean interpret
-					const char *out;
+					const char *interp;
 					idata id;
 					char val[32];
 					int type;
@@ -466,67 +475,212 @@ static void print_rule(const struct audit_rule_data *r)
 					id.val = val;
 					type = auparse_interp_adjust_type(
 						AUDIT_SYSCALL, name, val);
-					out = auparse_do_interpretation(type,
+					interp = auparse_do_interpretation(type,
 							&id,
 							AUPARSE_ESC_TTY);
-					printf(" -F %s%s%s", name,
+					fprintf(out, " -F %s%s%s", name,
 						audit_operator_to_symbol(op),
-								out);
-					free((void *)out);
+								interp);
+					free((void *)interp);
 				}
 			} else if (field == AUDIT_EXIT) {
 				int e = abs((int)r->values[i]);
 				const char *err = audit_errno_to_name(e);
 
 				if (((int)r->values[i] < 0) && err)
-					printf(" -F %s%s-%s", name,
+					fprintf(out, " -F %s%s-%s", name,
 						audit_operator_to_symbol(op),
 						err);
 				else
-					printf(" -F %s%s%d", name,
+					fprintf(out, " -F %s%s%d", name,
 						audit_operator_to_symbol(op),
 						(int)r->values[i]);
 			} else if (field == AUDIT_FSTYPE) {
 				if (!audit_fstype_to_name(r->values[i]))
-					printf(" -F %s%s%d", name,
+					fprintf(out, " -F %s%s%d", name,
 						audit_operator_to_symbol(op),
 						r->values[i]);
 				else
-					printf(" -F %s%s%s", name,
+					fprintf(out, " -F %s%s%s", name,
 						audit_operator_to_symbol(op),
 						audit_fstype_to_name(
 						r->values[i]));
 			} else if (field == AUDIT_LOGINUID ||
 				   field == AUDIT_SESSIONID) {
 				if (r->values[i] == -1 && interpret)
-					printf(" -F %s%sunset", name,
+					fprintf(out, " -F %s%sunset", name,
 					       audit_operator_to_symbol(op));
 				else
-					printf(" -F %s%s%d", name,
+					fprintf(out, " -F %s%s%d", name,
 					       audit_operator_to_symbol(op),
 					       r->values[i]);
 			} else {
 				// The default is signed decimal
-				printf(" -F %s%s%d", name,
+				fprintf(out, " -F %s%s%d", name,
 						audit_operator_to_symbol(op),
 						r->values[i]);
 			}
 		} else {
 			 // The field name is unknown
-			printf(" f%d%s%d", r->fields[i],
+			fprintf(out, " f%d%s%d", r->fields[i],
 						audit_operator_to_symbol(op),
 						r->values[i]);
 		}
 	}
-	printf("\n");
+	fprintf(out, "\n");
+}
+
+static void json_string(FILE *f, const char *s, size_t len)
+{
+	size_t i;
+
+	fputc('"', f);
+	for (i = 0; i < len; i++) {
+		unsigned char c = s[i];
+
+		if (c == '"' || c == '\\')
+			fprintf(f, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(f, "\\u%04x", c);
+		else
+			fputc(c, f);
+	}
+	fputc('"', f);
+}
+
+/*
+ *  This function prints 1 rule as a JSON object. The rule text is the
+ *  same as what is printed in the normal listing.
+ */
+static void print_json_rule(const struct audit_rule_data *r, unsigned int num)
+{
+	const char *list = audit_flag_to_name(r->flags);
+	const char *act = audit_action_to_name((int)r->action);
+	char *text = NULL;
+	size_t len = 0, boffset = 0;
+	unsigned int i, keys = 0;
+	FILE *f = out;
+
+	fprintf(f, "%s\n{\"list\":\"%s\",\"action\":\"%s\",\"keys\":[",
+		num ? "," : "", list ? list : "unknown", act ? act : "unknown");
+	for (i = 0; i < r->field_count; i++) {
+		int field = r->fields[i] & ~AUDIT_OPERATORS;
+
+		if (field == AUDIT_FILTERKEY) {
+			const char *k = &r->buf[boffset];
+			const char *end = k + r->values[i];
+
+			while (k < end) {
+				const char *sep = memchr(k, key_sep[0], end - k);
+
+				if (sep == NULL)
+					sep = end;
+				if (sep > k) {
+					if (keys++)
+						fputc(',', f);
+					json_string(f, k, sep - k);
+				}
+				k = sep + 1;
+			}
+		}
+		if (field_in_buf(field))
+			boffset += r->values[i];
+	}
+	fputs("],\"rule\":", f);
+
+	out = open_memstream(&text, &len);
+	if (out) {
+		print_rule(r);
+		fclose(out);
+		if (len && text[len-1] == '\n')
+			len--;
+		json_string(f, text, len);
+	} else
+		fputs("null", f);
+	free(text);
+	fputc('}', f);
+	out = f;
+}
+
+/*
+ * Render all the collected rules into one buffer and write it out at once
+ * so that large rule sets do not cost a write per rule.
+ */
+static void print_rules(void)
+{
+	char *buf = NULL;
+	size_t len = 0;
+	unsigned int num = 0;
+	lnode *n;
+
+	out = open_memstream(&buf, &len);
+	if (out == NULL)
+		out = stdout;
+
+	if (json_output)
+		fputs("{\"rules\":[", out);
+	else if (printed == 0)
+		fputs("No rules\n", out);
+
+	list_first(&l);
+	n = l.cur;
+	while (n) {
+		if (json_output)
+			print_json_rule(n->r, num++);
+		else
+			print_rule(n->r);
+		n = list_next(&l);
+	}
+	list_clear(&l);
+	if (json_output)
+		fputs(num ? "\n]}\n" : "]}\n", out);
+
+	if (out != stdout) {
+		fclose(out);
+		fwrite(buf, 1, len, stdout);
+		free(buf);
+		out = stdout;
+	}
+}
+
+static void print_json_status(const struct audit_reply *rep)
+{
+	printf("{\"enabled\":%u,\"failure\":%u,\"pid\":%u,\"rate_limit\":%u,"
+		"\"backlog_limit\":%u,\"lost\":%u,\"backlog\":%u",
+		rep->status->enabled, rep->status->failure,
+		rep->status->pid, rep->status->rate_limit,
+		rep->status->backlog_limit, rep->status->lost,
+		rep->status->backlog);
+#if HAVE_DECL_AUDIT_VERSION_BACKLOG_WAIT_TIME == 1 || \
+    HAVE_DECL_AUDIT_STATUS_BACKLOG_WAIT_TIME == 1
+	printf(",\"backlog_wait_time\":%u", rep->status->backlog_wait_time);
+#endif
+#if HAVE_DECL_AUDIT_STATUS_BACKLOG_WAIT_TIME_ACTUAL == 1
+	if (rep->len == NLMSG_LENGTH(sizeof(struct audit_status)))
+		printf(",\"backlog_wait_time_actual\":%u",
+			rep->status->backlog_wait_time_actual);
+#endif
+	status_open = 1;
 }
 
 void audit_print_init(void)
 {
 	printed = 0;
+	out = stdout;
 	list_create(&l);
 }
 
+/*
+ * Closes any JSON status object that the replies left open
+ */
+void audit_print_finish(void)
+{
+	if (status_open) {
+		printf("}\n");
+		status_open = 0;
+	}
+}
+
 static const char *get_enable(unsigned e)
 {
 	switch (e)
@@ -572,18 +726,7 @@ int audit_print_reply(const struct audit_reply *rep, int fd)
 		case NLMSG_DONE:
 			// Close the socket so kernel can do other things
 			audit_close(fd);
-			if (printed == 0)
-				printf("No rules\n");
-			else {
-				lnode *n;
-				list_first(&l);
-				n = l.cur;
-				while (n) {
-					print_rule(n->r);
-					n = list_next(&l);
-				}
-				list_clear(&l);
-			}
+			print_rules();
 			break;
 		case NLMSG_ERROR:
 		        printf("NLMSG_ERROR %d (%s)\n",
@@ -592,6 +735,11 @@ int audit_print_reply(const struct audit_reply *rep, int fd)
 			printed = 1;
 			break;
 		case AUDIT_GET:
+			if (json_output) {
+				print_json_status(rep);
+				printed = 1;
+				break;
+			}
 			if (interpret)
 				printf("enabled %s\nfailure %s\n",
 					get_enable(rep->status->enabled),
@@ -626,7 +774,21 @@ int audit_print_reply(const struct audit_reply *rep, int fd)
 			{
 			uint32_t mask = AUDIT_FEATURE_TO_MASK(
 					      AUDIT_FEATURE_LOGINUID_IMMUTABLE);
-			if (rep->features->mask & mask)
+			if (json_output) {
+				if (status_open == 0) {
+					printf("{");
+					status_open = 1;
+				} else
+					printf(",");
+				if (rep->features->mask & mask)
+					printf("\"loginuid_immutable\":%u,"
+						"\"loginuid_immutable_locked\":%s",
+					!!(rep->features->features & mask),
+					rep->features->lock & mask ? "true" :
+					"false");
+				else
+					printf("\"loginuid_immutable\":null");
+			} else if (rep->features->mask & mask)
 				printf("loginuid_immutable %u %s\n",
 					!!(rep->features->features & mask),
 					rep->features->lock & mask ? "locked" :
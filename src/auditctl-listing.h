@@ -29,6 +29,7 @@
 #include "libaudit.h"
 
 void audit_print_init(void);
+void audit_print_finish(void);
 int audit_print_reply(const struct audit_reply *rep, int fd);
 int key_match(const struct audit_rule_data *r);
 
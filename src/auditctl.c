@@ -52,6 +52,9 @@
  */
 #define LINE_SIZE 6144
 
+/* Socket receive buffer requested when listing rules */
+#define LIST_RCVBUF_SIZE (1024*1024)
+
 
 /* Global functions */
 static int handle_request(int status);
@@ -59,7 +62,7 @@ static void get_reply(void);
 extern int delete_all_rules(int fd);
 
 /* Global vars */
-int list_requested = 0, interpret = 0;
+int list_requested = 0, interpret = 0, json_output = 0;
 char key[AUDIT_MAX_KEY_LEN+1];
 const char key_sep[2] = { AUDIT_KEY_SEPARATOR, 0 };
 static unsigned int keylen;
@@ -70,6 +73,18 @@ static int exclude = 0;
 static int multiple = 0;
 static struct audit_rule_data *rule_new = NULL;
 
+/* When fingerprinting a rules file, nothing is sent to the kernel. The
+ * rules are kept here in the order the kernel would hold them instead. */
+struct fp_rule {
+	struct audit_rule_data *r;
+	uint64_t hash;
+};
+static int fingerprint_only = 0;
+static int fingerprint_req = 0;
+static const char *fingerprint_file = NULL;
+static struct fp_rule *fp_rules = NULL;
+static unsigned int fp_cnt = 0, fp_size = 0;
+
 /*
  * This function will reset everything used for each loop when loading
  * a ruleset from a file.
@@ -91,7 +106,7 @@ static int reset_vars(void)
 
 	audit_rule_free_data(rule_new);
 	rule_new = audit_rule_create_data();
-	if (fd < 0) {
+	if (fd < 0 && !fingerprint_only) {
 		if ((fd = audit_open()) < 0) {
 			audit_msg(LOG_ERR, "Cannot open netlink audit socket");
 			return 1;
@@ -132,11 +147,14 @@ static void usage(void)
      "    -R <file>                         read rules from file\n"
      "    -s                                Report status\n"
      "    -S syscall                        Build rule: syscall name or number\n"
+     "    --fingerprint [file]              Print the fingerprint of the loaded rules\n"
+     "                                      or of the rules in <file>\n"
      "    --signal <signal>                 Send the specified signal to the daemon\n"
      "    -t                                Trim directory watches\n"
      "    -v                                Version\n"
      "    -w <path>                         Insert watch at <path>\n"
      "    -W <path>                         Remove watch at <path>\n"
+     "    --json                            Print the -l or -s output as JSON\n"
 #if HAVE_DECL_AUDIT_FEATURE_VERSION == 1
      "    --loginuid-immutable              Make loginuids unchangeable once set\n"
 #endif
@@ -356,6 +374,14 @@ static int equiv_parse(char *optarg, char **mp, char **sub)
 
 static int audit_request_rule_list(void)
 {
+	int rcvbuf = LIST_RCVBUF_SIZE;
+
+	/* The kernel sends a message per rule. Give it room to queue a
+	 * large rule set rather than waiting on us after every message. */
+	if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf,
+			sizeof(rcvbuf)) < 0)
+		setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
 	if (audit_request_rules_list_data(fd) > 0) {
 		list_requested = 1;
 		get_reply();
@@ -584,6 +610,91 @@ static int parse_io_uring(const char *optarg)
 }
 #endif
 
+static int fingerprint_find(uint64_t hash)
+{
+	unsigned int i;
+
+	for (i = 0; i < fp_cnt; i++) {
+		if (fp_rules[i].hash == hash)
+			return i;
+	}
+	return -1;
+}
+
+/*
+ * Does to the kept rules what the kernel would do with the rule being
+ * added or deleted. Returns 0 on success and -1 on errors like the
+ * kernel would report.
+ */
+static int fingerprint_rule(int flags)
+{
+	struct fp_rule n;
+	size_t sz = sizeof(struct audit_rule_data) + rule_new->buflen;
+	int i;
+
+	rule_new->flags = flags;
+	rule_new->action = action;
+	n.hash = audit_rule_hash_data(rule_new);
+	i = fingerprint_find(n.hash);
+
+	if (del != AUDIT_FILTER_UNSET) {
+		if (i < 0) {
+			audit_msg(LOG_WARNING,
+			"Error sending delete rule request (No rule matches)");
+			return -1;
+		}
+		free(fp_rules[i].r);
+		fp_cnt--;
+		memmove(&fp_rules[i], &fp_rules[i+1],
+			(fp_cnt - i) * sizeof(struct fp_rule));
+		return 0;
+	}
+
+	if (i >= 0) {
+		audit_msg(LOG_ERR,
+			"Error sending add rule data request (Rule exists)");
+		return -1;
+	}
+	if (fp_cnt == fp_size) {
+		unsigned int size = fp_size ? fp_size * 2 : 64;
+		struct fp_rule *tmp;
+
+		tmp = realloc(fp_rules, size * sizeof(struct fp_rule));
+		if (tmp == NULL)
+			return -1;
+		fp_rules = tmp;
+		fp_size = size;
+	}
+	n.r = malloc(sz);
+	if (n.r == NULL)
+		return -1;
+	memcpy(n.r, rule_new, sz);
+
+	// The kernel puts prepended rules at the head of their list
+	if (flags & AUDIT_FILTER_PREPEND) {
+		memmove(&fp_rules[1], &fp_rules[0],
+			fp_cnt * sizeof(struct fp_rule));
+		fp_rules[0] = n;
+	} else
+		fp_rules[fp_cnt] = n;
+	fp_cnt++;
+	return 0;
+}
+
+/* Like delete_all_rules, honors the -k option */
+static void fingerprint_delete_all(void)
+{
+	unsigned int i, j = 0;
+
+	for (i = 0; i < fp_cnt; i++) {
+		if (key_match(fp_rules[i].r))
+			free(fp_rules[i].r);
+		else
+			fp_rules[j++] = fp_rules[i];
+	}
+	fp_cnt = j;
+}
+
 static const struct option long_opts[] =
 {
 #if HAVE_DECL_AUDIT_FEATURE_VERSION == 1
@@ -600,6 +711,8 @@ static const struct option long_opts[] =
   {"reset_backlog_wait_time_actual", 0, NULL, 4},
 #endif
   {"signal", 1, NULL, 5},
+  {"json", 0, NULL, 6},
+  {"fingerprint", 2, NULL, 7},
   {NULL, 0, NULL, 0}
 };
 
@@ -610,7 +723,7 @@ static const struct option long_opts[] =
  */
 static int setopt(int count, int lineno, char *vars[])
 {
-    int c, lidx = 0;
+    int c, lidx = 0, i, n;
     int retval = 0, rc;
 
     optind = 0;
@@ -638,22 +751,26 @@ static int setopt(int count, int lineno, char *vars[])
 		retval = -2;
 		break;
         case 's':
-		if (count > 3) {
-			audit_msg(LOG_ERR,
-				"Too many options for status command");
-			retval = -1;
-			break;
-		} else if (optind == 2 && count == 3) { 
-			if (strcmp(vars[optind], "-i") == 0) {
+		/* The status goes out right away, so whatever follows -s
+		 * is taken here. Only -i and --json may. */
+		for (i = optind, n = 0; i < count && retval >= 0; i++) {
+			if (strcmp(vars[i], "--json") == 0)
+				json_output = 1;
+			else if (++n > 1) {
+				audit_msg(LOG_ERR,
+					"Too many options for status command");
+				retval = -1;
+			} else if (strcmp(vars[i], "-i") == 0)
 				interpret = 1;
-				count -= 1;
-			} else {
+			else {
 				audit_msg(LOG_ERR,
 					"Only -i option is allowed");
 				retval = -1;
-				break;
 			}
 		}
+		if (retval < 0)
+			break;
+		count = optind;
 		retval = report_status();
 		break;
         case 'e':
@@ -724,33 +841,28 @@ static int setopt(int count, int lineno, char *vars[])
 		}
 		break;
         case 'l':
-		if (count > 4) {
-			audit_msg(LOG_ERR,
-				"Wrong number of options for list request");
-			retval = -1;
-			break;
-		}
-		if (count == 3) {
-			if (strcmp(vars[optind], "-i") == 0) {
-				interpret = 1;
-				count -= 1;
-			} else {
+		/* Whatever follows -l is taken here: -i or -k key, and
+		 * --json anywhere */
+		for (i = optind, n = 0; i < count && retval >= 0; i++) {
+			if (strcmp(vars[i], "--json") == 0)
+				json_output = 1;
+			else if (n++) {
 				audit_msg(LOG_ERR,
-					"Only -k or -i options are allowed");
+					"Wrong number of options for list request");
 				retval = -1;
-				break;
-			}
-		} else if (count == 4) {
-			if (vars[optind] && strcmp(vars[optind], "-k") == 0) {
-				strncat(key, vars[3], keylen);
-				count -= 2;
-			} else {
+			} else if (strcmp(vars[i], "-i") == 0)
+				interpret = 1;
+			else if (strcmp(vars[i], "-k") == 0 && i + 1 < count)
+				strncat(key, vars[++i], keylen);
+			else {
 				audit_msg(LOG_ERR,
 					"Only -k or -i options are allowed");
 				retval = -1;
-				break;
 			}
 		}
+		if (retval < 0)
+			break;
+		count = optind;
 		if (audit_request_rule_list()) {
 			list_requested = 1;
 			retval = -2;
@@ -1020,6 +1132,12 @@ static int setopt(int count, int lineno, char *vars[])
 				break;
 			}
 		}
+		if (fingerprint_only) {
+			fingerprint_delete_all();
+			key[0] = 0;
+			retval = -2;
+			break;
+		}
 		retval = delete_all_rules(fd);
 		if (retval == 0) {
 			(void)audit_request_rule_list();
@@ -1191,6 +1309,32 @@ process_keys:
 	case 5:
 		retval = send_signal(optarg);
 		break;
+	case 6:
+		json_output = 1;
+		break;
+	case 7:
+		/* The fingerprint is printed once the options are parsed.
+		 * Only the rules file may follow --fingerprint. */
+		if (lineno) {
+			audit_msg(LOG_ERR,
+				"--fingerprint on line %d is invalid", lineno);
+			retval = -1;
+			break;
+		}
+		fingerprint_file = optarg;
+		if (fingerprint_file == NULL && optind < count &&
+				vars[optind][0] != '-')
+			fingerprint_file = vars[optind++];
+		if (optind < count) {
+			audit_msg(LOG_ERR,
+				"Only a file may follow --fingerprint");
+			retval = -1;
+			break;
+		}
+		count = optind;
+		fingerprint_req = 1;
+		retval = -2;
+		break;
         default: {
 		char *bad_opt;
 		if (optind >= 2)
@@ -1325,6 +1469,19 @@ static void postprocess(char *buf)
  * error conditions after executing some of the rules. It will abort reading
  * the file if it encounters any problems.
  */
+/* Returns 1 if the command adds or deletes rules, 0 otherwise */
+static int rule_line(int count, char *vars[])
+{
+	int i;
+
+	for (i = 1; i < count; i++) {
+		if (vars[i][0] == '-' && vars[i][1] &&
+				strchr("aAdDwW", vars[i][1]))
+			return 1;
+	}
+	return 0;
+}
+
 static int fileopt(const char *file)
 {
 	int i, tfd, rc, lineno = 1;
@@ -1406,6 +1563,13 @@ static int fileopt(const char *file)
 
 		fields[i] = NULL;
 
+		/* Only rule changes matter for a fingerprint */
+		if (fingerprint_only && !rule_line(i, fields)) {
+			free(fields);
+			lineno++;
+			continue;
+		}
+
 		/* Parse it */
 		if (reset_vars()) {
 			free(fields);
@@ -1442,6 +1606,53 @@ static int fileopt(const char *file)
 	return 0;
 }
 
+/*
+ * Prints the fingerprint of the kernel's rules, or of the rules that
+ * loading the file would leave in the kernel. Returns 0 on success.
+ */
+static int print_fingerprint(const char *file)
+{
+	char buf[AUDIT_FINGERPRINT_LEN];
+	unsigned int i;
+
+	if (file) {
+		struct audit_fingerprint fp;
+
+		fingerprint_only = 1;
+		if (fileopt(file) || continue_error < 0)
+			return 1;
+		audit_fingerprint_init(&fp);
+		for (i = 0; i < fp_cnt; i++) {
+			audit_fingerprint_add_rule(&fp, fp_rules[i].r);
+			free(fp_rules[i].r);
+		}
+		free(fp_rules);
+		audit_fingerprint_format(&fp, buf, sizeof(buf));
+	} else {
+		fd = audit_open();
+		if (fd < 0) {
+			audit_msg(LOG_ERR, "Cannot open netlink audit socket");
+			return 1;
+		}
+		if (audit_get_rules_fingerprint(fd, buf, sizeof(buf))) {
+			audit_msg(LOG_ERR, "Error getting the rules (%s)",
+				strerror(errno));
+			audit_close(fd);
+			return 1;
+		}
+		audit_close(fd);
+	}
+	printf("%s\n", buf);
+	return 0;
+}
+
+/* Fingerprinting a rules file does not touch the kernel */
+static int fingerprint_file_mode(int argc, char *argv[])
+{
+	return (argc == 3 && strcmp(argv[1], "--fingerprint") == 0) ||
+		(argc == 2 && strncmp(argv[1], "--fingerprint=", 14) == 0);
+}
+
 /* Return 1 if ready, 0 otherwise */
 static int is_ready(void)
 {
@@ -1471,6 +1682,7 @@ int main(int argc, char *argv[])
 	if (!(argc == 2 && (strcmp(argv[1], "--help")==0 ||
 			strcmp(argv[1], "-h") == 0 ||
 			(strcmp(argv[1], "-l") == 0 && geteuid() == 0))) &&
+			!fingerprint_file_mode(argc, argv) &&
 			!audit_can_control()) {
 		audit_msg(LOG_WARNING, "You must be root to run this program.");
 		return 4;
@@ -1503,6 +1715,11 @@ int main(int argc, char *argv[])
 			free(rule_new);
 			return 0;
 		}
+		if (fingerprint_req) {
+			retval = print_fingerprint(fingerprint_file);
+			free(rule_new);
+			return retval;
+		}
 	}
 
 	if (add != AUDIT_FILTER_UNSET || del != AUDIT_FILTER_UNSET) {
@@ -1513,6 +1730,7 @@ int main(int argc, char *argv[])
 		}
 	}
 	retval = handle_request(retval);
+	audit_print_finish();
 	if (retval == -1) {
 		if (errno != ECONNREFUSED)
 			audit_msg(LOG_ERR,
@@ -1554,6 +1772,8 @@ static int handle_request(int status)
 					audit_rule_syscallbyname_data(
 							rule_new, "all");
 			}
+			if (fingerprint_only)
+				return fingerprint_rule(add);
 			set_aumessage_mode(MSG_QUIET, DBG_NO);
 			rc = audit_add_rule_data(fd, rule_new, add, action);
 			set_aumessage_mode(MSG_STDERR, DBG_NO);
@@ -1578,6 +1798,8 @@ static int handle_request(int status)
 					audit_rule_syscallbyname_data(
 							rule_new, "all");
 			}
+			if (fingerprint_only)
+				return fingerprint_rule(del);
 			set_aumessage_mode(MSG_QUIET, DBG_NO);
 			rc = audit_delete_rule_data(fd, rule_new,
 								 del, action);
@@ -1623,8 +1845,6 @@ static void get_reply(void)
 	int timeout = 40; /* loop has delay of .1 - so this is 4 seconds */
 	struct audit_reply rep;
 	fd_set read_mask;
-	FD_ZERO(&read_mask);
-	FD_SET(fd, &read_mask);
 
 	// Reset printing counter
 	audit_print_init();
@@ -1634,21 +1854,21 @@ static void get_reply(void)
 
 		t.tv_sec  = 0;
 		t.tv_usec = 100000; /* .1 second */
+		FD_ZERO(&read_mask);
+		FD_SET(fd, &read_mask);
 		do {
 			retval=select(fd+1, &read_mask, NULL, NULL, &t);
 		} while (retval < 0 && errno == EINTR);
-		// We'll try to read just in case
-		retval = audit_get_reply(fd, &rep, GET_REPLY_NONBLOCKING, 0);
-		if (retval > 0) {
-			if (rep.type == NLMSG_ERROR && rep.error->error == 0) {
-				i = 0;    /* reset timeout */
+		// We'll try to read just in case. Drain everything that is
+		// queued before waiting again.
+		while ((retval = audit_get_reply(fd, &rep,
+					GET_REPLY_NONBLOCKING, 0)) > 0) {
+			i = 0; /* If getting more, reset timeout */
+			if (rep.type == NLMSG_ERROR && rep.error->error == 0)
 				continue; /* This was an ack */
-			}
 
-			if ((retval = audit_print_reply(&rep, fd)) == 0)
-				break;
-			else
-				i = 0; /* If getting more, reset timeout */
+			if (audit_print_reply(&rep, fd) == 0)
+				return;
 		}
 	}
 }
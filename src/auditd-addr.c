@@ -0,0 +1,160 @@
+/* auditd-addr.c -- connection counts per client address
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include "auditd-addr.h"
+
+/*
+ * Clients are kept in client_chain for iteration. Admission against
+ * tcp_max_per_addr uses a hash table of per address counters instead so
+ * that a reconnect storm does not walk the chain for every accept.
+ */
+#define ADDR_TABLE_MIN 256
+
+static struct addr_count **addr_table = NULL;
+static unsigned int addr_table_size = 0, addr_entries = 0;
+
+static size_t addr_bytes(const struct sockaddr_storage *addr,
+			const unsigned char **bytes)
+{
+	if (addr->ss_family == AF_INET) {
+		*bytes = (const unsigned char *)
+			&((const struct sockaddr_in *)addr)->sin_addr;
+		return sizeof(struct in_addr);
+	}
+	*bytes = (const unsigned char *)
+		&((const struct sockaddr_in6 *)addr)->sin6_addr;
+	return sizeof(struct in6_addr);
+}
+
+static unsigned int addr_hash(sa_family_t family, const unsigned char *b,
+			size_t len)
+{
+	unsigned int h = 2166136261U ^ family;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		h ^= b[i];
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static void addr_table_grow(void)
+{
+	struct addr_count **tmp;
+	unsigned int i, size;
+
+	size = addr_table_size ? addr_table_size * 2 : ADDR_TABLE_MIN;
+	tmp = calloc(size, sizeof(struct addr_count *));
+	if (tmp == NULL)
+		return;	// Keep the old table, chains just get longer
+
+	for (i = 0; i < addr_table_size; i++) {
+		struct addr_count *ac = addr_table[i];
+
+		while (ac) {
+			struct addr_count *next = ac->next;
+			unsigned int h = addr_hash(ac->family, ac->addr,
+				ac->family == AF_INET ? sizeof(struct in_addr) :
+					sizeof(struct in6_addr)) & (size - 1);
+
+			ac->next = tmp[h];
+			tmp[h] = ac;
+			ac = next;
+		}
+	}
+	free(addr_table);
+	addr_table = tmp;
+	addr_table_size = size;
+}
+
+/* Find the counter of an address, creating it with a zero count */
+struct addr_count *addr_get(const struct sockaddr_storage *addr)
+{
+	const unsigned char *b;
+	size_t len = addr_bytes(addr, &b);
+	unsigned int h;
+	struct addr_count *ac;
+
+	if (addr_entries >= addr_table_size)
+		addr_table_grow();
+	if (addr_table == NULL)
+		return NULL;
+
+	h = addr_hash(addr->ss_family, b, len) & (addr_table_size - 1);
+	for (ac = addr_table[h]; ac; ac = ac->next) {
+		if (ac->family == addr->ss_family && memcmp(ac->addr, b, len) == 0)
+			return ac;
+	}
+
+	ac = calloc(1, sizeof(struct addr_count));
+	if (ac == NULL)
+		return NULL;
+	ac->family = addr->ss_family;
+	memcpy(ac->addr, b, len);
+	ac->next = addr_table[h];
+	addr_table[h] = ac;
+	addr_entries++;
+	return ac;
+}
+
+/* Forget the address once it has no connections left */
+void addr_drop(struct addr_count *ac)
+{
+	struct addr_count **pp;
+	unsigned int h;
+
+	if (ac->count)
+		return;
+
+	h = addr_hash(ac->family, ac->addr, ac->family == AF_INET ?
+		sizeof(struct in_addr) : sizeof(struct in6_addr)) &
+		(addr_table_size - 1);
+	for (pp = &addr_table[h]; *pp; pp = &(*pp)->next) {
+		if (*pp == ac) {
+			*pp = ac->next;
+			free(ac);
+			addr_entries--;
+			return;
+		}
+	}
+}
+
+void addr_table_free(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < addr_table_size; i++) {
+		while (addr_table[i]) {
+			struct addr_count *ac = addr_table[i];
+
+			addr_table[i] = ac->next;
+			free(ac);
+		}
+	}
+	free(addr_table);
+	addr_table = NULL;
+	addr_table_size = addr_entries = 0;
+}
@@ -0,0 +1,41 @@
+/* auditd-addr.h --
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#ifndef AUDITD_ADDR_H
+#define AUDITD_ADDR_H
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+/* Number of connections from one address, for tcp_max_per_addr */
+struct addr_count {
+	struct addr_count *next;
+	sa_family_t family;
+	unsigned char addr[sizeof(struct in6_addr)];
+	unsigned int count;
+};
+
+struct addr_count *addr_get(const struct sockaddr_storage *addr);
+void addr_drop(struct addr_count *ac);
+void addr_table_free(void);
+
+#endif
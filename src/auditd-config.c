@@ -133,6 +133,8 @@ static int krb5_principal_parser(const struct nv_pair *nv, int line,
 		struct daemon_conf *config);
 static int krb5_key_file_parser(const struct nv_pair *nv, int line,
 		struct daemon_conf *config);
+static int tls_file_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
 static int distribute_network_parser(const struct nv_pair *nv, int line,
 		struct daemon_conf *config);
 static int q_depth_parser(const struct nv_pair *nv, int line,
@@ -143,9 +145,32 @@ static int max_restarts_parser(const struct nv_pair *nv, int line,
 		struct daemon_conf *config);
 static int plugin_dir_parser(const struct nv_pair *nv, int line,
 		struct daemon_conf *config);
+static int q_spill_dir_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
+static int q_spill_max_size_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
+static int q_lane_types_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
+static int q_lane_keys_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
 static int eoe_timeout_parser(const struct nv_pair *nv, int line,
 		struct daemon_conf *config);
+static int rate_limit_by_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
+static int log_stream_dir_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
+static int event_backend_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
+static int rate_limit_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
+static int rate_limit_burst_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
+static int rate_limit_sample_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
+static int rate_limit_report_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config);
 static int sanity_check(struct daemon_conf *config);
+static void load_log_streams(struct daemon_conf *config);
 
 static const struct kw_pair keywords[] = 
 {
@@ -182,12 +207,28 @@ static const struct kw_pair keywords[] =
   {"enable_krb5",              enable_krb5_parser,              0 },
   {"krb5_principal",           krb5_principal_parser,           0 },
   {"krb5_key_file",            krb5_key_file_parser,            0 },
+  {"tls_cert_file",            tls_file_parser,                 0 },
+  {"tls_key_file",             tls_file_parser,                 0 },
+  {"tls_ca_file",              tls_file_parser,                 0 },
   {"distribute_network",       distribute_network_parser,       0 },
+  {"event_backend",            event_backend_parser,            0 },
   {"q_depth",                  q_depth_parser,                  0 },
   {"overflow_action",          overflow_action_parser,          0 },
   {"max_restarts",             max_restarts_parser,             0 },
   {"plugin_dir",               plugin_dir_parser,               0 },
+  {"q_spill_dir",              q_spill_dir_parser,              0 },
+  {"q_spill_max_size",         q_spill_max_size_parser,         0 },
+  {"q_priority_types",         q_lane_types_parser,             0 },
+  {"q_priority_keys",          q_lane_keys_parser,              0 },
+  {"q_bulk_types",             q_lane_types_parser,             0 },
+  {"q_bulk_keys",              q_lane_keys_parser,              0 },
   {"end_of_event_timeout",     eoe_timeout_parser,              0 },
+  {"rate_limit_by",            rate_limit_by_parser,            0 },
+  {"rate_limit",               rate_limit_parser,               0 },
+  {"rate_limit_burst",         rate_limit_burst_parser,         0 },
+  {"rate_limit_sample",        rate_limit_sample_parser,        0 },
+  {"rate_limit_report",        rate_limit_report_parser,        0 },
+  {"log_stream_dir",           log_stream_dir_parser,           0 },
   { NULL,                      NULL,                            0 }
 };
 
@@ -260,15 +301,37 @@ static const struct nv_list overflow_actions[] =
   { NULL,     0 }
 };
 
+static const struct nv_list rate_limit_selectors[] =
+{
+  {"none",  RL_NONE },
+  {"key",   RL_KEY },
+  {"type",  RL_TYPE },
+  {"auid",  RL_AUID },
+  { NULL,   0 }
+};
+
 static const struct nv_list transport_words[] =
 {
   {"tcp",  T_TCP  },
+#ifdef USE_TLS
+  {"tls",  T_TLS  },
+#endif
 #ifdef USE_GSSAPI
   {"krb5", T_KRB5 },
 #endif
   { NULL,  0 }
 };
 
+static const struct nv_list event_backend_words[] =
+{
+  {"auto",     EB_AUTO },
+  {"select",   EB_SELECT },
+  {"poll",     EB_POLL },
+  {"epoll",    EB_EPOLL },
+  {"io_uring", EB_IO_URING },
+  { NULL,      0 }
+};
+
 const char *email_command = "/usr/lib/sendmail";
 static int allow_links = 0;
 static const char *config_dir = NULL;
@@ -334,13 +397,30 @@ void clear_config(struct daemon_conf *config)
 	config->transport = T_TCP;
 	config->krb5_principal = NULL;
 	config->krb5_key_file = NULL;
+	config->tls_cert_file = NULL;
+	config->tls_key_file = NULL;
+	config->tls_ca_file = NULL;
 	config->distribute_network_events = 0;
 	config->q_depth = 2000;
 	config->overflow_action = O_SYSLOG;
 	config->max_restarts = 10;
 	config->plugin_dir = strdup("/etc/audit/plugins.d");
+	config->q_spill_dir = NULL;
+	config->q_spill_max_size = 100;
+	config->q_priority_types = NULL;
+	config->q_priority_keys = NULL;
+	config->q_bulk_types = NULL;
+	config->q_bulk_keys = NULL;
 	config->config_dir = NULL;
 	config->end_of_event_timeout = EOE_TIMEOUT;
+	config->event_backend = EB_AUTO;
+	config->rate_limit_by = RL_NONE;
+	config->rate_limit = 0;
+	config->rate_limit_burst = 0;
+	config->rate_limit_sample = 0;
+	config->rate_limit_report = 60;
+	config->log_stream_dir = NULL;
+	config->log_streams = NULL;
 }
 
 static log_test_t log_test = TEST_AUDITD;
@@ -479,6 +559,8 @@ int load_config(struct daemon_conf *config, log_test_t lt)
 	}
 
 	fclose(f);
+	if (config->log_stream_dir)
+		load_log_streams(config);
 	if (lineno > 1)
 		return sanity_check(config);
 	return 0;
@@ -1707,6 +1789,29 @@ static int krb5_key_file_parser(const struct nv_pair *nv, int line,
 	return 0;
 }
 
+static int tls_file_parser(const struct nv_pair *nv, int line,
+	struct daemon_conf *config)
+{
+	audit_msg(LOG_DEBUG, "tls_file_parser called with: %s", nv->value);
+#ifndef USE_TLS
+	audit_msg(LOG_DEBUG,
+		"TLS support is not enabled, ignoring value at line %d",
+		line);
+#else
+	const char **file;
+
+	if (strcmp(nv->name, "tls_cert_file") == 0)
+		file = &config->tls_cert_file;
+	else if (strcmp(nv->name, "tls_key_file") == 0)
+		file = &config->tls_key_file;
+	else
+		file = &config->tls_ca_file;
+	free((void *)*file);
+	*file = strdup(nv->value);
+#endif
+	return 0;
+}
+
 static int distribute_network_parser(const struct nv_pair *nv, int line,
 	struct daemon_conf *config)
 {
@@ -1840,6 +1945,168 @@ static int plugin_dir_parser(const struct nv_pair *nv, int line,
 	return 0;
 }
 
+static int q_spill_dir_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config)
+{
+	audit_msg(LOG_DEBUG, "q_spill_dir_parser called with: %s", nv->value);
+
+	if (nv->value[0] != '/') {
+		audit_msg(LOG_ERR, "q_spill_dir must be an absolute path - line %d",
+			line);
+		return 1;
+	}
+	free(config->q_spill_dir);
+	config->q_spill_dir = strdup(nv->value);
+	if (config->q_spill_dir == NULL)
+		return 1;
+	return 0;
+}
+
+static int q_spill_max_size_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config)
+{
+	const char *ptr = nv->value;
+	unsigned long i;
+
+	audit_msg(LOG_DEBUG, "q_spill_max_size_parser called with: %s",
+		nv->value);
+
+	/* check that all chars are numbers */
+	for (i=0; ptr[i]; i++) {
+		if (!isdigit((unsigned char)ptr[i])) {
+			audit_msg(LOG_ERR,
+				"Value %s should only be numbers - line %d",
+				nv->value, line);
+			return 1;
+		}
+	}
+	/* convert to unsigned long */
+	errno = 0;
+	i = strtoul(nv->value, NULL, 10);
+	if (errno) {
+		audit_msg(LOG_ERR,
+			"Error converting string to a number (%s) - line %d",
+			strerror(errno), line);
+		return 1;
+	}
+	/* Check its range, in megabytes */
+	if (i == 0 || i > 1024*1024) {
+		audit_msg(LOG_ERR,
+		    "q_spill_max_size must be between 1 and 1048576 - line %d",
+			line);
+		return 1;
+	}
+	config->q_spill_max_size = (unsigned int)i;
+	return 0;
+}
+
+/*
+ * The dispatcher lanes keep the list as given, it is split up again when
+ * the queue is set up. Here it is only checked.
+ */
+static char **lane_option(const struct nv_pair *nv, struct daemon_conf *config)
+{
+	if (strcmp(nv->name, "q_priority_types") == 0)
+		return &config->q_priority_types;
+	if (strcmp(nv->name, "q_priority_keys") == 0)
+		return &config->q_priority_keys;
+	if (strcmp(nv->name, "q_bulk_types") == 0)
+		return &config->q_bulk_types;
+	return &config->q_bulk_keys;
+}
+
+/*
+ * The lane of an event is picked from its first record. These types only
+ * ever follow another record, so they would never pick a lane.
+ */
+static const int trailing_types[] = {
+	AUDIT_PATH, AUDIT_IPC, AUDIT_SOCKETCALL, AUDIT_SOCKADDR, AUDIT_CWD,
+	AUDIT_EXECVE, AUDIT_IPC_SET_PERM, AUDIT_MQ_OPEN, AUDIT_MQ_SENDRECV,
+	AUDIT_MQ_NOTIFY, AUDIT_MQ_GETSETATTR, AUDIT_FD_PAIR, AUDIT_OBJ_PID,
+	AUDIT_EOE, AUDIT_BPRM_FCAPS, AUDIT_CAPSET, AUDIT_MMAP, AUDIT_PROCTITLE,
+	AUDIT_KERN_MODULE, AUDIT_TIME_INJOFFSET, AUDIT_TIME_ADJNTPVAL,
+	AUDIT_OPENAT2
+};
+
+static int trailing_type(int type)
+{
+	unsigned int i;
+
+	for (i = 0; i < sizeof(trailing_types)/sizeof(trailing_types[0]); i++)
+		if (trailing_types[i] == type)
+			return 1;
+	return 0;
+}
+
+static int q_lane_types_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config)
+{
+	char *buf, *ptr, *saved, **opt;
+
+	audit_msg(LOG_DEBUG, "q_lane_types_parser called with: %s",
+		nv->value);
+
+	buf = strdup(nv->value);
+	if (buf == NULL)
+		return 1;
+	for (ptr = strtok_r(buf, ",", &saved); ptr;
+				ptr = strtok_r(NULL, ",", &saved)) {
+		int type = audit_name_to_msg_type(ptr);
+
+		if (type < 0) {
+			audit_msg(LOG_ERR, "Unknown record type %s - line %d",
+				ptr, line);
+			free(buf);
+			return 1;
+		}
+		if (trailing_type(type)) {
+			audit_msg(LOG_ERR,
+		"Record type %s never starts an event, use its key - line %d",
+				ptr, line);
+			free(buf);
+			return 1;
+		}
+	}
+	free(buf);
+
+	opt = lane_option(nv, config);
+	free(*opt);
+	*opt = strdup(nv->value);
+	if (*opt == NULL)
+		return 1;
+	return 0;
+}
+
+static int q_lane_keys_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config)
+{
+	char *buf, *ptr, *saved, **opt;
+
+	audit_msg(LOG_DEBUG, "q_lane_keys_parser called with: %s",
+		nv->value);
+
+	buf = strdup(nv->value);
+	if (buf == NULL)
+		return 1;
+	for (ptr = strtok_r(buf, ",", &saved); ptr;
+				ptr = strtok_r(NULL, ",", &saved)) {
+		if (strlen(ptr) > AUDIT_MAX_KEY_LEN) {
+			audit_msg(LOG_ERR, "Key %s is too long - line %d",
+				ptr, line);
+			free(buf);
+			return 1;
+		}
+	}
+	free(buf);
+
+	opt = lane_option(nv, config);
+	free(*opt);
+	*opt = strdup(nv->value);
+	if (*opt == NULL)
+		return 1;
+	return 0;
+}
+
 static int eoe_timeout_parser(const struct nv_pair *nv, int line,
 		struct daemon_conf *config)
 {
@@ -1871,6 +2138,463 @@ static int eoe_timeout_parser(const struct nv_pair *nv, int line,
 	return 0;
 }
 
+static int rate_limit_by_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config)
+{
+	int i;
+
+	audit_msg(LOG_DEBUG, "rate_limit_by_parser called with: %s",
+		nv->value);
+
+	for (i=0; rate_limit_selectors[i].name != NULL; i++) {
+		if (strcasecmp(nv->value, rate_limit_selectors[i].name) == 0) {
+			config->rate_limit_by = rate_limit_selectors[i].option;
+			return 0;
+		}
+	}
+	audit_msg(LOG_ERR, "Option %s not found - line %d", nv->value, line);
+	return 1;
+}
+
+static int event_backend_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config)
+{
+	int i;
+
+	audit_msg(LOG_DEBUG, "event_backend_parser called with: %s",
+		nv->value);
+
+	for (i=0; event_backend_words[i].name != NULL; i++) {
+		if (strcasecmp(nv->value, event_backend_words[i].name) == 0) {
+			config->event_backend = event_backend_words[i].option;
+			return 0;
+		}
+	}
+	audit_msg(LOG_ERR, "Option %s not found - line %d", nv->value, line);
+	return 1;
+}
+
+static int log_stream_dir_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config)
+{
+	audit_msg(LOG_DEBUG, "log_stream_dir_parser called with: %s",
+		nv->value);
+
+	free(config->log_stream_dir);
+	config->log_stream_dir = strdup(nv->value);
+	if (config->log_stream_dir == NULL)
+		return 1;
+	return 0;
+}
+
+/* Shared by the rate limit parsers. Returns 0 on success, 1 on error. */
+static int rate_limit_number(const struct nv_pair *nv, int line,
+		unsigned int *val)
+{
+	const char *ptr = nv->value;
+	unsigned long i;
+
+	/* check that all chars are numbers */
+	for (i=0; ptr[i]; i++) {
+		if (!isdigit((unsigned char)ptr[i])) {
+			audit_msg(LOG_ERR,
+				"Value %s should only be numbers - line %d",
+				nv->value, line);
+			return 1;
+		}
+	}
+
+	/* convert to unsigned int */
+	errno = 0;
+	i = strtoul(nv->value, NULL, 10);
+	if (errno) {
+		audit_msg(LOG_ERR,
+			"Error converting string to a number (%s) - line %d",
+			strerror(errno), line);
+		return 1;
+	}
+	/* Check its range */
+	if (i > INT_MAX) {
+		audit_msg(LOG_ERR,
+			"Error - converted number (%s) is too large - line %d",
+			nv->value, line);
+		return 1;
+	}
+	*val = (unsigned int)i;
+	return 0;
+}
+
+static int rate_limit_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config)
+{
+	audit_msg(LOG_DEBUG, "rate_limit_parser called with: %s", nv->value);
+	return rate_limit_number(nv, line, &config->rate_limit);
+}
+
+static int rate_limit_burst_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config)
+{
+	audit_msg(LOG_DEBUG, "rate_limit_burst_parser called with: %s",
+		nv->value);
+	return rate_limit_number(nv, line, &config->rate_limit_burst);
+}
+
+static int rate_limit_sample_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config)
+{
+	audit_msg(LOG_DEBUG, "rate_limit_sample_parser called with: %s",
+		nv->value);
+	return rate_limit_number(nv, line, &config->rate_limit_sample);
+}
+
+static int rate_limit_report_parser(const struct nv_pair *nv, int line,
+		struct daemon_conf *config)
+{
+	audit_msg(LOG_DEBUG, "rate_limit_report_parser called with: %s",
+		nv->value);
+	if (rate_limit_number(nv, line, &config->rate_limit_report))
+		return 1;
+	if (config->rate_limit_report == 0) {
+		audit_msg(LOG_ERR,
+			"rate_limit_report must be larger than 0 - line %d",
+			line);
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Log stream configuration. Each file in log_stream_dir describes one
+ * stream. The log file settings reuse the auditd.conf keyword parsers
+ * against a scratch daemon_conf, the match_* keywords are stream only.
+ */
+static const char *stream_keywords[] =
+{
+  "log_file",
+  "num_logs",
+  "max_log_file",
+  "max_log_file_action",
+  "space_left",
+  "space_left_action",
+  NULL
+};
+
+static int match_type_parser(const struct nv_pair *nv, int line,
+		struct log_stream_conf *s)
+{
+	char *buf, *ptr, *saved;
+	int rc = 0;
+
+	buf = strdup(nv->value);
+	if (buf == NULL)
+		return 1;
+	ptr = strtok_r(buf, ",", &saved);
+	while (ptr) {
+		int type = audit_name_to_msg_type(ptr);
+		int *tmp;
+
+		if (type < 0) {
+			audit_msg(LOG_ERR, "Unknown record type %s - line %d",
+				ptr, line);
+			rc = 1;
+			break;
+		}
+		tmp = realloc(s->match_types,
+			      (s->num_types + 1) * sizeof(int));
+		if (tmp == NULL) {
+			rc = 1;
+			break;
+		}
+		s->match_types = tmp;
+		s->match_types[s->num_types++] = type;
+		ptr = strtok_r(NULL, ",", &saved);
+	}
+	free(buf);
+	return rc;
+}
+
+static int match_key_parser(const struct nv_pair *nv, int line,
+		struct log_stream_conf *s)
+{
+	char *buf, *ptr, *saved;
+	int rc = 0;
+
+	buf = strdup(nv->value);
+	if (buf == NULL)
+		return 1;
+	ptr = strtok_r(buf, ",", &saved);
+	while (ptr) {
+		char **tmp;
+
+		if (strlen(ptr) > AUDIT_MAX_KEY_LEN) {
+			audit_msg(LOG_ERR, "Key %s is too long - line %d",
+				ptr, line);
+			rc = 1;
+			break;
+		}
+		tmp = realloc(s->match_keys,
+			      (s->num_keys + 1) * sizeof(char *));
+		if (tmp == NULL) {
+			rc = 1;
+			break;
+		}
+		s->match_keys = tmp;
+		s->match_keys[s->num_keys] = strdup(ptr);
+		if (s->match_keys[s->num_keys] == NULL) {
+			rc = 1;
+			break;
+		}
+		s->num_keys++;
+		ptr = strtok_r(NULL, ",", &saved);
+	}
+	free(buf);
+	return rc;
+}
+
+static int match_auid_parser(const struct nv_pair *nv, int line,
+		struct log_stream_conf *s)
+{
+	char *buf, *ptr, *saved;
+	int rc = 0;
+
+	buf = strdup(nv->value);
+	if (buf == NULL)
+		return 1;
+	ptr = strtok_r(buf, ",", &saved);
+	while (ptr) {
+		char *end;
+		unsigned long auid;
+		uid_t *tmp;
+
+		errno = 0;
+		auid = strtoul(ptr, &end, 10);
+		if (errno || *end || auid > UINT_MAX) {
+			audit_msg(LOG_ERR, "Invalid auid %s - line %d",
+				ptr, line);
+			rc = 1;
+			break;
+		}
+		tmp = realloc(s->match_auids,
+			      (s->num_auids + 1) * sizeof(uid_t));
+		if (tmp == NULL) {
+			rc = 1;
+			break;
+		}
+		s->match_auids = tmp;
+		s->match_auids[s->num_auids++] = (uid_t)auid;
+		ptr = strtok_r(NULL, ",", &saved);
+	}
+	free(buf);
+	return rc;
+}
+
+static void free_log_stream(struct log_stream_conf *s)
+{
+	unsigned int i;
+
+	free(s->name);
+	free(s->log_file);
+	free(s->match_types);
+	for (i = 0; i < s->num_keys; i++)
+		free(s->match_keys[i]);
+	free(s->match_keys);
+	free(s->match_auids);
+	free(s);
+}
+
+void free_log_streams(struct daemon_conf *config)
+{
+	struct log_stream_conf *s = config->log_streams;
+
+	while (s) {
+		struct log_stream_conf *next = s->next;
+		free_log_stream(s);
+		s = next;
+	}
+	config->log_streams = NULL;
+}
+
+/* Returns 0 on success and 1 if the stream should be skipped */
+static int parse_log_stream(FILE *f, const char *file,
+		struct log_stream_conf *s)
+{
+	struct daemon_conf tmp;
+	char buf[160];
+	int lineno = 1, rc = 0;
+
+	clear_config(&tmp);
+	free((void *)tmp.log_file);
+	tmp.log_file = NULL;
+	while (rc == 0 && get_line(f, buf, sizeof(buf), &lineno, file)) {
+		const struct kw_pair *kw;
+		struct nv_pair nv;
+		int i;
+
+		if (nv_split(buf, &nv)) {
+			audit_msg(LOG_ERR, "Malformed line %d in %s",
+				lineno, file);
+			rc = 1;
+			break;
+		}
+		if (nv.name == NULL) {
+			lineno++;
+			continue;
+		}
+		if (nv.value == NULL || nv.option != NULL) {
+			audit_msg(LOG_ERR, "Wrong number of arguments for "
+				"line %d in %s", lineno, file);
+			rc = 1;
+			break;
+		}
+
+		if (strcasecmp(nv.name, "match_type") == 0)
+			rc = match_type_parser(&nv, lineno, s);
+		else if (strcasecmp(nv.name, "match_key") == 0)
+			rc = match_key_parser(&nv, lineno, s);
+		else if (strcasecmp(nv.name, "match_auid") == 0)
+			rc = match_auid_parser(&nv, lineno, s);
+		else {
+			for (i = 0; stream_keywords[i]; i++) {
+				if (strcasecmp(nv.name, stream_keywords[i])==0)
+					break;
+			}
+			if (stream_keywords[i] == NULL) {
+				audit_msg(LOG_ERR,
+				   "Unknown keyword \"%s\" in line %d of %s",
+					nv.name, lineno, file);
+				rc = 1;
+				break;
+			}
+			kw = kw_lookup(nv.name);
+			rc = kw->parser(&nv, lineno, &tmp);
+		}
+		lineno++;
+	}
+
+	if (rc == 0 && tmp.log_file == NULL) {
+		audit_msg(LOG_ERR, "No log_file given in %s", file);
+		rc = 1;
+	}
+	if (rc == 0 && tmp.space_left_percent) {
+		audit_msg(LOG_ERR,
+		    "Percentages are not supported for space_left in %s", file);
+		rc = 1;
+	}
+	if (rc == 0) {
+		switch (tmp.space_left_action)
+		{
+			case FA_IGNORE:
+			case FA_SYSLOG:
+			case FA_ROTATE:
+			case FA_SUSPEND:
+				break;
+			default:
+				audit_msg(LOG_ERR,
+	"Only ignore, syslog, rotate, or suspend are allowed for space_left_action in %s",
+					file);
+				rc = 1;
+				break;
+		}
+	}
+	if (rc == 0 && s->num_types == 0 && s->num_keys == 0 &&
+			s->num_auids == 0) {
+		audit_msg(LOG_ERR, "No match criteria given in %s", file);
+		rc = 1;
+	}
+
+	s->log_file = (char *)tmp.log_file;
+	s->num_logs = tmp.num_logs;
+	s->max_log_size = tmp.max_log_size;
+	s->max_log_size_action = tmp.max_log_size_action;
+	s->space_left = tmp.space_left;
+	s->space_left_action = tmp.space_left_action;
+	free((void *)tmp.action_mail_acct);
+	free((void *)tmp.space_left_exe);
+	free(tmp.plugin_dir);
+	return rc;
+}
+
+static int filter_stream_file(const struct dirent *e)
+{
+	size_t len = strlen(e->d_name);
+
+	// Skip hidden files, backups, and anything not ending in .conf
+	if (e->d_name[0] == '.' || len <= 5)
+		return 0;
+	return strcmp(&e->d_name[len - 5], ".conf") == 0;
+}
+
+/*
+ * Load the log stream configs in name order, which is also the order
+ * that stream predicates are evaluated in. A stream with errors is
+ * skipped so that its events stay in the main log.
+ */
+static void load_log_streams(struct daemon_conf *config)
+{
+	struct dirent **namelist;
+	struct log_stream_conf **tail = &config->log_streams;
+	int i, n;
+
+	n = scandir(config->log_stream_dir, &namelist, filter_stream_file,
+		    alphasort);
+	if (n < 0) {
+		audit_msg(LOG_WARNING, "Could not open log stream dir %s (%s)",
+			config->log_stream_dir, strerror(errno));
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		char fname[PATH_MAX];
+		struct log_stream_conf *s;
+		struct stat st;
+		FILE *f;
+		int fd;
+
+		snprintf(fname, sizeof(fname), "%s/%s",
+			config->log_stream_dir, namelist[i]->d_name);
+		free(namelist[i]);
+
+		fd = open(fname, O_RDONLY|O_NOFOLLOW);
+		if (fd < 0) {
+			audit_msg(LOG_ERR, "Error opening %s (%s)", fname,
+				strerror(errno));
+			continue;
+		}
+		if (fstat(fd, &st) < 0 || st.st_uid != 0 ||
+				(st.st_mode & S_IWOTH) == S_IWOTH ||
+				!S_ISREG(st.st_mode)) {
+			audit_msg(LOG_ERR, "Error - %s must be a regular file "
+				"owned by root and not world writable", fname);
+			close(fd);
+			continue;
+		}
+		f = fdopen(fd, "rm");
+		if (f == NULL) {
+			close(fd);
+			continue;
+		}
+
+		s = calloc(1, sizeof(*s));
+		if (s == NULL) {
+			fclose(f);
+			continue;
+		}
+		s->name = strdup(basename(fname));
+		if (s->name)
+			s->name[strlen(s->name) - 5] = 0;
+		if (s->name == NULL || parse_log_stream(f, fname, s)) {
+			audit_msg(LOG_ERR,
+				"Skipping log stream %s due to errors", fname);
+			free_log_stream(s);
+		} else {
+			*tail = s;
+			tail = &s->next;
+		}
+		fclose(f);
+	}
+	free(namelist);
+}
+
 /*
  * Query file system and calculate in MB the given percentage is.
  * Returns 0 on error and a number otherwise.
@@ -1953,7 +2677,19 @@ static int sanity_check(struct daemon_conf *config)
 		if (rc)
 			return rc;
 	}
+	if (config->transport == T_TLS && (config->tls_cert_file == NULL ||
+			config->tls_key_file == NULL ||
+			config->tls_ca_file == NULL)) {
+		audit_msg(LOG_ERR,
+	    "Error - transport is tls, but tls_cert_file, tls_key_file, or tls_ca_file is not set");
+		return 1;
+	}
 	/* Warnings */
+	if (config->rate_limit_by == RL_NONE &&
+			(config->rate_limit || config->rate_limit_sample)) {
+		audit_msg(LOG_WARNING,
+	    "Warning - rate_limit_by is none, rate limiting is not active.");
+	}
 	if (config->flush > FT_INCREMENTAL_ASYNC && config->freq != 0) {
 		audit_msg(LOG_WARNING, 
            "Warning - freq is non-zero and incremental flushing not selected.");
@@ -1999,7 +2735,17 @@ void free_config(struct daemon_conf *config)
         free((void *)config->disk_error_exe);
         free((void *)config->krb5_principal);
         free((void *)config->krb5_key_file);
+	free((void *)config->tls_cert_file);
+	free((void *)config->tls_key_file);
+	free((void *)config->tls_ca_file);
 	free((void *)config->plugin_dir);
+	free(config->q_spill_dir);
+	free(config->q_priority_types);
+	free(config->q_priority_keys);
+	free(config->q_bulk_types);
+	free(config->q_bulk_keys);
+	free(config->log_stream_dir);
+	free_log_streams(config);
         free((void *)config_dir);
 	free(config_file);
         config_file = NULL;
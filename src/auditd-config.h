@@ -43,6 +43,28 @@ typedef enum { N_NONE, N_HOSTNAME, N_FQD, N_NUMERIC, N_USER } node_t;
 typedef enum { O_IGNORE, O_SYSLOG, O_SUSPEND, O_SINGLE,
 		O_HALT } overflow_action_t;
 typedef enum { T_TCP, T_TLS, T_KRB5, T_LABELED } transport_t;
+typedef enum { RL_NONE, RL_KEY, RL_TYPE, RL_AUID } rate_limit_t;
+typedef enum { EB_AUTO, EB_SELECT, EB_POLL, EB_EPOLL, EB_IO_URING } event_backend_t;
+
+/* A log stream is an extra log file that events matching its
+ * predicate are written to instead of the main log. */
+struct log_stream_conf
+{
+	char *name;
+	char *log_file;
+	unsigned int num_logs;
+	unsigned long max_log_size;
+	size_action max_log_size_action;
+	unsigned long space_left;
+	failure_action_t space_left_action;
+	int *match_types;
+	unsigned int num_types;
+	char **match_keys;
+	unsigned int num_keys;
+	uid_t *match_auids;
+	unsigned int num_auids;
+	struct log_stream_conf *next;
+};
 
 struct daemon_conf
 {
@@ -87,13 +109,32 @@ struct daemon_conf
 	int transport;
 	const char *krb5_principal;
 	const char *krb5_key_file;
+	const char *tls_cert_file;
+	const char *tls_key_file;
+	const char *tls_ca_file;
 	int distribute_network_events;
+	event_backend_t event_backend;
 	// Dispatcher config
 	unsigned int q_depth;
 	overflow_action_t overflow_action;
 	unsigned int max_restarts;
 	char *plugin_dir;
+	char *q_spill_dir;
+	unsigned int q_spill_max_size;
+	char *q_priority_types;
+	char *q_priority_keys;
+	char *q_bulk_types;
+	char *q_bulk_keys;
 	const char *config_dir;
+	// Userspace rate limiting
+	rate_limit_t rate_limit_by;
+	unsigned int rate_limit;
+	unsigned int rate_limit_burst;
+	unsigned int rate_limit_sample;
+	unsigned int rate_limit_report;
+	// Log streams
+	char *log_stream_dir;
+	struct log_stream_conf *log_streams;
         // Userspace configuration items
         unsigned long end_of_event_timeout;
 };
@@ -113,5 +154,6 @@ void init_config_manager(void);
 int start_config_manager(struct auditd_event *e);
 #endif
 void free_config(struct daemon_conf *config);
+void free_log_streams(struct daemon_conf *config);
 
 #endif
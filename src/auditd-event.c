@@ -42,49 +42,82 @@
 #include "auditd-event.h"
 #include "auditd-dispatch.h"
 #include "auditd-listen.h"
+#include "auditd-ratelimit.h"
+#include "auditd-reload.h"
+#include "evcache.h"
 #include "libaudit.h"
 #include "private.h"
 #include "auparse.h"
 #include "auparse-idata.h"
+#include "ev.h"
 
 /* This is defined in auditd.c */
 extern volatile ATOMIC_INT stop;
 
+/* Everything needed to write and rotate one log file. The main log
+ * takes its settings from the daemon config, log streams from their
+ * own config file. */
+struct log_stream {
+	const char *name;
+	const char *log_file;
+	unsigned int num_logs;
+	unsigned long max_log_size;
+	size_action max_log_size_action;
+	unsigned long space_left;
+	failure_action_t space_left_action;
+	const struct log_stream_conf *conf;	/* NULL for the main log */
+	volatile int fd;
+	FILE *file;
+	off_t size;
+	unsigned int known_logs;
+	unsigned int last_log;
+	int suspended;
+	int space_warning;
+};
+
 /* Local function prototypes */
 static void send_ack(const struct auditd_event *e, int ack_type,
 			const char *msg);
 static void write_to_log(const struct auditd_event *e);
-static void check_log_file_size(void);
+static void check_log_file_size(struct log_stream *ls);
 static void check_space_left(void);
+static void check_stream_space_left(struct log_stream *ls);
 static void do_space_left_action(int admin);
 static void do_disk_full_action(void);
 static void do_disk_error_action(const char *func, int err);
-static void fix_disk_permissions(void);
-static void check_excess_logs(void);
+static void log_disk_error(struct log_stream *ls, const char *func, int err);
+static void fix_disk_permissions(struct log_stream *ls);
+static void check_excess_logs(struct log_stream *ls);
 static void rotate_logs_now(void);
-static void rotate_logs(unsigned int num_logs, unsigned int keep_logs);
-static void shift_logs(void);
-static int  open_audit_log(void);
+static void rotate_logs(struct log_stream *ls, unsigned int num_logs,
+			unsigned int keep_logs);
+static void shift_logs(struct log_stream *ls);
+static int  open_audit_log(struct log_stream *ls);
+static struct log_stream *route_event(const struct auditd_event *e);
+static int write_to_stream(struct log_stream *ls,
+			const struct auditd_event *e);
+static void open_log_streams(void);
+static void close_log_streams(void);
 static void change_runlevel(const char *level);
 static void safe_exec(const char *exe);
 static void reconfigure(struct auditd_event *e);
+static char reconf_timing[256];
 static void init_flush_thread(void);
 
 
 /* Local Data */
 static struct daemon_conf *config;
-static volatile int log_fd;
-static FILE *log_file = NULL;
+static struct log_stream main_log = { .fd = -1, .last_log = 1 };
+static struct log_stream *streams = NULL;
+static unsigned int num_streams = 0;
+static evcache_t routes;	/* Stream index + 1 of open events, 0 is main */
 static unsigned int disk_err_warning = 0;
 static int fs_space_warning = 0;
 static int fs_admin_space_warning = 0;
 static int fs_space_left = 1;
-static int logging_suspended = 0;
-static unsigned int known_logs = 0;
 static const char *SINGLE = "1";
 static const char *HALT = "0";
 static char *format_buf = NULL;
-static off_t log_size = 0;
 static pthread_t flush_thread;
 static pthread_mutex_t flush_lock;
 static pthread_cond_t do_flush;
@@ -111,13 +144,13 @@ void write_logging_state(FILE *f)
 		struct statfs buf;
 
 		fprintf(f, "current log size = %llu KB\n",
-			(long long unsigned)log_size/1024);
+			(long long unsigned)main_log.size/1024);
 		fprintf(f, "max log size = %lu KB\n",
 				config->max_log_size * (MEGABYTE/1024));
-		fprintf(f,"logs detected last rotate/shift = %u\n", known_logs);
+		fprintf(f,"logs detected last rotate/shift = %u\n", main_log.known_logs);
 		fprintf(f, "space left on partition = %s\n",
 					fs_space_left ? "yes" : "no");
-		rc = fstatfs(log_fd, &buf);
+		rc = fstatfs(main_log.fd, &buf);
 		if (rc == 0) {
 			fprintf(f, "Logging partition free space %llu MB\n",
 				(long long unsigned)
@@ -128,75 +161,102 @@ void write_logging_state(FILE *f)
 				config->admin_space_left);
 		}
 		fprintf(f, "logging suspended = %s\n",
-					logging_suspended ? "yes" : "no");
+					main_log.suspended ? "yes" : "no");
 		fprintf(f, "file system space action performed = %s\n",
 					fs_space_warning ? "yes" : "no");
 		fprintf(f, "admin space action performed = %s\n",
 					fs_admin_space_warning ? "yes" : "no");
 		fprintf(f, "disk error detected = %s\n",
 					disk_err_warning ? "yes" : "no");
+		for (unsigned int i = 0; i < num_streams; i++) {
+			struct log_stream *ls = &streams[i];
+
+			fprintf(f, "log stream %s = %s size %llu KB%s\n",
+				ls->name, ls->log_file,
+				(long long unsigned)ls->size/1024,
+				ls->suspended ? " suspended" : "");
+		}
 	}
+	if (reconf_timing[0])
+		fprintf(f, "last reconfigure steps = %s\n", reconf_timing);
 }
 
 void shutdown_events(void)
 {
 	// We are no longer processing events, sync the disk and close up.
+	// Streams first, a cancelled flush thread may leave flush_lock held.
+	close_log_streams();
 	pthread_cancel(flush_thread);
 	free((void *)format_buf);
 	auparse_destroy_ext(au, AUPARSE_DESTROY_ALL);
-	if (log_fd >= 0)
-		fsync(log_fd);
-	if (log_file)
-		fclose(log_file);
+	if (main_log.fd >= 0)
+		fsync(main_log.fd);
+	if (main_log.file)
+		fclose(main_log.file);
+}
+
+/* Copy the settings of the main log from the daemon config */
+static void sync_main_log(void)
+{
+	main_log.name = "main";
+	main_log.log_file = config->log_file;
+	main_log.num_logs = config->num_logs;
+	main_log.max_log_size = config->max_log_size;
+	main_log.max_log_size_action = config->max_log_size_action;
 }
 
 int init_event(struct daemon_conf *conf)
 {
 	/* Store the netlink descriptor and config info away */
 	config = conf;
-	log_fd = -1;
+	main_log.fd = -1;
+	sync_main_log();
 
 	/* Now open the log */
 	if (config->daemonize == D_BACKGROUND) {
-		fix_disk_permissions();
-		if (open_audit_log())
+		fix_disk_permissions(&main_log);
+		if (open_audit_log(&main_log))
 			return 1;
-		setup_percentages(config, log_fd);
+		setup_percentages(config, main_log.fd);
 	} else {
-		log_fd = 1; // stdout
-		log_file = fdopen(log_fd, "a");
-		if (log_file == NULL) {
+		main_log.fd = 1; // stdout
+		main_log.file = fdopen(main_log.fd, "a");
+		if (main_log.file == NULL) {
 			audit_msg(LOG_ERR,
 				"Error setting up stdout descriptor (%s)",
 				strerror(errno));
 			return 1;
 		}
 		/* Set it to line buffering */
-		setlinebuf(log_file);
+		setlinebuf(main_log.file);
 	}
 
 	if (config->daemonize == D_BACKGROUND) {
-		check_log_file_size();
-		check_excess_logs();
+		check_log_file_size(&main_log);
+		check_excess_logs(&main_log);
 		check_space_left();
 	}
 	format_buf = (char *)malloc(FORMAT_BUF_LEN);
 	if (format_buf == NULL) {
 		audit_msg(LOG_ERR, "No memory for formatting, exiting");
-		if (log_file)
-			fclose(log_file);
-		log_file = NULL;
+		if (main_log.file)
+			fclose(main_log.file);
+		main_log.file = NULL;
 		return 1;
 	}
 	init_flush_thread();
+	open_log_streams();
 	return 0;
 }
 
 /* This tells the OS that pending writes need to get going.
  * Its only used when flush == incremental_async. */
+#define MAX_SYNC_STREAMS 64
 static void *flush_thread_main(void *arg)
 {
 	sigset_t sigs;
+	int fds[MAX_SYNC_STREAMS];
+	unsigned int i, n;
 
 	/* This is a worker thread. Don't handle signals. */
 	sigemptyset(&sigs);
@@ -222,10 +282,16 @@ static void *flush_thread_main(void *arg)
 			}
 		}
 		flush = 0;
+		// The stream array is only replaced while holding the lock
+		for (i = 0, n = 0; i < num_streams && n < MAX_SYNC_STREAMS; i++)
+			if (streams[i].fd >= 0)
+				fds[n++] = streams[i].fd;
 		pthread_mutex_unlock(&flush_lock);
 
-		if (log_fd >= 0)
-			fsync(log_fd);
+		if (main_log.fd >= 0)
+			fsync(main_log.fd);
+		for (i = 0; i < n; i++)
+			fsync(fds[i]);
 	}
 	return NULL;
 }
@@ -566,16 +632,15 @@ static unsigned int count = 0L;
 void handle_event(struct auditd_event *e)
 {
 	if (e->reply.type == AUDIT_DAEMON_RECONFIG && e->ack_func == NULL) {
+		// The result is logged once the last step has been applied
 		reconfigure(e);
-		if (config->write_logs == 0 && config->daemonize == D_BACKGROUND)
-                        return;
-                format_event(e);
+		return;
 	} else if (e->reply.type == AUDIT_DAEMON_ROTATE) {
 		rotate_logs_now();
 		if (config->write_logs == 0 && config->daemonize == D_BACKGROUND)
 			return;
 	}
-	if (!logging_suspended && (config->write_logs ||
+	if (!main_log.suspended && (config->write_logs ||
 					config->daemonize == D_FOREGROUND)) {
 		write_to_log(e);
 
@@ -587,8 +652,11 @@ void handle_event(struct auditd_event *e)
 				int rc;
 				errno = 0;
 				do {
-					rc = fflush_unlocked(log_file);
+					rc = fflush_unlocked(main_log.file);
 				} while (rc < 0 && errno == EINTR);
+				for (unsigned int i = 0; i < num_streams; i++)
+					if (streams[i].file)
+					     fflush_unlocked(streams[i].file);
 		                if (errno) {
 					if (errno == ENOSPC &&
 					     fs_space_left == 1) {
@@ -603,12 +671,16 @@ void handle_event(struct auditd_event *e)
 				if (config->daemonize == D_BACKGROUND) {
 					if (config->flush == FT_INCREMENTAL) {
 						/* EIO is only likely failure */
-						if (log_fd >= 0 &&
-							fsync(log_fd) != 0) {
+						if (main_log.fd >= 0 &&
+							fsync(main_log.fd) != 0) {
 						     do_disk_error_action(
 							"fsync",
 							errno);
 						}
+						for (unsigned int i = 0;
+							i < num_streams; i++)
+							if (streams[i].fd >= 0)
+							    fsync(streams[i].fd);
 					} else {
 						pthread_mutex_lock(&flush_lock);
 						flush = 1;
@@ -621,7 +693,7 @@ void handle_event(struct auditd_event *e)
 		}
 	} else if (!config->write_logs && config->daemonize == D_BACKGROUND)
 		send_ack(e, AUDIT_RMW_TYPE_ACK, "");
-	else if (logging_suspended)
+	else if (main_log.suspended)
 		send_ack(e,AUDIT_RMW_TYPE_DISKERROR,"remote logging suspended");
 }
 
@@ -641,24 +713,39 @@ static void send_ack(const struct auditd_event *e, int ack_type,
 void resume_logging(void)
 {
 	audit_msg(LOG_NOTICE, "Audit daemon is attempting to resume logging.");
-	logging_suspended = 0;
+	main_log.suspended = 0;
 	fs_space_left = 1;
 
 	// User space action scripts cause fd to close
 	// Need to reopen here to recreate the file if the
 	// script deleted or moved it.
-	if (log_file == NULL) {
-		fix_disk_permissions();
-		if (open_audit_log()) {
+	if (main_log.file == NULL) {
+		fix_disk_permissions(&main_log);
+		if (open_audit_log(&main_log)) {
 			int saved_errno = errno;
 			audit_msg(LOG_WARNING,
 				"Could not reopen a log after resume logging");
-			logging_suspended = 1;
+			main_log.suspended = 1;
 			do_disk_error_action("resume", saved_errno);
 		} else
-			check_log_file_size();
+			check_log_file_size(&main_log);
 		audit_msg(LOG_NOTICE, "Audit daemon resumed logging.");
 	}
+	for (unsigned int i = 0; i < num_streams; i++) {
+		struct log_stream *ls = &streams[i];
+
+		ls->suspended = 0;
+		ls->space_warning = 0;
+		if (ls->file == NULL) {
+			fix_disk_permissions(ls);
+			if (open_audit_log(ls)) {
+				audit_msg(LOG_WARNING,
+				    "Could not reopen log stream %s", ls->name);
+				ls->suspended = 1;
+			} else
+				check_log_file_size(ls);
+		}
+	}
 	disk_err_warning = 0;
 	fs_space_warning = 0;
 	fs_admin_space_warning = 0;
@@ -670,9 +757,15 @@ static void write_to_log(const struct auditd_event *e)
 	int rc;
 	int ack_type = AUDIT_RMW_TYPE_ACK;
 	const char *msg = "";
+	struct log_stream *ls;
+
+	/* Events claimed by a log stream go there, unless it fails */
+	ls = route_event(e);
+	if (ls && write_to_stream(ls, e) == 0)
+		return;
 
 	/* write it to disk */
-	rc = fprintf(log_file, "%s\n", e->reply.message);
+	rc = fprintf(main_log.file, "%s\n", e->reply.message);
 
 	/* error? Handle it */
 	if (rc < 0) {
@@ -699,10 +792,10 @@ static void write_to_log(const struct auditd_event *e)
 			// actionable. There may be some temporary condition
 			// that the system recovers from. The real error
 			// occurs on write.
-			log_size += rc;
-			check_log_file_size();
+			main_log.size += rc;
+			check_log_file_size(&main_log);
 			// Keep loose tabs on the free space
-			if ((log_size % 8) < 3)
+			if ((main_log.size % 8) < 3)
 				check_space_left();
 		}
 
@@ -713,16 +806,377 @@ static void write_to_log(const struct auditd_event *e)
 	}
 }
 
-static void check_log_file_size(void)
+/*
+ * Log stream routing. Records are routed as a whole event: the first
+ * record of an event decides the stream and the decision is remembered
+ * by event id until its EOE record so that the remaining records follow.
+ */
+static int get_event_id(const char *msg, struct audit_event_id *id)
+{
+	const char *ptr = strstr(msg, "msg=audit(");
+
+	if (ptr == NULL)
+		return 1;
+	ptr += 4;
+	return audit_event_id_parse(ptr, strlen(ptr), id);
+}
+
+static int get_event_type(const struct auditd_event *e)
+{
+	char name[64];
+	const char *ptr;
+	unsigned int i = 0;
+
+	if (e->reply.type)
+		return e->reply.type;
+
+	// Network events may not carry a type, take it from the text
+	if (strncmp(e->reply.message, "type=", 5))
+		return -1;
+	for (ptr = e->reply.message + 5; *ptr && *ptr != ' ' &&
+					i < sizeof(name) - 1; ptr++)
+		name[i++] = *ptr;
+	name[i] = 0;
+	return audit_name_to_msg_type(name);
+}
+
+/*
+ * Copy the key(s) of the event into buf separated by the key separator.
+ * Returns the length of the keys or 0 if there are none.
+ */
+static size_t get_event_keys(const char *msg, char *buf, size_t blen)
+{
+	const char *ptr;
+	size_t i = 0;
+
+	ptr = strstr(msg, " key=");
+	if (ptr == NULL)
+		return 0;
+	ptr += 5;
+	if (*ptr == '"') {
+		for (ptr++; *ptr && *ptr != '"' && i < blen - 1; ptr++)
+			buf[i++] = *ptr;
+	} else if (strncmp(ptr, "(null)", 6) == 0) {
+		return 0;
+	} else {
+		// Multiple keys are logged hex encoded
+		while (isxdigit((unsigned char)ptr[0]) &&
+				isxdigit((unsigned char)ptr[1]) &&
+				i < blen - 1) {
+			char hex[3] = { ptr[0], ptr[1], 0 };
+
+			buf[i++] = (char)strtoul(hex, NULL, 16);
+			ptr += 2;
+		}
+	}
+	buf[i] = 0;
+	return i;
+}
+
+static int get_event_auid(const char *msg, uid_t *auid)
+{
+	const char *ptr;
+	char *end;
+	unsigned long val;
+
+	ptr = strstr(msg, " auid=");
+	if (ptr == NULL)
+		return 0;
+	errno = 0;
+	val = strtoul(ptr + 6, &end, 10);
+	if (errno || end == ptr + 6)
+		return 0;
+	*auid = (uid_t)val;
+	return 1;
+}
+
+static int stream_has_key(const struct log_stream_conf *c,
+			const char *keys, size_t klen)
+{
+	const char *ptr = keys, *end = keys + klen;
+
+	while (ptr < end) {
+		const char *sep = memchr(ptr, AUDIT_KEY_SEPARATOR, end - ptr);
+		size_t len = sep ? (size_t)(sep - ptr) : (size_t)(end - ptr);
+		unsigned int i;
+
+		for (i = 0; i < c->num_keys; i++) {
+			if (strlen(c->match_keys[i]) == len &&
+				    memcmp(c->match_keys[i], ptr, len) == 0)
+				return 1;
+		}
+		ptr += len + 1;
+	}
+	return 0;
+}
+
+/* All given criteria must match, any value within one criterion will do */
+static int stream_matches(const struct log_stream_conf *c, int type,
+		const char *keys, size_t klen, int have_auid, uid_t auid)
+{
+	unsigned int i;
+
+	if (c->num_types) {
+		for (i = 0; i < c->num_types; i++)
+			if (c->match_types[i] == type)
+				break;
+		if (i == c->num_types)
+			return 0;
+	}
+	if (c->num_keys && (klen == 0 || !stream_has_key(c, keys, klen)))
+		return 0;
+	if (c->num_auids) {
+		if (!have_auid)
+			return 0;
+		for (i = 0; i < c->num_auids; i++)
+			if (c->match_auids[i] == auid)
+				break;
+		if (i == c->num_auids)
+			return 0;
+	}
+	return 1;
+}
+
+static struct log_stream *route_event(const struct auditd_event *e)
+{
+	struct audit_event_id id;
+	struct log_stream *ls = NULL;
+	char keys[AUDIT_MAX_KEY_LEN+1];
+	size_t klen;
+	uintptr_t idx;
+	uid_t auid = 0;
+	int type, have_id, have_auid, i;
+
+	if (num_streams == 0 || e->reply.message == NULL)
+		return NULL;
+
+	type = get_event_type(e);
+	have_id = !get_event_id(e->reply.message, &id);
+	if (have_id && evcache_find(&routes, &id, &idx)) {
+		if (type == AUDIT_EOE)
+			evcache_remove(&routes, &id);
+		return (idx && idx <= num_streams) ? &streams[idx - 1] : NULL;
+	}
+
+	// Never route the daemon's own records away from the main log
+	if (type >= AUDIT_FIRST_DAEMON && type <= AUDIT_LAST_DAEMON)
+		return NULL;
+
+	klen = get_event_keys(e->reply.message, keys, sizeof(keys));
+	have_auid = get_event_auid(e->reply.message, &auid);
+	for (i = 0; i < (int)num_streams; i++) {
+		if (stream_matches(streams[i].conf, type, keys, klen,
+				   have_auid, auid)) {
+			ls = &streams[i];
+			break;
+		}
+	}
+
+	/*
+	 * If the decision cannot be remembered, the rest of the event will
+	 * not follow it. Keep the event in the main log instead.
+	 */
+	if (have_id && type != AUDIT_EOE && !evcache_single_record(type) &&
+			evcache_add(&routes, &id, ls ? ls - streams + 1 : 0))
+		return NULL;
+	return ls;
+}
+
+/*
+ * Write the event to a log stream. Returns 0 on success and 1 if the
+ * event should go to the main log instead.
+ */
+static int write_to_stream(struct log_stream *ls,
+			const struct auditd_event *e)
+{
+	int rc;
+
+	if (ls->suspended || ls->file == NULL)
+		return 1;
+
+	rc = fprintf(ls->file, "%s\n", e->reply.message);
+	if (rc < 0) {
+		log_disk_error(ls, "write", errno);
+		return 1;
+	}
+
+	if (config->daemonize == D_BACKGROUND) {
+		ls->size += rc;
+		check_log_file_size(ls);
+		if ((ls->size % 8) < 3)
+			check_stream_space_left(ls);
+	}
+	send_ack(e, fs_space_warning || ls->space_warning ?
+			AUDIT_RMW_TYPE_DISKLOW : AUDIT_RMW_TYPE_ACK, "");
+	return 0;
+}
+
+/*
+ * Log streams only get a subset of the disk handling of the main log.
+ * Any error suspends the stream and its events fall back to the main
+ * log until logging is resumed.
+ */
+static void log_disk_error(struct log_stream *ls, const char *func, int err)
+{
+	if (ls != &main_log) {
+		audit_msg(LOG_ALERT,
+		    "%s: Audit daemon suspending log stream %s (%s)",
+			func, ls->name, strerror(err));
+		if (ls->file)
+			fclose(ls->file);
+		ls->file = NULL;
+		ls->fd = -1;
+		ls->suspended = 1;
+		return;
+	}
+
+	if (err == ENOSPC && fs_space_left == 1) {
+		fs_space_left = 0;
+		do_disk_full_action();
+	} else
+		do_disk_error_action(func, err);
+}
+
+static void check_stream_space_left(struct log_stream *ls)
+{
+	struct statfs buf;
+	unsigned long blocks;
+
+	if (ls->fd < 0 || ls->space_left == 0)
+		return;
+
+	if (fstatfs(ls->fd, &buf) != 0 || buf.f_bsize == 0)
+		return;
+
+	blocks = ls->space_left * (MEGABYTE/buf.f_bsize);
+	if (buf.f_bavail < blocks) {
+		if (ls->space_warning)
+			return;
+		switch (ls->space_left_action)
+		{
+			case FA_SYSLOG:
+				audit_msg(LOG_ALERT,
+			    "Audit daemon is low on disk space for log stream %s",
+					ls->name);
+				break;
+			case FA_ROTATE:
+				if (ls->num_logs > 1) {
+					audit_msg(LOG_NOTICE,
+				    "Audit daemon rotating log stream %s",
+						ls->name);
+					rotate_logs(ls, 0, 0);
+				}
+				// Allow unlimited rotation
+				return;
+			case FA_SUSPEND:
+				audit_msg(LOG_ALERT,
+		    "Audit daemon is suspending log stream %s due to low disk space",
+					ls->name);
+				if (ls->file)
+					fclose(ls->file);
+				ls->file = NULL;
+				ls->fd = -1;
+				ls->suspended = 1;
+				break;
+			default:
+				break;
+		}
+		ls->space_warning = 1;
+	} else if (ls->space_warning && ls->space_left_action == FA_SYSLOG)
+		// Auto reset only if failure action is syslog
+		ls->space_warning = 0;
+}
+
+/*
+ * Build the stream table from the configuration and open every stream.
+ * Streams that cannot be opened stay suspended so their events land in
+ * the main log.
+ */
+static void open_log_streams(void)
+{
+	const struct log_stream_conf *c;
+	struct log_stream *tmp;
+	unsigned int i, cnt = 0;
+
+	if (config->daemonize != D_BACKGROUND || config->write_logs == 0)
+		return;
+
+	for (c = config->log_streams; c; c = c->next)
+		cnt++;
+	if (cnt == 0)
+		return;
+
+	tmp = calloc(cnt, sizeof(struct log_stream));
+	if (tmp == NULL) {
+		audit_msg(LOG_ERR, "No memory for log streams");
+		return;
+	}
+
+	for (i = 0, c = config->log_streams; c; c = c->next, i++) {
+		struct log_stream *ls = &tmp[i];
+
+		ls->name = c->name;
+		ls->log_file = c->log_file;
+		ls->num_logs = c->num_logs;
+		ls->max_log_size = c->max_log_size;
+		ls->max_log_size_action = c->max_log_size_action;
+		ls->space_left = c->space_left;
+		ls->space_left_action = c->space_left_action;
+		ls->conf = c;
+		ls->fd = -1;
+		ls->last_log = 1;
+		fix_disk_permissions(ls);
+		if (open_audit_log(ls)) {
+			audit_msg(LOG_ERR, "Could not open log stream %s",
+				ls->name);
+			ls->suspended = 1;
+			continue;
+		}
+		check_log_file_size(ls);
+		check_excess_logs(ls);
+		check_stream_space_left(ls);
+		audit_msg(LOG_INFO, "Log stream %s writing to %s",
+			ls->name, ls->log_file);
+	}
+
+	pthread_mutex_lock(&flush_lock);
+	streams = tmp;
+	num_streams = cnt;
+	pthread_mutex_unlock(&flush_lock);
+}
+
+static void close_log_streams(void)
+{
+	struct log_stream *tmp;
+	unsigned int i, cnt;
+
+	pthread_mutex_lock(&flush_lock);
+	tmp = streams;
+	cnt = num_streams;
+	streams = NULL;
+	num_streams = 0;
+	pthread_mutex_unlock(&flush_lock);
+
+	for (i = 0; i < cnt; i++) {
+		if (tmp[i].fd >= 0)
+			fsync(tmp[i].fd);
+		if (tmp[i].file)
+			fclose(tmp[i].file);
+	}
+	free(tmp);
+	evcache_clear(&routes);
+}
+
+static void check_log_file_size(struct log_stream *ls)
 {
 	/* did we cross the size limit? */
-	off_t sz = log_size / MEGABYTE;
+	off_t sz = ls->size / MEGABYTE;
 
 	if (config->write_logs == 0)
 		return;
 
-	if (sz >= config->max_log_size && (config->daemonize == D_BACKGROUND)) {
-		switch (config->max_log_size_action)
+	if (sz >= ls->max_log_size && (config->daemonize == D_BACKGROUND)) {
+		switch (ls->max_log_size_action)
 		{
 			case SZ_IGNORE:
 				break;
@@ -737,23 +1191,23 @@ static void check_log_file_size(void)
 				// intervention can move or delete the file.
 				// We don't want to keep logging to a deleted
 				// file.
-				if (log_file)
-					fclose(log_file);
-				log_file = NULL;
-				log_fd = -1;
-				logging_suspended = 1;
+				if (ls->file)
+					fclose(ls->file);
+				ls->file = NULL;
+				ls->fd = -1;
+				ls->suspended = 1;
 				break;
 			case SZ_ROTATE:
-				if (config->num_logs > 1) {
+				if (ls->num_logs > 1) {
 					audit_msg(LOG_NOTICE,
 					    "Audit daemon rotating log files");
-					rotate_logs(0, 0);
+					rotate_logs(ls, 0, 0);
 				}
 				break;
 			case SZ_KEEP_LOGS:
 				audit_msg(LOG_NOTICE,
 			    "Audit daemon rotating log files with keep option");
-					shift_logs();
+					shift_logs(ls);
 				break;
 			default:
 				audit_msg(LOG_ALERT,
@@ -768,10 +1222,10 @@ static void check_space_left(void)
 	int rc;
 	struct statfs buf;
 
-	if (log_fd < 0)
+	if (main_log.fd < 0)
 		return;
 
-        rc = fstatfs(log_fd, &buf);
+        rc = fstatfs(main_log.fd, &buf);
         if (rc == 0) {
 		if (buf.f_bavail < 5) {
 			/* we won't consume the last 5 blocks */
@@ -837,7 +1291,7 @@ static void do_space_left_action(int admin)
 			if (config->num_logs > 1) {
 				audit_msg(LOG_NOTICE,
 					"Audit daemon rotating log files");
-				rotate_logs(0, 0);
+				rotate_logs(&main_log, 0, 0);
 			}
 			break;
 		case FA_EMAIL:
@@ -858,11 +1312,11 @@ static void do_space_left_action(int admin)
 		case FA_EXEC:
 			// Close the logging file in case the script zips or
 			// moves the file. We'll reopen in sigusr2 handler
-			if (log_file)
-				fclose(log_file);
-			log_file = NULL;
-			log_fd = -1;
-			logging_suspended = 1;
+			if (main_log.file)
+				fclose(main_log.file);
+			main_log.file = NULL;
+			main_log.fd = -1;
+			main_log.suspended = 1;
 			if (admin)
 				safe_exec(config->admin_space_left_exe);
 			else
@@ -874,11 +1328,11 @@ static void do_space_left_action(int admin)
 			// We need to close the file so that manual
 			// intervention can move or delete the file. We
 			// don't want to keep logging to a deleted file.
-			if (log_file)
-				fclose(log_file);
-			log_file = NULL;
-			log_fd = -1;
-			logging_suspended = 1;
+			if (main_log.file)
+				fclose(main_log.file);
+			main_log.file = NULL;
+			main_log.fd = -1;
+			main_log.suspended = 1;
 			break;
 		case FA_SINGLE:
 			audit_msg(LOG_ALERT,
@@ -912,17 +1366,17 @@ static void do_disk_full_action(void)
 			if (config->num_logs > 1) {
 				audit_msg(LOG_NOTICE,
 					"Audit daemon rotating log files");
-				rotate_logs(0, 0);
+				rotate_logs(&main_log, 0, 0);
 			}
 			break;
 		case FA_EXEC:
 			// Close the logging file in case the script zips or
 			// moves the file. We'll reopen in sigusr2 handler
-			if (log_file)
-				fclose(log_file);
-			log_file = NULL;
-			log_fd = -1;
-			logging_suspended = 1;
+			if (main_log.file)
+				fclose(main_log.file);
+			main_log.file = NULL;
+			main_log.fd = -1;
+			main_log.suspended = 1;
 			safe_exec(config->disk_full_exe);
 			break;
 		case FA_SUSPEND:
@@ -931,11 +1385,11 @@ static void do_disk_full_action(void)
 			// We need to close the file so that manual
 			// intervention can move or delete the file. We
 			// don't want to keep logging to a deleted file.
-			if (log_file)
-				fclose(log_file);
-			log_file = NULL;
-			log_fd = -1;
-			logging_suspended = 1;
+			if (main_log.file)
+				fclose(main_log.file);
+			main_log.file = NULL;
+			main_log.fd = -1;
+			main_log.suspended = 1;
 			break;
 		case FA_SINGLE:
 			audit_msg(LOG_ALERT,
@@ -975,11 +1429,11 @@ static void do_disk_error_action(const char *func, int err)
 		case FA_EXEC:
 			// Close the logging file in case the script zips or
 			// moves the file. We'll reopen in sigusr2 handler
-			if (log_file)
-				fclose(log_file);
-			log_file = NULL;
-			log_fd = -1;
-			logging_suspended = 1;
+			if (main_log.file)
+				fclose(main_log.file);
+			main_log.file = NULL;
+			main_log.fd = -1;
+			main_log.suspended = 1;
 			safe_exec(config->disk_error_exe);
 			break;
 		case FA_SUSPEND:
@@ -988,11 +1442,11 @@ static void do_disk_error_action(const char *func, int err)
 			// We need to close the file so that manual
 			// intervention can move or delete the file. We
 			// don't want to keep logging to a deleted file.
-			if (log_file)
-				fclose(log_file);
-			log_file = NULL;
-			log_fd = -1;
-			logging_suspended = 1;
+			if (main_log.file)
+				fclose(main_log.file);
+			main_log.file = NULL;
+			main_log.fd = -1;
+			main_log.suspended = 1;
 			break;
 		case FA_SINGLE:
 			audit_msg(LOG_ALERT,
@@ -1019,13 +1473,19 @@ static void rotate_logs_now(void)
 	if (config->daemonize == D_FOREGROUND)
 		return;
 	if (config->max_log_size_action == SZ_KEEP_LOGS)
-		shift_logs();
+		shift_logs(&main_log);
 	else
-		rotate_logs(0, 0);
+		rotate_logs(&main_log, 0, 0);
+	for (unsigned int i = 0; i < num_streams; i++) {
+		if (streams[i].max_log_size_action == SZ_KEEP_LOGS)
+			shift_logs(&streams[i]);
+		else
+			rotate_logs(&streams[i], 0, 0);
+	}
 }
 
 /* Check for and remove excess logs so that we don't run out of room */
-static void check_excess_logs(void)
+static void check_excess_logs(struct log_stream *ls)
 {
 	int rc;
 	unsigned int i, len;
@@ -1033,11 +1493,11 @@ static void check_excess_logs(void)
 
 	// Only do this if rotate is the log size action
 	// and we actually have a limit
-	if (config->max_log_size_action != SZ_ROTATE ||
-			config->num_logs < 2)
+	if (ls->max_log_size_action != SZ_ROTATE ||
+			ls->num_logs < 2)
 		return;
 
-	len = strlen(config->log_file) + 16;
+	len = strlen(ls->log_file) + 16;
 	name = (char *)malloc(len);
 	if (name == NULL) { /* Not fatal - just messy */
 		audit_msg(LOG_ERR, "No memory checking excess logs");
@@ -1045,10 +1505,10 @@ static void check_excess_logs(void)
 	}
 
 	// We want 1 beyond the normal logs
-	i = config->num_logs;
+	i = ls->num_logs;
 	rc = 0;
 	while (rc == 0) {
-		snprintf(name, len, "%s.%u", config->log_file, i++);
+		snprintf(name, len, "%s.%u", ls->log_file, i++);
 		rc=unlink(name);
 		if (rc == 0)
 			audit_msg(LOG_NOTICE,
@@ -1058,22 +1518,22 @@ static void check_excess_logs(void)
 	free(name);
 }
 
-static void fix_disk_permissions(void)
+static void fix_disk_permissions(struct log_stream *ls)
 {
 	char *path, *dir;
 	unsigned int i, len;
 
-	if (config == NULL || config->log_file == NULL)
+	if (config == NULL || ls->log_file == NULL)
 		return;
 
-	len = strlen(config->log_file) + 16;
+	len = strlen(ls->log_file) + 16;
 
 	path = malloc(len);
 	if (path == NULL)
 		return;
 
 	// Start with the directory
-	strcpy(path, config->log_file);
+	strcpy(path, ls->log_file);
 	dir = dirname(path);
 	if (chmod(dir,config->log_group ? S_IRWXU|S_IRGRP|S_IXGRP: S_IRWXU) < 0)
 		audit_msg(LOG_WARNING, "Couldn't change access mode of "
@@ -1083,22 +1543,23 @@ static void fix_disk_permissions(void)
 			"%s (%s)", dir, strerror(errno));
 
 	// Now, for each file...
-	for (i = 1; i < config->num_logs; i++) {
+	for (i = 1; i < ls->num_logs; i++) {
 		int rc;
-		snprintf(path, len, "%s.%u", config->log_file, i);
+		snprintf(path, len, "%s.%u", ls->log_file, i);
 		rc = chmod(path, config->log_group ? S_IRUSR|S_IRGRP : S_IRUSR);
 		if (rc && errno == ENOENT)
 			break;
 	}
 
 	// Now the current file
-	chmod(config->log_file, config->log_group ? S_IWUSR|S_IRUSR|S_IRGRP :
+	chmod(ls->log_file, config->log_group ? S_IWUSR|S_IRUSR|S_IRGRP :
 			S_IWUSR|S_IRUSR);
 
 	free(path);
 }
 
-static void rotate_logs(unsigned int num_logs, unsigned int keep_logs)
+static void rotate_logs(struct log_stream *ls, unsigned int num_logs,
+			unsigned int keep_logs)
 {
 	int rc, i;
 	unsigned int len;
@@ -1108,7 +1569,7 @@ static void rotate_logs(unsigned int num_logs, unsigned int keep_logs)
 	 * is no need to check for max_log_size_action == SZ_ROTATE because
 	 * this could be invoked externally by receiving a USR1 signal,
 	 * independently on the action parameter. */
-	if (config->num_logs < 2 && !keep_logs){
+	if (ls->num_logs < 2 && !keep_logs){
 		audit_msg(LOG_NOTICE,
 			"Log rotation disabled (num_logs < 2), skipping");
 		return;
@@ -1117,51 +1578,51 @@ static void rotate_logs(unsigned int num_logs, unsigned int keep_logs)
 	/* Close audit file. fchmod and fchown errors are not fatal because we
 	 * already adjusted log file permissions and ownership when opening the
 	 * log file. */
-	if (log_fd >= 0) {
-		if (fchmod(log_fd, config->log_group ? S_IRUSR|S_IRGRP :
+	if (ls->fd >= 0) {
+		if (fchmod(ls->fd, config->log_group ? S_IRUSR|S_IRGRP :
 			  S_IRUSR) < 0){
 		    audit_msg(LOG_WARNING, "Couldn't change permissions while "
 			"rotating log file (%s)", strerror(errno));
 		}
-		if (fchown(log_fd, 0, config->log_group) < 0) {
+		if (fchown(ls->fd, 0, config->log_group) < 0) {
 		    audit_msg(LOG_WARNING, "Couldn't change ownership while "
 			"rotating log file (%s)", strerror(errno));
 		}
 	}
-	if (log_file) {
-		log_fd = -1;
-		fclose(log_file);
-		log_file = NULL;
+	if (ls->file) {
+		ls->fd = -1;
+		fclose(ls->file);
+		ls->file = NULL;
 	}
 
 	/* Rotate */
-	len = strlen(config->log_file) + 16;
+	len = strlen(ls->log_file) + 16;
 	oldname = (char *)malloc(len);
 	if (oldname == NULL) { /* Not fatal - just messy */
 		audit_msg(LOG_ERR, "No memory rotating logs");
-		logging_suspended = 1;
+		ls->suspended = 1;
 		return;
 	}
 	newname = (char *)malloc(len);
 	if (newname == NULL) { /* Not fatal - just messy */
 		audit_msg(LOG_ERR, "No memory rotating logs");
 		free(oldname);
-		logging_suspended = 1;
+		ls->suspended = 1;
 		return;
 	}
 
 	/* If we are rotating, get number from config */
 	if (num_logs == 0)
-		num_logs = config->num_logs;
+		num_logs = ls->num_logs;
 
 	/* Handle this case first since it will not enter the for loop */
 	if (num_logs == 2)
-		snprintf(oldname, len, "%s.1", config->log_file);
+		snprintf(oldname, len, "%s.1", ls->log_file);
 
-	known_logs = 0;
+	ls->known_logs = 0;
 	for (i=(int)num_logs - 1; i>1; i--) {
-		snprintf(oldname, len, "%s.%d", config->log_file, i-1);
-		snprintf(newname, len, "%s.%d", config->log_file, i);
+		snprintf(oldname, len, "%s.%d", ls->log_file, i-1);
+		snprintf(newname, len, "%s.%d", ls->log_file, i);
 		/* if the old file exists */
 		rc = rename(oldname, newname);
 		if (rc == -1 && errno != ENOENT) {
@@ -1170,51 +1631,42 @@ static void rotate_logs(unsigned int num_logs, unsigned int keep_logs)
 			audit_msg(LOG_ERR,
 				"Error rotating logs from %s to %s (%s)",
 				oldname, newname, strerror(errno));
-			if (saved_errno == ENOSPC && fs_space_left == 1) {
-				fs_space_left = 0;
-				do_disk_full_action();
-			} else
-				do_disk_error_action("rotate", saved_errno);
-		} else if (rc == 0 && known_logs == 0)
-			known_logs = i + 1;
+			log_disk_error(ls, "rotate", saved_errno);
+		} else if (rc == 0 && ls->known_logs == 0)
+			ls->known_logs = i + 1;
 	}
 	free(newname);
 
 	/* At this point, oldname should point to lowest number - use it */
 	newname = oldname;
-	rc = rename(config->log_file, newname);
+	rc = rename(ls->log_file, newname);
 	if (rc == -1 && errno != ENOENT) {
 		// Likely errors: ENOSPC, ENOMEM, EBUSY
 		int saved_errno = errno;
 		audit_msg(LOG_ERR, "Error rotating logs from %s to %s (%s)",
-			config->log_file, newname, strerror(errno));
-		if (saved_errno == ENOSPC && fs_space_left == 1) {
-			fs_space_left = 0;
-			do_disk_full_action();
-		} else
-			do_disk_error_action("rotate2", saved_errno);
+			ls->log_file, newname, strerror(errno));
+		log_disk_error(ls, "rotate2", saved_errno);
 
 		/* At this point, we've failed to rotate the original log.
 		 * So, let's make the old log writable and try again next
 		 * time */
-		chmod(config->log_file,
+		chmod(ls->log_file,
 			config->log_group ? S_IWUSR|S_IRUSR|S_IRGRP :
 			S_IWUSR|S_IRUSR);
 	}
 	free(newname);
 
 	/* open new audit file */
-	if (open_audit_log()) {
+	if (open_audit_log(ls)) {
 		int saved_errno = errno;
 		audit_msg(LOG_CRIT,
 			"Could not reopen a log after rotating.");
-		logging_suspended = 1;
-		do_disk_error_action("reopen", saved_errno);
+		ls->suspended = 1;
+		log_disk_error(ls, "reopen", saved_errno);
 	}
 }
 
-static unsigned int last_log = 1;
-static void shift_logs(void)
+static void shift_logs(struct log_stream *ls)
 {
 	// The way this has to work is to start scanning from .1 up until
 	// no file is found. Then do the rotate algorithm using that number
@@ -1222,7 +1674,7 @@ static void shift_logs(void)
 	unsigned int num_logs, len;
 	char *name;
 
-	len = strlen(config->log_file) + 16;
+	len = strlen(ls->log_file) + 16;
 	name = (char *)malloc(len);
 	if (name == NULL) { /* Not fatal - just messy */
 		audit_msg(LOG_ERR, "No memory shifting logs");
@@ -1230,22 +1682,22 @@ static void shift_logs(void)
 	}
 
 	// Find last log
-	num_logs = last_log;
+	num_logs = ls->last_log;
 	while (num_logs) {
-		snprintf(name, len, "%s.%u", config->log_file,
+		snprintf(name, len, "%s.%u", ls->log_file,
 						num_logs);
 		if (access(name, R_OK) != 0)
 			break;
 		num_logs++;
 	}
-	known_logs = num_logs;
+	ls->known_logs = num_logs;
 
 	/* Our last known file disappeared, start over... */
-	if (num_logs <= last_log && last_log > 1) {
+	if (num_logs <= ls->last_log && ls->last_log > 1) {
 		audit_msg(LOG_WARNING, "Last known log disappeared (%s)", name);
-		num_logs = last_log = 1;
+		num_logs = ls->last_log = 1;
 		while (num_logs) {
-			snprintf(name, len, "%s.%u", config->log_file,
+			snprintf(name, len, "%s.%u", ls->log_file,
 							num_logs);
 			if (access(name, R_OK) != 0)
 				break;
@@ -1253,8 +1705,8 @@ static void shift_logs(void)
 		}
 		audit_msg(LOG_INFO, "Next log to use will be %s", name);
 	}
-	last_log = num_logs;
-	rotate_logs(num_logs+1, 1);
+	ls->last_log = num_logs;
+	rotate_logs(ls, num_logs+1, 1);
 	free(name);
 }
 
@@ -1263,7 +1715,7 @@ static void shift_logs(void)
  * file and ensuring the correct options are applied to the descriptor.
  * It returns 0 on success and 1 on failure.
  */
-static int open_audit_log(void)
+static int open_audit_log(struct log_stream *ls)
 {
 	int flags, lfd;
 
@@ -1279,27 +1731,27 @@ static int open_audit_log(void)
 	// Likely errors for open: Almost anything
 	// Likely errors on rotate: ENFILE, ENOMEM, ENOSPC
 retry:
-	lfd = open(config->log_file, flags);
+	lfd = open(ls->log_file, flags);
 	if (lfd < 0) {
 		if (errno == ENOENT) {
-			lfd = create_log_file(config->log_file);
+			lfd = create_log_file(ls->log_file);
 			if (lfd < 0) {
 				audit_msg(LOG_CRIT,
 					"Couldn't create log file %s (%s)",
-					config->log_file,
+					ls->log_file,
 					strerror(errno));
 				return 1;
 			}
 			close(lfd);
-			lfd = open(config->log_file, flags);
-			log_size = 0;
+			lfd = open(ls->log_file, flags);
+			ls->size = 0;
 		} else if (errno == ENFILE) {
 			// All system descriptors used, try again...
 			goto retry;
 		}
 		if (lfd < 0) {
 			audit_msg(LOG_CRIT, "Couldn't open log file %s (%s)",
-				config->log_file, strerror(errno));
+				ls->log_file, strerror(errno));
 			return 1;
 		}
 	} else {
@@ -1308,7 +1760,7 @@ retry:
 
 		int rc = fstat(lfd, &st);
 		if (rc == 0)
-			 log_size = st.st_size;
+			 ls->size = st.st_size;
 		else {
 			close(lfd);
 			return 1;
@@ -1330,9 +1782,9 @@ retry:
 		return 1;
 	}
 
-	log_fd = lfd;
-	log_file = fdopen(lfd, "a");
-	if (log_file == NULL) {
+	ls->fd = lfd;
+	ls->file = fdopen(lfd, "a");
+	if (ls->file == NULL) {
 		audit_msg(LOG_CRIT, "Error setting up log descriptor (%s)",
 			strerror(errno));
 		close(lfd);
@@ -1340,7 +1792,7 @@ retry:
 	}
 
 	/* Set it to line buffering */
-	setlinebuf(log_file);
+	setlinebuf(ls->file);
 	return 0;
 }
 
@@ -1402,23 +1854,22 @@ static void safe_exec(const char *exe)
 	exit(1);
 }
 
-static void reconfigure(struct auditd_event *e)
+/* The state of a reload while its steps are applied */
+struct reconfig_state {
+	struct daemon_conf nconf;
+	struct reload run;
+	int need_size_check;
+	int need_reopen;
+	int need_space_check;
+};
+
+static struct reconfig_state *reconf = NULL;
+
+static void reconfig_general(void *arg)
 {
-	struct daemon_conf *nconf = e->reply.conf;
+	struct reconfig_state *rs = arg;
+	struct daemon_conf *nconf = &rs->nconf;
 	struct daemon_conf *oconf = config;
-	uid_t uid = nconf->sender_uid;
-	pid_t pid = nconf->sender_pid;
-	const char *ctx = nconf->sender_ctx;
-	struct timeval tv;
-	char txt[MAX_AUDIT_MESSAGE_LENGTH];
-	char date[40];
-	unsigned int seq_num;
-	int need_size_check = 0, need_reopen = 0, need_space_check = 0;
-
-	snprintf(txt, sizeof(txt),
-		"config change requested by pid=%d auid=%u subj=%s",
-		pid, uid, ctx);
-	audit_msg(LOG_NOTICE, "%s", txt);
 
 	/* Do the reconfiguring. These are done in a specific
 	 * order from least invasive to most invasive. We will
@@ -1455,13 +1906,13 @@ static void reconfigure(struct auditd_event *e)
 	if ((oconf->write_logs != nconf->write_logs) &&
 				(oconf->daemonize == D_BACKGROUND)) {
 		oconf->write_logs = nconf->write_logs;
-		need_reopen = 1;
+		rs->need_reopen = 1;
 	}
 
 	// log_group
 	if (oconf->log_group != nconf->log_group) {
 		oconf->log_group = nconf->log_group;
-		need_reopen = 1;
+		rs->need_reopen = 1;
 	}
 
 	// action_mail_acct
@@ -1480,22 +1931,31 @@ static void reconfigure(struct auditd_event *e)
 		oconf->node_name = nconf->node_name;
 	}
 
-	// network listener
-	auditd_tcp_listen_reconfigure(nconf, oconf);
-
 	// distribute network events
 	oconf->distribute_network_events = nconf->distribute_network_events;
+}
 
-	// Dispatcher items
-	oconf->q_depth = nconf->q_depth;
-	oconf->overflow_action = nconf->overflow_action;
-	oconf->max_restarts = nconf->max_restarts;
-	if (oconf->plugin_dir != nconf->plugin_dir ||
-		(oconf->plugin_dir && nconf->plugin_dir &&
-		strcmp(oconf->plugin_dir, nconf->plugin_dir) != 0)) {
-		free(oconf->plugin_dir);
-		oconf->plugin_dir = nconf->plugin_dir;
-	}
+static void reconfig_listener(void *arg)
+{
+	struct reconfig_state *rs = arg;
+
+	// network listener
+	auditd_tcp_listen_reconfigure(&rs->nconf, config);
+}
+
+static void reconfig_ratelimit(void *arg)
+{
+	struct reconfig_state *rs = arg;
+
+	// userspace rate limiting
+	ratelimit_reconfigure(&rs->nconf, config);
+}
+
+static void reconfig_log_size(void *arg)
+{
+	struct reconfig_state *rs = arg;
+	struct daemon_conf *nconf = &rs->nconf;
+	struct daemon_conf *oconf = config;
 
 	/* At this point we will work on the items that are related to
 	 * a single log file. */
@@ -1503,52 +1963,88 @@ static void reconfigure(struct auditd_event *e)
 	// max logfile action
 	if (oconf->max_log_size_action != nconf->max_log_size_action) {
 		oconf->max_log_size_action = nconf->max_log_size_action;
-		need_size_check = 1;
+		rs->need_size_check = 1;
 	}
 
 	// max log size
 	if (oconf->max_log_size != nconf->max_log_size) {
 		oconf->max_log_size = nconf->max_log_size;
-		need_size_check = 1;
+		rs->need_size_check = 1;
 	}
 
-	if (need_size_check) {
-		logging_suspended = 0;
-		check_log_file_size();
+	sync_main_log();
+	if (rs->need_size_check) {
+		main_log.suspended = 0;
+		check_log_file_size(&main_log);
 	}
+}
+
+static void reconfig_log_file(void *arg)
+{
+	struct reconfig_state *rs = arg;
+	struct daemon_conf *nconf = &rs->nconf;
+	struct daemon_conf *oconf = config;
 
 	// flush technique
 	if (oconf->flush != nconf->flush) {
 		oconf->flush = nconf->flush;
-		need_reopen = 1;
+		rs->need_reopen = 1;
 	}
 
 	// logfile
 	if (strcmp(oconf->log_file, nconf->log_file)) {
 		free((void *)oconf->log_file);
 		oconf->log_file = nconf->log_file;
-		need_reopen = 1;
-		need_space_check = 1; // might be on new partition
+		rs->need_reopen = 1;
+		rs->need_space_check = 1; // might be on new partition
 	} else
 		free((void *)nconf->log_file);
-
-	if (need_reopen) {
-		if (log_file)
-			fclose(log_file);
-		log_file = NULL;
-		fix_disk_permissions();
-		if (open_audit_log()) {
+	sync_main_log();
+
+	if (rs->need_reopen) {
+		if (main_log.file)
+			fclose(main_log.file);
+		main_log.file = NULL;
+		fix_disk_permissions(&main_log);
+		if (open_audit_log(&main_log)) {
 			int saved_errno = errno;
 			audit_msg(LOG_ERR,
 				"Could not reopen a log after reconfigure");
-			logging_suspended = 1;
+			main_log.suspended = 1;
 			// Likely errors: ENOMEM, ENOSPC
 			do_disk_error_action("reconfig", saved_errno);
 		} else {
-			logging_suspended = 0;
-			check_log_file_size();
+			main_log.suspended = 0;
+			check_log_file_size(&main_log);
 		}
 	}
+}
+
+static void reconfig_log_streams(void *arg)
+{
+	struct reconfig_state *rs = arg;
+	struct daemon_conf *nconf = &rs->nconf;
+	struct daemon_conf *oconf = config;
+
+	// log streams are only reopened when they or the main log changed
+	if (rs->need_reopen ||
+		    log_streams_differ(oconf->log_streams, nconf->log_streams)) {
+		close_log_streams();
+		free_log_streams(oconf);
+		oconf->log_streams = nconf->log_streams;
+		nconf->log_streams = NULL;
+		open_log_streams();
+	} else
+		free_log_streams(nconf);
+	free(oconf->log_stream_dir);
+	oconf->log_stream_dir = nconf->log_stream_dir;
+}
+
+static void reconfig_space(void *arg)
+{
+	struct reconfig_state *rs = arg;
+	struct daemon_conf *nconf = &rs->nconf;
+	struct daemon_conf *oconf = config;
 
 	/* At this point we will start working on items that are
 	 * related to the amount of space on the partition. */
@@ -1556,19 +2052,19 @@ static void reconfigure(struct auditd_event *e)
 	// space left
 	if (oconf->space_left != nconf->space_left) {
 		oconf->space_left = nconf->space_left;
-		need_space_check = 1;
+		rs->need_space_check = 1;
 	}
 
 	// space left percent
 	if (oconf->space_left_percent != nconf->space_left_percent) {
 		oconf->space_left_percent = nconf->space_left_percent;
-		need_space_check = 1;
+		rs->need_space_check = 1;
 	}
 
 	// space left action
 	if (oconf->space_left_action != nconf->space_left_action) {
 		oconf->space_left_action = nconf->space_left_action;
-		need_space_check = 1;
+		rs->need_space_check = 1;
 	}
 
 	// space left exe
@@ -1576,9 +2072,9 @@ static void reconfigure(struct auditd_event *e)
 		if (nconf->space_left_exe == NULL)
 			; /* do nothing if new one is blank */
 		else if (oconf->space_left_exe == NULL && nconf->space_left_exe)
-			need_space_check = 1;
+			rs->need_space_check = 1;
 		else if (strcmp(oconf->space_left_exe, nconf->space_left_exe))
-			need_space_check = 1;
+			rs->need_space_check = 1;
 		free((char *)oconf->space_left_exe);
 		oconf->space_left_exe = nconf->space_left_exe;
 	}
@@ -1586,20 +2082,20 @@ static void reconfigure(struct auditd_event *e)
 	// admin space left
 	if (oconf->admin_space_left != nconf->admin_space_left) {
 		oconf->admin_space_left = nconf->admin_space_left;
-		need_space_check = 1;
+		rs->need_space_check = 1;
 	}
 
 	// admin space left percent
 	if (oconf->admin_space_left_percent != nconf->admin_space_left_percent){
 		oconf->admin_space_left_percent =
 					nconf->admin_space_left_percent;
-		need_space_check = 1;
+		rs->need_space_check = 1;
 	}
 
 	// admin space action
 	if (oconf->admin_space_left_action != nconf->admin_space_left_action) {
 		oconf->admin_space_left_action = nconf->admin_space_left_action;
-		need_space_check = 1;
+		rs->need_space_check = 1;
 	}
 
 	// admin space left exe
@@ -1608,17 +2104,17 @@ static void reconfigure(struct auditd_event *e)
 			; /* do nothing if new one is blank */
 		else if (oconf->admin_space_left_exe == NULL &&
 					 nconf->admin_space_left_exe)
-			need_space_check = 1;
+			rs->need_space_check = 1;
 		else if (strcmp(oconf->admin_space_left_exe,
 					nconf->admin_space_left_exe))
-			need_space_check = 1;
+			rs->need_space_check = 1;
 		free((char *)oconf->admin_space_left_exe);
 		oconf->admin_space_left_exe = nconf->admin_space_left_exe;
 	}
 	// disk full action
 	if (oconf->disk_full_action != nconf->disk_full_action) {
 		oconf->disk_full_action = nconf->disk_full_action;
-		need_space_check = 1;
+		rs->need_space_check = 1;
 	}
 
 	// disk full exe
@@ -1626,33 +2122,98 @@ static void reconfigure(struct auditd_event *e)
 		if (nconf->disk_full_exe == NULL)
 			; /* do nothing if new one is blank */
 		else if (oconf->disk_full_exe == NULL && nconf->disk_full_exe)
-			need_space_check = 1;
+			rs->need_space_check = 1;
 		else if (strcmp(oconf->disk_full_exe, nconf->disk_full_exe))
-			need_space_check = 1;
+			rs->need_space_check = 1;
 		free((char *)oconf->disk_full_exe);
 		oconf->disk_full_exe = nconf->disk_full_exe;
 	}
 
-	if (need_space_check) {
+	if (rs->need_space_check) {
 		/* note save suspended flag, then do space_left. If suspended
 		 * is still 0, then copy saved suspended back. This avoids
 		 * having to call check_log_file_size to restore it. */
-		int saved_suspend = logging_suspended;
+		int saved_suspend = main_log.suspended;
 
-		setup_percentages(oconf, log_fd);
+		setup_percentages(oconf, main_log.fd);
 		fs_space_warning = 0;
 		fs_admin_space_warning = 0;
 		fs_space_left = 1;
-		logging_suspended = 0;
-		check_excess_logs();
+		main_log.suspended = 0;
+		check_excess_logs(&main_log);
 		check_space_left();
-		if (logging_suspended == 0)
-			logging_suspended = saved_suspend;
+		if (main_log.suspended == 0)
+			main_log.suspended = saved_suspend;
 	}
+}
+
+static void reconfig_dispatcher(void *arg)
+{
+	struct reconfig_state *rs = arg;
+	struct daemon_conf *nconf = &rs->nconf;
+	struct daemon_conf *oconf = config;
 
+	// Dispatcher items
+	oconf->q_depth = nconf->q_depth;
+	oconf->overflow_action = nconf->overflow_action;
+	oconf->max_restarts = nconf->max_restarts;
+	if (oconf->plugin_dir != nconf->plugin_dir ||
+		(oconf->plugin_dir && nconf->plugin_dir &&
+		strcmp(oconf->plugin_dir, nconf->plugin_dir) != 0)) {
+		free(oconf->plugin_dir);
+		oconf->plugin_dir = nconf->plugin_dir;
+	}
+	// A new spill directory is only used once the queue restarts
+	free(oconf->q_spill_dir);
+	oconf->q_spill_dir = nconf->q_spill_dir;
+	oconf->q_spill_max_size = nconf->q_spill_max_size;
+	free(oconf->q_priority_types);
+	oconf->q_priority_types = nconf->q_priority_types;
+	free(oconf->q_priority_keys);
+	oconf->q_priority_keys = nconf->q_priority_keys;
+	free(oconf->q_bulk_types);
+	oconf->q_bulk_types = nconf->q_bulk_types;
+	free(oconf->q_bulk_keys);
+	oconf->q_bulk_keys = nconf->q_bulk_keys;
+
+	// Plugins are restarted later by the dispatcher's own thread
 	reconfigure_dispatcher(oconf);
+}
+
+static const struct reload_step reconfig_steps[] = {
+	{ "general",	reconfig_general },
+	{ "listener",	reconfig_listener },
+	{ "ratelimit",	reconfig_ratelimit },
+	{ "log_size",	reconfig_log_size },
+	{ "log_file",	reconfig_log_file },
+	{ "log_streams", reconfig_log_streams },
+	{ "space",	reconfig_space },
+	{ "dispatcher",	reconfig_dispatcher },
+};
+
+/* Log the step timings and document the results in the audit log */
+static void reconfig_done(struct reload *r)
+{
+	struct reconfig_state *rs = r->arg;
+	struct auditd_event *e;
+	struct timeval tv;
+	unsigned long total;
+	unsigned int seq_num;
+	char date[40];
+
+	reconf = NULL;
+	total = reload_format_timing(r, reconf_timing, sizeof(reconf_timing));
+	audit_msg(LOG_INFO, "Reconfigure applied in %lu.%03lu ms (%s)",
+		total/1000, total%1000, reconf_timing);
+
+	e = calloc(1, sizeof(*e));
+	if (e == NULL) {
+		audit_msg(LOG_ERR, "Cannot allocate reconfigure event");
+		free((char *)rs->nconf.sender_ctx);
+		free(rs);
+		return;
+	}
 
-	// Next document the results
 	srand(time(NULL));
 	seq_num = rand()%10000;
 	if (gettimeofday(&tv, NULL) == 0) {
@@ -1668,8 +2229,51 @@ static void reconfigure(struct auditd_event *e)
 	e->reply.type = AUDIT_DAEMON_CONFIG;
 	e->reply.len = snprintf(e->reply.msg.data, MAX_AUDIT_MESSAGE_LENGTH-2,
 	"%s: op=reconfigure state=changed auid=%u pid=%d subj=%s res=success",
-		date, uid, pid, ctx );
+		date, rs->nconf.sender_uid, rs->nconf.sender_pid,
+		rs->nconf.sender_ctx);
 	e->reply.message = e->reply.msg.data;
-	free((char *)ctx);
+	free((char *)rs->nconf.sender_ctx);
+
+	if (config->write_logs || config->daemonize == D_FOREGROUND) {
+		format_event(e);
+		handle_event(e);
+	}
+	cleanup_event(e);
+	free(rs);
+}
+
+/* Apply whatever is left of a reload right now */
+void finish_reconfigure(void)
+{
+	if (reconf)
+		reload_finish(&reconf->run);
+}
+
+static void reconfigure(struct auditd_event *e)
+{
+	struct reconfig_state *rs;
+
+	// A reload still in progress is completed before the next starts
+	finish_reconfigure();
+
+	rs = calloc(1, sizeof(*rs));
+	if (rs == NULL) {
+		audit_msg(LOG_ERR, "Cannot allocate reconfigure state");
+		free_config(e->reply.conf);
+		return;
+	}
+	memcpy(&rs->nconf, e->reply.conf, sizeof(rs->nconf));
+
+	audit_msg(LOG_NOTICE,
+		"config change requested by pid=%d auid=%u subj=%s",
+		rs->nconf.sender_pid, rs->nconf.sender_uid,
+		rs->nconf.sender_ctx);
+
+	rs->run.steps = reconfig_steps;
+	rs->run.nsteps = sizeof(reconfig_steps)/sizeof(reconfig_steps[0]);
+	rs->run.arg = rs;
+	rs->run.done = reconfig_done;
+	reconf = rs;
+	reload_start(ev_default_loop(EVFLAG_AUTO), &rs->run);
 }
 
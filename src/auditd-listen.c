@@ -48,9 +48,16 @@
 #include <gssapi/gssapi_generic.h>
 #include <krb5.h>
 #endif
+#ifdef USE_TLS
+#include <stddef.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include "auditd-tls.h"
+#endif
 #include "libaudit.h"
 #include "auditd-event.h"
 #include "auditd-config.h"
+#include "auditd-addr.h"
 #include "private.h"
 
 #include "ev.h"
@@ -62,6 +69,7 @@ typedef struct ev_tcp {
 	struct ev_io io;
 	struct sockaddr_storage addr;
 	struct ev_tcp *next, *prev;
+	struct addr_count *acct;
 	unsigned int bufptr;
 	int client_active;
 #ifdef USE_GSSAPI
@@ -69,6 +77,15 @@ typedef struct ev_tcp {
 	gss_ctx_id_t gss_context;
 	char *remote_name;
 	int remote_name_len;
+#endif
+#ifdef USE_TLS
+	/* The handshake is finished by the client handler */
+	SSL *ssl;
+	int handshake_done;
+	int ktls;
+	int read_wants_write;	/* SSL_read is waiting to write */
+	struct ev_io wio;	/* Runs while the socket must drain */
+	struct tls_out out;	/* Acks not sent yet */
 #endif
 	unsigned char buffer [MAX_AUDIT_MESSAGE_LENGTH + 17];
 } ev_tcp;
@@ -89,6 +106,10 @@ static gss_cred_id_t server_creds; // This is used to hold our own private key
 static char *my_service_name, *my_gss_realm;
 #define USE_GSS (transport == T_KRB5)
 #endif
+#ifdef USE_TLS
+static SSL_CTX *tls_ctx;
+#define USE_TLS_TRANSPORT (transport == T_TLS)
+#endif
 
 static char *sockaddr_to_string(const struct sockaddr_storage *addr)
 {
@@ -146,9 +167,23 @@ static void release_client(struct ev_tcp *client)
 #ifdef USE_GSSAPI
 	if (client->remote_name)
 		free (client->remote_name);
+#endif
+#ifdef USE_TLS
+	if (client->ssl) {
+		ev_io_stop(ev_default_loop(EVFLAG_AUTO), &client->wio);
+		if (client->handshake_done)
+			SSL_shutdown(client->ssl);
+		SSL_free(client->ssl);
+		tls_out_free(&client->out);
+	}
 #endif
 	shutdown(client->io.fd, SHUT_RDWR);
 	close(client->io.fd);
+	if (client->acct) {
+		client->acct->count--;
+		addr_drop(client->acct);
+		client->acct = NULL;
+	}
 	if (client_chain == client)
 		client_chain = client->next;
 	if (client->next)
@@ -496,6 +531,181 @@ static int negotiate_credentials(ev_tcp *io)
 }
 #endif /* USE_GSSAPI */
 
+#ifdef USE_TLS
+static void tls_failure(const char *msg, const struct sockaddr_storage *addr)
+{
+	unsigned long err = ERR_get_error();
+	char buf[256];
+
+	if (err)
+		ERR_error_string_n(err, buf, sizeof(buf));
+	audit_msg(LOG_ERR, "TLS %s failed for %s (%s)", msg,
+		  sockaddr_to_addr((struct sockaddr_storage *)addr),
+		  err ? buf : strerror(errno));
+	ERR_clear_error();
+}
+
+/* The key file is held to the same rules as the krb5 key */
+static int check_tls_key_file(const char *key_file)
+{
+	struct stat st;
+
+	if (stat(key_file, &st)) {
+		audit_msg(LOG_ERR, "Cannot stat %s (%s)", key_file,
+			  strerror(errno));
+		return -1;
+	}
+	if ((st.st_mode & 07777) != 0400) {
+		audit_msg(LOG_ERR,
+			 "%s is not mode 0400 (it's %#o) - compromised key?",
+			  key_file, st.st_mode & 07777);
+		return -1;
+	}
+	if (st.st_uid != 0) {
+		audit_msg(LOG_ERR,
+			 "%s is not owned by root (it's %d) - compromised key?",
+			  key_file, st.st_uid);
+		return -1;
+	}
+	return 0;
+}
+
+static int server_tls_init(const struct daemon_conf *config)
+{
+	if (check_tls_key_file(config->tls_key_file))
+		return -1;
+
+	tls_ctx = tls_server_ctx(config->tls_cert_file, config->tls_key_file,
+				 config->tls_ca_file);
+	if (tls_ctx == NULL) {
+		unsigned long e = ERR_get_error();
+		char buf[256];
+
+		ERR_error_string_n(e, buf, sizeof(buf));
+		audit_msg(LOG_ERR, "Unable to set up TLS (%s)", buf);
+		ERR_clear_error();
+		return -1;
+	}
+	return 0;
+}
+
+/* The socket could not take it all, finish when it is writable again */
+static void tls_want_write(ev_tcp *io)
+{
+	if (!ev_is_active(&io->wio))
+		ev_io_start(ev_default_loop(EVFLAG_AUTO), &io->wio);
+}
+
+/* Returns 0 unless the connection failed */
+static int tls_flush(ev_tcp *io)
+{
+	int rc = tls_out_flush(io->ssl, &io->out);
+
+	if (rc == SSL_ERROR_WANT_WRITE)
+		tls_want_write(io);
+	else if (rc < 0) {
+		tls_failure("write", &io->addr);
+		return -1;
+	}
+	// With SSL_ERROR_WANT_READ the client handler tries again
+	return 0;
+}
+
+/* Returns 1 when the handshake is done, 0 if it needs more data, and
+   -1 on errors. */
+static int tls_handshake(ev_tcp *io)
+{
+	char subject[256];
+	X509 *peer;
+	int rc;
+
+	if ((rc = SSL_accept(io->ssl)) != 1) {
+		int err = SSL_get_error(io->ssl, rc);
+
+		if (err == SSL_ERROR_WANT_READ)
+			return 0;
+		if (err == SSL_ERROR_WANT_WRITE) {
+			tls_want_write(io);
+			return 0;
+		}
+		tls_failure("handshake", &io->addr);
+		return -1;
+	}
+	io->handshake_done = 1;
+	io->ktls = BIO_get_ktls_send(SSL_get_wbio(io->ssl)) ? 1 : 0;
+
+	subject[0] = 0;
+	peer = SSL_get1_peer_certificate(io->ssl);
+	if (peer) {
+		X509_NAME_oneline(X509_get_subject_name(peer), subject,
+				  sizeof(subject));
+		X509_free(peer);
+	}
+	audit_msg(LOG_INFO,
+		"TLS connection from %s: %s %s, kernel TLS send %s recv %s",
+		sockaddr_to_addr(&io->addr), SSL_get_version(io->ssl),
+		subject, io->ktls ? "yes" : "no",
+		BIO_get_ktls_recv(SSL_get_rbio(io->ssl)) ? "yes" : "no");
+	return 1;
+}
+
+/* Like read(), except -1 with EAGAIN means no application data yet */
+static int tls_read(ev_tcp *io, void *buf, int len)
+{
+	int r = SSL_read(io->ssl, buf, len);
+
+	if (r > 0)
+		return r;
+	switch (SSL_get_error(io->ssl, r))
+	{
+		case SSL_ERROR_WANT_WRITE:
+			io->read_wants_write = 1;
+			tls_want_write(io);
+			/* Fall through */
+		case SSL_ERROR_WANT_READ:
+			errno = EAGAIN;
+			return -1;
+		case SSL_ERROR_ZERO_RETURN:
+			return 0;
+		default:
+			tls_failure("read", &io->addr);
+			errno = EIO;
+			return -1;
+	}
+}
+
+/* Queues the data and sends what the socket takes without waiting */
+static int tls_write(ev_tcp *io, const void *buf, int len)
+{
+	if (tls_out_add(&io->out, buf, len)) {
+		audit_msg(LOG_WARNING,
+			"client %s is not reading, dropping an ack",
+			sockaddr_to_addr(&io->addr));
+		return -1;
+	}
+	return tls_flush(io);
+}
+
+static void auditd_tcp_client_handler(struct ev_loop *loop,
+			struct ev_io *_io, int revents);
+
+/* The socket drained, carry on with whatever was waiting for it */
+static void tls_write_handler(struct ev_loop *loop, struct ev_io *_io,
+			int revents)
+{
+	ev_tcp *io = (ev_tcp *)((char *)_io - offsetof(ev_tcp, wio));
+
+	ev_io_stop(loop, _io);
+	if (!io->handshake_done || io->read_wants_write) {
+		io->read_wants_write = 0;
+		// This flushes the queue too, and may free the client
+		auditd_tcp_client_handler(loop, &io->io, EV_READ);
+		return;
+	}
+	tls_flush(io);
+}
+#endif /* USE_TLS */
+
 /* This is called from auditd-event after the message has been logged.
    The header is already filled in.  */
 static void client_ack(void *ack_data, const unsigned char *header,
@@ -539,6 +749,29 @@ static void client_ack(void *ack_data, const unsigned char *header,
 
 		return;
 	}
+#endif
+#ifdef USE_TLS
+	if (io->ssl) {
+		unsigned char sbuf[AUDIT_RMW_HEADER_SIZE + 256], *buf = sbuf;
+		size_t mlen = strlen(msg);
+
+		if (!io->handshake_done)
+			return;
+
+		// Queue the header and message together so that a full
+		// queue never splits them
+		if (mlen > sizeof(sbuf) - AUDIT_RMW_HEADER_SIZE) {
+			buf = malloc(AUDIT_RMW_HEADER_SIZE + mlen);
+			if (buf == NULL)
+				return;
+		}
+		memcpy(buf, header, AUDIT_RMW_HEADER_SIZE);
+		memcpy(buf + AUDIT_RMW_HEADER_SIZE, msg, mlen);
+		tls_write(io, buf, AUDIT_RMW_HEADER_SIZE + mlen);
+		if (buf != sbuf)
+			free(buf);
+		return;
+	}
 #endif
 	// Send the header and a text error message if it exists
 	ar_write(io->io.fd, header, AUDIT_RMW_HEADER_SIZE);
@@ -591,7 +824,35 @@ static void auditd_tcp_client_handler(struct ev_loop *loop,
 	   our buffer, we need to read it in multiple parts.  Thus, we
 	   keep reading/parsing/processing until we run out of ready
 	   data.  */
+#ifdef USE_TLS
+	// Acks that could not go out before go first
+	if (io->ssl && io->handshake_done && io->out.len &&
+			tls_flush(io)) {
+		ev_io_stop(loop, _io);
+		close_client(io);
+		return;
+	}
+#endif
 read_more:
+#ifdef USE_TLS
+	if (io->ssl) {
+		if (!io->handshake_done) {
+			r = tls_handshake(io);
+			if (r == 0)
+				return;
+			if (r < 0) {
+				ev_io_stop(loop, _io);
+				close_client(io);
+				return;
+			}
+		}
+		r = tls_read(io, io->buffer + io->bufptr,
+			     MAX_AUDIT_MESSAGE_LENGTH - io->bufptr);
+		// A record may have held only TLS protocol messages
+		if (r < 0 && errno == EAGAIN)
+			return;
+	} else
+#endif
 	r = read (io->io.fd,
 		  io->buffer + io->bufptr,
 		  MAX_AUDIT_MESSAGE_LENGTH - io->bufptr);
@@ -690,7 +951,7 @@ more_messages:
 		io->bufptr += r;
 
 		if (io->bufptr < AUDIT_RMW_HEADER_SIZE)
-			return;
+			goto partial;
 
 		AUDIT_RMW_UNPACK_HEADER (header, hver, mver, type, len, seq);
 
@@ -703,7 +964,7 @@ more_messages:
 
 		/* See if we have enough bytes to extract the whole message.  */
 		if (io->bufptr < i)
-			return;
+			goto partial;
 
 		/* We have an I-byte message in buffer. Send ACK */
 		client_message(io, i, io->buffer);
@@ -721,7 +982,7 @@ more_messages:
 
 		/* Check for a partial message, with no LF yet.  */
 		if (i == io->bufptr)
-			return;
+			goto partial;
 
 		i++;
 
@@ -743,6 +1004,14 @@ more_messages:
 
 	/* Go back and see if there's more data to read.  */
 	goto read_more;
+
+partial:
+#ifdef USE_TLS
+	/* The rest may be decrypted already, the socket won't say so */
+	if (io->ssl && SSL_pending(io->ssl) > 0)
+		goto read_more;
+#endif
+	return;
 }
 
 #ifdef HAVE_LIBWRAP
@@ -760,41 +1029,22 @@ static int auditd_tcpd_check(int sock)
 #endif
 
 /*
- * This function counts the number of concurrent connections and returns
- * a 1 if there are too many and a 0 otherwise. It assumes the incoming
- * connection has not been added to the linked list yet.
+ * This function checks the number of concurrent connections from the
+ * address and returns a 1 if there are too many and a 0 otherwise. It
+ * assumes the incoming connection has not been counted yet.
  */
-static int check_num_connections(const struct sockaddr_storage *aaddr)
+static int check_num_connections(const struct addr_count *ac)
 {
-	int num = 0;
-	struct ev_tcp *client = client_chain;
-
-	while (client) {
-		int rc;
-		struct sockaddr_storage *cl_addr = &client->addr;
-
-		if (aaddr->ss_family == AF_INET)
-			rc = memcmp(&((struct sockaddr_in *)aaddr)->sin_addr,
-				&((struct sockaddr_in *)cl_addr)->sin_addr,
-				sizeof(struct in_addr));
-		else
-			rc = memcmp(&((struct sockaddr_in6 *)aaddr)->sin6_addr,
-				&((struct sockaddr_in6 *)cl_addr)->sin6_addr,
-				sizeof(struct in6_addr));
-		if (rc == 0) {
-			num++;
-			if (num >= max_per_addr)
-				return 1;
-		}
-		client = client->next;
-	}
-	return 0;
+	return ac->count && ac->count >= max_per_addr;
 }
 
 void write_connection_state(FILE *f)
 {
 	unsigned int num = 0, act = 0;
 	struct ev_tcp *client = client_chain;
+#ifdef USE_TLS
+	unsigned int ktls = 0;
+#endif
 
 	fprintf(f, "listening for network connections = %s\n",
 		nlsocks ? "yes" : "no");
@@ -802,11 +1052,19 @@ void write_connection_state(FILE *f)
 		while (client) {
 			if (client->client_active)
 				act++;
+#ifdef USE_TLS
+			if (client->ktls)
+				ktls++;
+#endif
 			num++;
 			client = client->next;
 		}
 		fprintf(f, "active connections = %u\n", act);
 		fprintf(f, "total connections = %u\n", num);
+#ifdef USE_TLS
+		if (USE_TLS_TRANSPORT)
+			fprintf(f, "kernel tls connections = %u\n", ktls);
+#endif
 	}
 }
 
@@ -818,6 +1076,7 @@ static void auditd_tcp_listen_handler( struct ev_loop *loop,
 	socklen_t aaddrlen;
 	struct sockaddr_storage aaddr;
 	struct ev_tcp *client;
+	struct addr_count *ac;
 	char emsg[DEFAULT_BUF_SZ];
 
 	/* Accept the connection and see where it's coming from.  */
@@ -862,7 +1121,19 @@ static void auditd_tcp_listen_handler( struct ev_loop *loop,
 	}
 
 	/* Make sure we don't have too many connections */
-	if (check_num_connections(&aaddr)) {
+	ac = addr_get(&aaddr);
+	if (ac == NULL) {
+		audit_msg(LOG_CRIT, "Unable to allocate TCP address data");
+		snprintf(emsg, sizeof(emsg),
+			"op=alloc addr=%s port=%u res=no",
+			sockaddr_to_string(&aaddr),
+			sockaddr_to_port(&aaddr));
+		send_audit_event(AUDIT_DAEMON_ACCEPT, emsg);
+		shutdown(afd, SHUT_RDWR);
+		close(afd);
+		return;
+	}
+	if (check_num_connections(ac)) {
 		audit_msg(LOG_ERR, "Too many connections from %s - rejected",
 				sockaddr_to_addr(&aaddr));
 		snprintf(emsg, sizeof(emsg),
@@ -892,6 +1163,7 @@ static void auditd_tcp_listen_handler( struct ev_loop *loop,
 		send_audit_event(AUDIT_DAEMON_ACCEPT, emsg);
 		shutdown(afd, SHUT_RDWR);
 		close(afd);
+		addr_drop(ac);
 		return;
 	}
 
@@ -909,9 +1181,25 @@ static void auditd_tcp_listen_handler( struct ev_loop *loop,
 		close(afd);
 		free(client->remote_name);
 		free(client);
+		addr_drop(ac);
 		return;
 	}
 #endif
+#ifdef USE_TLS
+	if (USE_TLS_TRANSPORT) {
+		ev_io_init(&client->wio, tls_write_handler, afd, EV_WRITE);
+		client->ssl = SSL_new(tls_ctx);
+		if (client->ssl == NULL || SSL_set_fd(client->ssl, afd) != 1) {
+			tls_failure("setup", &aaddr);
+			SSL_free(client->ssl);
+			shutdown(afd, SHUT_RDWR);
+			close(afd);
+			free(client);
+			addr_drop(ac);
+			return;
+		}
+	}
+#endif
 
 	fcntl(afd, F_SETFL, O_NONBLOCK | O_NDELAY);
 	ev_io_start(loop, &(client->io));
@@ -921,6 +1209,8 @@ static void auditd_tcp_listen_handler( struct ev_loop *loop,
 	if (client->next)
 		client->next->prev = client;
 	client_chain = client;
+	ac->count++;
+	client->acct = ac;
 
 	/* And finally log that we accepted the connection */
 	snprintf(emsg, sizeof(emsg),
@@ -1124,6 +1414,10 @@ next_try:
 		}
 	}
 #endif
+#ifdef USE_TLS
+	if (USE_TLS_TRANSPORT && server_tls_init(config))
+		return -1;
+#endif
 
 	return 0;
 }
@@ -1162,6 +1456,12 @@ void auditd_tcp_listen_uninit(struct ev_loop *loop, struct daemon_conf *config)
 		ev_io_stop(loop, &client_chain->io);
 		close_client(client_chain);
 	}
+	addr_table_free();
+
+#ifdef USE_TLS
+	SSL_CTX_free(tls_ctx);
+	tls_ctx = NULL;
+#endif
 
 	if (config->tcp_client_max_idle)
 		ev_periodic_stop(loop, &periodic_watcher);
@@ -1210,5 +1510,12 @@ void auditd_tcp_listen_reconfigure(const struct daemon_conf *nconf,
 	// Copying the config for now. Should compare if the same
 	// and recredential if needed.
 	oconf->krb5_principal = nconf->krb5_principal;
+	// The TLS files are only reloaded when the listener restarts
+	free((void *)oconf->tls_cert_file);
+	oconf->tls_cert_file = nconf->tls_cert_file;
+	free((void *)oconf->tls_key_file);
+	oconf->tls_key_file = nconf->tls_key_file;
+	free((void *)oconf->tls_ca_file);
+	oconf->tls_ca_file = nconf->tls_ca_file;
 }
 
@@ -0,0 +1,442 @@
+/* auditd-ratelimit.c --
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "libaudit.h"
+#include "private.h"
+#include "evcache.h"
+#include "auditd-ratelimit.h"
+
+/*
+ * Userspace rate limiting works on whole events. The first record of an
+ * event picks the selector (rule key, record type, or auid) and decides
+ * whether the event is kept. That decision is remembered by event id until
+ * the event's EOE record so that the remaining records follow it. If the
+ * decision cannot be remembered the event is suppressed. Each selector has
+ * a token bucket. Events that find the bucket empty are suppressed unless
+ * they are picked by the 1 in N sampler. Suppressed counts are written
+ * out periodically as DAEMON_ERR records so that nothing vanishes silently.
+ */
+
+#define RL_HASH_SIZE	1024	/* must be a power of 2 */
+#define RL_MAX_ENTRIES	4096
+#define RL_MAX_NAME	256
+
+struct rl_entry {
+	struct rl_entry *next;
+	unsigned int hash;
+	double tokens;		/* Tokens currently in the bucket */
+	double last;		/* Time of last refill */
+	unsigned long excess;	/* Events over the limit, drives sampling */
+	unsigned long suppressed; /* Suppressed since last report */
+	unsigned long sampled;	/* Sampled since last report */
+	char name[];
+};
+
+/* Local Data */
+static struct daemon_conf *config = NULL;
+static struct rl_entry *rl_table[RL_HASH_SIZE];
+static struct rl_entry *rl_overflow = NULL;
+static unsigned int rl_entries = 0;
+static unsigned long long total_suppressed = 0, total_sampled = 0;
+static unsigned long suppress_untracked = 0;
+static evcache_t recent;
+static struct ev_periodic report_watcher;
+static int report_active = 0;
+
+extern int send_audit_event(int type, const char *str);
+
+static const char *selector_names[] = { "none", "key", "type", "auid" };
+
+static inline int ratelimit_enabled(const struct daemon_conf *conf)
+{
+	return conf->rate_limit_by != RL_NONE &&
+		(conf->rate_limit || conf->rate_limit_sample);
+}
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/* FNV-1a string hash */
+static unsigned int rl_hash(const char *s)
+{
+	unsigned int h = 2166136261U;
+
+	while (*s) {
+		h ^= (unsigned char)*s++;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+/*
+ * Copy the value of field name into buf. name must include the leading
+ * space and trailing '=' so that partial matches are not possible.
+ * Returns 0 if the field is not in the record.
+ */
+static int get_field(const char *msg, size_t len, const char *name,
+		     char *buf, size_t blen)
+{
+	const char *ptr, *end = msg + len;
+	size_t i = 0;
+
+	ptr = memmem(msg, len, name, strlen(name));
+	if (ptr == NULL)
+		return 0;
+	ptr += strlen(name);
+	while (ptr < end && *ptr && *ptr != ' ' && *ptr != '\n' &&
+							i < blen - 1)
+		buf[i++] = *ptr++;
+	buf[i] = 0;
+	return i != 0;
+}
+
+/* Returns 0 if the record carries nothing to select on */
+static int get_selector(const struct audit_reply *rep, char *buf,
+			size_t blen)
+{
+	const char *type;
+
+	switch (config->rate_limit_by)
+	{
+		case RL_KEY:
+			if (!get_field(rep->message, rep->len, " key=",
+						buf, blen))
+				return 0;
+			// Events not tagged by a rule are not limited
+			if (strcmp(buf, "(null)") == 0)
+				return 0;
+			return 1;
+		case RL_TYPE:
+			type = audit_msg_type_to_name(rep->type);
+			if (type)
+				snprintf(buf, blen, "%s", type);
+			else
+				snprintf(buf, blen, "UNKNOWN[%d]", rep->type);
+			return 1;
+		case RL_AUID:
+			return get_field(rep->message, rep->len, " auid=",
+					 buf, blen);
+		default:
+			break;
+	}
+	return 0;
+}
+
+static struct rl_entry *new_entry(const char *name, unsigned int hash,
+				  double now)
+{
+	size_t len = strlen(name) + 1;
+	struct rl_entry *ent = malloc(sizeof(*ent) + len);
+
+	if (ent == NULL)
+		return NULL;
+	memcpy(ent->name, name, len);
+	ent->next = NULL;
+	ent->hash = hash;
+	ent->tokens = config->rate_limit_burst ? config->rate_limit_burst :
+						 config->rate_limit;
+	ent->last = now;
+	ent->excess = 0;
+	ent->suppressed = 0;
+	ent->sampled = 0;
+	return ent;
+}
+
+static struct rl_entry *find_entry(const char *name, double now)
+{
+	unsigned int h = rl_hash(name);
+	struct rl_entry *ent, **head = &rl_table[h & (RL_HASH_SIZE - 1)];
+
+	for (ent = *head; ent; ent = ent->next) {
+		if (ent->hash == h && strcmp(ent->name, name) == 0)
+			return ent;
+	}
+
+	// Once the table is full, new selectors share one bucket
+	if (rl_entries >= RL_MAX_ENTRIES) {
+		if (rl_overflow == NULL)
+			rl_overflow = new_entry("", 0, now);
+		return rl_overflow;
+	}
+
+	ent = new_entry(name, h, now);
+	if (ent == NULL)
+		return NULL;
+	ent->next = *head;
+	*head = ent;
+	rl_entries++;
+	return ent;
+}
+
+/* Returns 1 if the event should be suppressed */
+static int decide(const struct audit_reply *rep)
+{
+	char name[RL_MAX_NAME];
+	struct rl_entry *ent;
+	double now;
+
+	if (!get_selector(rep, name, sizeof(name)))
+		return 0;
+
+	now = now_seconds();
+	ent = find_entry(name, now);
+	if (ent == NULL)
+		return 0;
+
+	if (config->rate_limit) {
+		double burst = config->rate_limit_burst ?
+			config->rate_limit_burst : config->rate_limit;
+
+		ent->tokens += (now - ent->last) * config->rate_limit;
+		if (ent->tokens > burst)
+			ent->tokens = burst;
+		ent->last = now;
+		if (ent->tokens >= 1.0) {
+			ent->tokens -= 1.0;
+			return 0;
+		}
+	} else
+		ent->last = now;
+
+	// Over the limit - keep every Nth event if sampling
+	if (config->rate_limit_sample &&
+			(ent->excess++ % config->rate_limit_sample) == 0) {
+		ent->sampled++;
+		total_sampled++;
+		return 0;
+	}
+	ent->suppressed++;
+	total_suppressed++;
+	return 1;
+}
+
+/*
+ * This function returns 1 if the event should not be logged or
+ * dispatched, and 0 otherwise. Daemon events are never limited.
+ */
+int ratelimit_event(const struct auditd_event *e)
+{
+	const struct audit_reply *rep = &e->reply;
+	struct audit_event_id id;
+	uintptr_t drop;
+	int have_id;
+
+	if (config == NULL || !ratelimit_enabled(config))
+		return 0;
+	if (rep->type >= AUDIT_FIRST_DAEMON && rep->type <= AUDIT_LAST_DAEMON)
+		return 0;
+	if (rep->message == NULL || rep->len <= 0)
+		return 0;
+
+	// Follow the decision already made for this event
+	have_id = !audit_event_id_parse(rep->message, rep->len, &id);
+	if (have_id && evcache_find(&recent, &id, &drop)) {
+		if (rep->type == AUDIT_EOE)
+			evcache_remove(&recent, &id);
+		return drop;
+	}
+
+	drop = decide(rep);
+	if (have_id && rep->type != AUDIT_EOE &&
+			!evcache_single_record(rep->type) &&
+			evcache_add(&recent, &id, drop)) {
+		// The rest of the event could not follow, so drop all of it
+		if (!drop) {
+			suppress_untracked++;
+			total_suppressed++;
+		}
+		return 1;
+	}
+	return drop;
+}
+
+static void report_entry(struct rl_entry *ent)
+{
+	char msg[MAX_AUDIT_MESSAGE_LENGTH];
+	const char *by = selector_names[config->rate_limit_by];
+
+	if (ent->suppressed == 0)
+		return;
+
+	if (ent->name[0] == 0)
+		snprintf(msg, sizeof(msg),
+		"op=rate-limit by=%s overflow=yes suppressed=%lu sampled=%lu "
+			"res=failed", by, ent->suppressed, ent->sampled);
+	else
+		snprintf(msg, sizeof(msg),
+			"op=rate-limit by=%s %s=%.*s suppressed=%lu "
+			"sampled=%lu res=failed", by,
+			config->rate_limit_by == RL_TYPE ? "rec_type" : by,
+			RL_MAX_NAME, ent->name, ent->suppressed, ent->sampled);
+	send_audit_event(AUDIT_DAEMON_ERR, msg);
+	ent->suppressed = 0;
+	ent->sampled = 0;
+}
+
+/*
+ * Write an accounting record for every selector that had events
+ * suppressed. Selectors that have been idle for a whole report
+ * interval are dropped to keep the table small.
+ */
+static void ratelimit_report(int prune)
+{
+	double now = now_seconds();
+	unsigned int i;
+
+	for (i = 0; i < RL_HASH_SIZE; i++) {
+		struct rl_entry *ent, **prev = &rl_table[i];
+
+		while ((ent = *prev)) {
+			report_entry(ent);
+			if (prune && now - ent->last > config->rate_limit_report){
+				*prev = ent->next;
+				free(ent);
+				rl_entries--;
+			} else
+				prev = &ent->next;
+		}
+	}
+	if (rl_overflow)
+		report_entry(rl_overflow);
+	if (suppress_untracked) {
+		char msg[MAX_AUDIT_MESSAGE_LENGTH];
+
+		snprintf(msg, sizeof(msg),
+			"op=rate-limit by=%s untracked=yes suppressed=%lu "
+			"res=failed", selector_names[config->rate_limit_by],
+			suppress_untracked);
+		send_audit_event(AUDIT_DAEMON_ERR, msg);
+		suppress_untracked = 0;
+	}
+}
+
+static void ratelimit_flush(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < RL_HASH_SIZE; i++) {
+		struct rl_entry *ent = rl_table[i];
+
+		while (ent) {
+			struct rl_entry *next = ent->next;
+			free(ent);
+			ent = next;
+		}
+		rl_table[i] = NULL;
+	}
+	free(rl_overflow);
+	rl_overflow = NULL;
+	rl_entries = 0;
+	evcache_clear(&recent);
+}
+
+static void report_handler(struct ev_loop *loop, struct ev_periodic *per,
+			int revents)
+{
+	ratelimit_report(1);
+}
+
+static void report_reconfigure(struct ev_loop *loop)
+{
+	if (report_active) {
+		ev_periodic_stop(loop, &report_watcher);
+		report_active = 0;
+	}
+	if (ratelimit_enabled(config)) {
+		ev_periodic_set(&report_watcher, ev_now(loop),
+				config->rate_limit_report, NULL);
+		ev_periodic_start(loop, &report_watcher);
+		report_active = 1;
+	}
+}
+
+void init_ratelimit(struct ev_loop *loop, struct daemon_conf *conf)
+{
+	config = conf;
+	evcache_init(&recent);
+	ev_periodic_init(&report_watcher, report_handler, 0,
+			 conf->rate_limit_report, NULL);
+	report_reconfigure(loop);
+}
+
+void shutdown_ratelimit(struct ev_loop *loop)
+{
+	if (config == NULL)
+		return;
+	if (report_active) {
+		ev_periodic_stop(loop, &report_watcher);
+		report_active = 0;
+	}
+	// Account for anything suppressed since the last report
+	ratelimit_report(0);
+	ratelimit_flush();
+	config = NULL;
+}
+
+void ratelimit_reconfigure(const struct daemon_conf *nconf,
+			   struct daemon_conf *oconf)
+{
+	struct ev_loop *loop = ev_default_loop(EVFLAG_AUTO);
+
+	if (config == NULL)
+		return;
+
+	// Settle accounts under the old settings before changing them
+	if (oconf->rate_limit_by != nconf->rate_limit_by ||
+			!ratelimit_enabled(nconf)) {
+		ratelimit_report(0);
+		ratelimit_flush();
+	}
+	oconf->rate_limit_by = nconf->rate_limit_by;
+	oconf->rate_limit = nconf->rate_limit;
+	oconf->rate_limit_burst = nconf->rate_limit_burst;
+	oconf->rate_limit_sample = nconf->rate_limit_sample;
+	oconf->rate_limit_report = nconf->rate_limit_report;
+	report_reconfigure(loop);
+}
+
+void write_ratelimit_state(FILE *f)
+{
+	if (config == NULL || !ratelimit_enabled(config)) {
+		fprintf(f, "rate limiting = no\n");
+		return;
+	}
+	fprintf(f, "rate limiting by = %s\n",
+		selector_names[config->rate_limit_by]);
+	fprintf(f, "rate limit = %u/s burst %u\n", config->rate_limit,
+		config->rate_limit_burst ? config->rate_limit_burst :
+					   config->rate_limit);
+	fprintf(f, "rate limit sample = %u\n", config->rate_limit_sample);
+	fprintf(f, "rate limit selectors tracked = %u\n", rl_entries);
+	fprintf(f, "rate limit events suppressed = %llu\n", total_suppressed);
+	fprintf(f, "rate limit events sampled = %llu\n", total_sampled);
+}
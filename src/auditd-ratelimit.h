@@ -0,0 +1,37 @@
+/* auditd-ratelimit.h --
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#ifndef AUDITD_RATELIMIT_H
+#define AUDITD_RATELIMIT_H
+
+#include <stdio.h>
+#include "ev.h"
+#include "auditd-event.h"
+
+void init_ratelimit(struct ev_loop *loop, struct daemon_conf *config);
+void shutdown_ratelimit(struct ev_loop *loop);
+void ratelimit_reconfigure(const struct daemon_conf *nconf,
+			   struct daemon_conf *oconf);
+int ratelimit_event(const struct auditd_event *e);
+void write_ratelimit_state(FILE *f);
+
+#endif
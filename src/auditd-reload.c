@@ -0,0 +1,137 @@
+/* auditd-reload.c -- stepwise application of configuration reloads
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "auditd-reload.h"
+
+/*
+ * A reload is applied one step per pass of the event loop. The steps run
+ * from an idle watcher at the highest priority, so netlink is still read
+ * between them, and a step whose settings did not change costs nothing.
+ */
+static void reload_idle_handler(struct ev_loop *loop, struct ev_idle *idle,
+				int revents)
+{
+	reload_step(idle->data);
+}
+
+void reload_start(struct ev_loop *loop, struct reload *r)
+{
+	r->step = 0;
+	r->loop = loop;
+	memset(r->usec, 0, sizeof(r->usec));
+	ev_idle_init(&r->watcher, reload_idle_handler);
+	r->watcher.data = r;
+	ev_set_priority(&r->watcher, EV_MAXPRI);
+	ev_idle_start(loop, &r->watcher);
+}
+
+/* Apply and time the next step. Returns 1 while steps remain. */
+int reload_step(struct reload *r)
+{
+	struct timespec start, end;
+	unsigned int i = r->step;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	r->steps[i].func(r->arg);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (i < RELOAD_MAX_STEPS)
+		r->usec[i] = (end.tv_sec - start.tv_sec) * 1000000L +
+				(end.tv_nsec - start.tv_nsec) / 1000;
+	r->step++;
+	if (r->step < r->nsteps)
+		return 1;
+
+	ev_idle_stop(r->loop, &r->watcher);
+	r->done(r);
+	return 0;
+}
+
+/* Apply whatever is left of a reload right now */
+void reload_finish(struct reload *r)
+{
+	while (reload_step(r))
+		;
+}
+
+/* Writes "name N.NNN ms, ..." for each step. Returns the total usec. */
+unsigned long reload_format_timing(const struct reload *r, char *buf, size_t len)
+{
+	size_t used = 0;
+	unsigned long total = 0;
+	unsigned int i;
+
+	if (len)
+		buf[0] = 0;
+	for (i = 0; i < r->nsteps && i < RELOAD_MAX_STEPS; i++) {
+		total += r->usec[i];
+		used += snprintf(buf + used, used < len ? len - used : 0,
+			"%s%s %lu.%03lu ms", i ? ", " : "",
+			r->steps[i].name, r->usec[i]/1000, r->usec[i]%1000);
+		if (used >= len)
+			used = len;
+	}
+	return total;
+}
+
+static int same_str(const char *s1, const char *s2)
+{
+	if (s1 == s2)
+		return 1;
+	if (s1 == NULL || s2 == NULL)
+		return 0;
+	return strcmp(s1, s2) == 0;
+}
+
+/* Returns 1 if the log streams would have to be reopened */
+int log_streams_differ(const struct log_stream_conf *s1,
+		       const struct log_stream_conf *s2)
+{
+	for (; s1 && s2; s1 = s1->next, s2 = s2->next) {
+		unsigned int i;
+
+		if (!same_str(s1->name, s2->name) ||
+		    !same_str(s1->log_file, s2->log_file) ||
+		    s1->num_logs != s2->num_logs ||
+		    s1->max_log_size != s2->max_log_size ||
+		    s1->max_log_size_action != s2->max_log_size_action ||
+		    s1->space_left != s2->space_left ||
+		    s1->space_left_action != s2->space_left_action ||
+		    s1->num_types != s2->num_types ||
+		    s1->num_keys != s2->num_keys ||
+		    s1->num_auids != s2->num_auids)
+			return 1;
+		if (s1->num_types && memcmp(s1->match_types, s2->match_types,
+					s1->num_types * sizeof(int)))
+			return 1;
+		if (s1->num_auids && memcmp(s1->match_auids, s2->match_auids,
+					s1->num_auids * sizeof(uid_t)))
+			return 1;
+		for (i = 0; i < s1->num_keys; i++)
+			if (!same_str(s1->match_keys[i], s2->match_keys[i]))
+				return 1;
+	}
+	return s1 != s2;
+}
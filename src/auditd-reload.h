@@ -0,0 +1,60 @@
+/* auditd-reload.h -- stepwise application of configuration reloads
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#ifndef AUDITD_RELOAD_H
+#define AUDITD_RELOAD_H
+
+#include <stddef.h>
+#include "auditd-config.h"
+#include "ev.h"
+
+#define RELOAD_MAX_STEPS 16
+
+struct reload_step {
+	const char *name;
+	void (*func)(void *arg);
+};
+
+/*
+ * A reload in progress. The steps run one per pass of the event loop and
+ * done is called once the last one has been applied. done may free the
+ * structure.
+ */
+struct reload {
+	const struct reload_step *steps;
+	unsigned int nsteps;
+	unsigned int step;		/* Next step to apply */
+	unsigned long usec[RELOAD_MAX_STEPS];
+	void *arg;
+	void (*done)(struct reload *r);
+	struct ev_loop *loop;
+	ev_idle watcher;
+};
+
+void reload_start(struct ev_loop *loop, struct reload *r);
+int reload_step(struct reload *r);
+void reload_finish(struct reload *r);
+unsigned long reload_format_timing(const struct reload *r, char *buf, size_t len);
+int log_streams_differ(const struct log_stream_conf *s1,
+		       const struct log_stream_conf *s2);
+
+#endif
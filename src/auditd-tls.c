@@ -0,0 +1,123 @@
+/* auditd-tls.c -- TLS helpers for the remote logging listener
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "auditd-tls.h"
+
+/* Largest piece handed to SSL_write, the size of one TLS record */
+#define TLS_CHUNK	16384
+
+/*
+ * Clients must present a certificate signed by the configured CA. Once
+ * the handshake is done OpenSSL hands the session keys to the kernel if
+ * it can, so the records are then encrypted by plain socket writes.
+ * Returns NULL on errors, which are left in the OpenSSL error queue.
+ */
+SSL_CTX *tls_server_ctx(const char *cert_file, const char *key_file,
+		const char *ca_file)
+{
+	SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+
+	if (ctx == NULL)
+		return NULL;
+	SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+	if (SSL_CTX_use_certificate_chain_file(ctx, cert_file) != 1 ||
+	    SSL_CTX_use_PrivateKey_file(ctx, key_file,
+				SSL_FILETYPE_PEM) != 1 ||
+	    SSL_CTX_check_private_key(ctx) != 1 ||
+	    SSL_CTX_load_verify_locations(ctx, ca_file, NULL) != 1) {
+		SSL_CTX_free(ctx);
+		return NULL;
+	}
+	SSL_CTX_set_verify(ctx,
+		SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, NULL);
+	// Session tickets are useless here and come after the handshake
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+	SSL_CTX_set_num_tickets(ctx, 0);
+	// More acks may be queued, moving the buffer, while a write waits
+	SSL_CTX_set_mode(ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+#ifdef SSL_OP_ENABLE_KTLS
+	SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+	return ctx;
+}
+
+/* Queues data to send. Returns 0 on success and -1 if it does not fit. */
+int tls_out_add(struct tls_out *o, const void *data, size_t len)
+{
+	if (o->len + len > TLS_OUT_MAX) {
+		errno = ENOBUFS;
+		return -1;
+	}
+	if (o->len + len > o->size) {
+		size_t size = o->size ? o->size : 1024;
+		unsigned char *tmp;
+
+		while (size < o->len + len)
+			size *= 2;
+		tmp = realloc(o->buf, size);
+		if (tmp == NULL)
+			return -1;
+		o->buf = tmp;
+		o->size = size;
+	}
+	memcpy(o->buf + o->len, data, len);
+	o->len += len;
+	return 0;
+}
+
+/*
+ * Sends as much queued data as the socket takes. Returns 0 when all of
+ * it is gone, SSL_ERROR_WANT_WRITE or SSL_ERROR_WANT_READ when the
+ * socket has to be ready first, and -1 on errors.
+ */
+int tls_out_flush(SSL *ssl, struct tls_out *o)
+{
+	while (o->len) {
+		int w;
+
+		if (o->inflight == 0)
+			o->inflight = o->len < TLS_CHUNK ? o->len : TLS_CHUNK;
+		w = SSL_write(ssl, o->buf, o->inflight);
+		if (w <= 0) {
+			int err = SSL_get_error(ssl, w);
+
+			if (err == SSL_ERROR_WANT_WRITE ||
+					err == SSL_ERROR_WANT_READ)
+				return err;
+			return -1;
+		}
+		memmove(o->buf, o->buf + w, o->len - w);
+		o->len -= w;
+		o->inflight = 0;
+	}
+	return 0;
+}
+
+void tls_out_free(struct tls_out *o)
+{
+	free(o->buf);
+	memset(o, 0, sizeof(*o));
+}
@@ -0,0 +1,48 @@
+/* auditd-tls.h --
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#ifndef AUDITD_TLS_H
+#define AUDITD_TLS_H
+
+#include <stddef.h>
+#include <openssl/ssl.h>
+
+/* Most that may wait for a client that stopped reading its acks */
+#define TLS_OUT_MAX	(256 * 1024)
+
+/*
+ * Data waiting to go out on a non-blocking TLS connection. The first
+ * inflight bytes were handed to an SSL_write that could not finish and
+ * must be offered again unchanged.
+ */
+struct tls_out {
+	unsigned char *buf;
+	size_t len, size, inflight;
+};
+
+SSL_CTX *tls_server_ctx(const char *cert_file, const char *key_file,
+		const char *ca_file);
+int tls_out_add(struct tls_out *o, const void *data, size_t len);
+int tls_out_flush(SSL *ssl, struct tls_out *o);
+void tls_out_free(struct tls_out *o);
+
+#endif
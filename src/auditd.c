@@ -47,6 +47,7 @@
 #include "auditd-config.h"
 #include "auditd-dispatch.h"
 #include "auditd-listen.h"
+#include "auditd-ratelimit.h"
 #include "libdisp.h"
 #include "private.h"
 
@@ -79,12 +80,17 @@ static ATOMIC_INT hup_info_requested = 0;
 static ATOMIC_INT usr1_info_requested = 0, usr2_info_requested = 0;
 static char subj[SUBJ_LEN];
 static uint32_t session;
+static struct timespec start_time;	// For startup to first event latency
+static double first_event_delay = -1.0;
+static pthread_t resolve_thread;
+static int resolve_started = 0;
 
 /* Local function prototypes */
 int send_audit_event(int type, const char *str);
 static void clean_exit(void);
 static int get_reply(int fd, struct audit_reply *rep, int seq);
 static char *getsubj(char *subj);
+static const char *event_backend_name(unsigned int backend);
 
 enum startup_state {startup_disable=0, startup_enable, startup_nochange,
 	startup_INVALID};
@@ -183,10 +189,11 @@ static void child_handler2( int sig )
 }
 
 /*
- * Used to dump internal state information
+ * Used to dump internal state information. fingerprint is NULL if the
+ * rules could not be listed, and err then says why.
  */
-static void cont_handler(struct ev_loop *loop, struct ev_signal *sig,
-			int revents)
+static void write_state_report(struct ev_loop *loop, const char *fingerprint,
+			int err)
 {
 	char buf[64];
 	mode_t u = umask(0137);	// allow 0640
@@ -200,7 +207,20 @@ static void cont_handler(struct ev_loop *loop, struct ev_signal *sig,
 	strftime(buf, sizeof(buf), "%x %X", localtime(&now));
 	fprintf(f, "current time = %s\n", buf);
 	fprintf(f, "process priority = %d\n", getpriority(PRIO_PROCESS, 0));
+	fprintf(f, "event backend = %s\n",
+		event_backend_name(ev_backend(loop)));
+	if (fingerprint)
+		fprintf(f, "rules fingerprint = %s\n", fingerprint);
+	else
+		fprintf(f, "rules fingerprint = unavailable (%s)\n",
+			strerror(err));
+	if (first_event_delay >= 0.0)
+		fprintf(f, "startup to first event = %.3f sec\n",
+			first_event_delay);
+	else
+		fprintf(f, "startup to first event = none yet\n");
 	write_logging_state(f);
+	write_ratelimit_state(f);
 	libdisp_write_queue_state(f);
 #ifdef USE_LISTENER
 	write_connection_state(f);
@@ -208,6 +228,85 @@ static void cont_handler(struct ev_loop *loop, struct ev_signal *sig,
 	fclose(f);
 }
 
+/*
+ * The state report has the fingerprint of the loaded rules. The kernel
+ * sends the rule list from a thread of its own, so it is read by the event
+ * loop on a socket of its own and the report is written when it is done.
+ */
+#define RULES_LISTING_TIMEOUT 4.0
+static struct {
+	int fd;			// -1 unless a listing is in progress
+	struct ev_io io;
+	struct ev_timer timer;
+	struct audit_fingerprint fp;
+} listing = { .fd = -1 };
+
+static void finish_listing(struct ev_loop *loop, const char *fingerprint,
+			int err)
+{
+	ev_io_stop(loop, &listing.io);
+	ev_timer_stop(loop, &listing.timer);
+	audit_close(listing.fd);
+	listing.fd = -1;
+	write_state_report(loop, fingerprint, err);
+}
+
+static void listing_handler(struct ev_loop *loop, struct ev_io *io,
+			int revents)
+{
+	char buf[AUDIT_FINGERPRINT_LEN];
+	struct audit_reply rep;
+	int rc;
+
+	while ((rc = audit_get_reply(listing.fd, &rep,
+				GET_REPLY_NONBLOCKING, 0)) > 0) {
+		if (rep.type == AUDIT_LIST_RULES)
+			audit_fingerprint_add_rule(&listing.fp, rep.ruledata);
+		else if (rep.type == NLMSG_DONE) {
+			audit_fingerprint_format(&listing.fp, buf,
+						 sizeof(buf));
+			finish_listing(loop, buf, 0);
+			return;
+		} else if (rep.type == NLMSG_ERROR && rep.error->error) {
+			finish_listing(loop, NULL, -rep.error->error);
+			return;
+		}
+	}
+	if (rc < 0 && rc != -EAGAIN)
+		finish_listing(loop, NULL, -rc);
+}
+
+static void listing_timeout(struct ev_loop *loop, struct ev_timer *t,
+			int revents)
+{
+	finish_listing(loop, NULL, ETIMEDOUT);
+}
+
+static void cont_handler(struct ev_loop *loop, struct ev_signal *sig,
+			int revents)
+{
+	// The report is already on its way
+	if (listing.fd >= 0)
+		return;
+
+	listing.fd = audit_open();
+	if (listing.fd < 0 ||
+			audit_request_rules_list_data(listing.fd) <= 0) {
+		int err = errno;
+
+		audit_close(listing.fd);
+		listing.fd = -1;
+		write_state_report(loop, NULL, err);
+		return;
+	}
+	audit_fingerprint_init(&listing.fp);
+	ev_io_init(&listing.io, listing_handler, listing.fd, EV_READ);
+	ev_io_start(loop, &listing.io);
+	ev_timer_init(&listing.timer, listing_timeout,
+		      RULES_LISTING_TIMEOUT, 0.);
+	ev_timer_start(loop, &listing.timer);
+}
+
 static int extract_type(const char *str)
 {
 	char tmp, *ptr2, *ptr = (char *)str;
@@ -267,6 +366,12 @@ void distribute_event(struct auditd_event *e)
 			proto = AUDISP_PROTOCOL_VER2;
 		}
 	} else if (e->reply.type != AUDIT_DAEMON_RECONFIG) {
+		// Drop events over their rate limit before formatting them
+		if (ratelimit_event(e)) {
+			cleanup_event(e);
+			return;
+		}
+
 		// All other local events need formatting
 		format_event(e);
 
@@ -475,6 +580,45 @@ static void tell_parent(int status)
 	} while (rc < 0 && errno == EINTR);
 }
 
+static void note_first_event(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	first_event_delay = (now.tv_sec - start_time.tv_sec) +
+			(now.tv_nsec - start_time.tv_nsec) / 1e9;
+	audit_msg(LOG_INFO, "First event received %.3f seconds after startup",
+		first_event_delay);
+}
+
+/*
+ * Resolving the node name can block on DNS. It runs on its own thread
+ * while the logs, the event loop and the dispatcher are set up.
+ */
+static void *resolve_node_main(void *arg)
+{
+	return (void *)(long)resolve_node(arg);
+}
+
+static void start_resolve_node(void)
+{
+	resolve_started = pthread_create(&resolve_thread, NULL,
+				resolve_node_main, &config) == 0;
+}
+
+/* Returns the result of resolve_node */
+static int wait_for_node_name(void)
+{
+	void *rc;
+
+	if (!resolve_started)
+		return resolve_node(&config);
+	resolve_started = 0;
+	if (pthread_join(resolve_thread, &rc))
+		return -1;
+	return (int)(long)rc;
+}
+
 static void netlink_handler(struct ev_loop *loop, struct ev_io *io,
 			int revents)
 {
@@ -563,6 +707,8 @@ static void netlink_handler(struct ev_loop *loop, struct ev_io *io,
 				}
 				break;
 			default:
+				if (first_event_delay < 0.0)
+					note_first_event();
 				distribute_event(cur_event);
 				cur_event = NULL;
 				break;
@@ -597,6 +743,56 @@ static void close_pipes(void)
 	close(pipefds[1]);
 }
 
+/*
+ * Map the event_backend option to libev flags. The requested backend is
+ * returned and the backends that libev may fall back to, if the kernel
+ * does not support it, are added to flags.
+ */
+static unsigned int event_backend_flags(const struct daemon_conf *c,
+					unsigned int *flags)
+{
+	switch (c->event_backend)
+	{
+		case EB_SELECT:
+			*flags |= EVBACKEND_SELECT;
+			return EVBACKEND_SELECT;
+		case EB_POLL:
+			*flags |= EVBACKEND_POLL | EVBACKEND_SELECT;
+			return EVBACKEND_POLL;
+		case EB_EPOLL:
+			*flags |= EVBACKEND_EPOLL | EVBACKEND_POLL |
+					EVBACKEND_SELECT;
+			return EVBACKEND_EPOLL;
+		case EB_IO_URING:
+			*flags |= EVBACKEND_IOURING | EVBACKEND_EPOLL |
+					EVBACKEND_POLL | EVBACKEND_SELECT;
+			return EVBACKEND_IOURING;
+		default:
+			break;
+	}
+
+	if (c->tcp_listen_port == 0)
+		*flags |= EVBACKEND_SELECT;
+	return 0;
+}
+
+static const char *event_backend_name(unsigned int backend)
+{
+	switch (backend)
+	{
+		case EVBACKEND_SELECT:
+			return "select";
+		case EVBACKEND_POLL:
+			return "poll";
+		case EVBACKEND_EPOLL:
+			return "epoll";
+		case EVBACKEND_IOURING:
+			return "io_uring";
+		default:
+			return "unknown";
+	}
+}
+
 struct ev_loop *loop;
 int main(int argc, char *argv[])
 {
@@ -624,6 +820,8 @@ int main(int argc, char *argv[])
 	struct ev_signal sigchld_watcher;
 	struct ev_signal sigcont_watcher;
 
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+
 	/* Get params && set mode */
 	while ((c = getopt_long(argc, argv, "flns:c:", opts, NULL)) != -1) {
 		switch (c) {
@@ -751,10 +949,14 @@ int main(int argc, char *argv[])
 		openlog("auditd", LOG_PID, LOG_DAEMON);
 	}
 
+	/* Start getting the machine name ready for use */
+	start_resolve_node();
+
 	/* Init netlink */
 	if ((fd = audit_open()) < 0) {
         	audit_msg(LOG_ERR, "Cannot open netlink audit socket");
 		tell_parent(FAILURE);
+		wait_for_node_name();
 		free_config(&config);
 		return 1;
 	}
@@ -765,6 +967,7 @@ int main(int argc, char *argv[])
 		if (pidfile)
 			unlink(pidfile);
 		tell_parent(FAILURE);
+		wait_for_node_name();
 		free_config(&config);
 		return 1;
 	}
@@ -773,10 +976,15 @@ int main(int argc, char *argv[])
 	 * backend which is faster for small numbers of descriptors. This
 	 * will fallback to the epoll backend otherwise. */
 	{
-	int flags = EVFLAG_NOENV;
-	if (config.tcp_listen_port == 0)
-		flags |= EVBACKEND_SELECT;
+	unsigned int flags = EVFLAG_NOENV, want;
+
+	want = event_backend_flags(&config, &flags);
 	loop = ev_default_loop(flags);
+	if (loop && want && ev_backend(loop) != want)
+		audit_msg(LOG_WARNING,
+			"%s event backend is not available, using %s",
+			event_backend_name(want),
+			event_backend_name(ev_backend(loop)));
 	}
 
 	/* Startup dispatcher */
@@ -784,13 +992,14 @@ int main(int argc, char *argv[])
 		if (pidfile)
 			unlink(pidfile);
 		tell_parent(FAILURE);
+		wait_for_node_name();
 		free_config(&config);
 		ev_default_destroy();
 		return 1;
 	}
 
-	/* Get machine name ready for use */
-	if (resolve_node(&config)) {
+	/* The machine name is needed from the start message on */
+	if (wait_for_node_name()) {
 		if (pidfile)
 			unlink(pidfile);
 		shutdown_dispatcher();
@@ -955,6 +1164,8 @@ int main(int argc, char *argv[])
 	ev_io_init (&pipe_watcher, pipe_handler, pipefds[0], EV_READ);
 	ev_io_start (loop, &pipe_watcher);
 
+	init_ratelimit(loop, &config);
+
 	if (auditd_tcp_listen_init(loop, &config)) {
 		char emsg[DEFAULT_BUF_SZ];
 		if (*subj)
@@ -990,6 +1201,7 @@ int main(int argc, char *argv[])
 		ev_loop (loop, 0);
 
 	// Event loop finished, clean up everything
+	finish_reconfigure();
 	auditd_tcp_listen_uninit (loop, &config);
 
 	// Tear down IO watchers Part 1
@@ -998,6 +1210,7 @@ int main(int argc, char *argv[])
 	ev_signal_stop (loop, &sigusr2_watcher);
 	ev_signal_stop (loop, &sigterm_watcher);
 	ev_signal_stop (loop, &sigcont_watcher);
+	shutdown_ratelimit(loop);
 
 	/* Write message to log that we are going down */
 	rc = audit_request_signal_info(fd);
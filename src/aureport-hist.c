@@ -0,0 +1,204 @@
+/*
+* aureport-hist.c - time bucketed event counts
+* Copyright (c) 2026 agent <agent@local>
+* All Rights Reserved.
+*
+* This software may be freely redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free
+* Software Foundation; either version 2, or (at your option) any
+* later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; see the file COPYING. If not, write to the
+* Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1335, USA.
+*
+* Authors:
+*   agent <agent@local>
+*/
+
+
+/*
+ * The histogram is built while the logs are scanned. Buckets are aligned
+ * to local wall clock time and kept in one array indexed by the distance
+ * from the oldest bucket, so the count is a single increment. The bounds
+ * of the last bucket are remembered since neighbouring events almost
+ * always land in the same one.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "aureport-hist.h"
+
+// Refuse to grow past this many buckets, about 8 years of minutes
+#define MAX_BUCKETS	(1U << 22)
+
+struct nv_pair {
+	int        value;
+	const char *name;
+};
+
+static const struct nv_pair intervaltab[] = {
+	{ 60, "minute" },
+	{ 3600, "hour" },
+	{ 86400, "day" }
+};
+#define INTERVAL_NAMES (sizeof(intervaltab)/sizeof(intervaltab[0]))
+
+static time_t interval = 0;
+static const char *interval_name = NULL;
+static unsigned long *counts = NULL;
+static unsigned int num_buckets = 0, max_buckets = 0;
+static time_t base;			// Local time of the first bucket
+static time_t cur_lo, cur_hi;		// UTC bounds of the last bucket used
+static unsigned int cur_idx;
+static int too_wide = 0;
+
+int hist_set_interval(const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < INTERVAL_NAMES; i++) {
+		if (strcmp(intervaltab[i].name, name) == 0) {
+			interval = intervaltab[i].value;
+			interval_name = intervaltab[i].name;
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int hist_enabled(void)
+{
+	return interval != 0;
+}
+
+static int grow_buckets(unsigned int num)
+{
+	unsigned long *tmp;
+	unsigned int size = max_buckets ? max_buckets : 64;
+
+	if (num <= max_buckets)
+		return 0;
+	if (num > MAX_BUCKETS) {
+		if (too_wide == 0)
+			fprintf(stderr,
+		    "Histogram covers too much time, use a longer interval\n");
+		too_wide = 1;
+		return 1;
+	}
+	while (size < num)
+		size *= 2;
+	tmp = realloc(counts, size * sizeof(unsigned long));
+	if (tmp == NULL) {
+		fprintf(stderr, "Out of memory building histogram\n");
+		return 1;
+	}
+	counts = tmp;
+	max_buckets = size;
+	return 0;
+}
+
+void hist_add(time_t sec)
+{
+	struct tm tv;
+	time_t lsec, start;
+	unsigned int idx;
+
+	if (num_buckets && sec >= cur_lo && sec < cur_hi) {
+		counts[cur_idx]++;
+		return;
+	}
+
+	if (localtime_r(&sec, &tv) == NULL)
+		return;
+	lsec = sec + tv.tm_gmtoff;
+	start = lsec - (lsec % interval);
+
+	if (num_buckets == 0) {
+		if (grow_buckets(1))
+			return;
+		base = start;
+		counts[0] = 0;
+		num_buckets = 1;
+	} else if (start < base) {
+		// Older than anything seen so far, shift everything up
+		unsigned int shift = (base - start) / interval;
+
+		if (grow_buckets(num_buckets + shift))
+			return;
+		memmove(counts + shift, counts,
+			num_buckets * sizeof(unsigned long));
+		memset(counts, 0, shift * sizeof(unsigned long));
+		num_buckets += shift;
+		base = start;
+	}
+
+	idx = (start - base) / interval;
+	if (idx >= num_buckets) {
+		if (grow_buckets(idx + 1))
+			return;
+		memset(counts + num_buckets, 0,
+			(idx + 1 - num_buckets) * sizeof(unsigned long));
+		num_buckets = idx + 1;
+	}
+	counts[idx]++;
+
+	cur_idx = idx;
+	cur_lo = sec - (lsec - start);
+	cur_hi = cur_lo + interval;
+}
+
+void hist_output(void)
+{
+	unsigned long max = 0, total = 0;
+	unsigned int i;
+
+	printf("\nHistogram Report (per %s)\n", interval_name);
+	printf("======================================\n");
+	printf("# date time event_count\n");
+	printf("======================================\n");
+
+	for (i = 0; i < num_buckets; i++) {
+		if (counts[i] > max)
+			max = counts[i];
+		total += counts[i];
+	}
+
+	for (i = 0; i < num_buckets; i++) {
+		char date[32];
+		struct tm tv;
+		time_t t = base + (time_t)i * interval;
+		unsigned int bar, j;
+
+		// Bucket times are already local, don't convert them again
+		if (gmtime_r(&t, &tv))
+			strftime(date, sizeof(date),
+				interval == 86400 ? "%x" : "%x %H:%M", &tv);
+		else
+			strcpy(date, "?");
+		printf("%u. %s %lu", i + 1, date, counts[i]);
+		bar = (unsigned int)((counts[i] * 50 + max - 1) / max);
+		if (bar)
+			putchar(' ');
+		for (j = 0; j < bar; j++)
+			putchar('#');
+		putchar('\n');
+	}
+	printf("\nTotal events: %lu\n\n", total);
+}
+
+void hist_clear(void)
+{
+	free(counts);
+	counts = NULL;
+	num_buckets = 0;
+	max_buckets = 0;
+}
@@ -0,0 +1,38 @@
+/*
+* aureport-hist.h - time bucketed event counts
+* Copyright (c) 2026 agent <agent@local>
+* All Rights Reserved.
+*
+* This software may be freely redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free
+* Software Foundation; either version 2, or (at your option) any
+* later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; see the file COPYING. If not, write to the
+* Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1335, USA.
+*
+* Authors:
+*   agent <agent@local>
+*/
+
+
+#ifndef AUREPORT_HIST_HEADER
+#define AUREPORT_HIST_HEADER
+
+#include "config.h"
+#include <time.h>
+
+int hist_set_interval(const char *name);
+int hist_enabled(void);
+void hist_add(time_t sec);
+void hist_output(void);
+void hist_clear(void);
+
+#endif
@@ -34,6 +34,8 @@
 #include <limits.h>
 #include "aureport-options.h"
 #include "ausearch-time.h"
+#include "ausearch-merge.h"
+#include "aureport-hist.h"
 #include "libaudit.h"
 #include "auparse-defs.h"
 
@@ -88,7 +90,7 @@ enum {  R_INFILE, R_TIME_END, R_TIME_START, R_VERSION, R_LOG_TIMES,
 	R_INTERPRET, R_HELP, R_ANOMALY, R_RESPONSE, R_SUMMARY_DET, R_CRYPTO,
 	R_MAC, R_FAILED, R_SUCCESS, R_ADD, R_DEL, R_AUTH, R_NODE, R_IN_LOGS,
 	R_KEYS, R_TTY, R_NO_CONFIG, R_COMM, R_VIRT, R_INTEG, R_ESCAPE,
-	R_DEBUG, R_EOE_TMO };
+	R_DEBUG, R_EOE_TMO, R_HISTOGRAM };
 
 static const struct nv_pair optiontab[] = {
 	{ R_AUTH, "-au" },
@@ -112,6 +114,7 @@ static const struct nv_pair optiontab[] = {
 	{ R_FAILED, "--failed" },
 	{ R_HOSTS, "-h" },
 	{ R_HOSTS, "--host" },
+	{ R_HISTOGRAM, "--histogram" },
 	{ R_HELP, "--help" },
 	{ R_INTERPRET, "-i" },
 	{ R_INTERPRET, "--interpret" },
@@ -186,8 +189,9 @@ static void usage(void)
 	"\t--failed\t\t\tonly failed events in report\n"
 	"\t-h,--host\t\t\tRemote Host name report\n"
 	"\t--help\t\t\t\thelp\n"
+	"\t--histogram minute|hour|day\tcount the report's events per interval\n"
 	"\t-i,--interpret\t\t\tInterpretive mode\n"
-	"\t-if,--input <Input File name>\tuse this file as input\n"
+	"\t-if,--input <Input File name>\tuse this file as input; repeat to\n\t\t\t\t\tmerge several files or log dirs by time\n"
 	"\t--input-logs\t\t\tUse the logs even if stdin is a pipe\n"
 	"\t--integrity\t\t\tIntegrity event report\n"
 	"\t-k,--key\t\t\tKey report\n"
@@ -274,9 +278,17 @@ int check_params(int count, char *vars[])
 					retval = -1;
 					break;
 				}
-				user_file = strdup(optarg);
-				if (user_file == NULL)
-					retval = -1;
+				// More than one input gets merged by time
+				if (user_file) {
+					if ((merge_num_sources() == 0 &&
+					     merge_add_source(user_file)) ||
+					    merge_add_source(optarg))
+						retval = -1;
+				} else {
+					user_file = strdup(optarg);
+					if (user_file == NULL)
+						retval = -1;
+				}
 				c++;
 			}
 			break;
@@ -727,6 +739,23 @@ int check_params(int count, char *vars[])
 		case R_SUMMARY_DET:
 			set_detail(D_SUM);
 			break;
+		case R_HISTOGRAM:
+			if (!optarg) {
+				fprintf(stderr,
+					"Argument is required for %s\n",
+					vars[c]);
+				retval = -1;
+				break;
+			}
+			if (hist_set_interval(optarg)) {
+				fprintf(stderr,
+				    "Unknown histogram interval (%s)\n",
+					optarg);
+				retval = -1;
+				break;
+			}
+			c++;
+			break;
 		case R_FAILED:
 			event_failed = F_FAILED;
 			break;
@@ -803,6 +832,13 @@ int check_params(int count, char *vars[])
 				event_tauid = dummy;
 			}
 		}
+		// A histogram counts events, the summaries count objects
+		if (hist_enabled() && (report_type == RPT_TIME ||
+		    (report_type != RPT_SUMMARY && report_detail == D_SUM))) {
+			fprintf(stderr,
+		"--histogram cannot be used with --summary or the log report\n");
+			retval = -1;
+		}
 	} else
 		usage();
 
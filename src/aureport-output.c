@@ -29,6 +29,8 @@
 #include "aureport-scan.h"
 #include "aureport-options.h"
 #include "ausearch-lookup.h"
+#include "aureport-hist.h"
+#include "ausearch-time.h"
 
 /* Locale functions */
 static void print_title_summary(void);
@@ -486,15 +488,16 @@ void print_per_event_item(llist *l)
 {
 	char buf[128];
 	char name[64];
-	char date[32];
-	struct tm *tv;
+	const char *date;
+
+	// Histograms only count the matching events
+	if (hist_enabled())
+		return;
 
 	// The beginning is common to all reports
-	tv = localtime(&l->e.sec);
-	if (tv)
-		strftime(date, sizeof(date), "%x %T", tv);
-	else
-		strcpy(date, "?");
+	date = ausearch_date_time(l->e.sec);
+	if (date == NULL)
+		date = "?";
 	if (report_type != RPT_AVC) {
 		line_item++;
 		printf("%u. %s ", line_item, date);
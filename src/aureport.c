@@ -40,6 +40,8 @@
 #include "aureport-options.h"
 #include "aureport-scan.h"
 #include "ausearch-lol.h"
+#include "ausearch-merge.h"
+#include "aureport-hist.h"
 #include "ausearch-lookup.h"
 #include "auparse-idata.h"
 #include "ausearch-parse.h"
@@ -58,6 +60,7 @@ static int process_log_fd(const char *filename);
 static int process_stdin(void);
 static int process_file(char *filename);
 static int get_event(llist **);
+static int merge_event(llist *l);
 
 extern char *user_file;
 extern int force_logs;
@@ -114,13 +117,22 @@ int main(int argc, char *argv[])
 	if (arg_eoe_timeout != 0)
 		lol_set_eoe_timeout((time_t)arg_eoe_timeout);
 
-	print_title();
+	if (!hist_enabled())
+		print_title();
 	if (arg_eoe_timeout != 0) {
 		lol_set_eoe_timeout(arg_eoe_timeout);
 	}
 
 	lol_create(&lo);
-	if (user_file) {
+	if (merge_num_sources()) {
+		if (report_type == RPT_TIME) {
+			fprintf(stderr,
+			    "The log time report needs a single input\n");
+			return 1;
+		}
+		rc = merge_process(merge_event);
+		merge_clear();
+	} else if (user_file) {
 		struct stat sb;
 		if (stat(user_file, &sb) == -1) {
 			perror("stat");
@@ -152,8 +164,11 @@ int main(int argc, char *argv[])
 		destroy_counters();
 		aulookup_destroy_uid_list();
 		return 1;
-	} else
+	} else if (hist_enabled())
+		hist_output();
+	else
 		print_wrap_up();
+	hist_clear();
 	destroy_counters();
 	aulookup_destroy_uid_list();
 	lookup_uid_destroy_list();
@@ -161,12 +176,74 @@ int main(int argc, char *argv[])
 	return 0;
 }
 
+/*
+ * Log streams are extra sets of rotated logs written by auditd for the
+ * events it routed away from the main log. They are only read when
+ * reading the logs named by auditd.conf, merged with the main log by time.
+ * The log time report lists their files after the main log's instead.
+ */
+static int use_log_streams(void)
+{
+	return config.log_streams && !(user_file && userfile_is_dir);
+}
+
+static int process_log_streams(void)
+{
+	const struct log_stream_conf *s;
+	int rc;
+
+	rc = merge_add_log_set(config.log_file);
+	for (s = config.log_streams; s && rc == 0; s = s->next)
+		rc = merge_add_log_set(s->log_file);
+	if (rc == 0)
+		rc = merge_process(merge_event);
+	merge_clear();
+	free_config(&config);
+	return rc;
+}
+
+static int time_log_streams(void)
+{
+	const struct log_stream_conf *s;
+
+	for (s = config.log_streams; s; s = s->next) {
+		char *filename;
+		size_t len = strlen(s->log_file) + 16;
+		int num = log_set_oldest(s->log_file);
+
+		filename = malloc(len);
+		if (filename == NULL) {
+			fprintf(stderr, "No memory\n");
+			return 1;
+		}
+		for (; num >= 0; num--) {
+			int ret;
+
+			if (num > 0)
+				snprintf(filename, len, "%s.%d",
+					 s->log_file, num);
+			else
+				snprintf(filename, len, "%s", s->log_file);
+			if ((ret = process_file(filename))) {
+				free(filename);
+				return ret;
+			}
+			files_to_process--;
+		}
+		free(filename);
+	}
+	return 0;
+}
+
 static int process_logs(void)
 {
 	char *filename;
 	size_t len;
 	int num = 0;
 
+	if (use_log_streams() && report_type != RPT_TIME)
+		return process_log_streams();
+
 	if (user_file && userfile_is_dir) {
 		char dirname[MAXPATHLEN+1];
 		clear_config (&config);
@@ -202,6 +279,12 @@ static int process_logs(void)
 	 * We note how many files we need to process
 	 */
 	files_to_process = num;
+	if (use_log_streams()) {
+		const struct log_stream_conf *st;
+
+		for (st = config.log_streams; st; st = st->next)
+			files_to_process += log_set_oldest(st->log_file) + 1;
+	}
 
 	/* Got it, now process logs from last to first */
 	if (num > 0)
@@ -227,6 +310,14 @@ static int process_logs(void)
 			break;
 	} while (1);
 	free(filename);
+	if (use_log_streams()) {
+		int ret = time_log_streams();
+
+		if (ret) {
+			free_config(&config);
+			return ret;
+		}
+	}
 	free_config(&config);
 	return 0;
 }
@@ -239,12 +330,43 @@ static void process_event(llist *entries)
 				(entries->head->type == AUDIT_SYSCALL))
 			_auparse_load_interpretations(entries->head->interp);
 		// This is the per entry action item
-		if (per_event_processing(entries))
+		if (hist_enabled() && report_type == RPT_SUMMARY) {
+			hist_add(entries->e.sec);
+			found = 1;
+		} else if (per_event_processing(entries)) {
+			if (hist_enabled())
+				hist_add(entries->e.sec);
 			found = 1;
+		}
 		_auparse_free_interpretations();
 	}
 }
 
+/* Per event handling when merging several inputs by time */
+static int merge_event(llist *entries)
+{
+	static int first = 1;
+
+	if (entries->cnt == 0 || entries->head == NULL)
+		return 0;
+	/*
+	 * Event assembly saw the sources in the order they were read. The
+	 * first event coming out of the merge is the oldest of them all.
+	 */
+	if (first) {
+		very_first_event.sec = entries->e.sec;
+		very_first_event.milli = entries->e.milli;
+		first = 0;
+	}
+	very_last_event.sec = entries->e.sec;
+	very_last_event.milli = entries->e.milli;
+	if (start_time == 0 || entries->e.sec >= start_time) {
+		if (end_time == 0 || entries->e.sec <= end_time)
+			process_event(entries);
+	}
+	return 0;
+}
+
 static int process_log_fd(const char *filename)
 {
 	llist *entries; // entries in a record
@@ -0,0 +1,573 @@
+/*
+* ausearch-group.c - group-by and count aggregation of search results
+* Copyright (c) 2026 agent <agent@local>
+* All Rights Reserved.
+*
+* This software may be freely redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free
+* Software Foundation; either version 2, or (at your option) any
+* later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; see the file COPYING. If not, write to the
+* Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1335, USA.
+*
+* Authors:
+*   agent <agent@local>
+*/
+
+/*
+ * Instead of printing every matching event, only the requested fields are
+ * pulled out of it and the event is counted in a hash table keyed by their
+ * values. The output is one line per distinct group, so its size depends
+ * on the number of groups rather than the number of events.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "libaudit.h"
+#include "ausearch-group.h"
+#include "ausearch-options.h"
+#include "ausearch-common.h"
+#include "ausearch-time.h"
+#include "auparse-idata.h"
+
+#define GROUP_MAX_FIELDS 8
+#define GROUP_INIT_BUCKETS 1024
+#define GROUP_SEP 0x1F		// separates the values in the group key
+#define GROUP_NONE "(none)"
+
+extern void ausearch_load_interpretations(const lnode *n);
+extern void ausearch_free_interpretations(void);
+
+typedef struct _group {
+	char *key;		// Values joined by GROUP_SEP
+	unsigned int hash;
+	unsigned long count;
+	time_t first_sec, last_sec;
+	unsigned int first_milli, last_milli;
+	struct _group *next;
+} group;
+
+static char *fields[GROUP_MAX_FIELDS];
+static unsigned int num_fields = 0;
+static group_format_t group_format = GRP_TABLE;
+static const lnode *interp_node = NULL;	// Record whose interpretations are loaded
+static group **buckets = NULL;
+static unsigned int num_buckets = 0;
+static unsigned long num_groups = 0;
+
+int group_set_fields(const char *list)
+{
+	char *buf, *ptr, *saved;
+
+	if (num_fields) {
+		fprintf(stderr, "Group fields already given\n");
+		return 1;
+	}
+	buf = strdup(list);
+	if (buf == NULL)
+		return 1;
+	ptr = strtok_r(buf, ",", &saved);
+	while (ptr) {
+		if (num_fields == GROUP_MAX_FIELDS) {
+			fprintf(stderr, "Too many group fields, %d maximum\n",
+				GROUP_MAX_FIELDS);
+			free(buf);
+			return 1;
+		}
+		fields[num_fields] = strdup(ptr);
+		if (fields[num_fields] == NULL) {
+			free(buf);
+			return 1;
+		}
+		num_fields++;
+		ptr = strtok_r(NULL, ",", &saved);
+	}
+	free(buf);
+	if (num_fields == 0) {
+		fprintf(stderr, "No group fields given\n");
+		return 1;
+	}
+	return 0;
+}
+
+int group_set_format(const char *fmt)
+{
+	if (strcmp(fmt, "table") == 0)
+		group_format = GRP_TABLE;
+	else if (strcmp(fmt, "csv") == 0)
+		group_format = GRP_CSV;
+	else if (strcmp(fmt, "json") == 0)
+		group_format = GRP_JSON;
+	else {
+		fprintf(stderr, "Unknown group format (%s)\n", fmt);
+		return 1;
+	}
+	return 0;
+}
+
+int group_enabled(void)
+{
+	return num_fields != 0;
+}
+
+static unsigned int group_hash(const char *s)
+{
+	unsigned int h = 2166136261U;
+
+	while (*s) {
+		h ^= (unsigned char)*s++;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+/*
+ * Copy the value of " name=" from the record into buf. Quotes are dropped.
+ * Returns 1 if the field was found.
+ */
+static int find_field(const char *msg, const char *name, char *buf,
+		      size_t blen)
+{
+	const char *ptr = msg;
+	size_t nlen = strlen(name), i = 0;
+	char end = ' ';
+
+	while ((ptr = strstr(ptr, name))) {
+		if (ptr > msg && (ptr[-1] == ' ' || ptr[-1] == '\'') &&
+				ptr[nlen] == '=')
+			break;
+		ptr += nlen;
+	}
+	if (ptr == NULL)
+		return 0;
+	ptr += nlen + 1;
+	if (*ptr == '"') {
+		end = '"';
+		ptr++;
+	}
+	while (*ptr && *ptr != end && *ptr != '\n' && i < blen - 1) {
+		// A field at the end of msg='...' is closed by the quote
+		if (end == ' ' && *ptr == '\'')
+			break;
+		buf[i++] = *ptr++;
+	}
+	buf[i] = 0;
+	return 1;
+}
+
+/* The machine does not change while a log is read, ask the kernel once */
+static int host_machine(void)
+{
+	static int machine = -2;
+
+	if (machine == -2)
+		machine = audit_detect_machine();
+	return machine;
+}
+
+static char *interpret_value(const lnode *n, const char *name,
+			     const char *val)
+{
+	char tmp[32];
+	idata id;
+	int type;
+
+	memset(&id, 0, sizeof(id));
+	type = auparse_interp_adjust_type(n->type, name, val);
+	if (type == AUPARSE_TYPE_UNCLASSIFIED)
+		return strdup(val);
+
+	// Syscall names depend on the arch of the record
+	id.machine = -1;
+	if (find_field(n->message, "arch", tmp, sizeof(tmp))) {
+		errno = 0;
+		id.machine = audit_elf_to_machine(strtoul(tmp, NULL, 16));
+		if (errno)
+			id.machine = -1;
+	}
+	if (id.machine == -1)
+		id.machine = host_machine();
+	if (find_field(n->message, "syscall", tmp, sizeof(tmp)))
+		id.syscall = strtol(tmp, NULL, 10);
+	id.name = name;
+	id.val = val;
+
+	// Load the record's interpretations once for all of its fields
+	if (interp_node != n) {
+		ausearch_free_interpretations();
+		ausearch_load_interpretations(n);
+		interp_node = n;
+	}
+	return auparse_do_interpretation(type, &id, escape_mode);
+}
+
+/* Fill buf with the value of field for this event */
+static void event_value(const llist *l, const char *field, char *buf,
+			size_t blen)
+{
+	char val[MAX_AUDIT_MESSAGE_LENGTH];
+	const lnode *n;
+
+	if (strcmp(field, "type") == 0) {
+		const char *name = audit_msg_type_to_name(l->e.type);
+
+		if (name)
+			snprintf(buf, blen, "%s", name);
+		else
+			snprintf(buf, blen, "UNKNOWN[%d]", l->e.type);
+		return;
+	}
+	if (strcmp(field, "node") == 0) {
+		snprintf(buf, blen, "%s", l->e.node ? l->e.node : GROUP_NONE);
+		return;
+	}
+
+	for (n = l->head; n; n = n->next) {
+		char *out, *ptr;
+
+		if (!find_field(n->message, field, val, sizeof(val)))
+			continue;
+
+		// The kernel logs unset values as (null) or (none)
+		if (strcmp(val, "(null)") == 0 || strcmp(val, GROUP_NONE) == 0)
+			break;
+
+		// Keys are always decoded, other fields follow -i
+		if (report_format == RPT_INTERP || strcmp(field, "key") == 0)
+			out = interpret_value(n, field, val);
+		else
+			out = strdup(val);
+		if (out == NULL)
+			break;
+		for (ptr = out; *ptr; ptr++) {
+			if (*ptr == AUDIT_KEY_SEPARATOR)
+				*ptr = ',';
+			else if (*ptr == GROUP_SEP)
+				*ptr = ' ';
+		}
+		snprintf(buf, blen, "%s", out);
+		free(out);
+		return;
+	}
+	snprintf(buf, blen, "%s", GROUP_NONE);
+}
+
+static int grow_buckets(void)
+{
+	unsigned int i, size = num_buckets ? num_buckets * 2 :
+						GROUP_INIT_BUCKETS;
+	group **tmp;
+
+	tmp = calloc(size, sizeof(group *));
+	if (tmp == NULL)
+		return 1;
+	for (i = 0; i < num_buckets; i++) {
+		group *g = buckets[i];
+
+		while (g) {
+			group *next = g->next;
+
+			g->next = tmp[g->hash & (size - 1)];
+			tmp[g->hash & (size - 1)] = g;
+			g = next;
+		}
+	}
+	free(buckets);
+	buckets = tmp;
+	num_buckets = size;
+	return 0;
+}
+
+static int time_before(time_t s1, unsigned int m1, time_t s2, unsigned int m2)
+{
+	return s1 < s2 || (s1 == s2 && m1 < m2);
+}
+
+void group_event(const llist *l)
+{
+	char key[MAX_AUDIT_MESSAGE_LENGTH];
+	size_t len = 0;
+	unsigned int i, hash;
+	group *g;
+
+	for (i = 0; i < num_fields && len < sizeof(key) - 1; i++) {
+		if (i)
+			key[len++] = GROUP_SEP;
+		event_value(l, fields[i], key + len, sizeof(key) - len);
+		len += strlen(key + len);
+	}
+	key[len] = 0;
+	if (interp_node) {
+		ausearch_free_interpretations();
+		interp_node = NULL;
+	}
+
+	if (num_groups >= (unsigned long)num_buckets * 2 && grow_buckets()) {
+		fprintf(stderr, "Out of memory grouping events\n");
+		return;
+	}
+
+	hash = group_hash(key);
+	for (g = buckets[hash & (num_buckets - 1)]; g; g = g->next) {
+		if (g->hash == hash && strcmp(g->key, key) == 0)
+			break;
+	}
+	if (g == NULL) {
+		g = calloc(1, sizeof(group));
+		if (g == NULL || (g->key = strdup(key)) == NULL) {
+			free(g);
+			fprintf(stderr, "Out of memory grouping events\n");
+			return;
+		}
+		g->hash = hash;
+		g->first_sec = g->last_sec = l->e.sec;
+		g->first_milli = g->last_milli = l->e.milli;
+		g->next = buckets[hash & (num_buckets - 1)];
+		buckets[hash & (num_buckets - 1)] = g;
+		num_groups++;
+	}
+
+	g->count++;
+	if (time_before(l->e.sec, l->e.milli, g->first_sec, g->first_milli)) {
+		g->first_sec = l->e.sec;
+		g->first_milli = l->e.milli;
+	}
+	if (time_before(g->last_sec, g->last_milli, l->e.sec, l->e.milli)) {
+		g->last_sec = l->e.sec;
+		g->last_milli = l->e.milli;
+	}
+}
+
+// Most frequent groups first, ties in key order
+static int compare_groups(const void *p1, const void *p2)
+{
+	const group *g1 = *(const group * const *)p1;
+	const group *g2 = *(const group * const *)p2;
+
+	if (g1->count != g2->count)
+		return g1->count < g2->count ? 1 : -1;
+	return strcmp(g1->key, g2->key);
+}
+
+/* Split the group key back into its values */
+static void split_key(char *key, const char **vals)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_fields; i++) {
+		char *sep = strchr(key, GROUP_SEP);
+
+		vals[i] = key;
+		if (sep) {
+			*sep = 0;
+			key = sep + 1;
+		} else
+			key = "";
+	}
+}
+
+static void format_time(time_t sec, unsigned int milli, char *buf, size_t len)
+{
+	const char *str;
+
+	if (group_format != GRP_TABLE) {
+		snprintf(buf, len, "%lld.%03u", (long long)sec, milli);
+		return;
+	}
+	str = ausearch_date_time(sec);
+	snprintf(buf, len, "%s.%03u", str ? str : "?", milli);
+}
+
+static void print_csv_value(const char *val)
+{
+	if (strpbrk(val, ",\"\n") == NULL) {
+		fputs(val, stdout);
+		return;
+	}
+	putchar('"');
+	for (; *val; val++) {
+		if (*val == '"')
+			putchar('"');
+		putchar(*val);
+	}
+	putchar('"');
+}
+
+static void print_json_string(const char *val)
+{
+	putchar('"');
+	for (; *val; val++) {
+		unsigned char c = *val;
+
+		if (c == '"' || c == '\\')
+			printf("\\%c", c);
+		else if (c < 0x20)
+			printf("\\u%04x", c);
+		else
+			putchar(c);
+	}
+	putchar('"');
+}
+
+static void print_table(group **list)
+{
+	unsigned long i;
+	unsigned int f, width[GROUP_MAX_FIELDS];
+	const char *vals[GROUP_MAX_FIELDS];
+	char first[48], last[48];
+
+	for (f = 0; f < num_fields; f++)
+		width[f] = strlen(fields[f]);
+	for (i = 0; i < num_groups; i++) {
+		char *key = strdup(list[i]->key);
+
+		if (key == NULL)
+			continue;
+		split_key(key, vals);
+		for (f = 0; f < num_fields; f++)
+			if (strlen(vals[f]) > width[f])
+				width[f] = strlen(vals[f]);
+		free(key);
+	}
+
+	for (f = 0; f < num_fields; f++)
+		printf("%-*s  ", width[f], fields[f]);
+	printf("%10s  %-23s  %s\n", "count", "first", "last");
+	for (i = 0; i < num_groups; i++) {
+		group *g = list[i];
+
+		split_key(g->key, vals);
+		for (f = 0; f < num_fields; f++)
+			printf("%-*s  ", width[f], vals[f]);
+		format_time(g->first_sec, g->first_milli, first, sizeof(first));
+		format_time(g->last_sec, g->last_milli, last, sizeof(last));
+		printf("%10lu  %-23s  %s\n", g->count, first, last);
+	}
+}
+
+static void print_csv(group **list)
+{
+	unsigned long i;
+	unsigned int f;
+	const char *vals[GROUP_MAX_FIELDS];
+	char first[48], last[48];
+
+	for (f = 0; f < num_fields; f++) {
+		print_csv_value(fields[f]);
+		putchar(',');
+	}
+	printf("count,first,last\n");
+	for (i = 0; i < num_groups; i++) {
+		group *g = list[i];
+
+		split_key(g->key, vals);
+		for (f = 0; f < num_fields; f++) {
+			print_csv_value(vals[f]);
+			putchar(',');
+		}
+		format_time(g->first_sec, g->first_milli, first, sizeof(first));
+		format_time(g->last_sec, g->last_milli, last, sizeof(last));
+		printf("%lu,%s,%s\n", g->count, first, last);
+	}
+}
+
+static void print_json(group **list)
+{
+	unsigned long i;
+	unsigned int f;
+	const char *vals[GROUP_MAX_FIELDS];
+	char first[48], last[48];
+
+	printf("[");
+	for (i = 0; i < num_groups; i++) {
+		group *g = list[i];
+
+		split_key(g->key, vals);
+		printf("%s\n  {", i ? "," : "");
+		for (f = 0; f < num_fields; f++) {
+			print_json_string(fields[f]);
+			putchar(':');
+			print_json_string(vals[f]);
+			putchar(',');
+		}
+		format_time(g->first_sec, g->first_milli, first, sizeof(first));
+		format_time(g->last_sec, g->last_milli, last, sizeof(last));
+		printf("\"count\":%lu,\"first\":%s,\"last\":%s}",
+			g->count, first, last);
+	}
+	printf("\n]\n");
+}
+
+void group_output(void)
+{
+	group **list;
+	unsigned long cnt = 0;
+	unsigned int i;
+
+	if (num_groups == 0)
+		return;
+
+	list = malloc(num_groups * sizeof(group *));
+	if (list == NULL) {
+		fprintf(stderr, "Out of memory sorting groups\n");
+		return;
+	}
+	for (i = 0; i < num_buckets; i++) {
+		group *g;
+
+		for (g = buckets[i]; g; g = g->next)
+			list[cnt++] = g;
+	}
+	qsort(list, num_groups, sizeof(group *), compare_groups);
+
+	switch (group_format)
+	{
+		case GRP_CSV:
+			print_csv(list);
+			break;
+		case GRP_JSON:
+			print_json(list);
+			break;
+		case GRP_TABLE:
+		default:
+			print_table(list);
+			break;
+	}
+	free(list);
+}
+
+void group_clear(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_buckets; i++) {
+		group *g = buckets[i];
+
+		while (g) {
+			group *next = g->next;
+
+			free(g->key);
+			free(g);
+			g = next;
+		}
+	}
+	free(buckets);
+	buckets = NULL;
+	num_buckets = 0;
+	num_groups = 0;
+	for (i = 0; i < num_fields; i++)
+		free(fields[i]);
+	num_fields = 0;
+}
@@ -0,0 +1,40 @@
+/*
+* ausearch-group.h - group-by and count aggregation of search results
+* Copyright (c) 2026 agent <agent@local>
+* All Rights Reserved.
+*
+* This software may be freely redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free
+* Software Foundation; either version 2, or (at your option) any
+* later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; see the file COPYING. If not, write to the
+* Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1335, USA.
+*
+* Authors:
+*   agent <agent@local>
+*/
+
+#ifndef AUSEARCH_GROUP_HEADER
+#define AUSEARCH_GROUP_HEADER
+
+#include "config.h"
+#include "ausearch-llist.h"
+
+typedef enum { GRP_TABLE, GRP_CSV, GRP_JSON } group_format_t;
+
+int group_set_fields(const char *list);
+int group_set_format(const char *fmt);
+int group_enabled(void);
+void group_event(const llist *l);
+void group_output(void);
+void group_clear(void);
+
+#endif
@@ -27,26 +27,18 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
-#include <linux/net.h>
 #include "ausearch-lookup.h"
 #include "ausearch-options.h"
 #include "ausearch-nvpair.h"
 #include "auparse-idata.h"
-
-/* This is the name/value pair used by search tables */
-struct nv_pair {
-	int        value;
-	const char *name;
-};
-
+#include "decode.h"
+#include "common.h"
 
 /* The machine based on elf type */
 static int machine = 0;
 static const char *Q = "?";
 static const char *results[3]= { "unset", "denied", "granted" };
 static const char *success[3]= { "unset", "no", "yes" };
-static const char *aulookup_socketcall(long sc);
-static const char *aulookup_ipccall(long ic);
 
 const char *aulookup_result(avc_t result)
 {
@@ -85,18 +77,23 @@ const char *aulookup_syscall(llist *l, char *buf, size_t size)
 		return buf;
 	}
 
-	machine = audit_elf_to_machine(l->s.arch);
-	if (machine < 0)
-		return Q;
-	sys = audit_syscall_to_name(l->s.syscall, machine);
+	sys = audit_elf_syscall_to_name(l->s.arch, l->s.syscall);
+	if (sys == NULL) {
+		machine = audit_elf_to_machine(l->s.arch);
+		if (machine < 0)
+			return Q;
+		sys = audit_syscall_to_name(l->s.syscall, machine);
+	}
 	if (sys) {
 		const char *func = NULL;
 		if (strcmp(sys, "socketcall") == 0) {
 			if (list_find_item(l, AUDIT_SYSCALL))
-				func = aulookup_socketcall((long)l->cur->a0);
+				func = _auparse_socketcall_to_name(
+							l->cur->a0);
 		} else if (strcmp(sys, "ipc") == 0) {
 			if(list_find_item(l, AUDIT_SYSCALL))
-				func = aulookup_ipccall((long)l->cur->a0);
+				func = _auparse_ipccall_to_name(
+							l->cur->a0);
 		}
 		if (func) {
 			snprintf(buf, size, "%s(%s)", sys, func);
@@ -109,87 +106,6 @@ const char *aulookup_syscall(llist *l, char *buf, size_t size)
 	return buf;
 }
 
-// See include/linux/net.h
-static const struct nv_pair socktab[] = {
-	{SYS_SOCKET, "socket"},
-	{SYS_BIND, "bind"},
-	{SYS_CONNECT, "connect"},
-	{SYS_LISTEN, "listen"},
-	{SYS_ACCEPT, "accept"},
-	{SYS_GETSOCKNAME, "getsockname"},
-	{SYS_GETPEERNAME, "getpeername"},
-	{SYS_SOCKETPAIR, "socketpair"},
-	{SYS_SEND, "send"},
-	{SYS_RECV, "recv"},
-	{SYS_SENDTO, "sendto"},
-	{SYS_RECVFROM, "recvfrom"},
-	{SYS_SHUTDOWN, "shutdown"},
-	{SYS_SETSOCKOPT, "setsockopt"},
-	{SYS_GETSOCKOPT, "getsockopt"},
-	{SYS_SENDMSG, "sendmsg"},
-	{SYS_RECVMSG, "recvmsg"},
-	{SYS_ACCEPT4, "accept4"},
-	{19, "recvmmsg"},
-	{20, "sendmmsg"}
-};
-#define SOCK_NAMES (sizeof(socktab)/sizeof(socktab[0]))
-
-static const char *aulookup_socketcall(long sc)
-{
-        unsigned int i;
-
-        for (i = 0; i < SOCK_NAMES; i++)
-                if (socktab[i].value == sc)
-                        return socktab[i].name;
-
-        return NULL;
-}
-
-/* This is from asm/ipc.h. Copying it for now as some platforms
- * have broken headers. */
-#define SEMOP            1
-#define SEMGET           2
-#define SEMCTL           3
-#define SEMTIMEDOP	 4
-#define MSGSND          11
-#define MSGRCV          12
-#define MSGGET          13
-#define MSGCTL          14
-#define SHMAT           21
-#define SHMDT           22
-#define SHMGET          23
-#define SHMCTL          24
-
-/*
- * This table maps ipc calls to their text name
- */
-static const struct nv_pair ipctab[] = {
-        {SEMOP, "semop"},
-        {SEMGET, "semget"},
-        {SEMCTL, "semctl"},
-        {SEMTIMEDOP, "semtimedop"},
-        {MSGSND, "msgsnd"},
-        {MSGRCV, "msgrcv"},
-        {MSGGET, "msgget"},
-        {MSGCTL, "msgctl"},
-        {SHMAT, "shmat"},
-        {SHMDT, "shmdt"},
-        {SHMGET, "shmget"},
-        {SHMCTL, "shmctl"}
-};
-#define IPC_NAMES (sizeof(ipctab)/sizeof(ipctab[0]))
-
-static const char *aulookup_ipccall(long ic)
-{
-        unsigned int i;
-
-        for (i = 0; i < IPC_NAMES; i++)
-                if (ipctab[i].value == ic)
-                        return ipctab[i].name;
-
-        return NULL;
-} 
-
 static nvlist uid_nvl;
 static int uid_list_created=0;
 const char *aulookup_uid(uid_t uid, char *buf, size_t size)
@@ -253,91 +169,45 @@ void aulookup_destroy_uid_list(void)
 
 static int is_hex_string(const char *str)
 {
-	while (*str) {
-		if (!isxdigit(*str))
-			return 0;
-		str++;
-	}
-	return 1;
-}
-/*
- * This function will take a pointer to a 2 byte Ascii character buffer and 
- * return the actual hex value.
- */
-static unsigned char x2c(unsigned char *buf)
-{
-	static const char AsciiArray[17] = "0123456789ABCDEF";
-	char *ptr;
-	unsigned char total=0;
-
-	ptr = strchr(AsciiArray, (char)toupper(buf[0]));
-	if (ptr)
-		total = (unsigned char)(((ptr-AsciiArray) & 0x0F)<<4);
-	ptr = strchr(AsciiArray, (char)toupper(buf[1]));
-	if (ptr)
-		total += (unsigned char)((ptr-AsciiArray) & 0x0F);
-
-	return total;
+	size_t len = strlen(str);
+
+	return audit_hex_span(str, len) == len;
 }
 
 /* returns a freshly malloc'ed and converted buffer */
 char *unescape(const char *buf)
 {
-	int len, i;
-	char *str, *strptr;
-	const char *ptr = buf;
+	size_t len;
+	char *str;
+	const char *ptr;
 
 	/* Find the end of the name */
-	if (*ptr == '(') {
-		ptr = strchr(ptr, ')');
+	if (*buf == '(') {
+		ptr = strchr(buf, ')');
 		if (ptr == NULL)
 			return NULL;
-		else
-			ptr++;
+		len = ptr - buf + 1;
 	} else {
-		while (isxdigit(*ptr))
-			ptr++;
+		len = audit_hex_span(buf, strlen(buf));
+		if (len < 2)
+			return NULL;
 	}
-	if ((ptr - buf) == 0)
-		return NULL;
 
-	str = strndup(buf, ptr - buf);
+	/* The decoded string is half the size, the copy is the same */
+	str = malloc(len + 1);
 	if (str == NULL) {
 		fprintf(stderr, "Out of memory. Check %s file, %d line", __FILE__, __LINE__);
 		return NULL;
 	}
 
-	if (*buf == '(')
-		return str;
-
-	/* We can get away with this since the buffer is 2 times
-	 * bigger than what we are putting there.
-	 */
-	len = strlen(str);
-	if (len < 2) {
-		free(str);
-		return NULL;
-	}
-	strptr = str;
-	for (i=0; i<len; i+=2) {
-		*strptr = x2c((unsigned char *)&str[i]);
-		strptr++;
-	}
-	*strptr = 0;
+	if (*buf == '(') {
+		memcpy(str, buf, len);
+		str[len] = 0;
+	} else
+		str[audit_hex_decode((unsigned char *)str, buf, len)] = 0;
 	return str;
 }
 
-static int need_tty_escape(const unsigned char *s, unsigned int len)
-{
-	unsigned int i = 0;
-	while (i < len) {
-		if (s[i] < 32)
-			return 1;
-		i++;
-	}
-	return 0;
-}
-
 static void tty_escape(const char *s, unsigned int len)
 {
 	unsigned int i = 0;
@@ -424,7 +294,7 @@ static unsigned int need_escaping(const char *s, unsigned int len)
 		case AUPARSE_ESC_RAW:
 			break;
 		case AUPARSE_ESC_TTY:
-			return need_tty_escape(s, len);
+			return audit_ctrl_count((const unsigned char *)s, len);
 		case AUPARSE_ESC_SHELL:
 			return need_shell_escape(s, len);
 		case AUPARSE_ESC_SHELL_QUOTE:
@@ -0,0 +1,373 @@
+/*
+* ausearch-merge.c - time ordered merge of several log sources
+* Copyright (c) 2026 agent <agent@local>
+* All Rights Reserved.
+*
+* This software may be freely redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free
+* Software Foundation; either version 2, or (at your option) any
+* later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; see the file COPYING. If not, write to the
+* Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1335, USA.
+*
+* Authors:
+*   agent <agent@local>
+*/
+
+/*
+ * Aggregation servers usually keep the logs of each machine in its own
+ * directory. Each source given here is read lazily, one file at a time,
+ * with its own event assembly. The oldest ready event of every source is
+ * kept in a binary heap so that the output of all sources comes out in
+ * (sec, milli, serial, node) order in a single pass. The log streams
+ * written by auditd are merged with its main log the same way.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdio_ext.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "libaudit.h"
+#include "ausearch-merge.h"
+#include "ausearch-lol.h"
+
+typedef struct {
+	char *path;		// File or directory given by the user
+	char **files;		// Files of the source, oldest first
+	unsigned int num_files;
+	unsigned int cur;	// Next file to open
+	FILE *f;		// File being read
+	lol lo;			// Events being assembled
+	llist *next;		// Oldest ready event of this source
+} msource;
+
+static msource **sources = NULL;
+static unsigned int num_sources = 0;
+
+static int add_file(msource *s, const char *name)
+{
+	char **tmp;
+
+	tmp = realloc(s->files, (s->num_files + 1) * sizeof(char *));
+	if (tmp == NULL)
+		return 1;
+	s->files = tmp;
+	s->files[s->num_files] = strdup(name);
+	if (s->files[s->num_files] == NULL)
+		return 1;
+	s->num_files++;
+	return 0;
+}
+
+/* Returns the number of the oldest log in the set or -1 if none exist */
+int log_set_oldest(const char *base)
+{
+	char *filename;
+	size_t len = strlen(base) + 16;
+	int num = 0;
+
+	filename = malloc(len);
+	if (filename == NULL)
+		return -1;
+	snprintf(filename, len, "%s", base);
+	while (access(filename, R_OK) == 0) {
+		num++;
+		snprintf(filename, len, "%s.%d", base, num);
+	}
+	free(filename);
+	return num - 1;
+}
+
+/* Collect a rotated log set, oldest first */
+static int add_set_files(msource *s, const char *base)
+{
+	char *name;
+	size_t len = strlen(base) + 16;
+	int num;
+
+	name = malloc(len);
+	if (name == NULL)
+		return 1;
+
+	for (num = log_set_oldest(base); num >= 0; num--) {
+		if (num > 0)
+			snprintf(name, len, "%s.%d", base, num);
+		else
+			snprintf(name, len, "%s", base);
+		if (add_file(s, name)) {
+			free(name);
+			return 1;
+		}
+	}
+	free(name);
+	return 0;
+}
+
+static void free_source(msource *s)
+{
+	while (s->num_files)
+		free(s->files[--s->num_files]);
+	free(s->files);
+	free(s->path);
+	free(s);
+}
+
+static msource *new_source(const char *path)
+{
+	msource *s = calloc(1, sizeof(msource));
+
+	if (s == NULL)
+		return NULL;
+	s->path = strdup(path);
+	if (s->path == NULL) {
+		free(s);
+		return NULL;
+	}
+	return s;
+}
+
+static int append_source(msource *s)
+{
+	msource **tmp;
+
+	tmp = realloc(sources, (num_sources + 1) * sizeof(msource *));
+	if (tmp == NULL)
+		return 1;
+	sources = tmp;
+	lol_create(&s->lo);
+	sources[num_sources++] = s;
+	return 0;
+}
+
+int merge_add_source(const char *path)
+{
+	msource *s;
+	struct stat sb;
+	int rc;
+
+	if (stat(path, &sb)) {
+		fprintf(stderr, "Error stat'ing %s (%s)\n", path,
+			strerror(errno));
+		return 1;
+	}
+
+	s = new_source(path);
+	if (s == NULL) {
+		fprintf(stderr, "Out of memory adding %s\n", path);
+		return 1;
+	}
+	if (S_ISDIR(sb.st_mode)) {
+		// A directory holds a rotated audit.log set
+		size_t len = strlen(path) + 16;
+		char *base = malloc(len);
+
+		rc = 1;
+		if (base) {
+			snprintf(base, len, "%s/audit.log", path);
+			rc = add_set_files(s, base);
+			free(base);
+		}
+	} else
+		rc = add_file(s, path);
+	if (rc == 0 && s->num_files == 0)
+		fprintf(stderr, "NOTE - no logs found in %s\n", path);
+
+	if (rc || append_source(s)) {
+		fprintf(stderr, "Out of memory adding %s\n", path);
+		free_source(s);
+		return 1;
+	}
+	return 0;
+}
+
+/* Adds the rotated logs named base, base.1, ... as one source */
+int merge_add_log_set(const char *base)
+{
+	msource *s = new_source(base);
+
+	if (s == NULL || add_set_files(s, base) || append_source(s)) {
+		fprintf(stderr, "Out of memory adding %s\n", base);
+		if (s)
+			free_source(s);
+		return 1;
+	}
+	return 0;
+}
+
+unsigned int merge_num_sources(void)
+{
+	return num_sources;
+}
+
+/*
+ * Read the source until it has a complete event. Returns 0 when one is
+ * ready in s->next, 1 when the source is exhausted, and -1 on errors.
+ */
+static int source_fill(msource *s, char *buff)
+{
+	s->next = get_ready_event(&s->lo);
+	while (s->next == NULL) {
+		if (s->f == NULL) {
+			if (s->cur == s->num_files) {
+				// No more input, flush what's left
+				terminate_all_events(&s->lo);
+				s->next = get_ready_event(&s->lo);
+				return s->next ? 0 : 1;
+			}
+			s->f = fopen(s->files[s->cur], "rm");
+			if (s->f == NULL) {
+				fprintf(stderr, "Error opening %s (%s)\n",
+					s->files[s->cur], strerror(errno));
+				return -1;
+			}
+			__fsetlocking(s->f, FSETLOCKING_BYCALLER);
+			s->cur++;
+		}
+
+		if (fgets_unlocked(buff, MAX_AUDIT_MESSAGE_LENGTH, s->f)) {
+			if (lol_add_record(&s->lo, buff))
+				s->next = get_ready_event(&s->lo);
+		} else {
+			if (ferror_unlocked(s->f)) {
+				fprintf(stderr, "Error reading %s (%s)\n",
+					s->files[s->cur - 1], strerror(errno));
+				fclose(s->f);
+				s->f = NULL;
+				return -1;
+			}
+			// Events may continue in the next file of the set
+			fclose(s->f);
+			s->f = NULL;
+		}
+	}
+	return 0;
+}
+
+// Returns -1 if e1 < e2, 0 if equal, and 1 if e1 > e2
+static int compare_sources(const msource *s1, const msource *s2)
+{
+	const event *e1 = &s1->next->e, *e2 = &s2->next->e;
+
+	if (e1->sec != e2->sec)
+		return e1->sec > e2->sec ? 1 : -1;
+	if (e1->milli != e2->milli)
+		return e1->milli > e2->milli ? 1 : -1;
+	if (e1->serial != e2->serial)
+		return e1->serial > e2->serial ? 1 : -1;
+	if (e1->node == e2->node)
+		return 0;
+	if (e1->node == NULL)
+		return -1;
+	if (e2->node == NULL)
+		return 1;
+	return strcmp(e1->node, e2->node);
+}
+
+static void heap_down(msource **heap, unsigned int cnt, unsigned int i)
+{
+	while (1) {
+		unsigned int l = 2*i + 1, r = l + 1, min = i;
+		msource *tmp;
+
+		if (l < cnt && compare_sources(heap[l], heap[min]) < 0)
+			min = l;
+		if (r < cnt && compare_sources(heap[r], heap[min]) < 0)
+			min = r;
+		if (min == i)
+			return;
+		tmp = heap[i];
+		heap[i] = heap[min];
+		heap[min] = tmp;
+		i = min;
+	}
+}
+
+int merge_process(merge_cb_t cb)
+{
+	msource **heap;
+	unsigned int i, cnt = 0;
+	char *buff;
+	int rc = 0;
+
+	buff = malloc(MAX_AUDIT_MESSAGE_LENGTH);
+	heap = malloc((num_sources + 1) * sizeof(msource *));
+	if (buff == NULL || heap == NULL) {
+		free(buff);
+		free(heap);
+		fprintf(stderr, "Out of memory merging logs\n");
+		return 1;
+	}
+
+	// Prime the heap with the first event of every source
+	for (i = 0; i < num_sources; i++) {
+		int ret = source_fill(sources[i], buff);
+
+		if (ret < 0) {
+			rc = 1;
+			goto out;
+		}
+		if (ret == 0)
+			heap[cnt++] = sources[i];
+	}
+	for (i = cnt / 2; i > 0; i--)
+		heap_down(heap, cnt, i - 1);
+
+	while (cnt) {
+		msource *s = heap[0];
+		llist *l = s->next;
+		int ret;
+
+		s->next = NULL;
+		ret = cb(l);
+		list_clear(l);
+		free(l);
+		if (ret)
+			break;
+
+		ret = source_fill(s, buff);
+		if (ret < 0) {
+			rc = 1;
+			break;
+		}
+		if (ret == 1)
+			heap[0] = heap[--cnt];
+		heap_down(heap, cnt, 0);
+	}
+out:
+	free(heap);
+	free(buff);
+	return rc;
+}
+
+void merge_clear(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_sources; i++) {
+		msource *s = sources[i];
+
+		if (s->f)
+			fclose(s->f);
+		if (s->next) {
+			list_clear(s->next);
+			free(s->next);
+		}
+		lol_clear(&s->lo);
+		free_source(s);
+	}
+	free(sources);
+	sources = NULL;
+	num_sources = 0;
+}
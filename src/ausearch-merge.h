@@ -0,0 +1,42 @@
+/*
+* ausearch-merge.h - time ordered merge of several log sources
+* Copyright (c) 2026 agent <agent@local>
+* All Rights Reserved.
+*
+* This software may be freely redistributed and/or modified under the
+* terms of the GNU General Public License as published by the Free
+* Software Foundation; either version 2, or (at your option) any
+* later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; see the file COPYING. If not, write to the
+* Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+* Boston, MA 02110-1335, USA.
+*
+* Authors:
+*   agent <agent@local>
+*/
+
+#ifndef AUSEARCH_MERGE_HEADER
+#define AUSEARCH_MERGE_HEADER
+
+#include "config.h"
+#include "ausearch-llist.h"
+
+/* Called for each event in time order. A non-zero return stops the merge.
+ * The list is freed afterwards. merge_process returns 1 on errors. */
+typedef int (*merge_cb_t)(llist *l);
+
+int merge_add_source(const char *path);
+int merge_add_log_set(const char *base);
+unsigned int merge_num_sources(void);
+int merge_process(merge_cb_t cb);
+void merge_clear(void);
+int log_set_oldest(const char *base);
+
+#endif
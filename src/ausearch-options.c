@@ -34,6 +34,8 @@
 #include <limits.h>
 #include "ausearch-options.h"
 #include "ausearch-time.h"
+#include "ausearch-merge.h"
+#include "ausearch-group.h"
 #include "ausearch-int.h"
 #include "libaudit.h"
 #include "auparse-defs.h"
@@ -93,7 +95,8 @@ S_TIME_END, S_TIME_START, S_TERMINAL, S_ALL_UID, S_EFF_UID, S_UID, S_LOGINID,
 S_VERSION, S_EXACT_MATCH, S_EXECUTABLE, S_CONTEXT, S_SUBJECT, S_OBJECT,
 S_PPID, S_KEY, S_RAW, S_NODE, S_IN_LOGS, S_JUST_ONE, S_SESSION, S_EXIT,
 S_LINEBUFFERED, S_UUID, S_VMNAME, S_DEBUG, S_CHECKPOINT, S_ARCH, S_FORMAT,
-S_EXTRA_TIME, S_EXTRA_LABELS, S_EXTRA_KEYS, S_EXTRA_OBJ2, S_ESCAPE, S_EOE_TMO };
+S_EXTRA_TIME, S_EXTRA_LABELS, S_EXTRA_KEYS, S_EXTRA_OBJ2, S_ESCAPE, S_EOE_TMO,
+S_GROUP_BY, S_GROUP_FORMAT };
 
 static const struct nv_pair optiontab[] = {
 	{ S_EVENT, "-a" },
@@ -120,6 +123,8 @@ static const struct nv_pair optiontab[] = {
 	{ S_EFF_GID, "--gid-effective" },
 	{ S_GID, "-gi" },
 	{ S_GID, "--gid" },
+	{ S_GROUP_BY, "--group-by" },
+	{ S_GROUP_FORMAT, "--group-format" },
 	{ S_HELP, "-h" },
 	{ S_HELP, "--help" },
 	{ S_HOSTNAME, "-hn" },
@@ -213,10 +218,12 @@ static void usage(void)
 	"\t-ga,--gid-all <all Group id>\tsearch based on All group ids\n"
 	"\t-ge,--gid-effective <effective Group id>  search based on Effective\n\t\t\t\t\tgroup id\n"
 	"\t-gi,--gid <Group Id>\t\tsearch based on group id\n"
+	"\t--group-by <field,...>\t\tcount matching events by these fields\n"
+	"\t--group-format [table|csv|json] output format of --group-by\n"
 	"\t-h,--help\t\t\thelp\n"
 	"\t-hn,--host <Host Name>\t\tsearch based on remote host name\n"
 	"\t-i,--interpret\t\t\tInterpret results to be human readable\n"
-	"\t-if,--input <Input File name>\tuse this file instead of current logs\n"
+	"\t-if,--input <Input File name>\tuse this file instead of current logs; repeat to\n\t\t\t\t\tmerge several files or log dirs by time\n"
 	"\t--input-logs\t\t\tUse the logs even if stdin is a pipe\n"
 	"\t--just-one\t\t\tEmit just one event\n"
 	"\t-k,--key  <key string>\t\tsearch based on key field\n"
@@ -371,6 +378,30 @@ int check_params(int count, char *vars[])
 				retval = -1;
 			}
 			break;
+		case S_GROUP_BY:
+			if (!optarg) {
+				fprintf(stderr,
+					"Argument is required for %s\n",
+					vars[c]);
+				retval = -1;
+			} else {
+				if (group_set_fields(optarg))
+					retval = -1;
+				c++;
+			}
+			break;
+		case S_GROUP_FORMAT:
+			if (!optarg) {
+				fprintf(stderr,
+					"Argument is required for %s\n",
+					vars[c]);
+				retval = -1;
+			} else {
+				if (group_set_format(optarg))
+					retval = -1;
+				c++;
+			}
+			break;
 		case S_EXTRA_KEYS:
 			extra_keys = 1;
 			if (optarg) {
@@ -600,9 +631,17 @@ int check_params(int count, char *vars[])
 					retval = -1;
 					break;
 				}
-				user_file = strdup(optarg);
-				if (user_file == NULL)
-					retval = -1;
+				// More than one input gets merged by time
+				if (user_file) {
+					if ((merge_num_sources() == 0 &&
+					     merge_add_source(user_file)) ||
+					    merge_add_source(optarg))
+						retval = -1;
+				} else {
+					user_file = strdup(optarg);
+					if (user_file == NULL)
+						retval = -1;
+				}
 				c++;
 			}
 			break;
@@ -39,6 +39,7 @@
 #include "ausearch-lookup.h"
 #include "ausearch-parse.h"
 #include "auparse-idata.h"
+#include "decode.h"
 #include "ausearch-nvpair.h"
 
 #define NAME_OFFSET 28
@@ -1770,8 +1771,8 @@ static int parse_sockaddr(const lnode *n, search_items *s)
 				s->hostname = NULL;
 				return 0;
 			}
-			if (getnameinfo(saddr, len, name, NI_MAXHOST,
-					NULL, 0, NI_NUMERICHOST) ) {
+			if (_auparse_sockaddr_addr(saddr, len, name,
+					sizeof(name), NULL, 0)) {
 				free(s->hostname);
 				s->hostname = NULL;
 			} else {
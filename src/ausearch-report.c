@@ -31,6 +31,8 @@
 #include "ausearch-options.h"
 #include "ausearch-parse.h"
 #include "ausearch-lookup.h"
+#include "ausearch-group.h"
+#include "ausearch-time.h"
 #include "auparse.h"
 #include "auparse-idata.h"
 #include "auditd-config.h"
@@ -78,6 +80,11 @@ void ausearch_free_interpretations(void)
 /* This function branches to the correct output format */
 void output_event(llist *l)
 {
+	if (group_enabled()) {
+		group_event(l);
+		return;
+	}
+
 	switch (report_format) {
 		case RPT_RAW:
 			output_raw(l);
@@ -128,10 +135,12 @@ static void output_raw(llist *l)
 static void output_default(llist *l)
 {
 	const lnode *n;
+	const char *t;
 
 	list_last(l);
 	n = list_get_cur(l);
-	printf("----\ntime->%s", ctime(&l->e.sec));
+	t = ausearch_ctime(l->e.sec);
+	printf("----\ntime->%s", t ? t : "?\n");
 	if (!n) {
 		fprintf(stderr, "Error - no elements in record.");
 		return;
@@ -179,8 +188,7 @@ static void output_interpreted_record(const lnode *n, const event *e)
 	char *ptr, *str = n->message;
 	int found, comma = 0;
 	int num = n->type;
-	struct tm *btm;
-	char tmp[32];
+	const char *ts;
 
 	// Reset these because each record could be different
 	machine = -1;
@@ -226,12 +234,8 @@ no_print:
 	if(str == NULL)
 		return;
 	*str++ = 0;
-	btm = localtime(&e->sec);
-	if (btm)
-		strftime(tmp, sizeof(tmp), "%x %T", btm);
-	else
-		strcpy(tmp, "?");
-	printf("%s", tmp);
+	ts = ausearch_date_time(e->sec);
+	printf("%s", ts ? ts : "?");
 	printf(".%03u:%lu) ", e->milli, e->serial);
 
 	if (n->type == AUDIT_SYSCALL) { 
@@ -347,8 +351,14 @@ static void report_interpret(char *name, char *val, int comma, int rtype)
 	    rtype == AUDIT_URINGOP) {
 		if (rtype == AUDIT_URINGOP)
 			machine = MACH_IO_URING;
-		else if (machine == (unsigned long)-1)
-			machine = audit_detect_machine();
+		else if (machine == (unsigned long)-1) {
+			// Ask the kernel once, not for every record
+			static int host_machine = -2;
+
+			if (host_machine == -2)
+				host_machine = audit_detect_machine();
+			machine = host_machine;
+		}
 		if (*name == 'a' && strcmp(name, "arch") == 0) {
 			unsigned long ival;
 			errno = 0;
@@ -431,11 +441,10 @@ static void csv_event(auparse_state_t *au,
 			extra_keys ? ",KEY" : "");
 	}
 
-	char tmp[20];
 	const char *item, *type, *evkind, *subj_kind, *action, *str, *how;
 	int rc;
 	time_t t = auparse_get_time(au);
-	struct tm *tv = localtime(&t);
+	const struct tm *tv = ausearch_localtime(t);
 
 	// NODE
 	item = auparse_get_node(au);
@@ -456,53 +465,39 @@ static void csv_event(auparse_state_t *au,
 			extra_labels ? NORM_OPT_ALL : NORM_OPT_NO_ATTRS);
 
 	// DATE
-	if (tv) {
-		strftime(tmp, sizeof(tmp), "%x", tv);
-		printf("%s", tmp);
-	}
+	if (tv)
+		printf("%s", ausearch_date(t));
 	putchar(',');
 
 	// TIME
-	if (tv) {
-		strftime(tmp, sizeof(tmp), "%T", tv);
-		printf("%s", tmp);
-	}
+	if (tv)
+		printf("%02d:%02d:%02d", tv->tm_hour, tv->tm_min, tv->tm_sec);
 	putchar(',');
 
 	if (extra_time) {
 		// YEAR
-		if (tv) {
-			strftime(tmp, sizeof(tmp), "%Y", tv);
-			printf("%s", tmp);
-		}
+		if (tv)
+			printf("%d", 1900 + tv->tm_year);
 		putchar(',');
 
 		// MONTH
-		if (tv) {
-			strftime(tmp, sizeof(tmp), "%m", tv);
-			printf("%s", tmp);
-		}
+		if (tv)
+			printf("%02d", tv->tm_mon + 1);
 		putchar(',');
 
 		// DAY
-		if (tv) {
-			strftime(tmp, sizeof(tmp), "%d", tv);
-			printf("%s", tmp);
-		}
+		if (tv)
+			printf("%02d", tv->tm_mday);
 		putchar(',');
 
 		// WEEKDAY
-		if (tv) {
-			strftime(tmp, sizeof(tmp), "%u", tv);
-			printf("%s", tmp);
-		}
+		if (tv)
+			printf("%d", tv->tm_wday ? tv->tm_wday : 7);
 		putchar(',');
 
 		// HOUR
-		if (tv) {
-			strftime(tmp, sizeof(tmp), "%k", tv);
-			printf("%s", tmp);
-		}
+		if (tv)
+			printf("%2d", tv->tm_hour);
 		putchar(',');
 		// MILLISECOND
 		printf("%u", auparse_get_milli(au));
@@ -685,14 +680,15 @@ static void text_event(auparse_state_t *au,
 	if (cb_event_type != AUPARSE_CB_EVENT_READY)
 		return;
 
-	char tmp[20];
+	char tmp[48];
         const char *item, *action, *how;
         int rc, type, id = -2;
         time_t t = auparse_get_time(au);
-        struct tm *tv = localtime(&t);
+        const struct tm *tv = ausearch_localtime(t);
 
 	if (tv)
-		strftime(tmp, sizeof(tmp), "%T %x", tv);
+		snprintf(tmp, sizeof(tmp), "%02d:%02d:%02d %s", tv->tm_hour,
+			 tv->tm_min, tv->tm_sec, ausearch_date(t));
 	else
 		strcpy(tmp, "?");
 	type = auparse_get_type(au);
@@ -446,3 +446,146 @@ set_it:
 	return rc;
 }
 
+
+/*
+ * Cached time formatting for printing events. Most events of a log share
+ * their day with the previous one, so localtime and the locale's date
+ * format are done once per day and the time of day is computed from the
+ * offset into it. A day is only cached as a whole when it has 86400
+ * seconds with one UTC offset. Daylight saving and leap second days are
+ * cached per minute instead.
+ */
+static struct {
+	time_t start, end;	// The cached range is [start, end)
+	struct tm base;		// Broken down time at start
+	struct tm tm;		// Broken down time of the last lookup
+	char date[32];		// %x of the cached day
+	char str[64];
+} tcache;
+
+static int same_day_at(const struct tm *day, time_t t, int hour, int min,
+			int sec)
+{
+	struct tm tm;
+
+	if (localtime_r(&t, &tm) == NULL)
+		return 0;
+	return tm.tm_yday == day->tm_yday && tm.tm_hour == hour &&
+		tm.tm_min == min && tm.tm_sec == sec;
+}
+
+static int midnight_at(time_t t)
+{
+	struct tm tm;
+
+	if (localtime_r(&t, &tm) == NULL)
+		return 0;
+	return tm.tm_hour == 0 && tm.tm_min == 0 && tm.tm_sec == 0;
+}
+
+static int tcache_fill(time_t t)
+{
+	struct tm tm;
+	time_t start;
+
+	if (localtime_r(&t, &tm) == NULL)
+		return 1;
+
+	start = t - (tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec);
+	if (tm.tm_sec == 60) {
+		// A leap second is a range of its own
+		start = t;
+		tcache.end = t + 1;
+	} else if (same_day_at(&tm, start, 0, 0, 0) &&
+			same_day_at(&tm, start + SECONDS_IN_DAY - 1, 23, 59, 59) &&
+			midnight_at(start + SECONDS_IN_DAY)) {
+		tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+		tcache.end = start + SECONDS_IN_DAY;
+	} else {
+		start = t - tm.tm_sec;
+		tm.tm_sec = 0;
+		tcache.end = start + 60;
+	}
+	tcache.start = start;
+	tcache.base = tm;
+	if (strftime(tcache.date, sizeof(tcache.date), "%x", &tm) == 0)
+		tcache.date[0] = 0;
+	return 0;
+}
+
+/* Like localtime, the result is overwritten by the next call */
+const struct tm *ausearch_localtime(time_t t)
+{
+	time_t secs;
+
+	if (t < tcache.start || t >= tcache.end) {
+		if (tcache_fill(t)) {
+			tcache.start = tcache.end = 0;
+			return NULL;
+		}
+	}
+	if (t == tcache.start) {
+		tcache.tm = tcache.base;
+		return &tcache.tm;
+	}
+
+	secs = tcache.base.tm_hour * 3600 + tcache.base.tm_min * 60 +
+		tcache.base.tm_sec + (t - tcache.start);
+	tcache.tm = tcache.base;
+	tcache.tm.tm_hour = secs / 3600;
+	tcache.tm.tm_min = (secs / 60) % 60;
+	tcache.tm.tm_sec = secs % 60;
+	return &tcache.tm;
+}
+
+// Returns the %x date or NULL if the time cannot be converted
+const char *ausearch_date(time_t t)
+{
+	if (ausearch_localtime(t) == NULL)
+		return NULL;
+	return tcache.date;
+}
+
+// Returns the %T time of day or NULL if the time cannot be converted
+const char *ausearch_time_of_day(time_t t)
+{
+	const struct tm *tm = ausearch_localtime(t);
+
+	if (tm == NULL)
+		return NULL;
+	snprintf(tcache.str, sizeof(tcache.str), "%02d:%02d:%02d",
+		 tm->tm_hour, tm->tm_min, tm->tm_sec);
+	return tcache.str;
+}
+
+// Returns "%x %T" or NULL if the time cannot be converted
+const char *ausearch_date_time(time_t t)
+{
+	const struct tm *tm = ausearch_localtime(t);
+
+	if (tm == NULL)
+		return NULL;
+	snprintf(tcache.str, sizeof(tcache.str), "%s %02d:%02d:%02d",
+		 tcache.date, tm->tm_hour, tm->tm_min, tm->tm_sec);
+	return tcache.str;
+}
+
+// Same output as ctime(3), including the trailing newline
+const char *ausearch_ctime(time_t t)
+{
+	static const char wday[7][4] = {
+		"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+	static const char mon[12][4] = {
+		"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+		"Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+	const struct tm *tm = ausearch_localtime(t);
+
+	if (tm == NULL || tm->tm_wday < 0 || tm->tm_wday > 6 ||
+			tm->tm_mon < 0 || tm->tm_mon > 11)
+		return NULL;
+	snprintf(tcache.str, sizeof(tcache.str),
+		 "%.3s %.3s%3d %.2d:%.2d:%.2d %d\n", wday[tm->tm_wday],
+		 mon[tm->tm_mon], tm->tm_mday, tm->tm_hour, tm->tm_min,
+		 tm->tm_sec, 1900 + tm->tm_year);
+	return tcache.str;
+}
@@ -32,5 +32,13 @@ int lookup_time(const char *name);
 int ausearch_time_start(const char *da, const char *ti);
 int ausearch_time_end(const char *da, const char *ti);
 
+/* Cached conversions for event output, results are overwritten by the
+ * next call */
+const struct tm *ausearch_localtime(time_t t);
+const char *ausearch_date(time_t t);
+const char *ausearch_time_of_day(time_t t);
+const char *ausearch_date_time(time_t t);
+const char *ausearch_ctime(time_t t);
+
 #endif
 
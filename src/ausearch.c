@@ -41,6 +41,8 @@
 #include "auditd-config.h"
 #include "ausearch-options.h"
 #include "ausearch-lol.h"
+#include "ausearch-merge.h"
+#include "ausearch-group.h"
 #include "ausearch-lookup.h"
 #include "auparse.h"
 #include "ausearch-checkpt.h"
@@ -59,6 +61,7 @@ static int process_log_fd(void);
 static int process_stdin(void);
 static int process_file(char *filename);
 static int get_next_event(llist **);
+static int merge_event(llist *l);
 
 extern const char *checkpt_filename;	/* checkpoint file name */
 extern int checkpt_timeonly;	/* use timestamp from within checkpoint file */
@@ -133,6 +136,20 @@ int main(int argc, char *argv[])
 	if (arg_eoe_timeout != 0)
 		lol_set_eoe_timeout((time_t)arg_eoe_timeout);
 
+	if (checkpt_filename && merge_num_sources()) {
+		fprintf(stderr,
+			"Checkpointing is not supported with multiple inputs\n");
+		return 1;
+	}
+
+	/* A checkpoint is a position in one log, streams are many logs */
+	if (checkpt_filename && config.log_streams && user_file == NULL &&
+			(force_logs || !is_pipe(0))) {
+		fprintf(stderr,
+			"Checkpointing is not supported with log streams\n");
+		return 1;
+	}
+
 	/* Load the checkpoint file if requested */
 	if (checkpt_filename) {
 		rc = load_ChkPt(checkpt_filename);
@@ -159,7 +176,11 @@ int main(int argc, char *argv[])
 	}
 
 	lol_create(&lo);
-	if (user_file) {
+	if (merge_num_sources()) {
+		rc = merge_process(merge_event);
+		merge_clear();
+		free_config(&config);
+	} else if (user_file) {
 		if (stat(user_file, &sb) == -1) {
                		perror("stat");
 			return 1;
@@ -211,6 +232,10 @@ int main(int argc, char *argv[])
 	}
 
 skip_checkpt:
+	if (group_enabled()) {
+		group_output();
+		group_clear();
+	}
 	lol_clear(&lo);
 	lookup_uid_destroy_list();
 	ilist_clear(event_type);
@@ -232,6 +257,31 @@ skip_checkpt:
 	return 0;
 }
 
+/*
+ * Log streams are extra sets of rotated logs written by auditd for the
+ * events it routed away from the main log. They are only searched when
+ * reading the logs named by auditd.conf, merged with the main log by time.
+ */
+static int use_log_streams(void)
+{
+	return config.log_streams && !(user_file && userfile_is_dir);
+}
+
+static int process_log_streams(void)
+{
+	const struct log_stream_conf *s;
+	int rc;
+
+	rc = merge_add_log_set(config.log_file);
+	for (s = config.log_streams; s && rc == 0; s = s->next)
+		rc = merge_add_log_set(s->log_file);
+	if (rc == 0)
+		rc = merge_process(merge_event);
+	merge_clear();
+	free_config(&config);
+	return rc;
+}
+
 static int process_logs(void)
 {
 	char *filename;
@@ -239,6 +289,9 @@ static int process_logs(void)
 	int found_chkpt_file = -1;
 	int ret;
 
+	if (use_log_streams())
+		return process_log_streams();
+
 	if (user_file && userfile_is_dir) {
 		char dirname[MAXPATHLEN+1];
 		clear_config (&config);
@@ -342,6 +395,7 @@ static int process_logs(void)
 		else
 			break;
 	} while (1);
+
 	/*
  	 * If performing a checkpoint, set the checkpointed
 	 * file details - ie remember the last file processed
@@ -639,3 +693,19 @@ static int get_next_event(llist **l)
 	return 0;
 }
 
+/* Per event handling when merging several inputs by time */
+static int merge_event(llist *entries)
+{
+	int rc = 0;
+
+	if (match(entries)) {
+		found = 1;
+		output_event(entries);
+		if (just_one)
+			rc = 1;
+		else if (line_buffered)
+			fflush(stdout);
+	}
+	ausearch_free_interpretations();
+	return rc;
+}
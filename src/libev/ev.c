@@ -128,7 +128,7 @@
    
 # if HAVE_LINUX_FS_H && HAVE_SYS_TIMERFD_H && HAVE_KERNEL_RWF_T
 #  ifndef EV_USE_IOURING
-#   define EV_USE_IOURING 0  // Intentionally drop the io_uring backend
+#   define EV_USE_IOURING EV_FEATURE_BACKENDS
 #  endif
 # else
 #  undef EV_USE_IOURING
@@ -3148,7 +3148,7 @@ ev_supported_backends (void) EV_NOEXCEPT
   if (EV_USE_KQUEUE                                    ) flags |= EVBACKEND_KQUEUE;
   if (EV_USE_EPOLL                                     ) flags |= EVBACKEND_EPOLL;
   if (EV_USE_LINUXAIO                                  ) flags |= EVBACKEND_LINUXAIO;
-  if (EV_USE_IOURING && ev_linux_version () >= 0x050601) flags |= EVBACKEND_IOURING; /* 5.6.1+ */
+  if (EV_USE_IOURING && ev_linux_version () >= 0x050b00) flags |= EVBACKEND_IOURING; /* 5.11+ */
   if (EV_USE_POLL                                      ) flags |= EVBACKEND_POLL;
   if (EV_USE_SELECT                                    ) flags |= EVBACKEND_SELECT;
 
@@ -0,0 +1,578 @@
+/*
+ * libev linux io_uring fd activity backend
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modifica-
+ * tion, are permitted provided that the following conditions are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MER-
+ * CHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPE-
+ * CIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTH-
+ * ERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * the GNU General Public License ("GPL") version 2 or any later version,
+ * in which case the provisions of the GPL are applicable instead of
+ * the above. If you wish to allow the use of your version of this file
+ * only under the terms of the GPL and not to allow others to use your
+ * version of this file under the BSD license, indicate your decision
+ * by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL. If you do not delete the
+ * provisions above, a recipient may use your version of this file under
+ * either the BSD or the GPL.
+ */
+
+/*
+ * general notes about this io_uring backend:
+ *
+ * a) every fd gets one IORING_OP_POLL_ADD. multishot polls (5.13+) are
+ *    edge triggered: a fd that still has data after its callback ran is
+ *    not reported again. libev watchers are level triggered, so the polls
+ *    are one-shot and re-armed after each event, just like with linux aio.
+ * b) re-arms and interest changes cost no syscall of their own: they are
+ *    queued in the sq ring and submitted by the same io_uring_enter that
+ *    waits for the next events.
+ * c) polls are identified by fd and generation counter in user_data, just
+ *    like the epoll backend does. changing or stopping a watcher removes
+ *    the old poll and bumps the generation, so late completions for it
+ *    are ignored.
+ * d) waiting uses IORING_ENTER_EXT_ARG (5.11+) to pass the timeout, so
+ *    timers need neither a timeout sqe nor a timerfd.
+ * e) a poll request holds a reference to its file. a closed fd is only
+ *    released once the removal was submitted, which happens at the
+ *    latest with the next loop iteration.
+ * f) older kernels, seccomp filters or kernel.io_uring_disabled make
+ *    iouring_init fail, so ev_loop_new falls through to the next
+ *    requested backend.
+ */
+
+#include <sys/mman.h>
+#include <poll.h>
+#include <stdint.h>
+#include <linux/types.h>
+
+/*****************************************************************************/
+/* syscall wrapdadoop - this section has the raw api/abi definitions */
+
+#include <sys/syscall.h> /* no glibc wrappers */
+
+/* the kernel headers might be older than the running kernel, or not there
+ * at all, so we carry the few bits of the abi that we need */
+
+struct io_uring_sqe
+{
+  __u8  opcode;
+  __u8  flags;
+  __u16 ioprio;
+  __s32 fd;
+  __u64 off;
+  __u64 addr;
+  __u32 len;
+  __u32 poll32_events;
+  __u64 user_data;
+  __u16 buf_index;
+  __u16 personality;
+  __s32 splice_fd_in;
+  __u64 __pad2[2];
+};
+
+struct io_uring_cqe
+{
+  __u64 user_data;
+  __s32 res;
+  __u32 flags;
+};
+
+struct io_sqring_offsets
+{
+  __u32 head;
+  __u32 tail;
+  __u32 ring_mask;
+  __u32 ring_entries;
+  __u32 flags;
+  __u32 dropped;
+  __u32 array;
+  __u32 resv1;
+  __u64 resv2;
+};
+
+struct io_cqring_offsets
+{
+  __u32 head;
+  __u32 tail;
+  __u32 ring_mask;
+  __u32 ring_entries;
+  __u32 overflow;
+  __u32 cqes;
+  __u32 flags;
+  __u32 resv1;
+  __u64 resv2;
+};
+
+struct io_uring_params
+{
+  __u32 sq_entries;
+  __u32 cq_entries;
+  __u32 flags;
+  __u32 sq_thread_cpu;
+  __u32 sq_thread_idle;
+  __u32 features;
+  __u32 wq_fd;
+  __u32 resv[3];
+  struct io_sqring_offsets sq_off;
+  struct io_cqring_offsets cq_off;
+};
+
+struct io_uring_getevents_arg
+{
+  __u64 sigmask;
+  __u32 sigmask_sz;
+  __u32 pad;
+  __u64 ts;
+};
+
+struct iouring_timespec
+{
+  int64_t   tv_sec;
+  long long tv_nsec;
+};
+
+#define IORING_OP_POLL_ADD      6
+#define IORING_OP_POLL_REMOVE   7
+
+#define IORING_ENTER_GETEVENTS  0x01U
+#define IORING_ENTER_EXT_ARG    0x08U
+
+#define IORING_FEAT_SINGLE_MMAP 0x0001U
+#define IORING_FEAT_NODROP      0x0002U
+#define IORING_FEAT_EXT_ARG     0x0100U
+
+#define IORING_SQ_CQ_OVERFLOW   0x0002U
+
+#define IORING_OFF_SQ_RING      0x00000000ULL
+#define IORING_OFF_SQES         0x10000000ULL
+
+inline_size
+int
+evsys_io_uring_setup (unsigned entries, struct io_uring_params *params)
+{
+  return ev_syscall2 (SYS_io_uring_setup, entries, params);
+}
+
+inline_size
+int
+evsys_io_uring_enter (int fd, unsigned to_submit, unsigned min_complete, unsigned flags, const void *arg, size_t argsz)
+{
+  return ev_syscall6 (SYS_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+/*****************************************************************************/
+/* actual backend implementation */
+
+/* number of sqes, the cq ring is twice that and the kernel keeps overflows */
+#define IOURING_INIT_ENTRIES 64
+
+/* user_data of poll removals, their completions are of no interest */
+#define IOURING_IGNORE ((uint64_t)-1)
+
+#define EV_SQ_VAR(name) *(unsigned *)((char *)iouring_sq_ring + iouring_sq_ ## name)
+#define EV_CQ_VAR(name) *(unsigned *)((char *)iouring_cq_ring + iouring_cq_ ## name)
+
+#define EV_SQ_ARRAY     ((unsigned *)((char *)iouring_sq_ring + iouring_sq_array))
+#define EV_SQES         ((struct io_uring_sqe *)iouring_sqes)
+#define EV_CQES         ((struct io_uring_cqe *)((char *)iouring_cq_ring + iouring_cq_cqes))
+
+/* the kernel expects the poll mask halfword swapped on big endian */
+inline_size
+uint32_t
+iouring_poll_mask (int events)
+{
+  uint32_t mask = (events & EV_READ  ? POLLIN  : 0)
+                | (events & EV_WRITE ? POLLOUT : 0);
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  mask = (mask << 16) | (mask >> 16);
+#endif
+
+  return mask;
+}
+
+inline_size
+uint64_t
+iouring_user_data (EV_P_ int fd)
+{
+  return (uint64_t)(uint32_t)fd
+       | ((uint64_t)(uint32_t)anfds [fd].egen << 32);
+}
+
+static int iouring_handle_cq (EV_P);
+
+/* submit queued sqes without waiting for anything */
+static void
+iouring_submit (EV_P)
+{
+  while (iouring_to_submit)
+    {
+      int res = evsys_io_uring_enter (backend_fd, iouring_to_submit, 0, 0, 0, 0);
+
+      if (ecb_expect_true (res >= 0))
+        iouring_to_submit -= res;
+      else if (errno == EBUSY)
+        /* the cq ring is full and the kernel wants us to reap it first, */
+        /* all queued sqes are still valid */
+        break;
+      else if (errno != EINTR && errno != EAGAIN)
+        ev_syserr ("(libev) io_uring_enter");
+    }
+}
+
+/* return a zeroed sqe, submitting queued ones if the sq ring is full */
+inline_speed
+struct io_uring_sqe *
+iouring_sqe_get (EV_P)
+{
+  unsigned tail = EV_SQ_VAR (tail);
+  struct io_uring_sqe *sqe;
+
+  for (;;)
+    {
+      unsigned head = *(volatile unsigned *)&EV_SQ_VAR (head);
+
+      ECB_MEMORY_FENCE_ACQUIRE;
+
+      if (ecb_expect_true (tail - head < iouring_sq_ring_entries))
+        break;
+
+      iouring_submit (EV_A);
+
+      /* the kernel refuses new sqes while the cq ring is full, so we have
+       * to handle events here. fd_reify copes with the fd changes this
+       * may cause. */
+      if (ecb_expect_false (iouring_to_submit))
+        iouring_handle_cq (EV_A);
+    }
+
+  sqe = EV_SQES + (tail & iouring_sq_ring_mask);
+  memset (sqe, 0, sizeof (*sqe));
+
+  return sqe;
+}
+
+/* hand the sqe returned by the last iouring_sqe_get to the kernel */
+inline_speed
+void
+iouring_sqe_submit (EV_P)
+{
+  ECB_MEMORY_FENCE_RELEASE;
+  *(volatile unsigned *)&EV_SQ_VAR (tail) = EV_SQ_VAR (tail) + 1;
+  ++iouring_to_submit;
+}
+
+static void
+iouring_modify (EV_P_ int fd, int oev, int nev)
+{
+  if (oev)
+    {
+      /* remove the poll of the old generation, the removal itself is
+       * reported with a completion that we ignore */
+      struct io_uring_sqe *sqe = iouring_sqe_get (EV_A);
+
+      sqe->opcode    = IORING_OP_POLL_REMOVE;
+      sqe->fd        = -1;
+      sqe->addr      = iouring_user_data (EV_A_ fd);
+      sqe->user_data = IOURING_IGNORE;
+      iouring_sqe_submit (EV_A);
+    }
+
+  /* anything still in flight for this fd is stale from now on */
+  ++anfds [fd].egen;
+
+  if (nev)
+    {
+      struct io_uring_sqe *sqe = iouring_sqe_get (EV_A);
+
+      sqe->opcode        = IORING_OP_POLL_ADD;
+      sqe->fd            = fd;
+      sqe->poll32_events = iouring_poll_mask (nev);
+      sqe->user_data     = iouring_user_data (EV_A_ fd);
+      iouring_sqe_submit (EV_A);
+    }
+}
+
+/* the poll of this fd ended, let fd_reify add a new one */
+/* this also lets fd_reify drop it if the watcher was stopped meanwhile */
+inline_speed
+void
+iouring_fd_rearm (EV_P_ int fd)
+{
+  anfds [fd].events = 0;
+  fd_change (EV_A_ fd, EV_ANFD_REIFY);
+}
+
+inline_speed
+void
+iouring_process_cqe (EV_P_ struct io_uring_cqe *cqe)
+{
+  int fd       = cqe->user_data & 0xffffffffU;
+  uint32_t gen = cqe->user_data >> 32;
+  int res      = cqe->res;
+
+  if (cqe->user_data == IOURING_IGNORE)
+    return;
+
+  assert (("libev: io_uring fd must be in-bounds", fd >= 0 && fd < anfdmax));
+
+  /* only accept events if generation counter matches */
+  if (ecb_expect_false (gen != (uint32_t)anfds [fd].egen))
+    return;
+
+  if (ecb_expect_false (res < 0))
+    {
+      if (res == -EBADF)
+        {
+          assert (("libev: event loop rejected bad fd", res != -EBADF));
+          fd_kill (EV_A_ fd);
+        }
+      else if (res == -ECANCELED || res == -ENOMEM || res == -EAGAIN)
+        /* the kernel gave up on this poll, just ask again */
+        iouring_fd_rearm (EV_A_ fd);
+      else
+        {
+          errno = -res;
+          ev_syserr ("(libev) IORING_OP_POLL_ADD");
+        }
+
+      return;
+    }
+
+  fd_event (
+    EV_A_
+    fd,
+    (res & (POLLOUT | POLLERR | POLLHUP) ? EV_WRITE : 0)
+    | (res & (POLLIN | POLLERR | POLLHUP) ? EV_READ : 0)
+  );
+
+  /* polls are oneshot: rearm fd */
+  iouring_fd_rearm (EV_A_ fd);
+}
+
+/* handle all completions in the cq ring, return true if there were any */
+static int
+iouring_handle_cq (EV_P)
+{
+  unsigned head, tail;
+
+  head = EV_CQ_VAR (head);
+  ECB_MEMORY_FENCE_ACQUIRE;
+  tail = *(volatile unsigned *)&EV_CQ_VAR (tail);
+
+  if (head == tail)
+    return 0;
+
+  /* parse all available events, but only once, to avoid starvation */
+  for (; head != tail; ++head)
+    iouring_process_cqe (EV_A_ EV_CQES + (head & iouring_cq_ring_mask));
+
+  ECB_MEMORY_FENCE_RELEASE;
+  *(volatile unsigned *)&EV_CQ_VAR (head) = tail;
+
+  return 1;
+}
+
+static void
+iouring_poll (EV_P_ ev_tstamp timeout)
+{
+  /* if there are events already, or fds have been added during fd_reify,
+   * we must not block */
+  if (EV_CQ_VAR (head) != *(volatile unsigned *)&EV_CQ_VAR (tail) || fdchangecnt)
+    timeout = EV_TS_CONST (0.);
+
+  /* the kernel only moves overflowed completions back into the
+   * ring when asked for events */
+  if (ecb_expect_false (*(volatile unsigned *)&EV_SQ_VAR (flags) & IORING_SQ_CQ_OVERFLOW))
+    timeout = EV_TS_CONST (0.);
+  else if (!timeout && !iouring_to_submit)
+    {
+      /* nothing to submit and no wait, so no syscall either */
+      iouring_handle_cq (EV_A);
+      return;
+    }
+
+  {
+    struct iouring_timespec ts;
+    struct io_uring_getevents_arg arg;
+    int res;
+
+    ts.tv_sec  = (int64_t)timeout;
+    ts.tv_nsec = (long long)((timeout - (ev_tstamp)ts.tv_sec) * 1e9);
+
+    memset (&arg, 0, sizeof (arg));
+    arg.ts = (uintptr_t)&ts;
+
+    EV_RELEASE_CB;
+
+    res = evsys_io_uring_enter (backend_fd, iouring_to_submit, timeout ? 1 : 0,
+                                IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                                &arg, sizeof (arg));
+
+    EV_ACQUIRE_CB;
+
+    if (ecb_expect_true (res >= 0))
+      iouring_to_submit -= res;
+    else if (errno != EINTR && errno != ETIME && errno != EBUSY && errno != EAGAIN)
+      ev_syserr ("(libev) io_uring_enter");
+  }
+
+  iouring_handle_cq (EV_A);
+}
+
+inline_size
+void
+iouring_internal_destroy (EV_P)
+{
+  if (iouring_sq_ring)
+    munmap (iouring_sq_ring, iouring_sq_ring_size);
+
+  if (iouring_sqes)
+    munmap (iouring_sqes, iouring_sqes_size);
+
+  iouring_sq_ring = 0;
+  iouring_cq_ring = 0;
+  iouring_sqes    = 0;
+}
+
+/* create the ring and map it, returns the ring fd or -1 */
+static int
+iouring_internal_init (EV_P)
+{
+  struct io_uring_params params;
+  unsigned i;
+  int fd;
+
+  memset (&params, 0, sizeof (params));
+
+  iouring_sq_ring = 0;
+  iouring_cq_ring = 0;
+  iouring_sqes    = 0;
+  iouring_to_submit = 0;
+
+  fd = evsys_io_uring_setup (iouring_entries, &params);
+  if (fd < 0)
+    return -1;
+
+  /* the kernel must keep overflows, take a timeout with the wait
+   * and share a single mapping between the two rings */
+  if ((~params.features) & (IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG))
+    {
+      close (fd);
+      errno = ENOSYS;
+      return -1;
+    }
+
+  iouring_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+  iouring_cq_ring_size = params.cq_off.cqes  + params.cq_entries * sizeof (struct io_uring_cqe);
+  iouring_sqes_size    = params.sq_entries * sizeof (struct io_uring_sqe);
+
+  if (iouring_sq_ring_size < iouring_cq_ring_size)
+    iouring_sq_ring_size = iouring_cq_ring_size;
+
+  iouring_sq_ring = mmap (0, iouring_sq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  iouring_sqes    = mmap (0, iouring_sqes_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+  if (iouring_sq_ring == MAP_FAILED || iouring_sqes == MAP_FAILED)
+    {
+      if (iouring_sq_ring != MAP_FAILED)
+        munmap (iouring_sq_ring, iouring_sq_ring_size);
+      if (iouring_sqes != MAP_FAILED)
+        munmap (iouring_sqes, iouring_sqes_size);
+
+      iouring_sq_ring = 0;
+      iouring_sqes    = 0;
+      close (fd);
+      return -1;
+    }
+
+  iouring_cq_ring = iouring_sq_ring;
+
+  iouring_sq_head         = params.sq_off.head;
+  iouring_sq_tail         = params.sq_off.tail;
+  iouring_sq_ring_mask    = *(unsigned *)((char *)iouring_sq_ring + params.sq_off.ring_mask);
+  iouring_sq_ring_entries = *(unsigned *)((char *)iouring_sq_ring + params.sq_off.ring_entries);
+  iouring_sq_flags        = params.sq_off.flags;
+  iouring_sq_dropped      = params.sq_off.dropped;
+  iouring_sq_array        = params.sq_off.array;
+
+  iouring_cq_head         = params.cq_off.head;
+  iouring_cq_tail         = params.cq_off.tail;
+  iouring_cq_ring_mask    = *(unsigned *)((char *)iouring_cq_ring + params.cq_off.ring_mask);
+  iouring_cq_ring_entries = *(unsigned *)((char *)iouring_cq_ring + params.cq_off.ring_entries);
+  iouring_cq_overflow     = params.cq_off.overflow;
+  iouring_cq_cqes         = params.cq_off.cqes;
+
+  /* sqes are always used in ring order, so the index array is fixed */
+  for (i = 0; i < iouring_sq_ring_entries; ++i)
+    EV_SQ_ARRAY [i] = i;
+
+  fcntl (fd, F_SETFD, FD_CLOEXEC);
+
+  return fd;
+}
+
+inline_size
+int
+iouring_init (EV_P_ int flags)
+{
+  /* IORING_ENTER_EXT_ARG appeared in 5.11 */
+  if (ev_linux_version () < 0x050b00)
+    return 0;
+
+  iouring_entries = IOURING_INIT_ENTRIES;
+
+  if ((backend_fd = iouring_internal_init (EV_A)) < 0)
+    return 0;
+
+  backend_mintime = EV_TS_CONST (1e-6); /* the wait timeout has nanosecond resolution */
+  backend_modify  = iouring_modify;
+  backend_poll    = iouring_poll;
+
+  return EVBACKEND_IOURING;
+}
+
+inline_size
+void
+iouring_destroy (EV_P)
+{
+  /* backend_fd is closed by loop_destroy */
+  iouring_internal_destroy (EV_A);
+}
+
+ecb_cold
+static void
+iouring_fork (EV_P)
+{
+  /* the child shares the ring with the parent, make a new one */
+  iouring_internal_destroy (EV_A);
+  close (backend_fd);
+
+  while ((backend_fd = iouring_internal_init (EV_A)) < 0)
+    ev_syserr ("(libev) io_uring_setup");
+
+  fd_rearm_all (EV_A);
+}
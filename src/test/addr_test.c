@@ -0,0 +1,96 @@
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include "auditd-addr.h"
+
+#define ADDRS 5000
+
+static struct sockaddr_storage *v4(unsigned int n, unsigned short port)
+{
+	static struct sockaddr_storage ss;
+	struct sockaddr_in *sin = (struct sockaddr_in *)&ss;
+
+	memset(&ss, 0, sizeof(ss));
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(port);
+	sin->sin_addr.s_addr = htonl(0x0a000000 + n);
+	return &ss;
+}
+
+static struct sockaddr_storage *v6(unsigned int n)
+{
+	static struct sockaddr_storage ss;
+	struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&ss;
+
+	memset(&ss, 0, sizeof(ss));
+	sin6->sin6_family = AF_INET6;
+	// ::ffff:10.x.x.x looks like the IPv4 address but is not the same
+	sin6->sin6_addr.s6_addr[10] = 0xff;
+	sin6->sin6_addr.s6_addr[11] = 0xff;
+	sin6->sin6_addr.s6_addr[12] = 10;
+	sin6->sin6_addr.s6_addr[13] = n >> 16;
+	sin6->sin6_addr.s6_addr[14] = n >> 8;
+	sin6->sin6_addr.s6_addr[15] = n;
+	return &ss;
+}
+
+int main(void)
+{
+	static struct addr_count *a4[ADDRS], *a6[ADDRS];
+	struct addr_count *ac;
+	unsigned int i;
+
+	// Enough addresses to make the table grow several times
+	for (i = 0; i < ADDRS; i++) {
+		a4[i] = addr_get(v4(i, 60));
+		a6[i] = addr_get(v6(i));
+		if (a4[i] == NULL || a6[i] == NULL || a4[i] == a6[i]) {
+			printf("Test failed - address %u\n", i);
+			return 1;
+		}
+		a4[i]->count = i + 1;
+		a6[i]->count = 1;
+	}
+
+	// The port is not part of the address
+	for (i = 0; i < ADDRS; i++) {
+		if (addr_get(v4(i, 61)) != a4[i] || a4[i]->count != i + 1 ||
+				addr_get(v6(i)) != a6[i]) {
+			printf("Test failed - address %u lost its count\n", i);
+			return 1;
+		}
+	}
+
+	// Only addresses without connections are forgotten
+	for (i = 0; i < ADDRS; i += 2) {
+		a4[i]->count = 0;
+		addr_drop(a4[i]);
+	}
+	addr_drop(a6[0]);
+	for (i = 1; i < ADDRS; i += 2) {
+		if (addr_get(v4(i, 60)) != a4[i] || a4[i]->count != i + 1) {
+			printf("Test failed - drop affected address %u\n", i);
+			return 1;
+		}
+	}
+	if (addr_get(v6(0)) != a6[0] || a6[0]->count != 1) {
+		puts("Test failed - address with connections dropped");
+		return 1;
+	}
+	ac = addr_get(v4(0, 60));
+	if (ac == NULL || ac->count != 0) {
+		puts("Test failed - dropped address kept its count");
+		return 1;
+	}
+
+	addr_table_free();
+	ac = addr_get(v4(1, 60));
+	if (ac == NULL || ac->count != 0) {
+		puts("Test failed - table not emptied");
+		return 1;
+	}
+	addr_table_free();
+	puts("addr test passed");
+	return 0;
+}
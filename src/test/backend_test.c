@@ -0,0 +1,137 @@
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "ev.h"
+
+#define PIPES 300
+
+#define DEADLINE 10.0	/* Seconds, only reached if something is broken */
+
+static int reads, wanted;
+
+/* Reads one byte per call, like the auditd watchers read one message */
+static void read_one(struct ev_loop *loop, struct ev_io *io, int revents)
+{
+	char ch;
+
+	if (read(io->fd, &ch, 1) == 1 && ++reads == wanted)
+		ev_break(loop, EVBREAK_ONE);
+}
+
+static void timeout(struct ev_loop *loop, struct ev_timer *t, int revents)
+{
+	ev_break(loop, EVBREAK_ONE);
+}
+
+/* Runs the loop for secs or until the wanted number of reads is done */
+static void run_for(struct ev_loop *loop, double secs, int want)
+{
+	struct ev_timer t;
+
+	wanted = want;
+	ev_now_update(loop);
+	ev_timer_init(&t, timeout, secs, 0.);
+	ev_timer_start(loop, &t);
+	ev_run(loop, 0);
+	ev_timer_stop(loop, &t);
+}
+
+/* Runs the loop until want more bytes have been read */
+static void run(struct ev_loop *loop, int want)
+{
+	reads = 0;
+	run_for(loop, DEADLINE, want);
+}
+
+static int test_backend(unsigned int backend, const char *name)
+{
+	struct ev_loop *loop = ev_loop_new(backend);
+	static struct ev_io w[PIPES];
+	static int fds[PIPES][2];
+	ev_tstamp start;
+	int i;
+
+	if (loop == NULL || ev_backend(loop) != backend) {
+		printf("%s backend not available here, skipped\n", name);
+		if (loop)
+			ev_loop_destroy(loop);
+		return 0;
+	}
+
+	// Data left after a callback is reported again
+	for (i = 0; i < PIPES; i++) {
+		if (pipe(fds[i]))
+			return 1;
+		ev_io_init(&w[i], read_one, fds[i][0], EV_READ);
+		ev_io_start(loop, &w[i]);
+		write(fds[i][1], "abc", 3);
+	}
+	run(loop, 3 * PIPES);
+	if (reads != 3 * PIPES) {
+		printf("Test failed - %s read %d of %d\n", name, reads,
+			3 * PIPES);
+		return 1;
+	}
+
+	// A stopped watcher hears nothing until it is started again
+	ev_io_stop(loop, &w[0]);
+	write(fds[0][1], "d", 1);
+	reads = 0;
+	run_for(loop, 0.05, -1);
+	if (reads) {
+		printf("Test failed - %s stopped watcher ran\n", name);
+		return 1;
+	}
+	ev_io_start(loop, &w[0]);
+	run(loop, 1);
+	if (reads != 1) {
+		printf("Test failed - %s restarted watcher missed data\n",
+			name);
+		return 1;
+	}
+
+	// A closed fd number reused for a new pipe is watched afresh
+	ev_io_stop(loop, &w[0]);
+	close(fds[0][0]);
+	close(fds[0][1]);
+	if (pipe(fds[0]))
+		return 1;
+	ev_io_set(&w[0], fds[0][0], EV_READ);
+	ev_io_start(loop, &w[0]);
+	write(fds[0][1], "e", 1);
+	run(loop, 1);
+	if (reads != 1) {
+		printf("Test failed - %s reused fd missed data\n", name);
+		return 1;
+	}
+
+	// Timers still wake the loop when no fd is ready
+	ev_now_update(loop);
+	start = ev_now(loop);
+	run_for(loop, 0.05, -1);
+	if (ev_now(loop) - start < 0.04) {
+		printf("Test failed - %s timer fired early\n", name);
+		return 1;
+	}
+
+	for (i = 0; i < PIPES; i++) {
+		ev_io_stop(loop, &w[i]);
+		close(fds[i][0]);
+		close(fds[i][1]);
+	}
+	ev_loop_destroy(loop);
+	printf("%s backend passed\n", name);
+	return 0;
+}
+
+int main(void)
+{
+	if (test_backend(EVBACKEND_SELECT, "select") ||
+	    test_backend(EVBACKEND_POLL, "poll") ||
+	    test_backend(EVBACKEND_EPOLL, "epoll") ||
+	    test_backend(EVBACKEND_IOURING, "io_uring"))
+		return 1;
+	puts("backend test passed");
+	return 0;
+}
@@ -0,0 +1,325 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "libaudit.h"
+#include "auditd-config.h"
+
+static char dir[] = "/tmp/config_test.XXXXXX";
+static char made[32][128];
+static unsigned int num_made;
+
+/* Settings every test config needs to get past the sanity check */
+#define BASE	"space_left = 75\nadmin_space_left = 50\n"
+
+static void cleanup(void)
+{
+	while (num_made--)
+		remove(made[num_made]);
+	rmdir(dir);
+}
+
+/*
+ * Writes a file under dir, or makes a directory if text is NULL. Each
+ * one is remembered so it can be removed at the end.
+ */
+static int make(const char *name, const char *text)
+{
+	char path[sizeof(made[0])];
+	unsigned int i;
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	for (i = 0; i < num_made && strcmp(made[i], path); i++)
+		;
+	if (i == num_made) {
+		if (num_made == sizeof(made) / sizeof(made[0]))
+			return 1;
+		strcpy(made[num_made++], path);
+	}
+	if (text == NULL)
+		return mkdir(path, 0700);
+	f = fopen(path, "w");
+	if (f == NULL)
+		return 1;
+	fputs(text, f);
+	return fclose(f);
+}
+
+/*
+ * Writes BASE and text to auditd.conf and loads it. free_config forgets
+ * the config dir, so it is set every time.
+ */
+static int load(struct daemon_conf *c, const char *text)
+{
+	char buf[1024];
+
+	snprintf(buf, sizeof(buf), "%s%s", BASE, text);
+	if (set_config_dir(dir) || make("auditd.conf", buf))
+		return -1;
+	return load_config(c, TEST_SEARCH);
+}
+
+/* A config that must be turned away */
+static int rejected(const char *text)
+{
+	struct daemon_conf c;
+	int rc = load(&c, text);
+
+	free_config(&c);
+	if (rc == 0) {
+		printf("Test failed - accepted: %s", text);
+		return 0;
+	}
+	return 1;
+}
+
+static int test_rate_limit(void)
+{
+	struct daemon_conf c;
+
+	if (load(&c, "rate_limit_by = key\nrate_limit = 5\n"
+			"rate_limit_burst = 20\nrate_limit_sample = 10\n"
+			"rate_limit_report = 30\n") ||
+			c.rate_limit_by != RL_KEY || c.rate_limit != 5 ||
+			c.rate_limit_burst != 20 || c.rate_limit_sample != 10 ||
+			c.rate_limit_report != 30) {
+		puts("Test failed - rate limit options");
+		return 1;
+	}
+	free_config(&c);
+	if (load(&c, "rate_limit_by = AUID\n") || c.rate_limit_by != RL_AUID ||
+			c.rate_limit || c.rate_limit_report != 60) {
+		puts("Test failed - rate limit defaults");
+		return 1;
+	}
+	free_config(&c);
+	// Limits without a selector are only warned about
+	if (load(&c, "rate_limit = 5\n") || c.rate_limit_by != RL_NONE) {
+		puts("Test failed - rate limit without rate_limit_by");
+		return 1;
+	}
+	free_config(&c);
+	if (!rejected("rate_limit = 5x\n") ||
+			!rejected("rate_limit_burst = 3000000000\n") ||
+			!rejected("rate_limit_report = 0\n") ||
+			!rejected("rate_limit_by = host\n"))
+		return 1;
+	return 0;
+}
+
+static int test_log_streams(void)
+{
+	struct daemon_conf c;
+	const struct log_stream_conf *s;
+	char buf[512], bad[512];
+
+	// Streams load in name order, broken ones and other files are
+	// skipped
+	snprintf(buf, sizeof(buf), "log_file = %s/sec.log\n"
+		"match_key = passwd,shadow\nmatch_type = USER_LOGIN\n"
+		"num_logs = 3\nmax_log_file = 5\n"
+		"max_log_file_action = rotate\n", dir);
+	if (make("streams", NULL) || make("streams/10-sec.conf", buf))
+		return 1;
+	snprintf(buf, sizeof(buf), "log_file = %s/none.log\n", dir);
+	if (make("streams/20-nomatch.conf", buf))
+		return 1;
+	snprintf(buf, sizeof(buf), "log_file = %s/auid.log\n"
+		"match_auid = 1000,1001\n", dir);
+	if (make("streams/40-auid.conf", buf) ||
+	    make("streams/notes.txt", buf) ||
+	    make("streams/.hidden.conf", buf))
+		return 1;
+	// Each of these is fine but for its last line
+	strcpy(bad, buf);
+	strcat(bad, "flush = data\n");
+	if (make("streams/30-keyword.conf", bad))
+		return 1;
+	strcpy(bad, buf);
+	strcat(bad, "space_left = 5%\n");
+	if (make("streams/35-percent.conf", bad))
+		return 1;
+	strcpy(bad, buf);
+	strcat(bad, "space_left_action = email\n");
+	if (make("streams/45-email.conf", bad))
+		return 1;
+	snprintf(buf, sizeof(buf), "log_stream_dir = %s/streams\n", dir);
+	if (load(&c, buf)) {
+		puts("Test failed - log_stream_dir");
+		return 1;
+	}
+
+	s = c.log_streams;
+	if (s == NULL || strcmp(s->name, "10-sec") || s->num_keys != 2 ||
+			strcmp(s->match_keys[1], "shadow") || s->num_types != 1 ||
+			s->match_types[0] != AUDIT_USER_LOGIN ||
+			s->num_auids || s->num_logs != 3 ||
+			s->max_log_size != 5 ||
+			s->max_log_size_action != SZ_ROTATE) {
+		puts("Test failed - first log stream");
+		return 1;
+	}
+	s = s->next;
+	if (s == NULL || strcmp(s->name, "40-auid") || s->num_auids != 2 ||
+			s->match_auids[1] != 1001 || s->num_keys ||
+			s->next) {
+		puts("Test failed - log streams skipped or out of order");
+		return 1;
+	}
+	free_config(&c);
+
+	// A missing directory only costs the streams
+	if (load(&c, "log_stream_dir = /nonexistent/streams\n") ||
+			c.log_streams) {
+		puts("Test failed - missing log_stream_dir");
+		return 1;
+	}
+	free_config(&c);
+	return 0;
+}
+
+static int test_spill(void)
+{
+	struct daemon_conf c;
+
+	if (load(&c, "") || c.q_spill_dir || c.q_spill_max_size != 100) {
+		puts("Test failed - spill defaults");
+		return 1;
+	}
+	free_config(&c);
+	if (load(&c, "q_spill_dir = /var/spool/audit\n"
+			"q_spill_max_size = 1048576\n") ||
+			c.q_spill_dir == NULL ||
+			strcmp(c.q_spill_dir, "/var/spool/audit") ||
+			c.q_spill_max_size != 1048576) {
+		puts("Test failed - spill options");
+		return 1;
+	}
+	free_config(&c);
+	if (!rejected("q_spill_dir = spool\n") ||
+			!rejected("q_spill_max_size = 0\n") ||
+			!rejected("q_spill_max_size = 1048577\n") ||
+			!rejected("q_spill_max_size = -1\n"))
+		return 1;
+	return 0;
+}
+
+static int test_lanes(void)
+{
+	struct daemon_conf c;
+
+	if (load(&c, "q_priority_types = USER_LOGIN,ANOM_ABEND\n"
+			"q_priority_keys = ids\n"
+			"q_bulk_types = SYSCALL\nq_bulk_keys = exec,files\n") ||
+			c.q_priority_types == NULL || c.q_priority_keys == NULL ||
+			c.q_bulk_types == NULL || c.q_bulk_keys == NULL ||
+			strcmp(c.q_priority_types, "USER_LOGIN,ANOM_ABEND") ||
+			strcmp(c.q_priority_keys, "ids") ||
+			strcmp(c.q_bulk_types, "SYSCALL") ||
+			strcmp(c.q_bulk_keys, "exec,files")) {
+		puts("Test failed - lane options");
+		return 1;
+	}
+	free_config(&c);
+	// Types that never start an event could never pick a lane
+	if (!rejected("q_priority_types = PATH\n") ||
+			!rejected("q_bulk_types = SYSCALL,EOE\n") ||
+			!rejected("q_bulk_types = NOT_A_TYPE\n"))
+		return 1;
+	return 0;
+}
+
+static int test_tls(void)
+{
+	struct daemon_conf c;
+
+#ifdef USE_TLS
+	if (load(&c, "transport = tls\n"
+			"tls_cert_file = /etc/pki/audit/server.crt\n"
+			"tls_key_file = /etc/pki/audit/server.key\n"
+			"tls_ca_file = /etc/pki/audit/ca.crt\n") ||
+			c.transport != T_TLS || c.tls_cert_file == NULL ||
+			strcmp(c.tls_cert_file, "/etc/pki/audit/server.crt") ||
+			c.tls_key_file == NULL ||
+			strcmp(c.tls_key_file, "/etc/pki/audit/server.key") ||
+			c.tls_ca_file == NULL ||
+			strcmp(c.tls_ca_file, "/etc/pki/audit/ca.crt")) {
+		puts("Test failed - tls options");
+		return 1;
+	}
+	free_config(&c);
+	// Every file is needed to use TLS
+	if (!rejected("transport = tls\n"
+			"tls_cert_file = /etc/pki/audit/server.crt\n"
+			"tls_key_file = /etc/pki/audit/server.key\n"))
+		return 1;
+#else
+	// Without TLS support the files are ignored and it can't be chosen
+	if (load(&c, "tls_ca_file = /etc/pki/audit/ca.crt\n") ||
+			c.tls_ca_file) {
+		puts("Test failed - tls file without tls support");
+		return 1;
+	}
+	free_config(&c);
+	if (!rejected("transport = tls\n"))
+		return 1;
+#endif
+	return 0;
+}
+
+static int test_event_backend(void)
+{
+	static const struct {
+		const char *word;
+		int backend;
+	} words[] = {
+		{ "auto", EB_AUTO }, { "select", EB_SELECT },
+		{ "POLL", EB_POLL }, { "epoll", EB_EPOLL },
+		{ "io_uring", EB_IO_URING }
+	};
+	struct daemon_conf c;
+	char line[64];
+	unsigned int i;
+
+	if (load(&c, "") || c.event_backend != EB_AUTO) {
+		puts("Test failed - event_backend default");
+		return 1;
+	}
+	free_config(&c);
+	for (i = 0; i < sizeof(words)/sizeof(words[0]); i++) {
+		snprintf(line, sizeof(line), "event_backend = %s\n",
+			words[i].word);
+		if (load(&c, line) || (int)c.event_backend != words[i].backend) {
+			printf("Test failed - event_backend %s\n",
+				words[i].word);
+			return 1;
+		}
+		free_config(&c);
+	}
+	if (!rejected("event_backend = kqueue\n"))
+		return 1;
+	return 0;
+}
+
+int main(void)
+{
+	if (geteuid() != 0) {
+		puts("config files must be owned by root, skipped");
+		return 77;
+	}
+	if (mkdtemp(dir) == NULL) {
+		puts("Test failed - cannot make the config dir");
+		return 1;
+	}
+	atexit(cleanup);
+
+	if (test_rate_limit() || test_log_streams() || test_spill() ||
+			test_lanes() || test_tls() ||
+			test_event_backend())
+		return 1;
+	puts("config test passed");
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include "libaudit.h"
+#include "evcache.h"
+
+#define OPEN 5000
+
+int main(void)
+{
+	struct audit_event_id id;
+	evcache_t c;
+	uintptr_t val;
+	unsigned int i;
+	const char *rec = "audit(1700000123.456:7890): arch=c000003e";
+
+	if (audit_event_id_parse(rec, strlen(rec), &id) ||
+			id.sec != 1700000123 || id.milli != 456 ||
+			id.serial != 7890) {
+		puts("Test failed - event id not parsed");
+		return 1;
+	}
+	if (audit_event_id_parse("audit(17.1", 10, &id) == 0) {
+		puts("Test failed - truncated event id accepted");
+		return 1;
+	}
+
+	// Many open events must all be remembered
+	evcache_init(&c);
+	id.sec = 1700000000;
+	for (i = 0; i < OPEN; i++) {
+		id.milli = i % 1000;
+		id.serial = i;
+		if (evcache_add(&c, &id, i * 3)) {
+			printf("Test failed - add %u\n", i);
+			return 1;
+		}
+	}
+	for (i = 0; i < OPEN; i++) {
+		id.milli = i % 1000;
+		id.serial = i;
+		if (!evcache_find(&c, &id, &val) || val != i * 3) {
+			printf("Test failed - event %u forgotten\n", i);
+			return 1;
+		}
+	}
+
+	// Removing every other one must not lose the rest
+	for (i = 0; i < OPEN; i += 2) {
+		id.milli = i % 1000;
+		id.serial = i;
+		evcache_remove(&c, &id);
+	}
+	for (i = 0; i < OPEN; i++) {
+		id.milli = i % 1000;
+		id.serial = i;
+		if (evcache_find(&c, &id, &val) != (i & 1)) {
+			printf("Test failed - remove affected event %u\n", i);
+			return 1;
+		}
+	}
+
+	// Events that never end are dropped once they are old
+	id.sec += EVCACHE_TTL + 1;
+	for (i = 0; i < OPEN; i++) {
+		id.milli = 0;
+		id.serial = OPEN + i;
+		evcache_add(&c, &id, 1);
+	}
+	id.sec = 1700000000;
+	id.milli = 1;
+	id.serial = 1;
+	if (evcache_find(&c, &id, &val)) {
+		puts("Test failed - old event not expired");
+		return 1;
+	}
+	evcache_clear(&c);
+
+	if (!evcache_single_record(AUDIT_USER_LOGIN) ||
+			evcache_single_record(AUDIT_SYSCALL) ||
+			evcache_single_record(AUDIT_PROCTITLE)) {
+		puts("Test failed - single record events");
+		return 1;
+	}
+	puts("evcache test passed");
+	return 0;
+}
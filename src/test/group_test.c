@@ -0,0 +1,113 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "libaudit.h"
+#include "ausearch-options.h"
+#include "ausearch-group.h"
+
+// Normally set by ausearch's option parsing and report code
+report_t report_format = RPT_INTERP;
+auparse_esc_t escape_mode = AUPARSE_ESC_RAW;
+static int loaded = 0, loads = 0;
+
+void ausearch_load_interpretations(const lnode *n)
+{
+	(void)n;
+	if (loaded == 0) {
+		loaded = 1;
+		loads++;
+	}
+}
+
+void ausearch_free_interpretations(void)
+{
+	loaded = 0;
+}
+
+static void add_event(unsigned long serial, const char *rec1,
+		      const char *rec2)
+{
+	llist l;
+	lnode n;
+
+	list_create(&l);
+	l.e.sec = 1700000000;
+	l.e.milli = 0;
+	l.e.serial = serial;
+	l.e.type = AUDIT_SYSCALL;
+	memset(&n, 0, sizeof(n));
+	n.type = AUDIT_SYSCALL;
+	n.message = strdup(rec1);
+	list_append(&l, &n);
+	if (rec2) {
+		n.type = AUDIT_CWD;
+		n.message = strdup(rec2);
+		list_append(&l, &n);
+	}
+	group_event(&l);
+	list_clear(&l);
+}
+
+int main(void)
+{
+	char path[] = "/tmp/group_testXXXXXX", line[256];
+	unsigned int none = 0, k1 = 0;
+	FILE *f;
+	int fd;
+
+	if (group_set_fields("key,syscall") || group_set_format("csv")) {
+		puts("Test failed - options");
+		return 1;
+	}
+
+	add_event(1, "type=SYSCALL msg=audit(1700000000.000:1): arch=c000003e "
+		"syscall=2 success=yes key=\"k1\"", "type=CWD "
+		"msg=audit(1700000000.000:1): cwd=\"/\"");
+	add_event(2, "type=SYSCALL msg=audit(1700000000.000:2): arch=c000003e "
+		"syscall=2 success=yes key=(null)", NULL);
+	add_event(3, "type=SYSCALL msg=audit(1700000000.000:3): arch=c000003e "
+		"syscall=2 success=yes", NULL);
+	add_event(4, "type=SYSCALL msg=audit(1700000000.000:4): arch=c000003e "
+		"syscall=2 success=yes key=\"k1\"", NULL);
+
+	// Both fields come from one record, so one load per event
+	if (loads != 4 || loaded) {
+		printf("Test failed - interpretations loaded %d times\n",
+			loads);
+		return 1;
+	}
+
+	fd = mkstemp(path);
+	if (fd < 0 || dup2(fd, STDOUT_FILENO) < 0) {
+		fputs("Test failed - no temp file\n", stderr);
+		return 1;
+	}
+	group_output();
+	group_clear();
+	fflush(stdout);
+
+	f = fopen(path, "r");
+	if (f == NULL) {
+		fputs("Test failed - cannot read output\n", stderr);
+		return 1;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		if (strncmp(line, "(none),open,2,", 14) == 0)
+			none++;
+		else if (strncmp(line, "k1,open,2,", 10) == 0)
+			k1++;
+	}
+	fclose(f);
+	unlink(path);
+
+	// A (null) key and a missing key are the same group
+	if (none != 1 || k1 != 1) {
+		fprintf(stderr, "Test failed - groups none:%u k1:%u\n",
+			none, k1);
+		return 1;
+	}
+	fputs("group test passed\n", stderr);
+	return 0;
+}
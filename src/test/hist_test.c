@@ -0,0 +1,76 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "aureport-hist.h"
+
+#define T0 1700000000	// 22:13:20 UTC
+
+int main(void)
+{
+	char path[] = "/tmp/hist_testXXXXXX", line[256];
+	unsigned long counts[8];
+	unsigned int num = 0, n;
+	unsigned long c, total = 0;
+	FILE *f;
+	int fd;
+
+	setenv("TZ", "UTC", 1);
+	tzset();
+	if (hist_set_interval("fortnight") == 0 || hist_enabled()) {
+		puts("Test failed - bad interval accepted");
+		return 1;
+	}
+	if (hist_set_interval("hour") || !hist_enabled()) {
+		puts("Test failed - hour not accepted");
+		return 1;
+	}
+
+	hist_add(T0);
+	hist_add(T0 + 100);
+	hist_add(T0 + 3 * 3600);	// Leaves two empty hours
+	hist_add(T0 - 3600);		// Older than the first bucket
+	hist_add(T0 - 3600 + 1);
+
+	fd = mkstemp(path);
+	if (fd < 0 || dup2(fd, STDOUT_FILENO) < 0) {
+		fputs("Test failed - no temp file\n", stderr);
+		return 1;
+	}
+	hist_output();
+	hist_clear();
+	fflush(stdout);
+
+	f = fopen(path, "r");
+	if (f == NULL) {
+		fputs("Test failed - cannot read output\n", stderr);
+		return 1;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		char *ptr;
+
+		if (sscanf(line, "Total events: %lu", &c) == 1) {
+			total = c;
+			continue;
+		}
+		// Lines look like "1. 11/14/23 21:00 2 ####..."
+		if (sscanf(line, "%u.", &n) != 1 || n != num + 1 || num == 8)
+			continue;
+		ptr = strchr(line, ':');
+		if (ptr == NULL || sscanf(ptr + 3, " %lu", &c) != 1)
+			continue;
+		counts[num++] = c;
+	}
+	fclose(f);
+	unlink(path);
+
+	if (num != 5 || counts[0] != 2 || counts[1] != 2 || counts[2] != 0 ||
+			counts[3] != 0 || counts[4] != 1 || total != 5) {
+		fprintf(stderr, "Test failed - %u buckets, total %lu\n",
+			num, total);
+		return 1;
+	}
+	fputs("hist test passed\n", stderr);
+	return 0;
+}
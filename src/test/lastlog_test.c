@@ -0,0 +1,91 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include "lastlog-db.h"
+
+static int fail(const char *msg)
+{
+	printf("Test failed - %s\n", msg);
+	return 1;
+}
+
+int main(void)
+{
+	char path[] = "/tmp/lastlog_testXXXXXX";
+	struct aulastlog_rec rec;
+	off_t off = 1001 * (off_t)sizeof(rec);
+	time_t now = time(NULL);
+	int fd, tmp;
+
+	tmp = mkstemp(path);
+	if (tmp < 0)
+		return fail("no temp file");
+	close(tmp);
+
+	fd = aulastlog_db_open(path, 1);
+	if (fd < 0)
+		return fail("cannot create database");
+	memset(&rec, 0, sizeof(rec));
+	rec.auid = 1000;
+	rec.sec = 1700000000;
+	strcpy(rec.term, "ssh");
+	strcpy(rec.host, "example.com");
+	if (aulastlog_db_write(fd, &rec))
+		return fail("cannot write record");
+	rec.auid = 2000;
+	if (aulastlog_db_write(fd, &rec))
+		return fail("cannot write record");
+	close(fd);
+
+	fd = aulastlog_db_open(path, 0);
+	if (fd < 0)
+		return fail("cannot open database");
+	if (aulastlog_db_created(fd) < now - 5)
+		return fail("creation time not kept");
+	memset(&rec, 0, sizeof(rec));
+	if (aulastlog_db_read(fd, 1000, &rec) != 1 || rec.sec != 1700000000 ||
+			strcmp(rec.host, "example.com"))
+		return fail("record not read back");
+	if (aulastlog_db_read(fd, 1500, &rec) != 0 ||
+			aulastlog_db_read(fd, 5000, &rec) != 0)
+		return fail("missing user has a login");
+	close(fd);
+
+	// A damaged record is an error, not a user who never logged in
+	fd = open(path, O_WRONLY);
+	if (fd < 0 || pwrite(fd, "X", 1, off + 20) != 1)
+		return fail("cannot damage record");
+	close(fd);
+	fd = aulastlog_db_open(path, 0);
+	errno = 0;
+	if (aulastlog_db_read(fd, 1000, &rec) != -1 || errno != EBADMSG)
+		return fail("damaged record accepted");
+	close(fd);
+
+	// So is a record cut short at the end of the file
+	if (truncate(path, 2001 * (off_t)sizeof(rec) + 10))
+		return fail("cannot truncate");
+	fd = aulastlog_db_open(path, 0);
+	errno = 0;
+	if (aulastlog_db_read(fd, 2000, &rec) != -1 || errno != EBADMSG)
+		return fail("short record accepted");
+	close(fd);
+
+	// Other files are refused
+	fd = open(path, O_WRONLY);
+	if (fd < 0 || pwrite(fd, "NOTADB!!", 8, 0) != 8)
+		return fail("cannot overwrite header");
+	close(fd);
+	errno = 0;
+	if (aulastlog_db_open(path, 0) != -1 || errno != EPROTO)
+		return fail("bad header accepted");
+
+	unlink(path);
+	puts("lastlog database test passed");
+	return 0;
+}
@@ -0,0 +1,175 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "libaudit.h"
+#include "auditctl-listing.h"
+
+/* The options auditctl.c keeps for the listing */
+int list_requested, interpret, json_output;
+char key[AUDIT_MAX_KEY_LEN+1];
+const char key_sep[2] = { AUDIT_KEY_SEPARATOR, 0 };
+
+static char output[8192];
+
+static struct audit_rule_data *make_rule(const char *syscall, const char *k)
+{
+	struct audit_rule_data *r = audit_rule_create_data();
+	char pair[64];
+
+	if (r == NULL || audit_rule_syscallbyname_data(r, syscall))
+		return NULL;
+	snprintf(pair, sizeof(pair), "key=%s", k);
+	if (audit_rule_fieldpair_data(&r, pair, AUDIT_FILTER_EXIT))
+		return NULL;
+	r->flags = AUDIT_FILTER_EXIT;
+	r->action = AUDIT_ALWAYS;
+	return r;
+}
+
+static FILE *capture;
+static int saved_stdout;
+
+/* Sends what is printed from here on to a file */
+static void begin(void)
+{
+	capture = tmpfile();
+	fflush(stdout);
+	saved_stdout = dup(1);
+	if (capture)
+		dup2(fileno(capture), 1);
+}
+
+/* Puts stdout back and returns what was printed */
+static const char *end(void)
+{
+	size_t len = 0;
+
+	fflush(stdout);
+	dup2(saved_stdout, 1);
+	close(saved_stdout);
+	if (capture) {
+		rewind(capture);
+		len = fread(output, 1, sizeof(output) - 1, capture);
+		fclose(capture);
+	}
+	output[len] = 0;
+	return output;
+}
+
+/* Hands the rules to the listing as the kernel replies would */
+static const char *list(struct audit_rule_data **rules, int num)
+{
+	struct audit_reply rep;
+	int i;
+
+	begin();
+	audit_print_init();
+	memset(&rep, 0, sizeof(rep));
+	for (i = 0; i < num; i++) {
+		rep.type = AUDIT_LIST_RULES;
+		rep.ruledata = rules[i];
+		audit_print_reply(&rep, -1);
+	}
+	rep.type = NLMSG_DONE;
+	audit_print_reply(&rep, -1);
+	audit_print_finish();
+	return end();
+}
+
+static const char *status(struct audit_status *st)
+{
+	struct audit_reply rep;
+
+	begin();
+	audit_print_init();
+	memset(&rep, 0, sizeof(rep));
+	rep.type = AUDIT_GET;
+	rep.len = NLMSG_LENGTH(sizeof(*st));
+	rep.status = st;
+	audit_print_reply(&rep, -1);
+	audit_print_finish();
+	return end();
+}
+
+static int check(const char *got, const char *want, const char *what)
+{
+	if (strstr(got, want) == NULL) {
+		printf("Test failed - %s: no %s in\n%s", what, want, got);
+		return 1;
+	}
+	return 0;
+}
+
+int main(void)
+{
+	struct audit_rule_data *rules[2];
+	struct audit_status st;
+	const char *got, *want;
+
+	rules[0] = make_rule("open", "files" "\001" "a\"b");
+	rules[1] = make_rule("unlink", "other");
+	if (rules[0] == NULL || rules[1] == NULL) {
+		puts("Test failed - cannot make rules");
+		return 1;
+	}
+
+	// The usual listing is unchanged
+	got = list(rules, 2);
+	if (check(got, "-S open -F key=files", "text") ||
+			check(got, "-S unlink -F key=other", "text"))
+		return 1;
+	if (strcmp(list(rules, 0), "No rules\n")) {
+		printf("Test failed - empty listing is %s", output);
+		return 1;
+	}
+
+	json_output = 1;
+	got = list(rules, 2);
+	if (strncmp(got, "{\"rules\":[\n{", 12) ||
+			strcmp(got + strlen(got) - 5, "}\n]}\n")) {
+		printf("Test failed - json listing is not one object\n%s",
+			got);
+		return 1;
+	}
+	if (check(got, "{\"list\":\"exit\",\"action\":\"always\","
+				"\"keys\":[\"files\",\"a\\\"b\"],\"rule\":\""
+				"-a always,exit", "json") ||
+			check(got, "},\n{\"list\":\"exit\",\"action\":\"always\","
+				"\"keys\":[\"other\"]", "json"))
+		return 1;
+	if (strcmp(list(rules, 0), "{\"rules\":[]}\n")) {
+		printf("Test failed - empty json listing is %s", output);
+		return 1;
+	}
+
+	// Rules that do not have the wanted key are left out
+	strcpy(key, "other");
+	got = list(rules, 2);
+	if (check(got, "\"keys\":[\"other\"]", "key filter") ||
+			strstr(got, "files")) {
+		printf("Test failed - key filter kept\n%s", got);
+		return 1;
+	}
+
+	// The status is one object too
+	memset(&st, 0, sizeof(st));
+	st.enabled = 1;
+	st.pid = 42;
+	st.backlog_limit = 8192;
+	st.lost = 3;
+	got = status(&st);
+	want = "{\"enabled\":1,\"failure\":0,\"pid\":42,\"rate_limit\":0,"
+		"\"backlog_limit\":8192,\"lost\":3,\"backlog\":0";
+	if (strncmp(got, want, strlen(want)) ||
+			strcmp(got + strlen(got) - 2, "}\n")) {
+		printf("Test failed - json status is %s", got);
+		return 1;
+	}
+
+	free(rules[0]);
+	free(rules[1]);
+	puts("listing test passed");
+	return 0;
+}
@@ -0,0 +1,118 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ausearch-merge.h"
+
+// Normally set by the time options of ausearch and aureport
+time_t start_time = 0, end_time = 0;
+
+static char dir[] = "/tmp/merge_testXXXXXX";
+static time_t seen[16];
+static unsigned int num_seen = 0;
+
+static int write_log(const char *name, const time_t *secs, int cnt)
+{
+	char path[64];
+	FILE *f;
+	int i;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	f = fopen(path, "w");
+	if (f == NULL)
+		return 1;
+	for (i = 0; i < cnt; i++)
+		fprintf(f, "type=USER_LOGIN msg=audit(%ld.000:%d): pid=1 "
+			"uid=0 auid=0 ses=1 msg='op=login res=success'\n",
+			(long)secs[i], (int)secs[i]);
+	fclose(f);
+	return 0;
+}
+
+static int collect(llist *l)
+{
+	if (num_seen < 16)
+		seen[num_seen++] = l->e.sec;
+	return 0;
+}
+
+int main(void)
+{
+	static const time_t main1[] = { 1, 4 }, main0[] = { 6 };
+	static const time_t stream1[] = { 2 }, stream0[] = { 3, 5 };
+	char base[64], stream[64], missing[64];
+	unsigned int i;
+
+	if (mkdtemp(dir) == NULL) {
+		puts("Test failed - no temp dir");
+		return 1;
+	}
+	if (write_log("audit.log.1", main1, 2) ||
+			write_log("audit.log", main0, 1) ||
+			write_log("sshd.log.1", stream1, 1) ||
+			write_log("sshd.log", stream0, 2)) {
+		puts("Test failed - cannot write logs");
+		return 1;
+	}
+	snprintf(base, sizeof(base), "%s/audit.log", dir);
+	snprintf(stream, sizeof(stream), "%s/sshd.log", dir);
+	snprintf(missing, sizeof(missing), "%s/cron.log", dir);
+
+	if (log_set_oldest(base) != 1 || log_set_oldest(missing) != -1) {
+		puts("Test failed - oldest log");
+		return 1;
+	}
+
+	// A stream without logs yet is not an error
+	if (merge_add_log_set(base) || merge_add_log_set(stream) ||
+			merge_add_log_set(missing) || merge_num_sources() != 3) {
+		puts("Test failed - adding log sets");
+		return 1;
+	}
+	if (merge_process(collect)) {
+		puts("Test failed - merge");
+		return 1;
+	}
+	merge_clear();
+
+	if (num_seen != 6) {
+		printf("Test failed - %u events merged\n", num_seen);
+		return 1;
+	}
+	for (i = 0; i < num_seen; i++) {
+		if (seen[i] != (time_t)i + 1) {
+			printf("Test failed - event %ld out of order\n",
+				(long)seen[i]);
+			return 1;
+		}
+	}
+
+	// Inputs given by the user: a directory of audit.log files and a file
+	num_seen = 0;
+	if (merge_add_source(missing) == 0) {
+		puts("Test failed - missing input accepted");
+		return 1;
+	}
+	if (merge_add_source(dir) || merge_add_source(stream) ||
+			merge_process(collect)) {
+		puts("Test failed - merging inputs");
+		return 1;
+	}
+	merge_clear();
+	if (num_seen != 5 || seen[0] != 1 || seen[1] != 3 || seen[2] != 4 ||
+			seen[3] != 5 || seen[4] != 6) {
+		puts("Test failed - inputs out of order");
+		return 1;
+	}
+
+	unlink(base);
+	unlink(stream);
+	strcat(base, ".1");
+	strcat(stream, ".1");
+	unlink(base);
+	unlink(stream);
+	rmdir(dir);
+	puts("merge test passed");
+	return 0;
+}
@@ -0,0 +1,92 @@
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include "libaudit.h"
+#include "auditd-ratelimit.h"
+
+#define EVENTS 40
+
+static char last_report[MAX_AUDIT_MESSAGE_LENGTH];
+
+// Stands in for auditd's own function so reports can be checked
+int send_audit_event(int type, const char *str)
+{
+	snprintf(last_report, sizeof(last_report), "%s", str);
+	return 0;
+}
+
+static int check(struct auditd_event *e, int type, const char *msg)
+{
+	e->reply.type = type;
+	e->reply.message = (char *)msg;
+	e->reply.len = strlen(msg);
+	return ratelimit_event(e);
+}
+
+int main(void)
+{
+	struct daemon_conf conf;
+	struct auditd_event e;
+	char msg[256];
+	int verdict[EVENTS], i, drop;
+
+	memset(&conf, 0, sizeof(conf));
+	memset(&e, 0, sizeof(e));
+	conf.rate_limit_by = RL_KEY;
+	conf.rate_limit = 1;
+	conf.rate_limit_report = 60;
+	init_ratelimit(ev_default_loop(EVFLAG_AUTO), &conf);
+
+	// Open many events at once so their records are interleaved
+	for (i = 0; i < EVENTS; i++) {
+		snprintf(msg, sizeof(msg), "audit(1700000000.%03d:%d): "
+			"arch=c000003e syscall=2 success=yes key=\"flood\"",
+			i, 100 + i);
+		verdict[i] = check(&e, AUDIT_SYSCALL, msg);
+	}
+	if (verdict[0] != 0) {
+		puts("Test failed - first event was suppressed");
+		return 1;
+	}
+	for (i = 1; i < EVENTS; i++) {
+		if (verdict[i] != 1) {
+			printf("Test failed - event %d was kept\n", i);
+			return 1;
+		}
+	}
+
+	// Records without the key must follow the first record
+	for (i = EVENTS - 1; i >= 0; i--) {
+		snprintf(msg, sizeof(msg), "audit(1700000000.%03d:%d): "
+			"item=0 name=\"/etc/passwd\"", i, 100 + i);
+		if (check(&e, AUDIT_PATH, msg) != verdict[i]) {
+			printf("Test failed - PATH of event %d split off\n", i);
+			return 1;
+		}
+	}
+	for (i = 0; i < EVENTS; i++) {
+		snprintf(msg, sizeof(msg), "audit(1700000000.%03d:%d): ",
+			i, 100 + i);
+		if (check(&e, AUDIT_EOE, msg) != verdict[i]) {
+			printf("Test failed - EOE of event %d split off\n", i);
+			return 1;
+		}
+	}
+
+	// The same serial with another time stamp is another event
+	snprintf(msg, sizeof(msg), "audit(1700000001.000:%d): item=0", 101);
+	drop = check(&e, AUDIT_PATH, msg);
+	if (drop != 0) {
+		puts("Test failed - unrelated event took a cached decision");
+		return 1;
+	}
+
+	shutdown_ratelimit(ev_default_loop(EVFLAG_AUTO));
+	snprintf(msg, sizeof(msg), "suppressed=%d ", EVENTS - 1);
+	if (strstr(last_report, msg) == NULL) {
+		printf("Test failed - report was: %s\n", last_report);
+		return 1;
+	}
+	puts("ratelimit test passed");
+	return 0;
+}
@@ -0,0 +1,196 @@
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "auditd-reload.h"
+
+#define STEPS 8
+
+static char order[64];		/* A step is a digit, a read is r */
+static unsigned int olen, done_calls;
+static struct reload run;
+
+static void step(void *arg)
+{
+	order[olen++] = '0' + (int)(run.step);
+	(void)arg;
+}
+
+static void done(struct reload *r)
+{
+	done_calls++;
+}
+
+/* Stands in for the netlink socket, it always has data */
+static void read_one(struct ev_loop *loop, struct ev_io *io, int revents)
+{
+	if (olen < sizeof(order) - 1)
+		order[olen++] = 'r';
+}
+
+static void timeout(struct ev_loop *loop, struct ev_timer *t, int revents)
+{
+	ev_break(loop, EVBREAK_ALL);
+}
+
+static const struct reload_step steps[STEPS] = {
+	{ "a", step }, { "b", step }, { "c", step }, { "d", step },
+	{ "e", step }, { "f", step }, { "g", step }, { "h", step },
+};
+
+static void init_run(void)
+{
+	memset(order, 0, sizeof(order));
+	olen = 0;
+	done_calls = 0;
+	run.steps = steps;
+	run.nsteps = STEPS;
+	run.done = done;
+}
+
+static int test_loop(void)
+{
+	struct ev_loop *loop = ev_loop_new(EVFLAG_AUTO);
+	struct ev_io io;
+	struct ev_timer t;
+	int fds[2], i;
+	const char *p;
+
+	if (pipe(fds))
+		return 1;
+	write(fds[1], "x", 1);
+	ev_io_init(&io, read_one, fds[0], EV_READ);
+	ev_io_start(loop, &io);
+	ev_timer_init(&t, timeout, 0.05, 0.);
+	ev_timer_start(loop, &t);
+
+	init_run();
+	reload_start(loop, &run);
+	ev_run(loop, 0);
+
+	// Every step ran once, in order, and the reload was finished once
+	for (i = 0, p = order; *p; p++)
+		if (*p != 'r' && *p != '0' + i++)
+			break;
+	if (*p || i != STEPS || done_calls != 1) {
+		printf("Test failed - steps ran as %s, done %u times\n",
+			order, done_calls);
+		return 1;
+	}
+	// The event source was read between the steps
+	for (i = 1; i < STEPS; i++) {
+		char *s = strchr(order, '0' + i);
+
+		if (s == NULL || s[-1] != 'r') {
+			printf("Test failed - no read before step %d in %s\n",
+				i, order);
+			return 1;
+		}
+	}
+	if (ev_is_active(&run.watcher)) {
+		puts("Test failed - watcher still active after the reload");
+		return 1;
+	}
+
+	// A reload can be finished at once, as at shutdown or a new reload
+	init_run();
+	reload_start(loop, &run);
+	ev_run(loop, EVRUN_ONCE);
+	reload_finish(&run);
+	if (run.step != STEPS || done_calls != 1 ||
+			ev_is_active(&run.watcher)) {
+		puts("Test failed - reload_finish left steps");
+		return 1;
+	}
+
+	ev_io_stop(loop, &io);
+	ev_timer_stop(loop, &t);
+	ev_loop_destroy(loop);
+	close(fds[0]);
+	close(fds[1]);
+	return 0;
+}
+
+static int test_timing(void)
+{
+	char buf[256];
+	unsigned long total;
+
+	init_run();
+	run.nsteps = 2;
+	run.usec[0] = 1500;
+	run.usec[1] = 20;
+	total = reload_format_timing(&run, buf, sizeof(buf));
+	if (total != 1520 || strcmp(buf, "a 1.500 ms, b 0.020 ms")) {
+		printf("Test failed - timing is %lu %s\n", total, buf);
+		return 1;
+	}
+	// Too small a buffer is cut short, not overrun
+	memset(buf, 'x', sizeof(buf));
+	reload_format_timing(&run, buf, 8);
+	if (strlen(buf) != 7 || buf[8] != 'x') {
+		puts("Test failed - timing overran its buffer");
+		return 1;
+	}
+	return 0;
+}
+
+static int test_streams(void)
+{
+	int types1[] = { 1100, 1300 }, types2[] = { 1100, 1301 };
+	char *keys1[] = { "k1" }, *keys2[] = { "k2" };
+	char name1[] = "s", name2[] = "s";
+	struct log_stream_conf a, b, c;
+
+	memset(&a, 0, sizeof(a));
+	a.name = name1;
+	a.num_logs = 5;
+	a.match_types = types1;
+	a.num_types = 2;
+	a.match_keys = keys1;
+	a.num_keys = 1;
+	b = a;
+	b.name = name2;		// Equal strings, not the same pointer
+
+	if (log_streams_differ(NULL, NULL) || log_streams_differ(&a, &b)) {
+		puts("Test failed - equal streams differ");
+		return 1;
+	}
+	if (!log_streams_differ(&a, NULL) || !log_streams_differ(NULL, &b)) {
+		puts("Test failed - added or removed stream not seen");
+		return 1;
+	}
+	b.match_types = types2;
+	if (!log_streams_differ(&a, &b)) {
+		puts("Test failed - changed type not seen");
+		return 1;
+	}
+	b.match_types = types1;
+	b.match_keys = keys2;
+	if (!log_streams_differ(&a, &b)) {
+		puts("Test failed - changed key not seen");
+		return 1;
+	}
+	b.match_keys = keys1;
+	b.num_logs = 6;
+	if (!log_streams_differ(&a, &b)) {
+		puts("Test failed - changed num_logs not seen");
+		return 1;
+	}
+	b.num_logs = 5;
+	c = a;
+	a.next = &c;
+	if (!log_streams_differ(&a, &b)) {
+		puts("Test failed - extra stream not seen");
+		return 1;
+	}
+	return 0;
+}
+
+int main(void)
+{
+	if (test_loop() || test_timing() || test_streams())
+		return 1;
+	puts("reload test passed");
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ausearch-time.h"
+
+#define STEP 97		/* Seconds, so every time of day gets hit */
+#define RANDOM 20000
+
+static const char *zones[] = {
+	"right/UTC", "UTC", "America/New_York", "Europe/London",
+	"Australia/Lord_Howe", "Asia/Kolkata"
+};
+
+/* Compares the cached conversions of t with the libc ones */
+static int check(time_t t, const char *zone)
+{
+	const struct tm *c;
+	struct tm tm;
+	char want[64], cbuf[32];
+	const char *got;
+
+	localtime_r(&t, &tm);
+	c = ausearch_localtime(t);
+	if (c == NULL || c->tm_sec != tm.tm_sec || c->tm_min != tm.tm_min ||
+			c->tm_hour != tm.tm_hour || c->tm_mday != tm.tm_mday ||
+			c->tm_mon != tm.tm_mon || c->tm_year != tm.tm_year ||
+			c->tm_wday != tm.tm_wday || c->tm_yday != tm.tm_yday ||
+			c->tm_isdst != tm.tm_isdst) {
+		printf("Test failed - %s localtime of %lld\n", zone,
+			(long long)t);
+		return 1;
+	}
+
+	strftime(want, sizeof(want), "%x %T", &tm);
+	got = ausearch_date_time(t);
+	if (got == NULL || strcmp(got, want)) {
+		printf("Test failed - %s %lld is %s not %s\n", zone,
+			(long long)t, got ? got : "NULL", want);
+		return 1;
+	}
+	strftime(want, sizeof(want), "%T", &tm);
+	got = ausearch_time_of_day(t);
+	if (got == NULL || strcmp(got, want)) {
+		printf("Test failed - %s time of day of %lld\n", zone,
+			(long long)t);
+		return 1;
+	}
+	got = ausearch_ctime(t);
+	if (got == NULL || strcmp(got, ctime_r(&t, cbuf))) {
+		printf("Test failed - %s ctime of %lld\n", zone,
+			(long long)t);
+		return 1;
+	}
+	return 0;
+}
+
+int main(void)
+{
+	unsigned int z, i;
+
+	srandom(1);
+	for (z = 0; z < sizeof(zones)/sizeof(zones[0]); z++) {
+		struct tm start;
+		time_t t, end;
+
+		setenv("TZ", zones[z], 1);
+		tzset();
+
+		// Each zone gets its own year so nothing cached carries over.
+		// 2016 had a leap second at its end.
+		memset(&start, 0, sizeof(start));
+		start.tm_year = 116 + z;
+		start.tm_mday = 1;
+		start.tm_isdst = -1;
+		t = mktime(&start);
+		end = t + 366 * 24 * 3600;
+
+		// In order, as a log is read, across every DST change
+		for (; t < end; t += STEP)
+			if (check(t, zones[z]))
+				return 1;
+
+		// Second by second over the new year, for the leap second
+		for (t = end - 24 * 3600; t < end + 120; t++)
+			if (check(t, zones[z]))
+				return 1;
+
+		// And jumping around, as merged or sorted output does
+		for (i = 0; i < RANDOM; i++) {
+			t = end - 1 - random() % (366 * 24 * 3600);
+			if (check(t, zones[z]))
+				return 1;
+		}
+	}
+	puts("time test passed");
+	return 0;
+}
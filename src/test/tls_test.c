@@ -0,0 +1,240 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <openssl/pem.h>
+#include <openssl/err.h>
+#include "auditd-tls.h"
+
+#define ACKS 2000
+
+static char dir[] = "/tmp/tls_test.XXXXXX";
+
+/* Writes a self signed certificate and its key to dir */
+static int make_cert(const char *name)
+{
+	char path[256];
+	EVP_PKEY *key = EVP_EC_gen("P-256");
+	X509 *x = X509_new();
+	X509_EXTENSION *ext;
+	FILE *f;
+
+	if (key == NULL || x == NULL)
+		return 1;
+	X509_set_version(x, 2);
+	ASN1_INTEGER_set(X509_get_serialNumber(x), 1);
+	X509_gmtime_adj(X509_getm_notBefore(x), -60);
+	X509_gmtime_adj(X509_getm_notAfter(x), 3600);
+	X509_set_pubkey(x, key);
+	X509_NAME_add_entry_by_txt(X509_get_subject_name(x), "CN",
+		MBSTRING_ASC, (const unsigned char *)name, -1, -1, 0);
+	X509_set_issuer_name(x, X509_get_subject_name(x));
+	ext = X509V3_EXT_conf_nid(NULL, NULL, NID_basic_constraints,
+		"critical,CA:TRUE");
+	X509_add_ext(x, ext, -1);
+	X509_EXTENSION_free(ext);
+	if (X509_sign(x, key, EVP_sha256()) == 0)
+		return 1;
+
+	snprintf(path, sizeof(path), "%s/%s.crt", dir, name);
+	f = fopen(path, "w");
+	if (f == NULL)
+		return 1;
+	PEM_write_X509(f, x);
+	fclose(f);
+	snprintf(path, sizeof(path), "%s/%s.key", dir, name);
+	f = fopen(path, "w");
+	if (f == NULL)
+		return 1;
+	PEM_write_PrivateKey(f, key, NULL, NULL, 0, NULL, NULL);
+	fclose(f);
+	X509_free(x);
+	EVP_PKEY_free(key);
+	return 0;
+}
+
+static char *file(const char *name, const char *ext)
+{
+	static char path[2][256];
+	static int n;
+
+	n = !n;
+	snprintf(path[n], sizeof(path[n]), "%s/%s.%s", dir, name, ext);
+	return path[n];
+}
+
+static SSL *client_ssl(const char *name, int fd)
+{
+	SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+	SSL *ssl;
+
+	SSL_CTX_use_certificate_chain_file(ctx, file(name, "crt"));
+	SSL_CTX_use_PrivateKey_file(ctx, file(name, "key"), SSL_FILETYPE_PEM);
+	SSL_CTX_load_verify_locations(ctx, file("server", "crt"), NULL);
+	SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, NULL);
+	ssl = SSL_new(ctx);
+	SSL_CTX_free(ctx);
+	SSL_set_fd(ssl, fd);
+	return ssl;
+}
+
+/* Drives both ends of the handshake. Returns 0 if it worked. */
+static int handshake(SSL *srv, SSL *cli)
+{
+	int i, sdone = 0, cdone = 0;
+
+	for (i = 0; i < 100 && !(sdone && cdone); i++) {
+		int rc;
+
+		if (!sdone) {
+			rc = SSL_accept(srv);
+			if (rc == 1)
+				sdone = 1;
+			else if (SSL_get_error(srv, rc) != SSL_ERROR_WANT_READ &&
+				 SSL_get_error(srv, rc) != SSL_ERROR_WANT_WRITE)
+				return 1;
+		}
+		if (!cdone) {
+			rc = SSL_connect(cli);
+			if (rc == 1)
+				cdone = 1;
+			else if (SSL_get_error(cli, rc) != SSL_ERROR_WANT_READ &&
+				 SSL_get_error(cli, rc) != SSL_ERROR_WANT_WRITE)
+				return 1;
+		}
+	}
+	return !(sdone && cdone);
+}
+
+static int connect_pair(SSL_CTX *ctx, const char *client, SSL **srv,
+	SSL **cli)
+{
+	int sv[2], small = 4096;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv))
+		return 1;
+	setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+	setsockopt(sv[1], SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+	fcntl(sv[0], F_SETFL, O_NONBLOCK);
+	fcntl(sv[1], F_SETFL, O_NONBLOCK);
+	*srv = SSL_new(ctx);
+	SSL_set_fd(*srv, sv[0]);
+	*cli = client_ssl(client, sv[1]);
+	return 0;
+}
+
+static void close_pair(SSL *srv, SSL *cli)
+{
+	close(SSL_get_fd(srv));
+	close(SSL_get_fd(cli));
+	SSL_free(srv);
+	SSL_free(cli);
+}
+
+int main(void)
+{
+	struct tls_out out;
+	SSL_CTX *ctx;
+	SSL *srv, *cli;
+	static char sent[ACKS * 64], got[ACKS * 64];
+	size_t slen = 0, glen = 0;
+	int i, rc, blocked = 0;
+
+	if (mkdtemp(dir) == NULL || make_cert("server") ||
+			make_cert("stranger")) {
+		puts("Test failed - cannot make certificates");
+		return 1;
+	}
+	ctx = tls_server_ctx(file("server", "crt"), file("server", "key"),
+			     file("server", "crt"));
+	if (ctx == NULL) {
+		ERR_print_errors_fp(stdout);
+		puts("Test failed - server context");
+		return 1;
+	}
+
+	// A client with a certificate from the CA gets in
+	if (connect_pair(ctx, "server", &srv, &cli) || handshake(srv, cli)) {
+		ERR_print_errors_fp(stdout);
+		puts("Test failed - trusted client rejected");
+		return 1;
+	}
+
+	// Acks queue up without blocking while the client does not read
+	memset(&out, 0, sizeof(out));
+	for (i = 0; i < ACKS; i++) {
+		char ack[64];
+		int len = snprintf(ack, sizeof(ack), "ack %d\n", i);
+
+		if (tls_out_add(&out, ack, len)) {
+			puts("Test failed - ack not queued");
+			return 1;
+		}
+		memcpy(sent + slen, ack, len);
+		slen += len;
+		rc = tls_out_flush(srv, &out);
+		if (rc == SSL_ERROR_WANT_WRITE)
+			blocked = 1;
+		else if (rc) {
+			ERR_print_errors_fp(stdout);
+			printf("Test failed - flush of ack %d gave %d\n", i, rc);
+			return 1;
+		}
+	}
+	if (!blocked || out.len == 0) {
+		puts("Test failed - the socket never filled up");
+		return 1;
+	}
+
+	// Once the client reads, everything arrives in order
+	for (i = 0; i < 100000 && (out.len || glen < slen); i++) {
+		int r = SSL_read(cli, got + glen, sizeof(got) - glen);
+
+		if (r > 0)
+			glen += r;
+		rc = tls_out_flush(srv, &out);
+		if (rc < 0) {
+			ERR_print_errors_fp(stdout);
+			puts("Test failed - retried write was refused");
+			return 1;
+		}
+	}
+	if (glen != slen || memcmp(sent, got, slen)) {
+		printf("Test failed - got %zu of %zu bytes\n", glen, slen);
+		return 1;
+	}
+
+	// A client that stops reading cannot use up memory
+	memset(got, 'x', sizeof(got));
+	for (i = 0; i * sizeof(got) <= TLS_OUT_MAX; i++)
+		if (tls_out_add(&out, got, sizeof(got)))
+			break;
+	if (i * sizeof(got) > TLS_OUT_MAX || out.len > TLS_OUT_MAX) {
+		puts("Test failed - queue not limited");
+		return 1;
+	}
+	tls_out_free(&out);
+	close_pair(srv, cli);
+
+	// A certificate from anyone else is turned away
+	if (connect_pair(ctx, "stranger", &srv, &cli) ||
+			handshake(srv, cli) == 0) {
+		puts("Test failed - untrusted client accepted");
+		return 1;
+	}
+	close_pair(srv, cli);
+	SSL_CTX_free(ctx);
+
+	unlink(file("server", "crt"));
+	unlink(file("server", "key"));
+	unlink(file("stranger", "crt"));
+	unlink(file("stranger", "key"));
+	rmdir(dir);
+	puts("tls test passed");
+	return 0;
+}
@@ -26,10 +26,20 @@
 #include <string.h>
 #include "aulast-llist.h"
 
+// Hash tables start at this size and double when they get full
+#define HASH_START	64
+
 void list_create(llist *l)
 {
 	l->head = NULL;
+	l->tail = NULL;
 	l->cur = NULL;
+	l->ses_hash = NULL;
+	l->ses_tail = NULL;
+	l->auid_hash = NULL;
+	l->auid_tail = NULL;
+	l->hash_size = 0;
+	l->cnt = 0;
 }
 
 lnode *list_next(llist *l)
@@ -40,25 +50,154 @@ lnode *list_next(llist *l)
 	return l->cur;
 }
 
+static inline unsigned int hash_ses(unsigned int session, unsigned int size)
+{
+	return (session * 2654435761U) & (size - 1);
+}
+
+static inline unsigned int hash_auid(uid_t auid, int pid,
+	unsigned int session, unsigned int size)
+{
+	unsigned int h = session * 2654435761U;
+
+	h ^= (unsigned int)auid * 2246822519U;
+	h ^= (unsigned int)pid * 3266489917U;
+	return (h ^ (h >> 15)) & (size - 1);
+}
+
+/*
+ * Nodes are added at the end of their chains so that, as with the list,
+ * the oldest of several matching sessions is found first. The tail of
+ * each chain is kept so that this does not walk the chain.
+ */
+static void hash_insert(llist *l, lnode *node)
+{
+	unsigned int b;
+
+	node->ses_next = NULL;
+	node->auid_next = NULL;
+	if (l->hash_size == 0)
+		return;
+
+	b = hash_ses(node->session, l->hash_size);
+	if (l->ses_tail[b])
+		l->ses_tail[b]->ses_next = node;
+	else
+		l->ses_hash[b] = node;
+	l->ses_tail[b] = node;
+
+	b = hash_auid(node->auid, node->pid, node->session, l->hash_size);
+	if (l->auid_tail[b])
+		l->auid_tail[b]->auid_next = node;
+	else
+		l->auid_hash[b] = node;
+	l->auid_tail[b] = node;
+}
+
+static void hash_remove(llist *l, lnode *node)
+{
+	lnode *cur, *prev;
+	unsigned int b;
+
+	if (l->hash_size == 0)
+		return;
+
+	b = hash_ses(node->session, l->hash_size);
+	for (prev = NULL, cur = l->ses_hash[b]; cur && cur != node;
+							cur = cur->ses_next)
+		prev = cur;
+	if (cur) {
+		if (prev)
+			prev->ses_next = node->ses_next;
+		else
+			l->ses_hash[b] = node->ses_next;
+		if (l->ses_tail[b] == node)
+			l->ses_tail[b] = prev;
+	}
+
+	b = hash_auid(node->auid, node->pid, node->session, l->hash_size);
+	for (prev = NULL, cur = l->auid_hash[b]; cur && cur != node;
+							cur = cur->auid_next)
+		prev = cur;
+	if (cur) {
+		if (prev)
+			prev->auid_next = node->auid_next;
+		else
+			l->auid_hash[b] = node->auid_next;
+		if (l->auid_tail[b] == node)
+			l->auid_tail[b] = prev;
+	}
+}
+
+static void hash_free(llist *l)
+{
+	free(l->ses_hash);
+	free(l->ses_tail);
+	free(l->auid_hash);
+	free(l->auid_tail);
+}
+
+/*
+ * Double the tables and rehash in list order. If memory runs out, the
+ * old tables are kept, or if there are none the lookups walk the list.
+ */
+static void hash_grow(llist *l)
+{
+	lnode **ses, **ses_tail, **auid, **auid_tail, *cur;
+	unsigned int size = l->hash_size ? l->hash_size * 2 : HASH_START;
+
+	ses = calloc(size, sizeof(lnode *));
+	ses_tail = calloc(size, sizeof(lnode *));
+	auid = calloc(size, sizeof(lnode *));
+	auid_tail = calloc(size, sizeof(lnode *));
+	if (ses == NULL || ses_tail == NULL || auid == NULL ||
+						auid_tail == NULL) {
+		free(ses);
+		free(ses_tail);
+		free(auid);
+		free(auid_tail);
+		return;
+	}
+	hash_free(l);
+	l->ses_hash = ses;
+	l->ses_tail = ses_tail;
+	l->auid_hash = auid;
+	l->auid_tail = auid_tail;
+	l->hash_size = size;
+	for (cur = l->head; cur; cur = cur->next)
+		hash_insert(l, cur);
+}
+
 static void list_append(llist *l, lnode *node)
 {
+	// Grow first so the rehash does not see the new node
+	if (l->cnt >= l->hash_size)
+		hash_grow(l);
+
 	node->next = NULL;
+	node->prev = l->tail;
 
 	// if we are at top, fix this up
 	if (l->head == NULL)
 		l->head = node;
-	else if (l->cur) {
-		// Make sure we are at the end
-		while (l->cur->next)
-			l->cur = l->cur->next;
-
-		l->cur->next = node;
-	}
+	else
+		l->tail->next = node;
+	l->tail = node;
+	l->cnt++;
+	hash_insert(l, node);
 
 	// make newnode current
 	l->cur = node;
 }
 
+static void free_node(lnode *node)
+{
+	free((void *)node->name);
+	free((void *)node->term);
+	free((void *)node->host);
+	free(node);
+}
+
 void list_clear(llist* l)
 {
 	lnode* nextnode;
@@ -67,14 +206,11 @@ void list_clear(llist* l)
 	current = l->head;
 	while (current) {
 		nextnode=current->next;
-		free((void *)current->name);
-		free((void *)current->term);
-		free((void *)current->host);
-		free(current);
+		free_node(current);
 		current=nextnode;
 	}
-	l->head = NULL;
-	l->cur = NULL;
+	hash_free(l);
+	list_create(l);
 }
 
 int list_create_session_simple(llist *l, lnode *n)
@@ -141,50 +277,43 @@ lnode *list_delete_cur(llist *l)
 {
         register lnode *cur, *prev;
 
-	if (l == NULL || l->head == NULL)
+	if (l == NULL || l->cur == NULL)
 		return NULL;
 
-	prev = cur = l->head;	/* start at the beginning */
-	while (cur) {
-		if (cur == l->cur) {
-			// If the first iteration
-			if (prev == l->head && cur == l->head) {
-				l->head = cur->next;
-				l->cur = cur->next;
-				free((void *)cur->name);
-				free((void *)cur->term);
-				free((void *)cur->host);
-				free(cur);
-				prev = NULL;
-			} else {
-				prev->next = cur->next;
-				free((void *)cur->name);
-				free((void *)cur->term);
-				free((void *)cur->host);
-				free(cur);
-				l->cur = prev;
-			}
-			return prev;
-		} else {
-			prev = cur;
-			cur = cur->next;
-		}
-	}
-	return NULL;
+	cur = l->cur;
+	prev = cur->prev;
+	hash_remove(l, cur);
+	if (prev)
+		prev->next = cur->next;
+	else
+		l->head = cur->next;
+	if (cur->next)
+		cur->next->prev = prev;
+	else
+		l->tail = prev;
+	l->cnt--;
+
+	// If it was the first one, the next one becomes current
+	l->cur = prev ? prev : cur->next;
+	free_node(cur);
+	return prev;
 }
 
 lnode *list_find_auid(llist *l, uid_t auid, int pid, unsigned int session)
 {
         register lnode* cur;
-                                                                                
-       	cur = l->head;	/* start at the beginning */
+
+	if (l->hash_size)
+		cur = l->auid_hash[hash_auid(auid, pid, session, l->hash_size)];
+	else
+		cur = l->head;
 	while (cur) {
 		if (cur->pid == pid && cur->auid == auid &&
 					cur->session == session) {
 			l->cur = cur;
 			return cur;
 		} else
-			cur = cur->next;
+			cur = l->hash_size ? cur->auid_next : cur->next;
 	}
 	return NULL;
 }
@@ -192,15 +321,17 @@ lnode *list_find_auid(llist *l, uid_t auid, int pid, unsigned int session)
 lnode *list_find_session(llist *l, unsigned int session)
 {
         register lnode* cur;
-                                                                                
-       	cur = l->head;	/* start at the beginning */
+
+	if (l->hash_size)
+		cur = l->ses_hash[hash_ses(session, l->hash_size)];
+	else
+		cur = l->head;
 	while (cur) {
 		if (cur->session == session) {
 			l->cur = cur;
 			return cur;
 		} else
-			cur = cur->next;
+			cur = l->hash_size ? cur->ses_next : cur->next;
 	}
 	return NULL;
 }
-
@@ -47,13 +47,25 @@ typedef struct _lnode{
   unsigned long user_login_proof; // audit serial number for user login event
   unsigned long  user_end_proof; // audit serial number for user log out event
   struct _lnode* next;	// Next node pointer
+  struct _lnode* prev;	// Previous node pointer
+  struct _lnode* ses_next;	// Next node in the session hash chain
+  struct _lnode* auid_next;	// Next node in the auid/pid hash chain
 } lnode;
 
 /* This is the linked list head. Only data elements that are 1 per
- * event goes here. */
+ * event goes here. The list keeps the sessions in the order they were
+ * opened. They are also hashed by session and by auid, pid, and session
+ * so that lookups don't have to walk the list. */
 typedef struct {
   lnode *head;		// List head
+  lnode *tail;		// List tail
   lnode *cur;		// Pointer to current node
+  lnode **ses_hash;	// Nodes hashed by session
+  lnode **ses_tail;	// Last node of each session chain
+  lnode **auid_hash;	// Nodes hashed by auid, pid, and session
+  lnode **auid_tail;	// Last node of each auid chain
+  unsigned int hash_size;	// Buckets in each hash table
+  unsigned int cnt;	// How many items in this list
 } llist;
 
 void list_create(llist *l);
@@ -0,0 +1,94 @@
+/* test-llist.c -- test suite for aulast-llist.c
+ * Copyright 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ *
+ * Authors:
+ *   agent <agent@local>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include "aulast-llist.h"
+
+// Enough to grow the hash tables a few times
+#define SESSIONS 1000
+
+static int fail(const char *msg, unsigned int i)
+{
+	printf("Test failed - %s %u\n", msg, i);
+	return 1;
+}
+
+int main(void)
+{
+	llist l;
+	lnode *n;
+	unsigned int i;
+
+	list_create(&l);
+	for (i = 0; i < SESSIONS; i++) {
+		if (!list_create_session(&l, 1000 + i % 7, 100 + i, i, i))
+			return fail("cannot create session", i);
+	}
+	// A reused session id must not hide the older session
+	if (!list_create_session(&l, 42, 42, 5, SESSIONS))
+		return fail("cannot create session", SESSIONS);
+
+	for (i = 0; i < SESSIONS; i++) {
+		n = list_find_session(&l, i);
+		if (n == NULL || n->loginuid_proof != i)
+			return fail("session not found", i);
+		n = list_find_auid(&l, 1000 + i % 7, 100 + i, i);
+		if (n == NULL || n->loginuid_proof != i)
+			return fail("auid not found", i);
+	}
+
+	// Delete every other session, chain heads, middles and tails alike
+	for (i = 0; i < SESSIONS; i += 2) {
+		if (list_find_session(&l, i) == NULL)
+			return fail("session vanished", i);
+		list_delete_cur(&l);
+	}
+	n = list_find_session(&l, 5);
+	if (n == NULL || n->loginuid_proof != 5)
+		return fail("oldest session not first", 5);
+	list_delete_cur(&l);
+	n = list_find_session(&l, 5);
+	if (n == NULL || n->loginuid_proof != SESSIONS)
+		return fail("reused session lost", 5);
+
+	// New sessions must still be linked after the chains were cut
+	for (i = 0; i < SESSIONS; i += 2) {
+		if (!list_create_session(&l, 7, 7, i, SESSIONS + i))
+			return fail("cannot create session", i);
+	}
+	for (i = 0; i < SESSIONS; i++) {
+		unsigned long proof = (i & 1) ? i : SESSIONS + i;
+
+		if (i == 5)
+			continue;
+		n = list_find_session(&l, i);
+		if (n == NULL || n->loginuid_proof != proof)
+			return fail("session lost after delete", i);
+	}
+	if (l.cnt != SESSIONS)
+		return fail("wrong count", l.cnt);
+
+	list_clear(&l);
+	puts("aulast list test passed");
+	return 0;
+}
@@ -60,6 +60,7 @@ int list_append(llist *l, lnode *node)
 		newnode->term = strdup(node->term);
 	else
 		newnode->term = NULL;
+	newnode->from_db = node->from_db;
 	newnode->item = l->cnt;
 	newnode->next = NULL;
 
@@ -36,6 +36,7 @@ typedef struct _lnode{
   char *name;		// users name
   char *host;		// host where logging in from
   char *term;		// terminal name
+  int from_db;		// login came from the lastlog database
   unsigned int item;	// Which item of the same event
   struct _lnode* next;	// Next node pointer
 } lnode;
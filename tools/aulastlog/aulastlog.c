@@ -27,18 +27,59 @@
 #include <string.h>
 #include <errno.h>
 #include <pwd.h>
+#include <unistd.h>
 #include "auparse.h"
+#include "lastlog-db.h"
 #include "aulastlog-llist.h"
 
 static void usage(void)
 {
-	fprintf(stderr, "usage: aulastlog [--stdin] [--user name]\n");
+	fprintf(stderr,
+	    "usage: aulastlog [--stdin] [--logs] [--db file] [--user name]\n");
+}
+
+/*
+ * Fill in the users from the database kept by the lastlog plugin.
+ * Each user is one read, so no logs have to be scanned. Returns the
+ * number of users it has no login for.
+ */
+static unsigned int load_db(llist *l, int fd, const char *path)
+{
+	struct aulastlog_rec rec;
+	unsigned int misses = 0;
+	lnode *cur;
+
+	list_first(l);
+	cur = list_get_cur(l);
+	while (cur) {
+		int rc = aulastlog_db_read(fd, cur->uid, &rec);
+
+		if (rc == 1) {
+			list_update_login(l, (time_t)rec.sec);
+			if (rec.host[0])
+				list_update_host(l, rec.host);
+			if (rec.term[0])
+				list_update_term(l, rec.term);
+			cur->from_db = 1;
+		} else {
+			if (rc < 0)
+				fprintf(stderr,
+				    "Error reading %s for %s (%s), "
+				    "scanning logs\n", path, cur->name,
+				    strerror(errno));
+			misses++;
+		}
+		cur = list_next(l);
+	}
+	return misses;
 }
 
 int main(int argc, char *argv[])
 {
-	int i, use_stdin = 0;
+	int i, use_stdin = 0, use_logs = 0;
 	char *user = NULL;
+	const char *db = AULASTLOG_DB;
+	time_t since = 0;
 	struct passwd *p;
         auparse_state_t *au;
 	llist l;
@@ -56,6 +97,16 @@ int main(int argc, char *argv[])
 			}
 		} else if (strcmp(argv[i], "--stdin") == 0) {
 			use_stdin = 1;
+		} else if (strcmp(argv[i], "--logs") == 0) {
+			use_logs = 1;
+		} else if (strcmp(argv[i], "--db") == 0) {
+			i++;
+			if (i<argc)
+				db = argv[i];
+			else {
+				usage();
+				return 1;
+			}
 		} else {
 			usage();
 			return 1;
@@ -74,6 +125,7 @@ int main(int argc, char *argv[])
 		n.name = p->pw_name;
 		n.host = NULL;
 		n.term = NULL;
+		n.from_db = 0;
 		if (user == NULL)
 			list_append(&l, &n);
 		else if (strcmp(user, p->pw_name) == 0)
@@ -86,6 +138,25 @@ int main(int argc, char *argv[])
 		return 1;
 	}
 
+	/*
+	 * Use the lastlog plugin's database when there is one. Users it
+	 * has no login for are looked up in the logs it was created from.
+	 */
+	if (!use_stdin && !use_logs) {
+		int fd = aulastlog_db_open(db, 0);
+
+		if (fd >= 0) {
+			unsigned int misses = load_db(&l, fd, db);
+
+			since = aulastlog_db_created(fd);
+			close(fd);
+			if (misses == 0)
+				goto report;
+		} else if (errno != ENOENT)
+			fprintf(stderr, "Cannot use %s (%s), scanning logs\n",
+				db, strerror(errno));
+	}
+
 	// Search for successful user logins
 	if (use_stdin)
 		au = auparse_init(AUSOURCE_FILE_POINTER, stdin);
@@ -105,6 +176,12 @@ int main(int argc, char *argv[])
 		printf("ausearch_add_item error - %s\n", strerror(errno));
 		goto error_exit_2;
 	}
+	if (since && ausearch_add_timestamp_item(au, "<", since, 0,
+						 AUSEARCH_RULE_AND)) {
+		printf("ausearch_add_timestamp_item error - %s\n",
+			strerror(errno));
+		goto error_exit_2;
+	}
 	if (ausearch_set_stop(au, AUSEARCH_STOP_RECORD)){
 		printf("ausearch_set_stop error - %s\n", strerror(errno));
 		goto error_exit_2;
@@ -116,7 +193,7 @@ int main(int argc, char *argv[])
 		if (auparse_find_field(au, "auid")) {
 			uid_t u = auparse_get_field_int(au);
 			list_first(&l);
-			if (list_find_uid(&l, u)) {
+			if (list_find_uid(&l, u) && !list_get_cur(&l)->from_db) {
 				const char *str;
 
 				list_update_login(&l, e->sec);
@@ -133,6 +210,7 @@ int main(int argc, char *argv[])
 	}
         auparse_destroy(au);
 
+report:
 	// Now output the report
 	printf( "Username         Port         From"
 		"                       Latest\n");